@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
+
+// This example compares DCTCP with NewReno in an incast scenario, where
+// many senders of a rack transmit at the same time to a single receiver
+// through a top-of-rack switch.
+//
+// Network topology
+//
+//   s0 ----+
+//          |  1 Gbps, 10 us
+//   s1 ----+
+//   ...    +---- switch ------------- receiver
+//          |            1 Gbps, 10 us
+//   sN-1 --+
+//
+// All the links run at the same rate, so the queue builds up at the switch
+// port towards the receiver. Two scenarios are simulated in sequence:
+//
+// - NewReno over a drop-tail switch port (pfifo_fast) holding up to
+//   bufferSize packets: the senders fill the buffer until a loss occurs;
+// - DCTCP with ECN enabled and a RED switch port in step marking mode,
+//   which marks every packet arriving when more than K packets are queued.
+//
+// For each scenario, the goodput, the average and the 99th percentile of the
+// queueing delay at the switch port (sampled every 10 us) and the queue disc
+// statistics are printed. DCTCP keeps the queue around K packets, i.e.,
+// a queueing delay below one millisecond at 1 Gbps, with the same goodput.
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("DctcpIncast");
+
+static std::vector<uint32_t> g_queueSamples;  //!< Samples of the switch queue, in bytes
+
+static void
+SampleQueue (Ptr<QueueDisc> q, Time interval)
+{
+  g_queueSamples.push_back (q->GetNBytes ());
+  Simulator::Schedule (interval, &SampleQueue, q, interval);
+}
+
+static void
+RunScenario (bool dctcp, uint32_t nSenders, uint32_t bufferSize, uint32_t k,
+             double simulationTime)
+{
+  std::string linkRate = "1Gbps";
+  DataRate rate (linkRate);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1448));
+  Config::SetDefault ("ns3::TcpSocket::DelAckCount", UintegerValue (2));
+  Config::SetDefault ("ns3::TcpSocketBase::UseEcn", BooleanValue (dctcp));
+  Config::SetDefault ("ns3::TcpL4Protocol::SocketType",
+                      TypeIdValue (dctcp ? TcpDctcp::GetTypeId () : TcpNewReno::GetTypeId ()));
+
+  NodeContainer senders;
+  senders.Create (nSenders);
+  Ptr<Node> tor = CreateObject<Node> ();
+  Ptr<Node> receiver = CreateObject<Node> ();
+
+  InternetStackHelper stack;
+  stack.Install (senders);
+  stack.Install (tor);
+  stack.Install (receiver);
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue (linkRate));
+  p2p.SetChannelAttribute ("Delay", StringValue ("10us"));
+  // Keep the device queue short, so that the packets are queued in the queue disc
+  p2p.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (1));
+
+  // Install the queue disc on the switch port towards the receiver before
+  // assigning the addresses, which would install the default one
+  NetDeviceContainer bottleneck = p2p.Install (tor, receiver);
+  TrafficControlHelper tch;
+  if (dctcp)
+    {
+      tch.SetRootQueueDisc ("ns3::RedQueueDisc",
+                            "StepMarking", BooleanValue (true),
+                            "MinTh", DoubleValue (k),
+                            "MaxTh", DoubleValue (bufferSize),
+                            "QueueLimit", UintegerValue (bufferSize),
+                            "LinkBandwidth", DataRateValue (rate),
+                            "LinkDelay", StringValue ("10us"));
+    }
+  else
+    {
+      tch.SetRootQueueDisc ("ns3::PfifoFastQueueDisc", "Limit", UintegerValue (bufferSize));
+    }
+  QueueDiscContainer qdiscs = tch.Install (bottleneck.Get (0));
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.2.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer receiverIf = address.Assign (bottleneck);
+
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  for (uint32_t i = 0; i < nSenders; ++i)
+    {
+      address.Assign (p2p.Install (senders.Get (i), tor));
+      address.NewNetwork ();
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  uint16_t port = 5000;
+  PacketSinkHelper sinkHelper ("ns3::TcpSocketFactory",
+                               InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinkApp = sinkHelper.Install (receiver);
+  sinkApp.Start (Seconds (0.0));
+  sinkApp.Stop (Seconds (simulationTime));
+
+  BulkSendHelper source ("ns3::TcpSocketFactory",
+                         InetSocketAddress (receiverIf.GetAddress (1), port));
+  ApplicationContainer sourceApps = source.Install (senders);
+  sourceApps.Start (Seconds (0.0));
+  sourceApps.Stop (Seconds (simulationTime));
+
+  // Skip the first slow start before sampling the queue
+  Time warmup = Seconds (simulationTime / 10);
+  g_queueSamples.clear ();
+  Simulator::Schedule (warmup, &SampleQueue, qdiscs.Get (0), MicroSeconds (10));
+
+  Simulator::Stop (Seconds (simulationTime));
+  Simulator::Run ();
+
+  uint64_t rxBytes = DynamicCast<PacketSink> (sinkApp.Get (0))->GetTotalRx ();
+
+  double sumDelay = 0;
+  std::vector<double> delays;
+  delays.reserve (g_queueSamples.size ());
+  for (std::vector<uint32_t>::const_iterator it = g_queueSamples.begin ();
+       it != g_queueSamples.end (); ++it)
+    {
+      double delay = rate.CalculateBytesTxTime (*it).GetMicroSeconds ();
+      delays.push_back (delay);
+      sumDelay += delay;
+    }
+  std::sort (delays.begin (), delays.end ());
+
+  std::cout << "*** " << (dctcp ? "DCTCP, RED step marking" : "NewReno, drop tail")
+            << " (" << nSenders << " senders) ***" << std::endl;
+  std::cout << "  Goodput: " << rxBytes * 8 / simulationTime / 1e6 << " Mbit/s" << std::endl;
+  if (!delays.empty ())
+    {
+      std::cout << "  Queueing delay: average " << sumDelay / delays.size () << " us, "
+                << "99th percentile " << delays[delays.size () * 99 / 100] << " us" << std::endl;
+    }
+  std::cout << "  Switch queue disc:" << TrafficControlHelper::GetStats (qdiscs) << std::endl;
+
+  Simulator::Destroy ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nSenders = 8;
+  uint32_t bufferSize = 250;
+  uint32_t k = 20;
+  double simulationTime = 0.5;
+
+  CommandLine cmd;
+  cmd.AddValue ("nSenders", "Number of senders", nSenders);
+  cmd.AddValue ("bufferSize", "Packets the switch port can hold", bufferSize);
+  cmd.AddValue ("k", "DCTCP marking threshold, in packets", k);
+  cmd.AddValue ("simulationTime", "Duration of each scenario, in seconds", simulationTime);
+  cmd.Parse (argc, argv);
+
+  RunScenario (false, nSenders, bufferSize, k, simulationTime);
+  RunScenario (true, nSenders, bufferSize, k, simulationTime);
+
+  return 0;
+}
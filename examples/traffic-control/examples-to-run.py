@@ -9,6 +9,7 @@
 # See test.py for more information.
 cpp_examples = [
     ("traffic-control", "True", "True"),
+    ("traffic-control --queueLimits=1", "True", "True"),
 ]
 
 # A list of Python examples to run in order to ensure that they remain
@@ -71,6 +71,11 @@
 // so that the standing queues build in the traffic control layer where
 // they can be managed by advanced queue discs rather than in the 
 // device layer.
+//
+// Alternatively, the device queue can be kept large (100 packets) and the
+// amount of data it holds can be dynamically limited by Byte Queue Limits
+// (BQL), by running the example with --queueLimits=1. In this case, the
+// device queue holds just the packets needed to keep the link busy.
 
 using namespace ns3;
 
@@ -94,9 +99,11 @@ main (int argc, char *argv[])
   double simulationTime = 10; //seconds
   std::string transportProt = "Tcp";
   std::string socketType;
+  bool queueLimits = false;
 
   CommandLine cmd;
   cmd.AddValue ("transportProt", "Transport protocol to use: Tcp, Udp", transportProt);
+  cmd.AddValue ("queueLimits", "Enable Byte Queue Limits on the device", queueLimits);
   cmd.Parse (argc, argv);
 
   if (transportProt.compare ("Tcp") == 0)
@@ -114,7 +121,8 @@ main (int argc, char *argv[])
   PointToPointHelper pointToPoint;
   pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
   pointToPoint.SetChannelAttribute ("Delay", StringValue ("2ms"));
-  pointToPoint.SetQueue ("ns3::DropTailQueue", "Mode", StringValue ("QUEUE_MODE_PACKETS"), "MaxPackets", UintegerValue (1));
+  pointToPoint.SetQueue ("ns3::DropTailQueue", "Mode", StringValue ("QUEUE_MODE_PACKETS"),
+                         "MaxPackets", UintegerValue (queueLimits ? 100 : 1));
 
   NetDeviceContainer devices;
   devices = pointToPoint.Install (nodes);
@@ -126,6 +134,10 @@ main (int argc, char *argv[])
   uint16_t handle = tch.SetRootQueueDisc ("ns3::RedQueueDisc");
   // Add the internal queue used by Red
   tch.AddInternalQueues (handle, 1, "ns3::DropTailQueue", "MaxPackets", UintegerValue (10000));
+  if (queueLimits)
+    {
+      tch.SetQueueLimits ("ns3::DynamicQueueLimits");
+    }
   QueueDiscContainer qdiscs = tch.Install (devices);
 
   Ptr<QueueDisc> q = qdiscs.Get (1);
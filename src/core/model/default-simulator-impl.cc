@@ -25,10 +25,26 @@
 
 #include "ptr.h"
 #include "pointer.h"
+#include "uinteger.h"
+#include "double.h"
+#include "boolean.h"
+#include "string.h"
+#include "trace-source-accessor.h"
 #include "assert.h"
 #include "log.h"
 
 #include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <typeinfo>
+#include <vector>
+#include <time.h>
+#if (__GNUC__ >= 3)
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
 
 
 /**
@@ -46,6 +62,129 @@ NS_LOG_COMPONENT_DEFINE ("DefaultSimulatorImpl");
 
 NS_OBJECT_ENSURE_REGISTERED (DefaultSimulatorImpl);
 
+namespace {
+
+/**
+ * \ingroup simulator
+ * Read the processor cycle counter, or a monotonic clock in
+ * nanoseconds on processors without one.
+ * \returns The current value of the counter.
+ */
+inline uint64_t
+ReadCycleCounter (void)
+{
+#if defined (__i386__) || defined (__x86_64__)
+  uint32_t lo, hi;
+  __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+  return (static_cast<uint64_t> (hi) << 32) | lo;
+#else
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t> (ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/**
+ * \ingroup simulator
+ * \param [in] name A type name, as returned by std::type_info::name().
+ * \returns The demangled type name.
+ */
+std::string
+DemangleTypeName (const char *name)
+{
+#if (__GNUC__ >= 3)
+  int status;
+  char *demangled = abi::__cxa_demangle (name, NULL, NULL, &status);
+  if (status == 0)
+    {
+      std::string ret = demangled;
+      std::free (demangled);
+      return ret;
+    }
+#endif
+  return name;
+}
+
+/**
+ * \ingroup simulator
+ * \param [in] context An event context.
+ * \returns The label of \p context in the profile.
+ */
+std::string
+GetContextLabel (uint32_t context)
+{
+  if (context == Simulator::NO_CONTEXT)
+    {
+      return "global";
+    }
+  std::ostringstream oss;
+  oss << "context " << context;
+  return oss.str ();
+}
+
+/**
+ * \ingroup simulator
+ * A line of the profile report: a label and its cost.
+ */
+struct ProfileLine
+{
+  /** Constructor. */
+  ProfileLine ()
+    : cycles (0),
+      count (0)
+  {
+  }
+  /** The type or context label. */
+  std::string label;
+  /** Number of cycles spent. */
+  uint64_t cycles;
+  /** Number of events executed. */
+  uint64_t count;
+};
+
+/**
+ * \ingroup simulator
+ * Compare two profile lines, sorting the most expensive first.
+ * \param [in] a The first line.
+ * \param [in] b The second line.
+ * \returns \c true if \p a is more expensive than \p b.
+ */
+bool
+IsMoreExpensive (const ProfileLine &a, const ProfileLine &b)
+{
+  return a.cycles > b.cycles;
+}
+
+/**
+ * \ingroup simulator
+ * Sort and print a section of the profile report.
+ * \param [in] os The output stream.
+ * \param [in] title The title of the section.
+ * \param [in] lines The lines of the section.
+ * \param [in] total The total number of cycles of the profile.
+ */
+void
+WriteProfileSection (std::ostream &os, const std::string &title,
+                     std::vector<ProfileLine> lines, uint64_t total)
+{
+  std::sort (lines.begin (), lines.end (), IsMoreExpensive);
+  os << std::endl << title << std::endl
+     << std::setw (16) << "cycles" << std::setw (8) << "%"
+     << std::setw (12) << "events" << std::setw (12) << "cycles/ev"
+     << "  name" << std::endl;
+  for (std::vector<ProfileLine>::const_iterator i = lines.begin (); i != lines.end (); ++i)
+    {
+      os << std::setw (16) << i->cycles
+         << std::setw (8) << std::fixed << std::setprecision (2)
+         << (total > 0 ? 100.0 * i->cycles / total : 0.0)
+         << std::setw (12) << i->count
+         << std::setw (12) << (i->count > 0 ? i->cycles / i->count : 0)
+         << "  " << i->label << std::endl;
+    }
+}
+
+} // unnamed namespace
+
 TypeId
 DefaultSimulatorImpl::GetTypeId (void)
 {
@@ -53,6 +192,38 @@ DefaultSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Core")
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("CompactionMinimum",
+                   "The minimum number of cancelled events in the queue "
+                   "before it is compacted.",
+                   UintegerValue (10000),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::m_compactionMinimum),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("CompactionRatio",
+                   "The minimum fraction of cancelled events in the queue "
+                   "before it is compacted.  Values above 1 disable compaction.",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&DefaultSimulatorImpl::m_compactionRatio),
+                   MakeDoubleChecker<double> (0))
+    .AddTraceSource ("CancelledEvents",
+                     "Number of cancelled events still in the queue.",
+                     MakeTraceSourceAccessor (&DefaultSimulatorImpl::m_cancelledEvents),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("Compaction",
+                     "The queue has been rebuilt without its cancelled events.",
+                     MakeTraceSourceAccessor (&DefaultSimulatorImpl::m_compactionTrace),
+                     "ns3::DefaultSimulatorImpl::CompactionTracedCallback")
+    .AddAttribute ("EnableProfiling",
+                   "Measure the cost of the events per event type and per "
+                   "context, and write it out at Simulator::Destroy.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DefaultSimulatorImpl::m_profiling),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ProfilePrefix",
+                   "The name prefix of the profile report (.txt) and "
+                   "folded stack (.folded) files.",
+                   StringValue ("simulator-profile"),
+                   MakeStringAccessor (&DefaultSimulatorImpl::m_profilePrefix),
+                   MakeStringChecker ())
   ;
   return tid;
 }
@@ -71,7 +242,8 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
-  m_eventsWithContextEmpty = true;
+  m_cancelledEvents = 0;
+  m_profiling = false;
   m_main = SystemThread::Self();
 }
 
@@ -98,6 +270,22 @@ void
 DefaultSimulatorImpl::Destroy ()
 {
   NS_LOG_FUNCTION (this);
+  if (m_profiling && !m_profile.empty ())
+    {
+      std::string reportName = m_profilePrefix + ".txt";
+      std::string foldedName = m_profilePrefix + ".folded";
+      std::ofstream report (reportName.c_str ());
+      std::ofstream folded (foldedName.c_str ());
+      if (!report.is_open () || !folded.is_open ())
+        {
+          NS_LOG_WARN ("Unable to write the event profile to " << m_profilePrefix);
+        }
+      else
+        {
+          WriteProfile (report, folded);
+        }
+      m_profile.clear ();
+    }
   while (!m_destroyEvents.empty ()) 
     {
       Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
@@ -115,6 +303,7 @@ DefaultSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
 {
   NS_LOG_FUNCTION (this << schedulerFactory);
   Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+  m_schedulerFactory = schedulerFactory;
 
   if (m_events != 0)
     {
@@ -146,10 +335,138 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
-  next.impl->Invoke ();
+  if (next.impl->IsCancelled ())
+    {
+      // Every event of the queue is cancelled through Cancel, which
+      // counts it once.
+      NS_ASSERT (m_cancelledEvents.Get () > 0);
+      m_cancelledEvents--;
+    }
+  else if (m_profiling)
+    {
+      InvokeProfiled (next);
+    }
+  else
+    {
+      next.impl->Invoke ();
+    }
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
+
+  if (m_cancelledEvents.Get () >= m_compactionMinimum
+      && m_cancelledEvents.Get () >= m_compactionRatio * m_unscheduledEvents)
+    {
+      Compact ();
+    }
+}
+
+void
+DefaultSimulatorImpl::InvokeProfiled (const Scheduler::Event &next)
+{
+  // Keep the type name lookup out of the measured section.
+  const char *type = typeid (*next.impl).name ();
+  uint64_t start = ReadCycleCounter ();
+  next.impl->Invoke ();
+  uint64_t cycles = ReadCycleCounter () - start;
+
+  std::pair<Profile::iterator, bool> i =
+    m_profile.insert (std::make_pair (ProfileKey (next.key.m_context, type), ProfileEntry ()));
+  i.first->second.cycles += cycles;
+  i.first->second.count++;
+}
+
+void
+DefaultSimulatorImpl::WriteProfile (std::ostream &report, std::ostream &folded) const
+{
+  NS_LOG_FUNCTION (this);
+  // Identical types may have several type_info names when they are
+  // instantiated in several libraries, so merge them by demangled name.
+  std::map<const char *, std::string> names;
+  std::map<std::string, ProfileLine> byType;
+  std::map<uint32_t, ProfileLine> byContext;
+  std::map<std::string, uint64_t> stacks;
+  uint64_t total = 0;
+  uint64_t count = 0;
+  for (Profile::const_iterator i = m_profile.begin (); i != m_profile.end (); ++i)
+    {
+      uint32_t context = i->first.first;
+      const char *type = i->first.second;
+      std::map<const char *, std::string>::iterator name = names.find (type);
+      if (name == names.end ())
+        {
+          name = names.insert (std::make_pair (type, DemangleTypeName (type))).first;
+        }
+      ProfileLine &t = byType[name->second];
+      t.label = name->second;
+      t.cycles += i->second.cycles;
+      t.count += i->second.count;
+      ProfileLine &c = byContext[context];
+      c.label = GetContextLabel (context);
+      c.cycles += i->second.cycles;
+      c.count += i->second.count;
+      stacks[c.label + ";" + t.label] += i->second.cycles;
+      total += i->second.cycles;
+      count += i->second.count;
+    }
+
+  std::vector<ProfileLine> lines;
+  for (std::map<std::string, ProfileLine>::const_iterator i = byType.begin (); i != byType.end (); ++i)
+    {
+      lines.push_back (i->second);
+    }
+  report << "Total: " << total << " cycles in " << count << " events" << std::endl;
+  WriteProfileSection (report, "By event type:", lines, total);
+  lines.clear ();
+  for (std::map<uint32_t, ProfileLine>::const_iterator i = byContext.begin (); i != byContext.end (); ++i)
+    {
+      lines.push_back (i->second);
+    }
+  WriteProfileSection (report, "By context:", lines, total);
+
+  for (std::map<std::string, uint64_t>::const_iterator i = stacks.begin (); i != stacks.end (); ++i)
+    {
+      folded << i->first << " " << i->second << std::endl;
+    }
+}
+
+void
+DefaultSimulatorImpl::Compact (void)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  uint32_t removed = 0;
+  while (!m_events->IsEmpty ())
+    {
+      Scheduler::Event next = m_events->RemoveNext ();
+      if (next.impl->IsCancelled ())
+        {
+          next.impl->Unref ();
+          removed++;
+        }
+      else
+        {
+          scheduler->Insert (next);
+        }
+    }
+  NS_ASSERT (removed == m_cancelledEvents.Get ());
+  m_events = scheduler;
+  m_unscheduledEvents -= removed;
+  m_cancelledEvents = 0;
+  NS_LOG_LOGIC ("removed " << removed << " cancelled events, kept " << m_unscheduledEvents);
+  m_compactionTrace (m_unscheduledEvents, removed);
+}
+
+uint32_t
+DefaultSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_unscheduledEvents - m_cancelledEvents.Get ();
+}
+
+uint32_t
+DefaultSimulatorImpl::GetCancelledEventCount (void) const
+{
+  return m_cancelledEvents;
 }
 
 bool 
@@ -161,30 +478,22 @@ DefaultSimulatorImpl::IsFinished (void) const
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  if (m_eventsWithContext.IsEmpty ())
     {
       return;
     }
 
-  // swap queues
-  EventsWithContext eventsWithContext;
-  {
-    CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
-  }
-  while (!eventsWithContext.empty ())
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
     {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
-       Scheduler::Event ev;
-       ev.impl = event.event;
-       ev.key.m_ts = m_currentTs + event.timestamp;
-       ev.key.m_context = event.context;
-       ev.key.m_uid = m_uid;
-       m_uid++;
-       m_unscheduledEvents++;
-       m_events->Insert (ev);
+      Scheduler::Event ev;
+      ev.impl = event.event;
+      ev.key.m_ts = m_currentTs + event.timestamp;
+      ev.key.m_context = event.context;
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
     }
 }
 
@@ -269,11 +578,7 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
       // Current time added in ProcessEventsWithContext()
       ev.timestamp = delay.GetTimeStep ();
       ev.event = event;
-      {
-        CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
-      }
+      m_eventsWithContext.Push (ev);
     }
 }
 
@@ -363,6 +668,12 @@ DefaultSimulatorImpl::Cancel (const EventId &id)
   if (!IsExpired (id))
     {
       id.PeekEventImpl ()->Cancel ();
+      // Only count the events of the queue which were live until now:
+      // events already cancelled or executed are expired.
+      if (id.GetUid () != 2)
+        {
+          m_cancelledEvents++;
+        }
     }
 }
 
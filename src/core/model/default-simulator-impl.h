@@ -26,10 +26,17 @@
 #include "event-impl.h"
 #include "system-thread.h"
 #include "ns3/system-mutex.h"
+#include "mpsc-ring.h"
+#include "object-factory.h"
+#include "traced-value.h"
+#include "traced-callback.h"
 
 #include "ptr.h"
 
 #include <list>
+#include <map>
+#include <ostream>
+#include <string>
 
 /**
  * \file
@@ -43,6 +50,24 @@ namespace ns3 {
  * \ingroup simulator
  *
  * The default single process simulator implementation.
+ *
+ * Cancelled events stay in the event queue until their timestamp is
+ * reached.  When many more events are cancelled than executed, as is
+ * the case with most protocol timers, these dead entries slow down
+ * the scheduler, so they are counted and, once they exceed both the
+ * CompactionMinimum and the CompactionRatio of the queue size, the
+ * queue is rebuilt with the live events only.  The events of the
+ * queue must therefore be cancelled through Simulator::Cancel (or
+ * EventId::Cancel) rather than through EventImpl::Cancel, which is not
+ * accounted.
+ *
+ * When the EnableProfiling attribute is set, the cost of every event,
+ * measured with the processor cycle counter (or a monotonic clock in
+ * nanoseconds where there is none), is attributed to the type of its
+ * EventImpl and to its context.  At Simulator::Destroy() a report
+ * sorted by decreasing cost is written to \<ProfilePrefix\>.txt and
+ * the same data, in the folded stack format understood by the
+ * FlameGraph tools, is written to \<ProfilePrefix\>.folded.
  */
 class DefaultSimulatorImpl : public SimulatorImpl
 {
@@ -78,6 +103,34 @@ public:
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
 
+  /**
+   * \returns The number of events in the queue which have not been
+   * cancelled.
+   */
+  uint32_t GetLiveEventCount (void) const;
+  /**
+   * \returns The number of cancelled events still in the queue.
+   */
+  uint32_t GetCancelledEventCount (void) const;
+
+  /**
+   * TracedCallback signature for queue compaction events.
+   *
+   * \param [in] live The number of events kept in the queue.
+   * \param [in] removed The number of cancelled events removed.
+   */
+  typedef void (* CompactionTracedCallback)(uint32_t live, uint32_t removed);
+
+  /**
+   * Write the event profile collected so far.
+   *
+   * \param [in] report The stream receiving the cost per event type and
+   * per context, sorted by decreasing cost.
+   * \param [in] folded The stream receiving the cost of each
+   * (context, event type) pair in the folded stack format.
+   */
+  void WriteProfile (std::ostream &report, std::ostream &folded) const;
+
 private:
   virtual void DoDispose (void);
 
@@ -85,6 +138,13 @@ private:
   void ProcessOneEvent (void);
   /** Move events from a different context into the main event queue. */
   void ProcessEventsWithContext (void);
+  /** Rebuild the event queue without the cancelled events. */
+  void Compact (void);
+  /**
+   * Invoke an event and account its cost in the event profile.
+   * \param [in] next The event to invoke.
+   */
+  void InvokeProfiled (const Scheduler::Event &next);
  
   /** Wrap an event with its execution context. */
   struct EventWithContext {
@@ -95,17 +155,8 @@ private:
     /** The event implementation. */
     EventImpl *event;
   };
-  /** Container type for the events from a different context. */
-  typedef std::list<struct EventWithContext> EventsWithContext;
-  /** The container of events from a different context. */
-  EventsWithContext m_eventsWithContext;
-  /**
-   * Flag \c true if all events with context have been moved to the
-   * primary event queue.
-   */
-  bool m_eventsWithContextEmpty;
-  /** Mutex to control access to the list of events with context. */
-  SystemMutex m_eventsWithContextMutex;
+  /** The events from a different thread, in scheduling order. */
+  MpscRing<struct EventWithContext> m_eventsWithContext;
 
   /** Container type for the events to run at Simulator::Destroy() */
   typedef std::list<EventId> DestroyEvents;
@@ -115,6 +166,35 @@ private:
   bool m_stop;
   /** The event priority queue. */
   Ptr<Scheduler> m_events;
+  /** The factory used to create m_events. */
+  ObjectFactory m_schedulerFactory;
+  /** Number of cancelled events still in m_events. */
+  TracedValue<uint32_t> m_cancelledEvents;
+  /** Minimum number of cancelled events to trigger a compaction. */
+  uint32_t m_compactionMinimum;
+  /** Minimum fraction of cancelled events to trigger a compaction. */
+  double m_compactionRatio;
+  /** Traced callback: fired after each compaction of the queue. */
+  TracedCallback<uint32_t, uint32_t> m_compactionTrace;
+
+  /** The cost accumulated by one entry of the event profile. */
+  struct ProfileEntry
+  {
+    /** Number of cycles spent in the events. */
+    uint64_t cycles;
+    /** Number of events executed. */
+    uint64_t count;
+  };
+  /** Profile entry key: the event context and the EventImpl type name. */
+  typedef std::pair<uint32_t, const char *> ProfileKey;
+  /** Container type for the event profile. */
+  typedef std::map<ProfileKey, ProfileEntry> Profile;
+  /** The event profile. */
+  Profile m_profile;
+  /** Flag \c true if the event profile is collected. */
+  bool m_profiling;
+  /** Name prefix of the profile files written at Destroy. */
+  std::string m_profilePrefix;
 
   /** Next event unique id. */
   uint32_t m_uid;
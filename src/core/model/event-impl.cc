@@ -20,6 +20,12 @@
 
 #include "event-impl.h"
 #include "log.h"
+#include "ns3/core-config.h"
+
+#include <new>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
 
 /**
  * \file
@@ -31,6 +37,182 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+namespace {
+
+/** Granularity of the pool size classes, in bytes. */
+const std::size_t POOL_GRANULARITY = 16;
+/** Number of size classes: events up to 256 bytes are pooled. */
+const std::size_t POOL_CLASSES = 16;
+/** Maximum number of free blocks cached in a size class. */
+const uint32_t POOL_MAX_CACHED = 4096;
+
+/** A free block, linked in the list of its size class. */
+struct FreeBlock
+{
+  FreeBlock *next; //!< Next free block of the same size class.
+};
+
+/** Whether the pool is used, accessed atomically. */
+bool g_poolEnabled = true;
+/** The free lists of the calling thread, one per size class. */
+__thread FreeBlock *g_freeLists[POOL_CLASSES];
+/** Number of blocks in each free list of the calling thread. */
+__thread uint32_t g_freeCounts[POOL_CLASSES];
+/** Number of events allocated by the calling thread. */
+__thread uint64_t g_allocations;
+/** Number of allocations served from a free list. */
+__thread uint64_t g_hits;
+/** Number of events deleted by the calling thread. */
+__thread uint64_t g_deallocations;
+/** Whether the pool of the main thread has been released at exit. */
+bool g_destroyed = false;
+
+#ifdef HAVE_PTHREAD_H
+/** Whether the calling thread releases its pool when it exits. */
+__thread bool g_releaseAtExit;
+/** Key whose destructor releases the pool of an exiting thread. */
+pthread_key_t g_releaseKey;
+/** Guard of the creation of g_releaseKey. */
+pthread_once_t g_releaseKeyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Release the pool of an exiting thread.
+ * \param arg unused
+ */
+void
+ReleaseAtExit (void *arg)
+{
+  EventImpl::ReleasePool ();
+}
+
+/** Create g_releaseKey. */
+void
+CreateReleaseKey (void)
+{
+  pthread_key_create (&g_releaseKey, &ReleaseAtExit);
+}
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * \brief Release the pool of the main thread when the program exits
+ */
+struct LocalStaticDestructor
+{
+  ~LocalStaticDestructor ()
+  {
+    EventImpl::ReleasePool ();
+    g_destroyed = true;
+  }
+} g_localStaticDestructor; //!< Local static destructor
+
+/**
+ * \returns \c true if the pool is used.
+ */
+inline bool
+IsPoolEnabled (void)
+{
+  return __atomic_load_n (&g_poolEnabled, __ATOMIC_RELAXED);
+}
+
+/**
+ * \param [in] size The size of an event.
+ * \returns The size class of \p size.
+ */
+inline std::size_t
+GetSizeClass (std::size_t size)
+{
+  return (size - 1) / POOL_GRANULARITY;
+}
+
+} // unnamed namespace
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  g_allocations++;
+  std::size_t sizeClass = GetSizeClass (size);
+  if (sizeClass >= POOL_CLASSES)
+    {
+      return ::operator new (size);
+    }
+  FreeBlock *block = g_freeLists[sizeClass];
+  if (block != 0 && IsPoolEnabled ())
+    {
+      g_freeLists[sizeClass] = block->next;
+      g_freeCounts[sizeClass]--;
+      g_hits++;
+      return block;
+    }
+  // allocate the full size class, so that the block can be reused by
+  // any event of the same class, even if the pool is enabled later.
+  return ::operator new ((sizeClass + 1) * POOL_GRANULARITY);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  g_deallocations++;
+  std::size_t sizeClass = GetSizeClass (size);
+  if (g_destroyed
+      || !IsPoolEnabled ()
+      || sizeClass >= POOL_CLASSES
+      || g_freeCounts[sizeClass] >= POOL_MAX_CACHED)
+    {
+      ::operator delete (p);
+      return;
+    }
+#ifdef HAVE_PTHREAD_H
+  if (!g_releaseAtExit)
+    {
+      pthread_once (&g_releaseKeyOnce, &CreateReleaseKey);
+      pthread_setspecific (g_releaseKey, &g_releaseAtExit);
+      g_releaseAtExit = true;
+    }
+#endif /* HAVE_PTHREAD_H */
+  FreeBlock *block = static_cast<FreeBlock *> (p);
+  block->next = g_freeLists[sizeClass];
+  g_freeLists[sizeClass] = block;
+  g_freeCounts[sizeClass]++;
+}
+
+EventImpl::PoolStatistics
+EventImpl::GetPoolStatistics (void)
+{
+  PoolStatistics stats;
+  stats.allocations = g_allocations;
+  stats.hits = g_hits;
+  stats.deallocations = g_deallocations;
+  stats.cached = 0;
+  for (std::size_t i = 0; i < POOL_CLASSES; ++i)
+    {
+      stats.cached += g_freeCounts[i];
+    }
+  return stats;
+}
+
+void
+EventImpl::ReleasePool (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  for (std::size_t i = 0; i < POOL_CLASSES; ++i)
+    {
+      while (g_freeLists[i] != 0)
+        {
+          FreeBlock *block = g_freeLists[i];
+          g_freeLists[i] = block->next;
+          ::operator delete (block);
+        }
+      g_freeCounts[i] = 0;
+    }
+}
+
+void
+EventImpl::EnablePool (bool enable)
+{
+  NS_LOG_FUNCTION (enable);
+  __atomic_store_n (&g_poolEnabled, enable, __ATOMIC_RELAXED);
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -40,6 +41,12 @@ namespace ns3 {
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Instances are allocated from a per-thread pool of free blocks,
+ * segregated by size class, instead of going through malloc and free
+ * for every event: the memory of an event deleted by its last Unref()
+ * is reused by the next event of a similar size created by the same
+ * thread.  Events larger than the biggest size class bypass the pool.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -66,6 +73,44 @@ public:
    */
   bool IsCancelled (void);
 
+  /** Allocation statistics of the pool of the calling thread. */
+  struct PoolStatistics
+  {
+    uint64_t allocations;   //!< Number of events allocated.
+    uint64_t hits;          //!< Number of allocations served by the pool.
+    uint64_t deallocations; //!< Number of events deleted.
+    uint64_t cached;        //!< Number of free blocks currently in the pool.
+  };
+  /**
+   * \returns The allocation statistics of the calling thread.
+   */
+  static PoolStatistics GetPoolStatistics (void);
+  /**
+   * Enable or disable the pool, for all the threads.  When disabled,
+   * events are allocated and freed with the global operators.
+   * \param [in] enable \c true to enable the pool (the default).
+   */
+  static void EnablePool (bool enable);
+  /**
+   * Free all the blocks cached in the pool of the calling thread.
+   * This is called by Simulator::Destroy, and when a thread which
+   * cached blocks exits.
+   */
+  static void ReleasePool (void);
+
+  /**
+   * Allocate an event from the pool of the calling thread.
+   * \param [in] size The size of the concrete event class.
+   * \returns The allocated memory.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Return an event to the pool of the calling thread.
+   * \param [in] p The memory to release.
+   * \param [in] size The size of the concrete event class.
+   */
+  static void operator delete (void *p, std::size_t size);
+
 protected:
   /**
    * Implementation for Invoke().
@@ -0,0 +1,330 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include <algorithm>
+#include "assert.h"
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+namespace {
+
+/**
+ * \ingroup scheduler
+ * Compare two events, sorting the earliest one last.
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \returns \c true if \p a is later than \p b.
+ */
+bool
+IsLater (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return a.key > b.key;
+}
+
+} // unnamed namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topStart (0),
+    m_topMin (~0ULL),
+    m_topMax (0),
+    m_rungs (MAX_RUNGS),
+    m_nRungs (0),
+    m_qSize (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::GetCurrentStart (uint32_t rung) const
+{
+  const Rung &r = m_rungs[rung];
+  return r.start + r.current * r.width;
+}
+
+void
+LadderScheduler::SpawnRung (Bucket &events, uint64_t start, uint64_t end)
+{
+  NS_LOG_FUNCTION (this << events.size () << start << end);
+  NS_ASSERT (m_nRungs < MAX_RUNGS);
+  NS_ASSERT (end > start);
+
+  uint64_t range = end - start;
+  uint64_t width = std::max<uint64_t> (1, (range + events.size () - 1) / events.size ());
+  uint32_t nBuckets = (range + width - 1) / width;
+
+  Rung &rung = m_rungs[m_nRungs];
+  rung.buckets.resize (nBuckets);
+  rung.start = start;
+  rung.width = width;
+  rung.current = 0;
+  rung.count = events.size ();
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      uint64_t bucket = (i->key.m_ts - start) / width;
+      NS_ASSERT (bucket < nBuckets);
+      rung.buckets[bucket].push_back (*i);
+    }
+  events.clear ();
+  m_nRungs++;
+}
+
+void
+LadderScheduler::FillBottom (Bucket &events)
+{
+  NS_LOG_FUNCTION (this << events.size ());
+  NS_ASSERT (m_bottom.empty ());
+  // swap rather than copy, so that the storage of both is recycled
+  m_bottom.swap (events);
+  std::sort (m_bottom.begin (), m_bottom.end (), IsLater);
+}
+
+void
+LadderScheduler::InsertBottom (const Scheduler::Event &ev)
+{
+  Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, IsLater);
+  m_bottom.insert (i, ev);
+  if (m_bottom.size () > THRESHOLD
+      && m_nRungs < MAX_RUNGS
+      && m_bottom.front ().key.m_ts > m_bottom.back ().key.m_ts)
+    {
+      // Bottom has grown too large to keep sorted: turn it into a rung
+      // covering everything up to the rung above it.
+      uint64_t start = m_bottom.back ().key.m_ts;
+      uint64_t end = m_nRungs > 0 ? GetCurrentStart (m_nRungs - 1) : m_topStart;
+      SpawnRung (m_bottom, start, end);
+      RefillBottom ();
+    }
+}
+
+void
+LadderScheduler::RefillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_bottom.empty ());
+  NS_ASSERT (m_qSize > 0);
+
+  while (true)
+    {
+      if (m_nRungs == 0)
+        {
+          // start a new epoch with the content of Top.
+          NS_ASSERT (!m_top.empty ());
+          m_topStart = m_topMax + 1;
+          if (m_top.size () > THRESHOLD && m_topMax > m_topMin)
+            {
+              SpawnRung (m_top, m_topMin, m_topStart);
+            }
+          else
+            {
+              FillBottom (m_top);
+            }
+          m_topMin = ~0ULL;
+          m_topMax = 0;
+          if (!m_bottom.empty ())
+            {
+              return;
+            }
+        }
+
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.count == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      Bucket &bucket = rung.buckets[rung.current];
+      rung.count -= bucket.size ();
+      rung.current++;
+      if (bucket.size () > THRESHOLD
+          && m_nRungs < MAX_RUNGS
+          && rung.width > 1)
+        {
+          uint64_t end = GetCurrentStart (m_nRungs - 1);
+          SpawnRung (bucket, end - rung.width, end);
+        }
+      else
+        {
+          FillBottom (bucket);
+          return;
+        }
+    }
+}
+
+bool
+LadderScheduler::RemoveFromBucket (Bucket &events, const Scheduler::Event &ev)
+{
+  for (Bucket::iterator i = events.begin (); i != events.end (); ++i)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (ev.impl == i->impl);
+          *i = events.back ();
+          events.pop_back ();
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+
+  if (m_qSize == 0)
+    {
+      // An empty queue starts a new epoch, anchored at this event.
+      m_nRungs = 0;
+      m_topStart = ts + 1;
+      m_topMin = ~0ULL;
+      m_topMax = 0;
+      m_bottom.push_back (ev);
+      m_qSize = 1;
+      return;
+    }
+  m_qSize++;
+
+  if (ts >= m_topStart)
+    {
+      m_top.push_back (ev);
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+      return;
+    }
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      if (ts >= GetCurrentStart (i))
+        {
+          Rung &rung = m_rungs[i];
+          uint64_t bucket = (ts - rung.start) / rung.width;
+          NS_ASSERT (bucket < rung.buckets.size ());
+          rung.buckets[bucket].push_back (ev);
+          rung.count++;
+          return;
+        }
+    }
+  InsertBottom (ev);
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  return m_qSize == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+
+  Scheduler::Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_qSize--;
+  if (m_bottom.empty () && m_qSize > 0)
+    {
+      RefillBottom ();
+    }
+  NS_LOG_DEBUG ("remove " << ev.key.m_ts << ", " << ev.key.m_uid << ", " << ev.impl);
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+
+  bool found = false;
+  if (ts >= m_topStart)
+    {
+      found = RemoveFromBucket (m_top, ev);
+    }
+  else
+    {
+      for (uint32_t i = 0; i < m_nRungs && !found; i++)
+        {
+          if (ts >= GetCurrentStart (i))
+            {
+              Rung &rung = m_rungs[i];
+              found = RemoveFromBucket (rung.buckets[(ts - rung.start) / rung.width], ev);
+              NS_ASSERT (found);
+              rung.count--;
+            }
+        }
+      if (!found)
+        {
+          Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, IsLater);
+          if (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid)
+            {
+              NS_ASSERT (ev.impl == i->impl);
+              m_bottom.erase (i);
+              found = true;
+            }
+        }
+    }
+  NS_ASSERT (found);
+  m_qSize--;
+  if (m_bottom.empty () && m_qSize > 0)
+    {
+      RefillBottom ();
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue described in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh and
+ * Ian Li-Jin Thng (ACM TOMACS, 2005).
+ *
+ * The queue is made of three tiers:
+ *   - Top, an unsorted list which receives all the events later than
+ *     the current epoch;
+ *   - the ladder, made of up to MAX_RUNGS rungs of buckets, each rung
+ *     spawned from a single overcrowded bucket of the rung above it;
+ *   - Bottom, a small sorted list from which events are dequeued.
+ *
+ * Events are only sorted once they reach Bottom, in groups of at most
+ * THRESHOLD events, and the bucket width of each rung is derived from
+ * the events it receives, so unlike the CalendarScheduler there is
+ * never a global rehash: bursts of events sharing close timestamps
+ * simply spawn a finer rung.  Insert and RemoveNext are O(1) amortized.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Maximum number of events sorted at once into Bottom. */
+  static const uint32_t THRESHOLD = 50;
+  /** Maximum number of rungs. */
+  static const uint32_t MAX_RUNGS = 8;
+
+  /** A bucket: an unsorted list of events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the ladder. */
+  struct Rung
+  {
+    /** The buckets. */
+    std::vector<Bucket> buckets;
+    /** Timestamp at the start of the first bucket. */
+    uint64_t start;
+    /** Duration of a bucket, in dimensionless time units. */
+    uint64_t width;
+    /** Index of the first bucket which has not been dequeued. */
+    uint32_t current;
+    /** Number of events in the rung. */
+    uint32_t count;
+  };
+
+  /**
+   * \param [in] rung The rung index.
+   * \returns The timestamp at the start of the current bucket of a rung.
+   */
+  inline uint64_t GetCurrentStart (uint32_t rung) const;
+  /**
+   * Create a new rung holding a set of events.
+   *
+   * \param [in] events The events to move to the new rung.
+   * \param [in] start The timestamp at the start of the rung.
+   * \param [in] end The timestamp at the end (excluded) of the rung.
+   */
+  void SpawnRung (Bucket &events, uint64_t start, uint64_t end);
+  /**
+   * Sort a set of events into Bottom.
+   *
+   * \param [in] events The events to move to Bottom.
+   */
+  void FillBottom (Bucket &events);
+  /**
+   * Insert an event into Bottom, keeping it sorted.
+   *
+   * \param [in] ev The new Event.
+   */
+  void InsertBottom (const Scheduler::Event &ev);
+  /** Move events from the ladder or from Top into Bottom. */
+  void RefillBottom (void);
+  /**
+   * Remove an event from an unsorted list.
+   *
+   * \param [in] events The list.
+   * \param [in] ev The event to remove.
+   * \returns \c true if the event was found in the list.
+   */
+  static bool RemoveFromBucket (Bucket &events, const Scheduler::Event &ev);
+
+  /** Top: the unsorted events later than the current epoch. */
+  Bucket m_top;
+  /** Events at or after this timestamp belong to Top. */
+  uint64_t m_topStart;
+  /** The earliest timestamp in Top. */
+  uint64_t m_topMin;
+  /** The latest timestamp in Top. */
+  uint64_t m_topMax;
+  /** The rungs, the finest one last. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** Bottom: sorted events, the earliest one last. */
+  Bucket m_bottom;
+  /** Number of events in queue. */
+  uint32_t m_qSize;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
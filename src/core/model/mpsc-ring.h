@@ -0,0 +1,272 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include "system-mutex.h"
+
+#include <list>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup thread
+ * Declaration and implementation of template class ns3::MpscRing.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup thread
+ *
+ * A multiple producer, single consumer FIFO queue.
+ *
+ * Items are stored in a bounded ring of cells, each tagged with a
+ * sequence number, so that producers only contend on an atomic
+ * increment of the tail index and the consumer does not need any
+ * read-modify-write operation at all (Vyukov's bounded queue).
+ *
+ * When the ring is full, producers fall back to a list protected by a
+ * mutex instead of blocking, and keep using it until the consumer has
+ * taken the list over, so that the items of every producer are
+ * always popped in the order they were pushed.
+ *
+ * Push() can be called from any thread; Pop() and IsEmpty() must
+ * only be called from a single consumer thread.
+ */
+template <typename T>
+class MpscRing
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] capacity The minimum number of items the ring can hold
+   * before producers fall back to the mutex-protected list.
+   */
+  explicit MpscRing (uint32_t capacity = 1024);
+
+  /**
+   * Append an item.  This never blocks, except on the fallback list
+   * mutex when the ring is full.
+   * \param [in] item The item.
+   */
+  void Push (const T &item);
+  /**
+   * Remove the oldest item.
+   * \param [out] item The item removed.
+   * \returns \c false if there was no item to remove.
+   */
+  bool Pop (T &item);
+  /**
+   * \returns \c true if no item has been pushed since the last Pop().
+   * An item being pushed concurrently may or may not be seen.
+   */
+  bool IsEmpty (void) const;
+
+private:
+  /** A cell of the ring. */
+  struct Cell
+  {
+    /**
+     * Equal to the position of the cell when it can be written, and to
+     * the position plus one once the item can be read.
+     */
+    uint32_t sequence;
+    /** The item. */
+    T item;
+  };
+
+  /**
+   * Append an item to the ring.
+   * \param [in] item The item.
+   * \returns \c false if the ring is full.
+   */
+  bool TryPush (const T &item);
+  /**
+   * Remove the oldest item of the ring.
+   * \param [out] item The item removed.
+   * \returns \c false if the ring is empty.
+   */
+  bool TryPop (T &item);
+
+  /** The cells of the ring. */
+  std::vector<Cell> m_cells;
+  /** The number of cells minus one. */
+  uint32_t m_mask;
+  /** Padding keeping m_tail in its own cache line. */
+  char m_pad0[64];
+  /** The position of the next cell to write, shared by the producers. */
+  uint32_t m_tail;
+  /** Padding keeping the consumer state off the m_tail cache line. */
+  char m_pad1[64];
+  /** The position of the next cell to read, private to the consumer. */
+  uint32_t m_head;
+  /** Flag \c true if m_overflow is not empty. */
+  bool m_overflowing;
+  /** Items pushed when the ring was full. */
+  std::list<T> m_overflow;
+  /** Mutex protecting m_overflow. */
+  SystemMutex m_overflowMutex;
+  /** Overflow items taken over by the consumer. */
+  std::list<T> m_drain;
+  /** Ring position before which the ring items precede m_drain. */
+  uint32_t m_drainStart;
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+MpscRing<T>::MpscRing (uint32_t capacity)
+  : m_tail (0),
+    m_head (0),
+    m_overflowing (false),
+    m_drainStart (0)
+{
+  uint32_t size = 2;
+  while (size < capacity)
+    {
+      size <<= 1;
+    }
+  m_cells.resize (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      m_cells[i].sequence = i;
+    }
+  m_mask = size - 1;
+}
+
+template <typename T>
+bool
+MpscRing<T>::TryPush (const T &item)
+{
+  uint32_t pos = __atomic_load_n (&m_tail, __ATOMIC_RELAXED);
+  Cell *cell;
+  while (true)
+    {
+      cell = &m_cells[pos & m_mask];
+      uint32_t seq = __atomic_load_n (&cell->sequence, __ATOMIC_ACQUIRE);
+      int32_t diff = static_cast<int32_t> (seq - pos);
+      if (diff == 0)
+        {
+          // the cell is free: claim it, or retry from the updated pos
+          if (__atomic_compare_exchange_n (&m_tail, &pos, pos + 1, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+              break;
+            }
+        }
+      else if (diff < 0)
+        {
+          // the cell still holds the item written one lap before
+          return false;
+        }
+      else
+        {
+          pos = __atomic_load_n (&m_tail, __ATOMIC_RELAXED);
+        }
+    }
+  cell->item = item;
+  __atomic_store_n (&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+template <typename T>
+bool
+MpscRing<T>::TryPop (T &item)
+{
+  Cell *cell = &m_cells[m_head & m_mask];
+  uint32_t seq = __atomic_load_n (&cell->sequence, __ATOMIC_ACQUIRE);
+  if (seq != m_head + 1)
+    {
+      return false;
+    }
+  item = cell->item;
+  __atomic_store_n (&cell->sequence, m_head + m_mask + 1, __ATOMIC_RELEASE);
+  m_head++;
+  return true;
+}
+
+template <typename T>
+void
+MpscRing<T>::Push (const T &item)
+{
+  if (!__atomic_load_n (&m_overflowing, __ATOMIC_ACQUIRE) && TryPush (item))
+    {
+      return;
+    }
+  CriticalSection cs (m_overflowMutex);
+  m_overflow.push_back (item);
+  __atomic_store_n (&m_overflowing, true, __ATOMIC_RELEASE);
+}
+
+template <typename T>
+bool
+MpscRing<T>::Pop (T &item)
+{
+  while (!m_drain.empty ())
+    {
+      if (static_cast<int32_t> (m_head - m_drainStart) < 0)
+        {
+          // Ring items claimed before the overflow was taken over come
+          // first: wait for their producer to finish writing them.
+          if (TryPop (item))
+            {
+              return true;
+            }
+          continue;
+        }
+      item = m_drain.front ();
+      m_drain.pop_front ();
+      return true;
+    }
+  if (TryPop (item))
+    {
+      return true;
+    }
+  if (!__atomic_load_n (&m_overflowing, __ATOMIC_ACQUIRE))
+    {
+      return false;
+    }
+  {
+    CriticalSection cs (m_overflowMutex);
+    m_drain.swap (m_overflow);
+    m_drainStart = __atomic_load_n (&m_tail, __ATOMIC_ACQUIRE);
+    __atomic_store_n (&m_overflowing, false, __ATOMIC_RELEASE);
+  }
+  return Pop (item);
+}
+
+template <typename T>
+bool
+MpscRing<T>::IsEmpty (void) const
+{
+  return m_drain.empty ()
+         && __atomic_load_n (&m_cells[m_head & m_mask].sequence, __ATOMIC_ACQUIRE) != m_head + 1
+         && !__atomic_load_n (&m_overflowing, __ATOMIC_ACQUIRE);
+}
+
+} // namespace ns3
+
+#endif /* MPSC_RING_H */
@@ -0,0 +1,1051 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "simulator.h"
+#include "multithreaded-simulator-impl.h"
+#include "scheduler.h"
+#include "event-impl.h"
+
+#include "ptr.h"
+#include "pointer.h"
+#include "uinteger.h"
+#include "object-ptr-container.h"
+#include "config.h"
+#include "assert.h"
+#include "fatal-error.h"
+#include "log.h"
+
+#include <algorithm>
+#include <map>
+#include <pthread.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Implementation of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the possibility
+// of causing recursions leading to stack overflow
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+/**
+ * \ingroup simulator
+ * Index plus one of the partition executed by the calling thread,
+ * zero when the calling thread is not executing a window.
+ */
+static __thread uint32_t g_partitionIndex = 0;
+
+/**
+ * \ingroup simulator
+ * The simulator whose parallel window the calling thread is executing,
+ * zero when the calling thread is not executing a window.
+ */
+static __thread const MultithreadedSimulatorImpl *g_window = 0;
+
+/**
+ * \ingroup simulator
+ * Find the group of a node, halving the paths on the way.
+ * \param [in,out] parent The parent of each node in its group.
+ * \param [in] node The node.
+ * \return The node representing the group of \p node.
+ */
+static uint32_t
+FindGroup (std::vector<uint32_t> &parent, uint32_t node)
+{
+  while (parent[node] != node)
+    {
+      parent[node] = parent[parent[node]];
+      node = parent[node];
+    }
+  return node;
+}
+
+/**
+ * \ingroup simulator
+ * A reusable barrier, implemented with pthread primitives.
+ */
+struct MultithreadedSimulatorImpl::BarrierPrivate
+{
+  /** Mutex protecting the barrier state. */
+  pthread_mutex_t mutex;
+  /** Condition signaled when the barrier opens. */
+  pthread_cond_t cond;
+  /** Number of threads which must arrive before the barrier opens. */
+  uint32_t threshold;
+  /** Number of threads which arrived. */
+  uint32_t count;
+  /** Incremented each time the barrier opens. */
+  uint32_t generation;
+};
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Core")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("ThreadCount",
+                   "The number of threads (and of event partitions). "
+                   "Zero means one per online processor.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_threadCount),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Lookahead",
+                   "The minimum delay of an event scheduled across partitions. "
+                   "Zero means the minimum positive delay of the channels.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&MultithreadedSimulatorImpl::m_lookahead),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  m_nPartitions = 0;
+  m_threadCount = 0;
+  m_partitioned = false;
+  m_serial = false;
+  m_late = false;
+  m_stop = false;
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  m_uid = 4;
+  m_currentUid = 0;
+  m_currentTs = 0;
+  m_currentContext = Simulator::NO_CONTEXT;
+  m_unscheduledEvents = 0;
+  m_windowEnd = 0;
+  m_parity = 0;
+  m_exit = false;
+  m_eventsWithContextEmpty = true;
+  m_main = SystemThread::Self ();
+
+  m_barrier = new BarrierPrivate;
+  pthread_mutex_init (&m_barrier->mutex, NULL);
+  pthread_cond_init (&m_barrier->cond, NULL);
+  m_barrier->threshold = 1;
+  m_barrier->count = 0;
+  m_barrier->generation = 0;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      delete m_partitions[i];
+    }
+  m_partitions.clear ();
+  pthread_cond_destroy (&m_barrier->cond);
+  pthread_mutex_destroy (&m_barrier->mutex);
+  delete m_barrier;
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  ProcessEventsWithContext ();
+
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      Partition *partition = m_partitions[i];
+      while (!partition->events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      partition->events = 0;
+      for (uint32_t parity = 0; parity < 2; ++parity)
+        {
+          for (uint32_t j = 0; j < partition->outbox[parity].size (); ++j)
+            {
+              std::vector<Scheduler::Event> &outbox = partition->outbox[parity][j];
+              for (uint32_t k = 0; k < outbox.size (); ++k)
+                {
+                  outbox[k].impl->Unref ();
+                }
+              outbox.clear ();
+            }
+        }
+    }
+  while (!m_globalEvents->IsEmpty ())
+    {
+      Scheduler::Event next = m_globalEvents->RemoveNext ();
+      next.impl->Unref ();
+    }
+  m_globalEvents = 0;
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT_MSG (g_partitionIndex == 0, "SetScheduler called while running a window");
+  m_schedulerFactory = schedulerFactory;
+
+  if (m_partitions.empty ())
+    {
+      m_nPartitions = m_threadCount;
+      if (m_nPartitions == 0)
+        {
+          long nProcessors = sysconf (_SC_NPROCESSORS_ONLN);
+          m_nPartitions = nProcessors > 0 ? nProcessors : 1;
+        }
+      for (uint32_t i = 0; i < m_nPartitions; ++i)
+        {
+          Partition *partition = new Partition;
+          partition->uid = 4;
+          partition->currentUid = 0;
+          partition->currentTs = 0;
+          partition->currentContext = Simulator::NO_CONTEXT;
+          partition->windowTs = 0;
+          partition->windowUid = 0;
+          partition->unscheduledEvents = 0;
+          for (uint32_t parity = 0; parity < 2; ++parity)
+            {
+              partition->outbox[parity].resize (m_nPartitions);
+              partition->outboxMinTs[parity] = ~0ULL;
+            }
+          m_partitions.push_back (partition);
+        }
+    }
+
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      Partition *partition = m_partitions[i];
+      if (partition->events != 0)
+        {
+          while (!partition->events->IsEmpty ())
+            {
+              scheduler->Insert (partition->events->RemoveNext ());
+            }
+        }
+      partition->events = scheduler;
+    }
+
+  Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+  if (m_globalEvents != 0)
+    {
+      while (!m_globalEvents->IsEmpty ())
+        {
+          scheduler->Insert (m_globalEvents->RemoveNext ());
+        }
+    }
+  m_globalEvents = scheduler;
+}
+
+// System ID for non-distributed simulation is always zero
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead (void) const
+{
+  return m_lookahead;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionIndex (uint32_t context) const
+{
+  if (context < m_partitionOf.size ())
+    {
+      return m_partitionOf[context];
+    }
+  return context % m_nPartitions;
+}
+
+bool
+MultithreadedSimulatorImpl::IsRemoteContext (uint32_t context)
+{
+  const MultithreadedSimulatorImpl *impl = g_window;
+  return impl != 0 && context != Simulator::NO_CONTEXT
+         && impl->GetPartitionIndex (context) + 1 != g_partitionIndex;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrentPartition (void) const
+{
+  if (g_partitionIndex == 0)
+    {
+      return 0;
+    }
+  return m_partitions[g_partitionIndex - 1];
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetCurrentTs (void) const
+{
+  Partition *current = GetCurrentPartition ();
+  return current != 0 ? current->currentTs : m_currentTs;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::InsertInPartition (Partition *partition, Scheduler::Event ev)
+{
+  ev.key.m_uid = partition->uid;
+  partition->uid++;
+  partition->unscheduledEvents++;
+  partition->events->Insert (ev);
+  return ev.key.m_uid;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::InsertGlobal (Scheduler::Event ev)
+{
+  if (g_partitionIndex != 0)
+    {
+      // Called from a window: the other threads may be inserting as
+      // well, and may already have executed events later than ev.
+      if (!m_serial && ev.key.m_ts < m_windowEnd)
+        {
+          NS_FATAL_ERROR ("Global event scheduled at " << TimeStep (ev.key.m_ts)
+                          << " from a window ending at " << TimeStep (m_windowEnd)
+                          << ": the delay of a global event scheduled by a node"
+                          << " must be at least the lookahead " << m_lookahead);
+        }
+      CriticalSection cs (m_eventsWithContextMutex);
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_globalEvents->Insert (ev);
+      return ev.key.m_uid;
+    }
+  ev.key.m_uid = m_uid;
+  m_uid++;
+  m_unscheduledEvents++;
+  m_globalEvents->Insert (ev);
+  return ev.key.m_uid;
+}
+
+bool
+MultithreadedSimulatorImpl::IsStopped (void) const
+{
+  return __atomic_load_n (&m_stop, __ATOMIC_ACQUIRE);
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (IsStopped ())
+    {
+      return true;
+    }
+  if (!m_globalEvents->IsEmpty ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      if (!m_partitions[i]->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessEventsWithContext (void)
+{
+  if (m_eventsWithContextEmpty)
+    {
+      return;
+    }
+
+  // swap queues
+  EventsWithContext eventsWithContext;
+  {
+    CriticalSection cs (m_eventsWithContextMutex);
+    m_eventsWithContext.swap (eventsWithContext);
+    m_eventsWithContextEmpty = true;
+  }
+  while (!eventsWithContext.empty ())
+    {
+      EventWithContext event = eventsWithContext.front ();
+      eventsWithContext.pop_front ();
+      Scheduler::Event ev;
+      ev.impl = event.event;
+      ev.key.m_ts = m_currentTs + event.timestamp;
+      ev.key.m_context = event.context;
+      if (event.context == Simulator::NO_CONTEXT)
+        {
+          InsertGlobal (ev);
+        }
+      else
+        {
+          InsertInPartition (m_partitions[GetPartitionIndex (event.context)], ev);
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::DrainInbox (uint32_t index, uint32_t parity)
+{
+  Partition *partition = m_partitions[index];
+  for (uint32_t i = 0; i < m_nPartitions; ++i)
+    {
+      std::vector<Scheduler::Event> &inbox = m_partitions[i]->outbox[parity][index];
+      for (uint32_t j = 0; j < inbox.size (); ++j)
+        {
+          InsertInPartition (partition, inbox[j]);
+        }
+      inbox.clear ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::InvokeNext (Partition *partition)
+{
+  Scheduler::Event next = partition->events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->currentTs);
+  partition->unscheduledEvents--;
+
+  partition->currentTs = next.key.m_ts;
+  partition->currentContext = next.key.m_context;
+  partition->currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow (uint32_t index)
+{
+  Partition *partition = m_partitions[index];
+  g_partitionIndex = index + 1;
+  g_window = this;
+  DrainInbox (index, 1 - m_parity);
+  partition->outboxMinTs[m_parity] = ~0ULL;
+
+  while (!partition->events->IsEmpty ()
+         && partition->events->PeekNext ().key.m_ts < m_windowEnd)
+    {
+      InvokeNext (partition);
+    }
+  g_partitionIndex = 0;
+  g_window = 0;
+}
+
+void
+MultithreadedSimulatorImpl::WaitBarrier (void)
+{
+  pthread_mutex_lock (&m_barrier->mutex);
+  uint32_t generation = m_barrier->generation;
+  m_barrier->count++;
+  if (m_barrier->count == m_barrier->threshold)
+    {
+      m_barrier->count = 0;
+      m_barrier->generation++;
+      pthread_cond_broadcast (&m_barrier->cond);
+    }
+  else
+    {
+      while (generation == m_barrier->generation)
+        {
+          pthread_cond_wait (&m_barrier->cond, &m_barrier->mutex);
+        }
+    }
+  pthread_mutex_unlock (&m_barrier->mutex);
+}
+
+void
+MultithreadedSimulatorImpl::WorkerLoop (uint32_t index)
+{
+  NS_LOG_FUNCTION (this << index);
+  while (true)
+    {
+      // wait for the main thread to open the window
+      WaitBarrier ();
+      if (m_exit)
+        {
+          return;
+        }
+      ProcessWindow (index);
+      WaitBarrier ();
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::PartitionTopology (void)
+{
+  NS_LOG_FUNCTION (this);
+  // find the node of each device
+  std::map<Ptr<Object>, uint32_t> nodeOfDevice;
+  uint32_t nNodes = 0;
+  Config::MatchContainer nodes = Config::LookupMatches ("/NodeList/*");
+  for (Config::MatchContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      UintegerValue id;
+      ObjectPtrContainerValue devices;
+      if (!(*i)->GetAttributeFailSafe ("Id", id)
+          || !(*i)->GetAttributeFailSafe ("DeviceList", devices))
+        {
+          continue;
+        }
+      nNodes = std::max<uint32_t> (nNodes, id.Get () + 1);
+      for (ObjectPtrContainerValue::Iterator j = devices.Begin (); j != devices.End (); ++j)
+        {
+          nodeOfDevice[j->second] = id.Get ();
+        }
+    }
+
+  // find the delay and the nodes of each channel
+  Config::MatchContainer channels = Config::LookupMatches ("/ChannelList/*");
+  std::vector<Time> delays;
+  std::vector<std::vector<uint32_t> > attached;
+  bool automatic = m_lookahead.IsZero ();
+  for (Config::MatchContainer::Iterator i = channels.Begin (); i != channels.End (); ++i)
+    {
+      // a channel without a Delay attribute counts as a zero-delay one
+      TimeValue delay (Seconds (0));
+      (*i)->GetAttributeFailSafe ("Delay", delay);
+      ObjectPtrContainerValue devices;
+      (*i)->GetAttributeFailSafe ("DeviceList", devices);
+      std::vector<uint32_t> channelNodes;
+      for (ObjectPtrContainerValue::Iterator j = devices.Begin (); j != devices.End (); ++j)
+        {
+          std::map<Ptr<Object>, uint32_t>::const_iterator node = nodeOfDevice.find (j->second);
+          if (node != nodeOfDevice.end ())
+            {
+              channelNodes.push_back (node->second);
+            }
+        }
+      delays.push_back (delay.Get ());
+      attached.push_back (channelNodes);
+      if (automatic && delay.Get ().IsStrictlyPositive ()
+          && (m_lookahead.IsZero () || delay.Get () < m_lookahead))
+        {
+          m_lookahead = delay.Get ();
+        }
+    }
+  NS_LOG_LOGIC ("lookahead " << m_lookahead);
+
+  // group the nodes joined by a channel shorter than the lookahead
+  std::vector<uint32_t> parent (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      parent[i] = i;
+    }
+  for (uint32_t i = 0; i < delays.size (); ++i)
+    {
+      if (delays[i] >= m_lookahead && m_lookahead.IsStrictlyPositive ())
+        {
+          continue;
+        }
+      for (uint32_t j = 1; j < attached[i].size (); ++j)
+        {
+          parent[FindGroup (parent, attached[i][j])] = FindGroup (parent, attached[i][0]);
+        }
+    }
+
+  // spread the groups over the partitions
+  std::vector<uint32_t> partitionOfGroup (nNodes, ~0U);
+  uint32_t nGroups = 0;
+  m_partitionOf.resize (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      uint32_t group = FindGroup (parent, i);
+      if (partitionOfGroup[group] == ~0U)
+        {
+          partitionOfGroup[group] = nGroups % m_nPartitions;
+          nGroups++;
+        }
+      m_partitionOf[i] = partitionOfGroup[group];
+    }
+  NS_LOG_LOGIC (nGroups << " groups of nodes");
+  return nGroups;
+}
+
+void
+MultithreadedSimulatorImpl::Repartition (void)
+{
+  NS_LOG_FUNCTION (this);
+  // No EventId can reference an event held by a partition before Run
+  // (Schedule without context goes to the global queue), so the uids
+  // can safely be reallocated.
+  std::vector<Scheduler::Event> events;
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      Partition *partition = m_partitions[i];
+      while (!partition->events->IsEmpty ())
+        {
+          events.push_back (partition->events->RemoveNext ());
+          partition->unscheduledEvents--;
+        }
+    }
+  for (uint32_t i = 0; i < events.size (); ++i)
+    {
+      InsertInPartition (m_partitions[GetPartitionIndex (events[i].key.m_context)], events[i]);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::MergePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_partitionOf.clear ();
+  m_nPartitions = 1;
+  Repartition ();
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  // Set the current threadId as the main threadId
+  m_main = SystemThread::Self ();
+  ProcessEventsWithContext ();
+  __atomic_store_n (&m_stop, false, __ATOMIC_RELEASE);
+  m_exit = false;
+
+  if (!m_partitioned)
+    {
+      m_partitioned = true;
+      uint32_t nGroups = PartitionTopology ();
+      if (m_nPartitions > 1 && (!m_lookahead.IsStrictlyPositive () || nGroups == 1))
+        {
+          NS_LOG_WARN ("No positive lookahead between the nodes, running on a single thread");
+          MergePartitions ();
+        }
+      else
+        {
+          Repartition ();
+        }
+    }
+  uint64_t lookahead = m_lookahead.IsStrictlyPositive () ? m_lookahead.GetTimeStep () : 1;
+
+  m_barrier->threshold = m_nPartitions;
+  for (uint32_t i = 1; i < m_nPartitions; ++i)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread>
+          (MakeCallback (&MultithreadedSimulatorImpl::WorkerLoop, this).Bind (i));
+      m_threads.push_back (thread);
+      thread->Start ();
+    }
+
+  while (!IsStopped ())
+    {
+      ProcessEventsWithContext ();
+
+      // the earliest event is either in a partition or in a mailbox
+      // filled during the previous window.
+      uint64_t next = ~0ULL;
+      uint32_t nextIndex = 0;
+      for (uint32_t i = 0; i < m_nPartitions; ++i)
+        {
+          Partition *partition = m_partitions[i];
+          if (!partition->events->IsEmpty ()
+              && partition->events->PeekNext ().key.m_ts < next)
+            {
+              next = partition->events->PeekNext ().key.m_ts;
+              nextIndex = i;
+            }
+          next = std::min (next, partition->outboxMinTs[m_parity]);
+        }
+      uint64_t globalNext = ~0ULL;
+      if (!m_globalEvents->IsEmpty ())
+        {
+          globalNext = m_globalEvents->PeekNext ().key.m_ts;
+        }
+      if (next == ~0ULL && globalNext == ~0ULL)
+        {
+          break;
+        }
+
+      if (globalNext <= next)
+        {
+          Scheduler::Event ev = m_globalEvents->RemoveNext ();
+          NS_ASSERT (ev.key.m_ts >= m_currentTs);
+          m_unscheduledEvents--;
+          m_currentTs = ev.key.m_ts;
+          m_currentContext = ev.key.m_context;
+          m_currentUid = ev.key.m_uid;
+          ev.impl->Invoke ();
+          ev.impl->Unref ();
+          m_currentContext = Simulator::NO_CONTEXT;
+          continue;
+        }
+
+      m_currentTs = next;
+      if (m_serial)
+        {
+          g_partitionIndex = nextIndex + 1;
+          InvokeNext (m_partitions[nextIndex]);
+          g_partitionIndex = 0;
+          continue;
+        }
+      m_windowEnd = std::min (next + lookahead, globalNext);
+      m_parity = 1 - m_parity;
+      WaitBarrier ();
+      ProcessWindow (0);
+      WaitBarrier ();
+
+      for (uint32_t i = 0; i < m_nPartitions; ++i)
+        {
+          m_partitions[i]->windowTs = m_partitions[i]->currentTs;
+          m_partitions[i]->windowUid = m_partitions[i]->currentUid;
+        }
+      if (__atomic_load_n (&m_late, __ATOMIC_ACQUIRE))
+        {
+          // from now on, the events are executed one at a time in
+          // timestamp order, and can be sent directly to any partition.
+          for (uint32_t i = 0; i < m_nPartitions; ++i)
+            {
+              DrainInbox (i, m_parity);
+              m_partitions[i]->outboxMinTs[m_parity] = ~0ULL;
+            }
+          m_serial = true;
+        }
+    }
+
+  m_exit = true;
+  if (!m_threads.empty ())
+    {
+      WaitBarrier ();
+      for (uint32_t i = 0; i < m_threads.size (); ++i)
+        {
+          m_threads[i]->Join ();
+        }
+      m_threads.clear ();
+    }
+  // hand the events still sitting in a mailbox to their partition, so
+  // that a subsequent Run can pick them up.
+  for (uint32_t i = 0; i < m_nPartitions; ++i)
+    {
+      DrainInbox (i, m_parity);
+      m_partitions[i]->outboxMinTs[m_parity] = ~0ULL;
+      m_currentTs = std::max (m_currentTs, m_partitions[i]->currentTs);
+    }
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  if (!IsStopped ())
+    {
+      NS_ASSERT (m_unscheduledEvents == 0);
+      for (uint32_t i = 0; i < m_nPartitions; ++i)
+        {
+          NS_ASSERT (m_partitions[i]->unscheduledEvents == 0);
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  __atomic_store_n (&m_stop, true, __ATOMIC_RELEASE);
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  // Stop is global: it must not be executed by a single partition.
+  Simulator::ScheduleWithContext (Simulator::NO_CONTEXT, delay, &Simulator::Stop);
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  Partition *current = GetCurrentPartition ();
+  NS_ASSERT_MSG (current != 0 || SystemThread::Equals (m_main),
+                 "Simulator::Schedule Thread-unsafe invocation!");
+
+  uint64_t currentTs = GetCurrentTs ();
+  Time tAbsolute = delay + TimeStep (currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (currentTs));
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = (uint64_t) tAbsolute.GetTimeStep ();
+  ev.key.m_context = GetContext ();
+  if (ev.key.m_context == Simulator::NO_CONTEXT)
+    {
+      ev.key.m_uid = InsertGlobal (ev);
+    }
+  else
+    {
+      if (current == 0)
+        {
+          current = m_partitions[GetPartitionIndex (ev.key.m_context)];
+        }
+      ev.key.m_uid = InsertInPartition (current, ev);
+    }
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+
+  Partition *current = GetCurrentPartition ();
+  if (current == 0 && !SystemThread::Equals (m_main))
+    {
+      EventWithContext ev;
+      ev.context = context;
+      // Current time added in ProcessEventsWithContext()
+      ev.timestamp = delay.GetTimeStep ();
+      ev.event = event;
+      {
+        CriticalSection cs (m_eventsWithContextMutex);
+        m_eventsWithContext.push_back (ev);
+        m_eventsWithContextEmpty = false;
+      }
+      return;
+    }
+
+  Time tAbsolute = delay + TimeStep (GetCurrentTs ());
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = (uint64_t) tAbsolute.GetTimeStep ();
+  ev.key.m_context = context;
+  if (context == Simulator::NO_CONTEXT)
+    {
+      InsertGlobal (ev);
+      return;
+    }
+  uint32_t index = GetPartitionIndex (context);
+  Partition *destination = m_partitions[index];
+  if (current == 0 || current == destination || m_serial)
+    {
+      InsertInPartition (destination, ev);
+      return;
+    }
+  if (ev.key.m_ts < m_windowEnd)
+    {
+      // The destination may already have executed events later than
+      // ev: execute it at the end of the window, and the rest of the
+      // simulation one event at a time.
+      NS_LOG_WARN ("Event scheduled for context " << context << " with delay "
+                   << delay << " smaller than the lookahead " << m_lookahead
+                   << ", delayed to " << TimeStep (m_windowEnd)
+                   << "; running on a single thread from now on");
+      ev.key.m_ts = m_windowEnd;
+      __atomic_store_n (&m_late, true, __ATOMIC_RELEASE);
+    }
+  // the uid is allocated by the destination when the mailbox is drained
+  current->outbox[m_parity][index].push_back (ev);
+  current->outboxMinTs[m_parity] = std::min (current->outboxMinTs[m_parity], ev.key.m_ts);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_ASSERT_MSG (GetCurrentPartition () == 0 && SystemThread::Equals (m_main),
+                 "Simulator::ScheduleDestroy Thread-unsafe invocation!");
+
+  EventId id (Ptr<EventImpl> (event, false), m_currentTs, 0xffffffff, 2);
+  m_destroyEvents.push_back (id);
+  m_uid++;
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (GetCurrentTs ());
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrentTs ());
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  if (id.GetContext () == Simulator::NO_CONTEXT)
+    {
+      NS_ASSERT_MSG (GetCurrentPartition () == 0,
+                     "Simulator::Remove of a global event from a window");
+      m_globalEvents->Remove (event);
+      m_unscheduledEvents--;
+    }
+  else
+    {
+      Partition *partition = m_partitions[GetPartitionIndex (id.GetContext ())];
+      NS_ASSERT_MSG (GetCurrentPartition () == 0 || GetCurrentPartition () == partition
+                     || m_serial,
+                     "Simulator::Remove of an event owned by another partition");
+      partition->events->Remove (event);
+      partition->unscheduledEvents--;
+    }
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0
+          || id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  if (id.PeekEventImpl () == 0
+      || id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  // compare with the progress of the queue owning the event
+  uint64_t currentTs;
+  uint32_t currentUid;
+  if (id.GetContext () == Simulator::NO_CONTEXT)
+    {
+      currentTs = m_currentTs;
+      currentUid = m_currentUid;
+    }
+  else
+    {
+      const Partition *partition = m_partitions[GetPartitionIndex (id.GetContext ())];
+      const Partition *current = GetCurrentPartition ();
+      if (current == 0 || current == partition || m_serial)
+        {
+          currentTs = partition->currentTs;
+          currentUid = partition->currentUid;
+        }
+      else
+        {
+          // another thread may be executing the partition: use its
+          // progress at the start of the window.
+          currentTs = partition->windowTs;
+          currentUid = partition->windowUid;
+        }
+    }
+  if (id.GetTs () < currentTs
+      || (id.GetTs () == currentTs && id.GetUid () <= currentUid))
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  Partition *current = GetCurrentPartition ();
+  return current != 0 ? current->currentContext : m_currentContext;
+}
+
+} // namespace ns3
@@ -0,0 +1,336 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "simulator-impl.h"
+#include "scheduler.h"
+#include "event-impl.h"
+#include "system-thread.h"
+#include "ns3/system-mutex.h"
+#include "nstime.h"
+
+#include "ptr.h"
+
+#include <list>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Declaration of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * A conservative, shared-memory parallel simulator implementation.
+ *
+ * Events are partitioned by the context they are scheduled with
+ * (normally the node id), and every partition owns its own Scheduler.
+ * Partitions are advanced concurrently by a pool of worker threads in
+ * windows of length equal to the lookahead, the smallest delay with
+ * which an event may cross from one partition to another.  This is the
+ * same granted time window algorithm used by the MPI-based
+ * DistributedSimulatorImpl, except that events crossing partitions are
+ * exchanged through in-memory, per-thread mailboxes which are only
+ * read after the window barrier, so no locking is needed on the
+ * critical path.
+ *
+ * The partitions are laid out by the first call to Run(), from the
+ * channels of the ChannelList.  Unless the Lookahead attribute is set,
+ * the lookahead is the smallest positive Delay attribute of these
+ * channels, whatever their type.  The nodes attached to a channel whose
+ * delay is smaller than the lookahead, zero, or unknown (the channel
+ * has no Delay attribute) are then placed in the same partition, and
+ * the groups of nodes so formed are spread over the partitions.  If
+ * there is no positive lookahead, or if all the nodes end up in a
+ * single group, the partitions are merged and the simulation runs
+ * sequentially.
+ *
+ * Events scheduled without a context (Simulator::NO_CONTEXT) are
+ * considered global: they are executed by the main thread, between two
+ * windows, while all the workers are idle.  Scheduling a global event
+ * from a window with a delay smaller than the lookahead is a fatal
+ * error, since the other partitions may already have executed events
+ * later than it.
+ *
+ * Model code executed concurrently must not share mutable state across
+ * partitions other than through events scheduled with a delay at least
+ * equal to the lookahead.  Should an event nevertheless be scheduled
+ * into another partition with a smaller delay, it cannot be executed
+ * at its exact time: a warning is logged, the event is executed at the
+ * end of the current window, and the rest of the simulation runs
+ * sequentially, one event at a time, so that this cannot happen again.
+ *
+ * The reference counts of ns-3 objects are not atomic.  The channels
+ * which may join two partitions therefore use IsRemoteContext to avoid
+ * sharing their packets and devices with the receiving partition.
+ *
+ * While a window is processed, Simulator::IsExpired on an event of
+ * another partition reflects the progress of that partition at the
+ * start of the window.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (const Time &delay);
+  virtual EventId Schedule (const Time &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \return The lookahead used to size the parallel windows.  Before
+   * Run() is called this is the value of the Lookahead attribute.
+   */
+  Time GetLookahead (void) const;
+
+  /**
+   * Check whether an event scheduled by the caller for a context may be
+   * executed concurrently with the caller, by another thread.
+   *
+   * The objects an event scheduled into another partition refers to
+   * must then not be shared with the caller, not even through reference
+   * counts: a channel, for instance, hands a copy of its packet which
+   * shares no buffer with the original (see Packet::CreateUnsharedCopy).
+   *
+   * \param [in] context The context of the event.
+   * \return \c true if the calling thread executes a parallel window of a
+   * MultithreadedSimulatorImpl, and \p context belongs to another
+   * partition.
+   */
+  static bool IsRemoteContext (uint32_t context);
+
+private:
+  virtual void DoDispose (void);
+
+  /** Opaque, platform-dependent barrier implementation. */
+  struct BarrierPrivate;
+
+  /**
+   * The state owned by a single partition.  Only the thread executing
+   * the partition touches it while a window is being processed.
+   */
+  struct Partition
+  {
+    /** The partition event priority queue. */
+    Ptr<Scheduler> events;
+    /** Next event unique id. */
+    uint32_t uid;
+    /** Unique id of the current event. */
+    uint32_t currentUid;
+    /** Timestamp of the current event. */
+    uint64_t currentTs;
+    /** Execution context of the current event. */
+    uint32_t currentContext;
+    /** Timestamp of the last event executed before the current window. */
+    uint64_t windowTs;
+    /** Unique id of the last event executed before the current window. */
+    uint32_t windowUid;
+    /** Number of events inserted but not yet executed. */
+    int unscheduledEvents;
+    /**
+     * Events sent to the other partitions, indexed by parity of the
+     * window and by destination partition.
+     */
+    std::vector<std::vector<Scheduler::Event> > outbox[2];
+    /** Earliest timestamp found in each outbox. */
+    uint64_t outboxMinTs[2];
+  };
+
+  /** Wrap an event with its execution context. */
+  struct EventWithContext {
+    /** The event context. */
+    uint32_t context;
+    /** Event timestamp. */
+    uint64_t timestamp;
+    /** The event implementation. */
+    EventImpl *event;
+  };
+  /** Container type for the events from a different context. */
+  typedef std::list<struct EventWithContext> EventsWithContext;
+  /** Container type for the events to run at Simulator::Destroy() */
+  typedef std::list<EventId> DestroyEvents;
+
+  /**
+   * \param [in] context The event context.
+   * \return The index of the partition which owns \p context.
+   */
+  uint32_t GetPartitionIndex (uint32_t context) const;
+  /**
+   * \return The partition executed by the calling thread, or 0 if the
+   * caller is not executing a partition window.
+   */
+  Partition * GetCurrentPartition (void) const;
+  /** \return The timestamp of the event being executed by the caller. */
+  uint64_t GetCurrentTs (void) const;
+  /**
+   * Insert an event in a partition, allocating its uid.
+   * \param [in] partition The destination partition.
+   * \param [in] ev The event; its uid is overwritten.
+   * \return The uid allocated to the event.
+   */
+  uint32_t InsertInPartition (Partition *partition, Scheduler::Event ev);
+  /**
+   * Insert an event in the global (context-less) queue.
+   * \param [in] ev The event; its uid is overwritten.
+   * \return The uid allocated to the event.
+   */
+  uint32_t InsertGlobal (Scheduler::Event ev);
+  /**
+   * Execute the earliest event of a partition.
+   * \param [in] partition The partition.
+   */
+  void InvokeNext (Partition *partition);
+  /** Move events from a foreign thread into the event queues. */
+  void ProcessEventsWithContext (void);
+  /**
+   * Move the events sent by the other partitions during the previous
+   * window into the scheduler of a partition.
+   * \param [in] index The destination partition.
+   * \param [in] parity The parity of the previous window.
+   */
+  void DrainInbox (uint32_t index, uint32_t parity);
+  /**
+   * Execute all the events of a partition earlier than the end of the
+   * current window.
+   * \param [in] index The partition to execute.
+   */
+  void ProcessWindow (uint32_t index);
+  /**
+   * Main loop of the worker threads.
+   * \param [in] index The partition executed by this worker.
+   */
+  void WorkerLoop (uint32_t index);
+  /**
+   * Wait on the window barrier until all the threads have arrived.
+   */
+  void WaitBarrier (void);
+  /**
+   * Compute m_lookahead from the channel delays, unless it is set, and
+   * map the nodes to the partitions so that the nodes joined by a
+   * channel shorter than the lookahead share a partition.
+   * \return The number of groups of nodes, zero if there are no nodes.
+   */
+  uint32_t PartitionTopology (void);
+  /** Move the events to the partition owning their context. */
+  void Repartition (void);
+  /** Fold all the partitions into the first one. */
+  void MergePartitions (void);
+  /** \return \c true if the simulation must stop. */
+  bool IsStopped (void) const;
+
+  /** The worker threads, one per partition except the first. */
+  std::vector<Ptr<SystemThread> > m_threads;
+  /** The partitions. */
+  std::vector<Partition *> m_partitions;
+  /** Number of partitions events are currently spread over. */
+  uint32_t m_nPartitions;
+  /** The partition of each node, indexed by node id. */
+  std::vector<uint32_t> m_partitionOf;
+  /** Flag \c true once the partitions have been laid out. */
+  bool m_partitioned;
+  /** Flag \c true when the partitions are executed one event at a time. */
+  bool m_serial;
+  /**
+   * Flag \c true when an event was sent to another partition with a
+   * delay smaller than the lookahead during the current window,
+   * accessed atomically.
+   */
+  bool m_late;
+  /** The number of threads requested through the ThreadCount attribute. */
+  uint32_t m_threadCount;
+  /** The lookahead, which is also the window size. */
+  Time m_lookahead;
+  /** The factory used to create the schedulers. */
+  ObjectFactory m_schedulerFactory;
+
+  /** Global events, executed by the main thread between windows. */
+  Ptr<Scheduler> m_globalEvents;
+  /** Next global event unique id. */
+  uint32_t m_uid;
+  /** Unique id of the current global event. */
+  uint32_t m_currentUid;
+  /** Timestamp of the current window or global event. */
+  uint64_t m_currentTs;
+  /** Execution context when not executing a partition. */
+  uint32_t m_currentContext;
+  /** Number of global events not yet executed. */
+  int m_unscheduledEvents;
+
+  /** End (excluded) of the window being processed. */
+  uint64_t m_windowEnd;
+  /** Parity of the window being processed. */
+  uint32_t m_parity;
+  /** The barrier opening and closing each window. */
+  BarrierPrivate *m_barrier;
+  /** Flag \c true when the worker threads must exit. */
+  bool m_exit;
+
+  /** The container of events from a foreign thread. */
+  EventsWithContext m_eventsWithContext;
+  /**
+   * Flag \c true if all events with context have been moved to the
+   * event queues.
+   */
+  bool m_eventsWithContextEmpty;
+  /** Mutex to control access to the list of events with context. */
+  SystemMutex m_eventsWithContextMutex;
+
+  /** The container of events to run at Destroy. */
+  DestroyEvents m_destroyEvents;
+  /**
+   * Flag calling for the end of the simulation, accessed atomically
+   * since it may be set from any partition.
+   */
+  bool m_stop;
+
+  /** Main execution thread. */
+  SystemThread::ThreadId m_main;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
@@ -34,6 +34,7 @@
 
 
 #include <cmath>
+#include <algorithm>
 
 
 /**
@@ -88,6 +89,7 @@ RealtimeSimulatorImpl::RealtimeSimulatorImpl ()
   // before ::Run is entered, the m_currentUid will be zero
   m_currentUid = 0;
   m_currentTs = 0;
+  m_eventsWithContextCount = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
 
@@ -107,6 +109,7 @@ void
 RealtimeSimulatorImpl::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  ProcessEventsWithContext ();
   while (!m_events->IsEmpty ())
     {
       Scheduler::Event next = m_events->RemoveNext ();
@@ -221,6 +224,15 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
         NS_ASSERT_MSG (m_synchronizer->Realtime (), 
                        "RealtimeSimulatorImpl::ProcessOneEvent (): Synchronizer reports not Realtime ()");
 
+        //
+        // Reset the synchronizer before looking at the events scheduled by
+        // other threads: an event pushed after ProcessEventsWithContext ()
+        // returns is always followed by a Signal () which will interrupt the
+        // wait below.
+        //
+        m_synchronizer->SetCondition (false);
+        ProcessEventsWithContext ();
+
         //
         // tsNow is set to the normalized current real time.  When the simulation was
         // started, the current real time was effectively set to zero; so tsNow is
@@ -253,10 +265,9 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
         // We've figured out how long we need to delay in order to pace the 
         // simulation time with the real time.  We're going to sleep, but need
         // to work with the synchronizer to make sure we're awakened if something 
-        // external happens (like a packet is received).  This next line resets
-        // the synchronizer so that any future event will cause it to interrupt.
+        // external happens (like a packet is received).  The synchronizer was
+        // reset above so that any future event will cause it to interrupt.
         //
-        m_synchronizer->SetCondition (false);
       }
 
       //
@@ -326,6 +337,7 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
     // event we're working on won't be on the list and so subsequent operations won't
     // mess with us.
     //
+    ProcessEventsWithContext ();
     NS_ASSERT_MSG (m_events->IsEmpty () == false, 
                    "RealtimeSimulatorImpl::ProcessOneEvent(): event queue is empty");
     next = m_events->RemoveNext ();
@@ -346,7 +358,7 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
     // executing.  From the rest of the simulation's point of view, simulation time
     // is frozen until the next event is executed.
     //
-    m_currentTs = next.key.m_ts;
+    __atomic_store_n (&m_currentTs, next.key.m_ts, __ATOMIC_RELEASE);
     m_currentContext = next.key.m_context;
     m_currentUid = next.key.m_uid;
 
@@ -399,7 +411,9 @@ RealtimeSimulatorImpl::IsFinished (void) const
   bool rc;
   {
     CriticalSection cs (m_mutex);
-    rc = m_events->IsEmpty () || m_stop;
+    rc = (m_events->IsEmpty ()
+          && __atomic_load_n (&m_eventsWithContextCount, __ATOMIC_ACQUIRE) == 0)
+      || m_stop;
   }
 
   return rc;
@@ -429,8 +443,8 @@ RealtimeSimulatorImpl::Run (void)
   m_main = SystemThread::Self();
 
   m_stop = false;
-  m_running = true;
   m_synchronizer->SetOrigin (m_currentTs);
+  __atomic_store_n (&m_running, true, __ATOMIC_RELEASE);
 
   // Sleep until signalled
   uint64_t tsNow;
@@ -442,6 +456,7 @@ RealtimeSimulatorImpl::Run (void)
       {
         CriticalSection cs (m_mutex);
 
+        ProcessEventsWithContext ();
         if (!m_events->IsEmpty ())
           {
             process = true;
@@ -472,11 +487,12 @@ RealtimeSimulatorImpl::Run (void)
   {
     CriticalSection cs (m_mutex);
 
+    ProcessEventsWithContext ();
     NS_ASSERT_MSG (m_events->IsEmpty () == false || m_unscheduledEvents == 0,
                    "RealtimeSimulatorImpl::Run(): Empty queue and unprocessed events");
   }
 
-  m_running = false;
+  __atomic_store_n (&m_running, false, __ATOMIC_RELEASE);
 }
 
 bool
@@ -543,23 +559,15 @@ RealtimeSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
 {
   NS_LOG_FUNCTION (this << context << delay << impl);
 
+  if (!SystemThread::Equals (m_main))
+    {
+      ScheduleFromOtherThread (context, GetOtherThreadTs () + delay.GetTimeStep (), impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
-    uint64_t ts;
-
-    if (SystemThread::Equals (m_main))
-      {
-        ts = m_currentTs + delay.GetTimeStep ();
-      }
-    else
-      {
-        //
-        // If the simulator is running, we're pacing and have a meaningful 
-        // realtime clock.  If we're not, then m_currentTs is where we stopped.
-        // 
-        ts = m_running ? m_synchronizer->GetCurrentRealtime () : m_currentTs;
-        ts += delay.GetTimeStep ();
-      }
+    uint64_t ts = m_currentTs + delay.GetTimeStep ();
 
     NS_ASSERT_MSG (ts >= m_currentTs, "RealtimeSimulatorImpl::ScheduleRealtime(): schedule for time < m_currentTs");
     Scheduler::Event ev;
@@ -574,6 +582,62 @@ RealtimeSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
   }
 }
 
+uint64_t
+RealtimeSimulatorImpl::GetOtherThreadTs (void) const
+{
+  //
+  // If the simulator is running, we're pacing and have a meaningful 
+  // realtime clock.  If we're not, then m_currentTs is where we stopped.
+  // 
+  if (__atomic_load_n (&m_running, __ATOMIC_ACQUIRE))
+    {
+      return m_synchronizer->GetCurrentRealtime ();
+    }
+  return __atomic_load_n (&m_currentTs, __ATOMIC_ACQUIRE);
+}
+
+void
+RealtimeSimulatorImpl::ScheduleFromOtherThread (uint32_t context, uint64_t ts, EventImpl *impl)
+{
+  EventWithContext ev;
+  ev.context = context;
+  ev.timestamp = ts;
+  ev.event = impl;
+  // counted before the push, so that IsFinished never misses the event
+  __atomic_add_fetch (&m_eventsWithContextCount, 1, __ATOMIC_RELEASE);
+  m_eventsWithContext.Push (ev);
+  m_synchronizer->Signal ();
+}
+
+void
+RealtimeSimulatorImpl::ProcessEventsWithContext (void)
+{
+  if (m_eventsWithContext.IsEmpty ())
+    {
+      return;
+    }
+
+  EventWithContext event;
+  uint32_t n = 0;
+  while (m_eventsWithContext.Pop (event))
+    {
+      n++;
+      //
+      // The timestamp was read from the real time clock before the event
+      // was queued, and we may have executed an event past it since then.
+      //
+      Scheduler::Event ev;
+      ev.impl = event.event;
+      ev.key.m_ts = std::max (event.timestamp, m_currentTs);
+      ev.key.m_context = event.context;
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
+    }
+  __atomic_sub_fetch (&m_eventsWithContextCount, n, __ATOMIC_RELEASE);
+}
+
 EventId
 RealtimeSimulatorImpl::ScheduleNow (EventImpl *impl)
 {
@@ -609,6 +673,12 @@ RealtimeSimulatorImpl::ScheduleRealtimeWithContext (uint32_t context, Time const
 {
   NS_LOG_FUNCTION (this << context << time << impl);
 
+  if (!SystemThread::Equals (m_main))
+    {
+      ScheduleFromOtherThread (context, m_synchronizer->GetCurrentRealtime () + time.GetTimeStep (), impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
 
@@ -636,13 +706,20 @@ void
 RealtimeSimulatorImpl::ScheduleRealtimeNowWithContext (uint32_t context, EventImpl *impl)
 {
   NS_LOG_FUNCTION (this << context << impl);
+
+  //
+  // If the simulator is running, we're pacing and have a meaningful 
+  // realtime clock.  If we're not, then m_currentTs is were we stopped.
+  // 
+  if (!SystemThread::Equals (m_main))
+    {
+      ScheduleFromOtherThread (context, GetOtherThreadTs (), impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
 
-    //
-    // If the simulator is running, we're pacing and have a meaningful 
-    // realtime clock.  If we're not, then m_currentTs is were we stopped.
-    // 
     uint64_t ts = m_running ? m_synchronizer->GetCurrentRealtime () : m_currentTs;
     NS_ASSERT_MSG (ts >= m_currentTs, 
                    "RealtimeSimulatorImpl::ScheduleRealtimeNowWithContext(): schedule for time < m_currentTs");
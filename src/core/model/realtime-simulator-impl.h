@@ -30,6 +30,7 @@
 #include "assert.h"
 #include "log.h"
 #include "system-mutex.h"
+#include "mpsc-ring.h"
 
 #include <list>
 
@@ -52,6 +53,12 @@ namespace ns3 {
  * \ingroup realtime
  *
  * Realtime version of SimulatorImpl.
+ *
+ * Events scheduled from threads other than the main one (for example
+ * by the FdNetDevice and TapBridge reader threads) are timestamped with
+ * the current real time and pushed into a lock-free ring, which the
+ * main thread drains every time it looks at the event list, so that
+ * these threads never wait for #m_mutex.
  */
 class RealtimeSimulatorImpl : public SimulatorImpl
 {
@@ -172,6 +179,24 @@ private:
   uint64_t NextTs (void) const;
   /** Process the next event. */
   void ProcessOneEvent (void);
+  /**
+   * Move the events scheduled by other threads into the event list.
+   * Should be called by the main thread, with #m_mutex locked.
+   */
+  void ProcessEventsWithContext (void);
+  /**
+   * Schedule an event from a thread other than the main one.
+   * \param [in] context The event context.
+   * \param [in] ts The absolute timestep of the event.
+   * \param [in] impl The event.
+   */
+  void ScheduleFromOtherThread (uint32_t context, uint64_t ts, EventImpl *impl);
+  /**
+   * Get the timestep of an event scheduled now by another thread: the
+   * real time if the simulator is running, else the current timestep.
+   * \returns The timestep.
+   */
+  uint64_t GetOtherThreadTs (void) const;
   /** Destructor implementation. */
   virtual void DoDispose (void);
 
@@ -181,7 +206,10 @@ private:
   DestroyEvents m_destroyEvents;
   /** Has the stopping condition been reached? */
   bool m_stop;
-  /** Is the simulator currently running. */
+  /**
+   * Is the simulator currently running.  Written by the main thread
+   * and read by other threads, so accessed atomically.
+   */
   bool m_running;
 
   /**
@@ -198,12 +226,29 @@ private:
   uint32_t m_uid;
   /**< Unique id of the current event. */
   uint32_t m_currentUid;
-  /**< Timestep of the current event. */
+  /**< Timestep of the current event, also read atomically by other threads. */
   uint64_t m_currentTs;
   /**< Execution context. */
   uint32_t m_currentContext;  
   /**@}*/
 
+  /** Wrap an event scheduled by another thread with its context. */
+  struct EventWithContext {
+    /** The event context. */
+    uint32_t context;
+    /** Event timestamp. */
+    uint64_t timestamp;
+    /** The event implementation. */
+    EventImpl *event;
+  };
+  /** The events scheduled by other threads, in scheduling order. */
+  MpscRing<struct EventWithContext> m_eventsWithContext;
+  /**
+   * Number of events scheduled by other threads and not yet moved to
+   * the event list, accessed atomically.
+   */
+  uint32_t m_eventsWithContextCount;
+
   /** Mutex to control access to key state. */  
   mutable SystemMutex m_mutex;  
 
@@ -0,0 +1,141 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/mpsc-ring.h"
+#include "ns3/system-thread.h"
+
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+class MpscRingFifoTestCase : public TestCase
+{
+public:
+  MpscRingFifoTestCase ();
+  virtual void DoRun (void);
+};
+
+MpscRingFifoTestCase::MpscRingFifoTestCase ()
+  : TestCase ("Check the order of the items, within and beyond the ring capacity")
+{
+}
+
+void
+MpscRingFifoTestCase::DoRun (void)
+{
+  MpscRing<uint32_t> ring (4);
+  uint32_t item;
+  NS_TEST_ASSERT_MSG_EQ (ring.IsEmpty (), true, "New ring not empty");
+  NS_TEST_ASSERT_MSG_EQ (ring.Pop (item), false, "Pop from an empty ring");
+
+  uint32_t next = 0;
+  for (uint32_t round = 0; round < 3; ++round)
+    {
+      // alternately fill the ring partially and well past its capacity
+      uint32_t count = round % 2 == 0 ? 3 : 50;
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          ring.Push (next + i);
+        }
+      NS_TEST_ASSERT_MSG_EQ (ring.IsEmpty (), false, "Filled ring empty");
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ (ring.Pop (item), true, "Item lost");
+          NS_TEST_ASSERT_MSG_EQ (item, next + i, "Item out of order");
+        }
+      next += count;
+      NS_TEST_ASSERT_MSG_EQ (ring.IsEmpty (), true, "Drained ring not empty");
+      NS_TEST_ASSERT_MSG_EQ (ring.Pop (item), false, "Pop from a drained ring");
+    }
+}
+
+class MpscRingThreadsTestCase : public TestCase
+{
+public:
+  MpscRingThreadsTestCase ();
+  virtual void DoRun (void);
+  static void Produce (std::pair<MpscRingThreadsTestCase *, uint32_t> context);
+
+  /** Item: the producer index and the item sequence number. */
+  typedef std::pair<uint32_t, uint32_t> Item;
+  MpscRing<Item> m_ring;
+  static const uint32_t PRODUCERS = 4;
+  static const uint32_t ITEMS = 20000;
+};
+
+MpscRingThreadsTestCase::MpscRingThreadsTestCase ()
+  : TestCase ("Check that the items of concurrent producers are neither lost nor reordered"),
+    m_ring (16)
+{
+}
+
+void
+MpscRingThreadsTestCase::Produce (std::pair<MpscRingThreadsTestCase *, uint32_t> context)
+{
+  for (uint32_t i = 0; i < ITEMS; ++i)
+    {
+      context.first->m_ring.Push (std::make_pair (context.second, i));
+    }
+}
+
+void
+MpscRingThreadsTestCase::DoRun (void)
+{
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < PRODUCERS; ++i)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (
+          &MpscRingThreadsTestCase::Produce,
+          std::pair<MpscRingThreadsTestCase *, uint32_t> (this, i))));
+    }
+  for (uint32_t i = 0; i < PRODUCERS; ++i)
+    {
+      threads[i]->Start ();
+    }
+
+  std::vector<uint32_t> expected (PRODUCERS, 0);
+  uint32_t received = 0;
+  bool ordered = true;
+  Item item;
+  while (received < PRODUCERS * ITEMS)
+    {
+      if (m_ring.Pop (item))
+        {
+          ordered = ordered && item.first < PRODUCERS && item.second == expected[item.first];
+          expected[item.first]++;
+          received++;
+        }
+    }
+  for (uint32_t i = 0; i < PRODUCERS; ++i)
+    {
+      threads[i]->Join ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (ordered, true, "Items of a producer out of order");
+  NS_TEST_ASSERT_MSG_EQ (m_ring.Pop (item), false, "Unexpected item");
+}
+
+class MpscRingTestSuite : public TestSuite
+{
+public:
+  MpscRingTestSuite ()
+    : TestSuite ("mpsc-ring")
+  {
+    AddTestCase (new MpscRingFifoTestCase (), TestCase::QUICK);
+    AddTestCase (new MpscRingThreadsTestCase (), TestCase::QUICK);
+  }
+} g_mpscRingTestSuite;
@@ -23,6 +23,19 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+
+#include <vector>
+#include <fstream>
+#include <string>
 
 using namespace ns3;
 
@@ -459,6 +472,300 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that clustered events are dequeued in order with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+/**
+ * A do-nothing event, only used as a key by SchedulerOrderTestCase.
+ */
+class NullEventImpl : public EventImpl
+{
+protected:
+  virtual void Notify (void)
+  {
+  }
+};
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  // Mimic many flows ticking at multiples of a few round trip times:
+  // the event times are heavily clustered, with many exact duplicates,
+  // and a fraction of the events is removed before it is dequeued.
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  Ptr<Scheduler> reference = CreateObject<MapScheduler> ();
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+  uint32_t uid = 4;
+  uint64_t now = 0;
+  std::vector<Scheduler::Event> pending;
+  for (uint32_t step = 0; step < 40000; ++step)
+    {
+      // start with a large population, so that the schedulers reorganize
+      uint32_t action = step < 5000 ? 0 : rng->GetInteger (0, 9);
+      if (action < 5 || reference->IsEmpty ())
+        {
+          Scheduler::Event ev;
+          ev.impl = new NullEventImpl ();
+          ev.key.m_ts = now + 1000 * rng->GetInteger (1, 4) + rng->GetInteger (0, 2);
+          ev.key.m_uid = uid++;
+          ev.key.m_context = 0;
+          // one reference for the scheduler, one for the pending list
+          ev.impl->Ref ();
+          scheduler->Insert (ev);
+          reference->Insert (ev);
+          pending.push_back (ev);
+        }
+      else if (action < 7 && !pending.empty ())
+        {
+          uint32_t i = rng->GetInteger (0, pending.size () - 1);
+          Scheduler::Event ev = pending[i];
+          pending[i] = pending.back ();
+          pending.pop_back ();
+          if (!ev.impl->IsCancelled ())
+            {
+              ev.impl->Cancel ();
+              scheduler->Remove (ev);
+              reference->Remove (ev);
+              ev.impl->Unref ();
+            }
+          ev.impl->Unref ();
+        }
+      else
+        {
+          Scheduler::Event expected = reference->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), false, "Scheduler unexpectedly empty");
+          NS_TEST_ASSERT_MSG_EQ (scheduler->PeekNext ().key.m_uid, expected.key.m_uid, "Bad peek");
+          Scheduler::Event ev = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, expected.key.m_uid, "Bad order at step " << step);
+          now = ev.key.m_ts;
+          // flag the event, so that it is not removed again
+          ev.impl->Cancel ();
+          ev.impl->Unref ();
+        }
+    }
+  while (!reference->IsEmpty ())
+    {
+      Scheduler::Event expected = reference->RemoveNext ();
+      Scheduler::Event ev = scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, expected.key.m_uid, "Bad order while draining");
+      ev.impl->Unref ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), true, "Scheduler not empty");
+  for (std::vector<Scheduler::Event>::iterator i = pending.begin (); i != pending.end (); ++i)
+    {
+      i->impl->Unref ();
+    }
+}
+
+class EventImplPoolTestCase : public TestCase
+{
+public:
+  EventImplPoolTestCase ();
+  virtual void DoRun (void);
+  void Tick (uint32_t n);
+  void TickLarge (uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e);
+  uint32_t m_ticks;
+};
+
+EventImplPoolTestCase::EventImplPoolTestCase ()
+  : TestCase ("Check that events are recycled by the EventImpl pool")
+{
+}
+
+void
+EventImplPoolTestCase::Tick (uint32_t n)
+{
+  ++m_ticks;
+  if (n > 0)
+    {
+      Simulator::Schedule (MicroSeconds (1), &EventImplPoolTestCase::Tick, this, n - 1);
+      Simulator::Schedule (MicroSeconds (1), &EventImplPoolTestCase::TickLarge, this, n, n, n, n, n);
+    }
+}
+
+void
+EventImplPoolTestCase::TickLarge (uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e)
+{
+  ++m_ticks;
+}
+
+void
+EventImplPoolTestCase::DoRun (void)
+{
+  m_ticks = 0;
+  EventImpl::PoolStatistics before = EventImpl::GetPoolStatistics ();
+  Simulator::Schedule (MicroSeconds (1), &EventImplPoolTestCase::Tick, this, 1000);
+  Simulator::Run ();
+  EventImpl::PoolStatistics after = EventImpl::GetPoolStatistics ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_ticks, 2001, "Bad number of events");
+  NS_TEST_ASSERT_MSG_EQ (after.allocations - before.allocations, 2001, "Bad number of allocations");
+  NS_TEST_ASSERT_MSG_EQ (after.deallocations - before.deallocations, 2001, "Bad number of deallocations");
+  // at most two blocks of each size are live at any time
+  NS_TEST_ASSERT_MSG_GT (after.hits - before.hits, 1990, "Events not recycled");
+
+  Simulator::Destroy ();
+  NS_TEST_ASSERT_MSG_EQ (EventImpl::GetPoolStatistics ().cached, 0, "Pool not released");
+}
+
+class EventCompactionTestCase : public TestCase
+{
+public:
+  EventCompactionTestCase ();
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  void Fire (void);
+  void CancelAll (void);
+  void Compaction (uint32_t live, uint32_t removed);
+  std::vector<EventId> m_ids;
+  uint32_t m_fired;
+  uint32_t m_live;
+  uint32_t m_removed;
+  uint32_t m_compactions;
+};
+
+EventCompactionTestCase::EventCompactionTestCase ()
+  : TestCase ("Check that cancelled events are compacted out of the queue")
+{
+}
+
+void
+EventCompactionTestCase::Fire (void)
+{
+  ++m_fired;
+}
+
+void
+EventCompactionTestCase::CancelAll (void)
+{
+  for (uint32_t i = 0; i < m_ids.size (); ++i)
+    {
+      if (i % 10 != 0)
+        {
+          m_ids[i].Cancel ();
+          // cancelling again must not count the event twice
+          m_ids[i].Cancel ();
+        }
+    }
+}
+
+void
+EventCompactionTestCase::Compaction (uint32_t live, uint32_t removed)
+{
+  ++m_compactions;
+  m_live = live;
+  m_removed = removed;
+}
+
+void
+EventCompactionTestCase::DoRun (void)
+{
+  m_fired = 0;
+  m_compactions = 0;
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::CompactionMinimum", UintegerValue (100));
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::CompactionRatio", DoubleValue (0.5));
+  Simulator::Destroy ();
+
+  Simulator::GetImplementation ()->TraceConnectWithoutContext
+    ("Compaction", MakeCallback (&EventCompactionTestCase::Compaction, this));
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      m_ids.push_back (Simulator::Schedule (MicroSeconds (i + 1), &EventCompactionTestCase::Fire, this));
+    }
+  Simulator::Schedule (Seconds (0), &EventCompactionTestCase::CancelAll, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_fired, 100, "Cancelled events fired");
+  NS_TEST_ASSERT_MSG_EQ (m_compactions, 1, "Bad number of compactions");
+  NS_TEST_ASSERT_MSG_EQ (m_live, 100, "Bad number of live events");
+  NS_TEST_ASSERT_MSG_EQ (m_removed, 900, "Bad number of removed events");
+}
+
+void
+EventCompactionTestCase::DoTeardown (void)
+{
+  m_ids.clear ();
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::CompactionMinimum", UintegerValue (10000));
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::CompactionRatio", DoubleValue (0.5));
+}
+
+class EventProfileTestCase : public TestCase
+{
+public:
+  EventProfileTestCase ();
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  void Fire (void);
+  uint32_t m_fired;
+};
+
+EventProfileTestCase::EventProfileTestCase ()
+  : TestCase ("Check that the event profile is written at Destroy")
+{
+}
+
+void
+EventProfileTestCase::Fire (void)
+{
+  ++m_fired;
+}
+
+void
+EventProfileTestCase::DoRun (void)
+{
+  m_fired = 0;
+  std::string prefix = CreateTempDirFilename ("simulator-profile");
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::EnableProfiling", BooleanValue (true));
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::ProfilePrefix", StringValue (prefix));
+  Simulator::Destroy ();
+
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      Simulator::ScheduleWithContext (i % 2 + 1, MicroSeconds (i + 1), &EventProfileTestCase::Fire, this);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  NS_TEST_ASSERT_MSG_EQ (m_fired, 10, "Events lost while profiling");
+
+  std::ifstream report ((prefix + ".txt").c_str ());
+  NS_TEST_ASSERT_MSG_EQ (report.is_open (), true, "No profile report");
+  std::string line;
+  std::getline (report, line);
+  NS_TEST_ASSERT_MSG_NE (line.find ("in 10 events"), std::string::npos, "Bad report header: " << line);
+
+  std::ifstream folded ((prefix + ".folded").c_str ());
+  NS_TEST_ASSERT_MSG_EQ (folded.is_open (), true, "No folded stack file");
+  uint32_t stacks = 0;
+  while (std::getline (folded, line))
+    {
+      NS_TEST_ASSERT_MSG_EQ (line.find ("context "), 0, "Bad context in " << line);
+      NS_TEST_ASSERT_MSG_NE (line.find ("EventProfileTestCase"), std::string::npos, "Bad event type in " << line);
+      ++stacks;
+    }
+  NS_TEST_ASSERT_MSG_EQ (stacks, 2, "Bad number of folded stacks");
+}
+
+void
+EventProfileTestCase::DoTeardown (void)
+{
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::EnableProfiling", BooleanValue (false));
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::ProfilePrefix", StringValue ("simulator-profile"));
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +782,16 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+
+    AddTestCase (new EventImplPoolTestCase (), TestCase::QUICK);
+    AddTestCase (new EventCompactionTestCase (), TestCase::QUICK);
+    AddTestCase (new EventProfileTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
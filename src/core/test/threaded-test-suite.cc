@@ -23,8 +23,11 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
 #include "ns3/config.h"
 #include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
 #include "ns3/system-thread.h"
 
 #include <ctime>
@@ -225,6 +228,189 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+#define NCONTEXTS 8
+
+class MultithreadedSimulatorPartitionTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorPartitionTestCase (ObjectFactory schedulerFactory, unsigned int threads);
+  void Ping (uint32_t context, uint32_t hop);
+  void Tick (uint32_t context, Time expected);
+  uint32_t m_received[NCONTEXTS];
+  uint32_t m_ticks[NCONTEXTS];
+  bool m_error[NCONTEXTS];
+  unsigned int m_threads;
+  ObjectFactory m_schedulerFactory;
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+};
+
+MultithreadedSimulatorPartitionTestCase::MultithreadedSimulatorPartitionTestCase (ObjectFactory schedulerFactory, unsigned int threads)
+  : TestCase ("Check that partitioned events are executed in order with " +
+              schedulerFactory.GetTypeId ().GetName () + " in ns3::MultithreadedSimulatorImpl"),
+    m_threads (threads),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+MultithreadedSimulatorPartitionTestCase::Ping (uint32_t context, uint32_t hop)
+{
+  // only the thread owning the partition of context touches its slot
+  if (Simulator::GetContext () != context || Simulator::Now () != MilliSeconds (2 * hop))
+    {
+      m_error[context] = true;
+    }
+  ++m_received[context];
+  Simulator::Schedule (MicroSeconds (500),
+                       &MultithreadedSimulatorPartitionTestCase::Tick, this, context,
+                       Simulator::Now () + MicroSeconds (500));
+  Simulator::ScheduleWithContext ((context + 1) % NCONTEXTS, MilliSeconds (2),
+                                  &MultithreadedSimulatorPartitionTestCase::Ping, this,
+                                  (context + 1) % NCONTEXTS, hop + 1);
+}
+
+void
+MultithreadedSimulatorPartitionTestCase::Tick (uint32_t context, Time expected)
+{
+  if (Simulator::GetContext () != context || Simulator::Now () != expected)
+    {
+      m_error[context] = true;
+    }
+  ++m_ticks[context];
+}
+
+void
+MultithreadedSimulatorPartitionTestCase::DoSetup (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (m_threads));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (MilliSeconds (1)));
+  for (unsigned int i = 0; i < NCONTEXTS; ++i)
+    {
+      m_received[i] = 0;
+      m_ticks[i] = 0;
+      m_error[i] = false;
+    }
+}
+
+void
+MultithreadedSimulatorPartitionTestCase::DoTeardown (void)
+{
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (0));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (Seconds (0)));
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+void
+MultithreadedSimulatorPartitionTestCase::DoRun (void)
+{
+  Simulator::SetScheduler (m_schedulerFactory);
+
+  for (uint32_t i = 0; i < NCONTEXTS; ++i)
+    {
+      Simulator::ScheduleWithContext (i, Seconds (0),
+                                      &MultithreadedSimulatorPartitionTestCase::Ping, this, i, 0);
+    }
+  Simulator::Stop (MilliSeconds (101));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), MilliSeconds (101), "Bad stop time");
+  Simulator::Destroy ();
+
+  for (uint32_t i = 0; i < NCONTEXTS; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_error[i], false, "Bad time or context in context " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_received[i], 51, "Bad number of pings in context " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_ticks[i], 51, "Bad number of ticks in context " << i);
+    }
+}
+
+#define NHOPS 20
+
+class MultithreadedSimulatorLateEventTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorLateEventTestCase ();
+  void Hop (uint32_t context, uint32_t hop, Time expected);
+  uint32_t m_received[NCONTEXTS];
+  bool m_error[NCONTEXTS];
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+};
+
+MultithreadedSimulatorLateEventTestCase::MultithreadedSimulatorLateEventTestCase ()
+  : TestCase ("Check that events crossing partitions below the lookahead are "
+              "executed sequentially in ns3::MultithreadedSimulatorImpl")
+{
+}
+
+void
+MultithreadedSimulatorLateEventTestCase::Hop (uint32_t context, uint32_t hop, Time expected)
+{
+  // the first hops cross partitions below the lookahead, and are
+  // executed at the end of the window; the later ones run sequentially.
+  if (Simulator::GetContext () != context
+      || (hop == 1 && (Simulator::Now () < expected || Simulator::Now () > MilliSeconds (1)))
+      || (hop != 1 && Simulator::Now () != expected))
+    {
+      m_error[context] = true;
+    }
+  ++m_received[context];
+  if (hop < NHOPS)
+    {
+      Simulator::ScheduleWithContext ((context + 1) % NCONTEXTS, MicroSeconds (100),
+                                      &MultithreadedSimulatorLateEventTestCase::Hop, this,
+                                      (context + 1) % NCONTEXTS, hop + 1,
+                                      Simulator::Now () + MicroSeconds (100));
+    }
+}
+
+void
+MultithreadedSimulatorLateEventTestCase::DoSetup (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (2));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (MilliSeconds (1)));
+  for (unsigned int i = 0; i < NCONTEXTS; ++i)
+    {
+      m_received[i] = 0;
+      m_error[i] = false;
+    }
+}
+
+void
+MultithreadedSimulatorLateEventTestCase::DoTeardown (void)
+{
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (0));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (Seconds (0)));
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+void
+MultithreadedSimulatorLateEventTestCase::DoRun (void)
+{
+  for (uint32_t i = 0; i < NCONTEXTS; ++i)
+    {
+      Simulator::ScheduleWithContext (i, Seconds (0),
+                                      &MultithreadedSimulatorLateEventTestCase::Hop, this,
+                                      i, 0, Seconds (0));
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  for (uint32_t i = 0; i < NCONTEXTS; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_error[i], false, "Bad time or context in context " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_received[i], NHOPS + 1, "Bad number of hops in context " << i);
+    }
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -235,13 +421,15 @@ public:
 #ifdef HAVE_RT
       "ns3::RealtimeSimulatorImpl",
 #endif
-      "ns3::DefaultSimulatorImpl"
+      "ns3::DefaultSimulatorImpl",
+      "ns3::MultithreadedSimulatorImpl"
     };
     std::string schedulerTypes[] = {
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler"
     };
     unsigned int threadcounts[] = {
       0,
@@ -262,5 +450,19 @@ public:
               }
           }
       }
+    unsigned int partitioncounts[] = {
+      1,
+      2,
+      3
+    };
+    for (unsigned int j = 0; j < (sizeof(partitioncounts) / sizeof(partitioncounts[0])); ++j)
+      {
+        for (unsigned int k = 0; k < (sizeof(schedulerTypes) / sizeof(schedulerTypes[0])); ++k)
+          {
+            factory.SetTypeId (schedulerTypes[k]);
+            AddTestCase (new MultithreadedSimulatorPartitionTestCase (factory, partitioncounts[j]), TestCase::QUICK);
+          }
+      }
+    AddTestCase (new MultithreadedSimulatorLateEventTestCase, TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
@@ -217,9 +217,89 @@ CsmaNetDevice::DoDispose ()
   NS_LOG_FUNCTION_NOARGS ();
   m_channel = 0;
   m_node = 0;
+  m_queueInterface = 0;
   NetDevice::DoDispose ();
 }
 
+void
+CsmaNetDevice::NotifyNewAggregate (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_queueInterface == 0)
+    {
+      Ptr<NetDeviceQueueInterface> ndqi = this->GetObject<NetDeviceQueueInterface> ();
+      //verify that it's a valid netdevice queue interface and that
+      //the netdevice queue interface was not set before
+      if (ndqi != 0)
+        {
+          m_queueInterface = ndqi;
+        }
+    }
+  NetDevice::NotifyNewAggregate ();
+}
+
+bool
+CsmaNetDevice::HasRoomInQueue (void) const
+{
+  return (m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
+          m_queue->GetNPackets () < m_queue->GetMaxPackets ()) ||
+         (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
+          m_queue->GetNBytes () + m_mtu <= m_queue->GetMaxBytes ());
+}
+
+void
+CsmaNetDevice::DequeueAndTransmit (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<NetDeviceQueue> txq;
+  if (m_queueInterface)
+    {
+      txq = m_queueInterface->GetTxQueue (0);
+    }
+
+  if (m_queue->IsEmpty ())
+    {
+      if (txq)
+        {
+          NS_LOG_DEBUG ("The device queue is being woken up (" << m_queue->GetNPackets () <<
+                        " packets and " << m_queue->GetNBytes () << " bytes inside)");
+          txq->Wake ();
+        }
+      return;
+    }
+
+  Ptr<QueueItem> item = m_queue->Dequeue ();
+  NS_ASSERT_MSG (item != 0, "CsmaNetDevice::DequeueAndTransmit(): IsEmpty false but no Packet on queue?");
+
+  //
+  // If the queue was stopped, start it again if there is room for another
+  // packet. The upper layers cannot be woken up here, because a packet sent
+  // to the device now would find the machine state not ready.
+  //
+  if (txq && txq->IsStopped () && HasRoomInQueue ())
+    {
+      NS_LOG_DEBUG ("The device queue is being started (" << m_queue->GetNPackets () <<
+                    " packets and " << m_queue->GetNBytes () << " bytes inside)");
+      txq->Start ();
+    }
+
+  m_currentPkt = item->GetPacket ();
+  m_snifferTrace (m_currentPkt);
+  m_promiscSnifferTrace (m_currentPkt);
+  TransmitStart ();
+}
+
+void
+CsmaNetDevice::NotifyTransmittedBytes (uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << bytes);
+  if (m_queueInterface)
+    {
+      m_queueInterface->GetTxQueue (0)->NotifyTransmittedBytes (bytes);
+    }
+}
+
 void
 CsmaNetDevice::SetEncapsulationMode (enum EncapsulationMode mode)
 {
@@ -455,7 +535,9 @@ CsmaNetDevice::TransmitStart (void)
   if (IsSendEnabled () == false)
     {
       m_phyTxDropTrace (m_currentPkt);
+      uint32_t txBytes = m_currentPkt->GetSize ();
       m_currentPkt = 0;
+      NotifyTransmittedBytes (txBytes);
       return;
     }
 
@@ -508,8 +590,10 @@ CsmaNetDevice::TransmitStart (void)
         {
           NS_LOG_WARN ("Channel TransmitStart returns an error");
           m_phyTxDropTrace (m_currentPkt);
+          uint32_t txBytes = m_currentPkt->GetSize ();
           m_currentPkt = 0;
           m_txMachineState = READY;
+          NotifyTransmittedBytes (txBytes);
         } 
       else 
         {
@@ -542,6 +626,7 @@ CsmaNetDevice::TransmitAbort (void)
   NS_LOG_LOGIC ("Pkt UID is " << m_currentPkt->GetUid () << ")");
 
   m_phyTxDropTrace (m_currentPkt);
+  uint32_t txBytes = m_currentPkt->GetSize ();
   m_currentPkt = 0;
 
   NS_ASSERT_MSG (m_txMachineState == BACKOFF, "Must be in BACKOFF state to abort.  Tx state is: " << m_txMachineState);
@@ -558,19 +643,9 @@ CsmaNetDevice::TransmitAbort (void)
   // get that out.  If the queue is empty we just wait until someone puts one
   // in.
   //
-  if (m_queue->IsEmpty ())
-    {
-      return;
-    }
-  else
-    {
-      Ptr<QueueItem> item = m_queue->Dequeue ();
-      NS_ASSERT_MSG (item != 0, "CsmaNetDevice::TransmitAbort(): IsEmpty false but no Packet on queue?");
-      m_currentPkt = item->GetPacket ();
-      m_snifferTrace (m_currentPkt);
-      m_promiscSnifferTrace (m_currentPkt);
-      TransmitStart ();
-    }
+  DequeueAndTransmit ();
+
+  NotifyTransmittedBytes (txBytes);
 }
 
 void
@@ -598,8 +673,15 @@ CsmaNetDevice::TransmitCompleteEvent (void)
 
   m_channel->TransmitEnd (); 
   m_phyTxEndTrace (m_currentPkt);
+  uint32_t txBytes = m_currentPkt->GetSize ();
   m_currentPkt = 0;
 
+  //
+  // The machine state is not ready during the interframe gap, hence packets
+  // sent by the upper layers woken up by the queue limits are just queued.
+  //
+  NotifyTransmittedBytes (txBytes);
+
   NS_LOG_LOGIC ("Schedule TransmitReadyEvent in " << m_tInterframeGap.GetSeconds () << "sec");
 
   Simulator::Schedule (m_tInterframeGap, &CsmaNetDevice::TransmitReadyEvent, this);
@@ -627,19 +709,7 @@ CsmaNetDevice::TransmitReadyEvent (void)
   //
   // Get the next packet from the queue for transmitting
   //
-  if (m_queue->IsEmpty ())
-    {
-      return;
-    }
-  else
-    {
-      Ptr<QueueItem> item = m_queue->Dequeue ();
-      NS_ASSERT_MSG (item != 0, "CsmaNetDevice::TransmitReadyEvent(): IsEmpty false but no Packet on queue?");
-      m_currentPkt = item->GetPacket ();
-      m_snifferTrace (m_currentPkt);
-      m_promiscSnifferTrace (m_currentPkt);
-      TransmitStart ();
-    }
+  DequeueAndTransmit ();
 }
 
 bool
@@ -951,6 +1021,14 @@ CsmaNetDevice::SendFrom (Ptr<Packet> packet, const Address& src, const Address&
 
   NS_ASSERT (IsLinkUp ());
 
+  Ptr<NetDeviceQueue> txq;
+  if (m_queueInterface)
+    {
+      txq = m_queueInterface->GetTxQueue (0);
+    }
+
+  NS_ASSERT_MSG (!txq || !txq->IsStopped (), "Send should not be called when the device is stopped");
+
   //
   // Only transmit if send side of net device is enabled
   //
@@ -973,9 +1051,23 @@ CsmaNetDevice::SendFrom (Ptr<Packet> packet, const Address& src, const Address&
   if (m_queue->Enqueue (Create<QueueItem> (packet)) == false)
     {
       m_macTxDropTrace (packet);
+      // This should not happen if the traffic control module has been
+      // installed. Anyway, stop the tx queue, so that the upper layers do
+      // not send packets until there is room in the queue again.
+      if (txq)
+        {
+          NS_LOG_ERROR ("BUG! Device queue full when the queue is not stopped! (" << m_queue->GetNPackets () <<
+                        " packets and " << m_queue->GetNBytes () << " bytes inside)");
+          txq->Stop ();
+        }
       return false;
     }
 
+  if (txq)
+    {
+      txq->NotifyQueuedBytes (packet->GetSize ());
+    }
+
   //
   // If the device is idle, we need to start a transmission. Otherwise,
   // the transmission will be started when the current packet finished
@@ -993,6 +1085,16 @@ CsmaNetDevice::SendFrom (Ptr<Packet> packet, const Address& src, const Address&
           TransmitStart ();
         }
     }
+
+  //
+  // Stop the tx queue if there is no room for another packet
+  //
+  if (txq && !HasRoomInQueue ())
+    {
+      NS_LOG_DEBUG ("The device queue is being stopped (" << m_queue->GetNPackets () <<
+                    " packets and " << m_queue->GetNBytes () << " bytes inside)");
+      txq->Stop ();
+    }
   return true;
 }
 
@@ -344,6 +344,12 @@ protected:
    */
   virtual void DoDispose (void);
 
+  /**
+   * Get a pointer to the netdevice queue interface, if it has been
+   * aggregated to this device
+   */
+  virtual void NotifyNewAggregate (void);
+
   /**
    * Adds the necessary headers and trailers to a packet of data in order to
    * respect the packet type
@@ -433,6 +439,29 @@ private:
    */
   void TransmitReadyEvent (void);
 
+  /**
+   * Dequeue the next packet, if any, and start transmitting it. If the
+   * queue is empty, the netdevice queue (if any) is woken up; otherwise, it
+   * is restarted (if it was stopped) when there is room for another packet.
+   */
+  void DequeueAndTransmit (void);
+
+  /**
+   * Check whether the device queue can store another packet (or another
+   * MTU-sized packet if the queue operates in byte mode).
+   *
+   * \return true if there is room for another packet in the queue
+   */
+  bool HasRoomInQueue (void) const;
+
+  /**
+   * Report the given number of bytes, which left the device (transmitted or
+   * dropped), to the Byte Queue Limits of the netdevice queue, if any.
+   *
+   * \param bytes the number of bytes
+   */
+  void NotifyTransmittedBytes (uint32_t bytes);
+
   /**
    * Aborts the transmission of the current packet
    *
@@ -532,6 +561,12 @@ private:
    */
   Ptr<Queue> m_queue;
 
+  /**
+   * The NetDevice queue interface, used for flow control and Byte Queue
+   * Limits if the traffic control layer is installed on this device.
+   */
+  Ptr<NetDeviceQueueInterface> m_queueInterface;
+
   /**
    * Error model for receive packet events.  When active this model will be
    * used to model transmission errors by marking some of the packets 
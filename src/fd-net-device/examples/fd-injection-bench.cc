@@ -0,0 +1,159 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+//   writer thread                      node 0
+//  +----------------+              +----------------+
+//  |  raw Ethernet  |  socketpair  |  fd-net-device |
+//  |     frames     |--------------|  reader thread |
+//  +----------------+              +----------------+
+//
+// This program measures the rate at which frames read by the reader
+// thread of a FdNetDevice can be injected into the simulator, which is
+// the bottleneck of emulation at line rate.  A writer thread pushes
+// broadcast Ethernet frames into one end of a socket pair as fast as
+// it can, and the FdNetDevice owning the other end schedules one event
+// per frame from its reader thread.  The program stops when all the
+// frames have been received by the device and prints the throughput.
+//
+// With the default simulator implementation, a periodic event keeps the
+// simulation alive while frames are in flight.
+//
+// $ ./waf --run="fd-injection-bench --packets=1000000"
+// $ ./waf --run="fd-injection-bench --realtime=1"
+//
+
+#include <sys/socket.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/fd-net-device-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("FdInjectionBench");
+
+static uint32_t g_packets = 100000;
+static uint32_t g_size = 1000;
+static uint32_t g_received = 0;
+static int g_writerFd = -1;
+
+static void
+Writer (void)
+{
+  std::vector<uint8_t> frame (g_size, 0);
+  // broadcast destination, locally administered source, experimental type
+  std::memset (&frame[0], 0xff, 6);
+  frame[6] = 0x02;
+  frame[12] = 0x88;
+  frame[13] = 0xb5;
+  for (uint32_t i = 0; i < g_packets; ++i)
+    {
+      if (write (g_writerFd, &frame[0], frame.size ()) < 0)
+        {
+          NS_FATAL_ERROR ("Error writing frame: " << std::strerror (errno));
+        }
+    }
+}
+
+static bool
+Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  if (++g_received == g_packets)
+    {
+      Simulator::Stop ();
+    }
+  return true;
+}
+
+static void
+KeepAlive (void)
+{
+  if (g_received < g_packets)
+    {
+      Simulator::Schedule (MicroSeconds (1), &KeepAlive);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  bool realtime = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("packets", "Number of frames to inject", g_packets);
+  cmd.AddValue ("size", "Size of the frames, in bytes", g_size);
+  cmd.AddValue ("realtime", "Use the realtime simulator implementation", realtime);
+  cmd.Parse (argc, argv);
+
+  if (g_size < 14)
+    {
+      NS_FATAL_ERROR ("Frames must be at least as long as an Ethernet header");
+    }
+  if (realtime)
+    {
+      GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::RealtimeSimulatorImpl"));
+    }
+
+  NodeContainer nodes;
+  nodes.Create (1);
+
+  FdNetDeviceHelper fd;
+  // the device must not drop frames when the simulator falls behind
+  fd.SetAttribute ("RxQueueSize", UintegerValue (g_packets));
+  NetDeviceContainer devices = fd.Install (nodes);
+
+  int sv[2];
+  if (socketpair (AF_UNIX, SOCK_DGRAM, 0, sv) < 0)
+    {
+      NS_FATAL_ERROR ("Error creating socket pair: " << std::strerror (errno));
+    }
+  Ptr<FdNetDevice> device = devices.Get (0)->GetObject<FdNetDevice> ();
+  device->SetFileDescriptor (sv[0]);
+  device->SetReceiveCallback (MakeCallback (&Receive));
+  g_writerFd = sv[1];
+
+  if (!realtime)
+    {
+      Simulator::Schedule (Seconds (0), &KeepAlive);
+    }
+
+  Ptr<SystemThread> writer = Create<SystemThread> (MakeCallback (&Writer));
+  SystemWallClockMs clock;
+  clock.Start ();
+  writer->Start ();
+  Simulator::Run ();
+  int64_t elapsed = clock.End ();
+  writer->Join ();
+
+  std::cout << g_received << " frames of " << g_size << " bytes in "
+            << elapsed << " ms";
+  if (elapsed > 0)
+    {
+      std::cout << ", " << g_received * 1000.0 / elapsed << " frames/s";
+    }
+  std::cout << std::endl;
+
+  Simulator::Destroy ();
+  close (sv[1]);
+  return 0;
+}
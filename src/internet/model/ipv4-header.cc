@@ -473,4 +473,16 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
   return GetSerializedSize ();
 }
 
+bool
+Ipv4Header::CopyTo (Header &header) const
+{
+  NS_LOG_FUNCTION (this << &header);
+  if (m_calcChecksum)
+    {
+      return false;
+    }
+  static_cast<Ipv4Header &> (header) = *this;
+  return true;
+}
+
 } // namespace ns3
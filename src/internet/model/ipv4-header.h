@@ -235,6 +235,7 @@ public:
   virtual uint32_t GetSerializedSize (void) const;
   virtual void Serialize (Buffer::Iterator start) const;
   virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual bool CopyTo (Header &header) const;
 private:
 
   /// flags related to IP fragmentation
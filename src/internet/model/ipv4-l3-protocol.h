@@ -426,8 +426,8 @@ private:
    * \param ipv4 the Ipv4 protocol
    * \param interface the interface index
    *
-   * Note: If the TracedCallback API ever is extended, we could consider
-   * to check for connected functions before adding the header
+   * Nothing is done if no function is connected to the TX trace, so that
+   * the header is not serialized needlessly.
    */
   void CallTxTrace (const Ipv4Header & ipHeader, Ptr<Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
 
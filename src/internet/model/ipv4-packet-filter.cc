@@ -22,6 +22,7 @@
 
 #include "ns3/log.h"
 #include "ns3/enum.h"
+#include "ns3/uinteger.h"
 #include "ipv4-queue-disc-item.h"
 #include "ipv4-packet-filter.h"
 
@@ -58,4 +59,46 @@ Ipv4PacketFilter::CheckProtocol (Ptr<QueueDiscItem> item) const
   return (DynamicCast<Ipv4QueueDiscItem> (item) != 0);
 }
 
+// ------------------------------------------------------------------------- //
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv4FlowHashPacketFilter);
+
+TypeId
+Ipv4FlowHashPacketFilter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4FlowHashPacketFilter")
+    .SetParent<Ipv4PacketFilter> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<Ipv4FlowHashPacketFilter> ()
+    .AddAttribute ("Buckets",
+                   "The number of buckets the packets are classified into",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&Ipv4FlowHashPacketFilter::m_buckets),
+                   MakeUintegerChecker<uint32_t> (1, 0x7fffffff))
+    .AddAttribute ("Perturbation",
+                   "The value combined with the hash of the flow (0 means none)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4FlowHashPacketFilter::m_perturbation),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+Ipv4FlowHashPacketFilter::Ipv4FlowHashPacketFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv4FlowHashPacketFilter::~Ipv4FlowHashPacketFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+int32_t
+Ipv4FlowHashPacketFilter::DoClassify (Ptr<QueueDiscItem> item) const
+{
+  NS_LOG_FUNCTION (this << item);
+  return item->GetFlowHash (m_perturbation) % m_buckets;
+}
+
 } // namespace ns3
@@ -17,7 +17,9 @@
  */
 
 #include "ns3/log.h"
+#include "ns3/hash.h"
 #include "ipv4-queue-disc-item.h"
+#include <cstring>
 
 namespace ns3 {
 
@@ -80,45 +82,42 @@ Ipv4QueueDiscItem::Print (std::ostream& os) const
 }
 
 bool
-Ipv4QueueDiscItem::IsEcnCapable(void) const
+Ipv4QueueDiscItem::IsEcnCapable (void) const
 {
   NS_LOG_FUNCTION (this);
-  Ptr<Packet> p = GetPacket();
-  Ipv4Header ipvh;
-  p->PeekHeader(ipvh);
-  if(ipvh.GetEcn()==Ipv4Header::ECN_ECT1 || ipvh.GetEcn()==Ipv4Header::ECN_ECT0)
-    return true;
-
-  return false;
+  Ipv4Header::EcnType ecn = m_header.GetEcn ();
+  return ecn == Ipv4Header::ECN_ECT1 || ecn == Ipv4Header::ECN_ECT0;
 }
 
 bool
-Ipv4QueueDiscItem::Mark(void)
+Ipv4QueueDiscItem::Mark (void)
 {
   NS_LOG_FUNCTION (this);
-  if(IsEcnCapable())
-  {
-    Ptr<Packet> p = GetPacket();
-    Ipv4Header ipvh;
-    p->RemoveHeader(ipvh);
-    ipvh.SetEcn(Ipv4Header::ECN_CE);
-    p->AddHeader(ipvh);
-    return true;
-  }
+  if (IsMarked ())
+    {
+      return true;
+    }
+  if (!IsEcnCapable ())
+    {
+      return false;
+    }
+  m_header.SetEcn (Ipv4Header::ECN_CE);
+  if (m_headerAdded)
+    {
+      // Rare case (e.g., a requeued packet): overwrite the serialized header
+      // with the cached one, without parsing it again
+      Ptr<Packet> p = GetPacket ();
+      p->RemoveAtStart (m_header.GetSerializedSize ());
+      p->AddHeader (m_header);
+    }
   return true;
 }
 
 bool
-Ipv4QueueDiscItem::IsMarked(void) const
+Ipv4QueueDiscItem::IsMarked (void) const
 {
   NS_LOG_FUNCTION (this);
-  Ptr<Packet> p = GetPacket();
-  Ipv4Header ipvh;
-  p->PeekHeader(ipvh);
-  if(ipvh.GetEcn()==Ipv4Header::ECN_CE)
-    return true; 
-
-  return false;
+  return m_header.GetEcn () == Ipv4Header::ECN_CE;
 }
 
 bool
@@ -137,4 +136,35 @@ Ipv4QueueDiscItem::GetUint8Value (QueueItem::Uint8Values field, uint8_t& value)
   return ret;
 }
 
+uint32_t
+Ipv4QueueDiscItem::Hash (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  // source address, destination address, protocol and ports
+  uint8_t buf[13];
+  m_header.GetSource ().Serialize (buf);
+  m_header.GetDestination ().Serialize (buf + 4);
+  buf[8] = m_header.GetProtocol ();
+  std::memset (buf + 9, 0, 4);
+
+  // Only the first fragment carries the ports, so fragments are hashed
+  // without them to keep all the fragments of a packet in the same flow
+  bool isFragment = m_header.GetFragmentOffset () != 0 || !m_header.IsLastFragment ();
+  if ((buf[8] == 6 || buf[8] == 17) && !isFragment)
+    {
+      // TCP and UDP ports are the first four bytes of the transport header
+      uint32_t offset = m_headerAdded ? m_header.GetSerializedSize () : 0;
+      uint8_t data[64];
+      Ptr<Packet> p = GetPacket ();
+      if (p->GetSize () >= offset + 4)
+        {
+          p->CopyData (data, offset + 4);
+          std::memcpy (buf + 9, data + offset, 4);
+        }
+    }
+
+  return ns3::Hash32 ((const char*) buf, sizeof (buf));
+}
+
 } // namespace ns3
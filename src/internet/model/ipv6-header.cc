@@ -185,6 +185,12 @@ uint32_t Ipv6Header::Deserialize (Buffer::Iterator start)
   return GetSerializedSize ();
 }
 
+bool Ipv6Header::CopyTo (Header &header) const
+{
+  static_cast<Ipv6Header &> (header) = *this;
+  return true;
+}
+
 void Ipv6Header::SetDscp (DscpType dscp)
 {
   NS_LOG_FUNCTION (this << dscp);
@@ -241,6 +241,13 @@ public:
    * \return size of the packet
    */
   virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  /**
+   * \brief Copy the header into another Ipv6Header.
+   * \param header the Ipv6Header to copy into
+   * \return true
+   */
+  virtual bool CopyTo (Header &header) const;
    
   /**
    * \enum EcnType
@@ -508,8 +508,8 @@ private:
    * \param ipv6 the Ipv6 protocol
    * \param interface the interface index
    *
-   * Note: If the TracedCallback API ever is extended, we could consider
-   * to check for connected functions before adding the header
+   * Nothing is done if no function is connected to the TX trace, so that
+   * the header is not serialized needlessly.
    */
   void CallTxTrace (const Ipv6Header & ipHeader, Ptr<Packet> packet, Ptr<Ipv6> ipv6, uint32_t interface);
 
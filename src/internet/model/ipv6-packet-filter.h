@@ -50,6 +50,36 @@ private:
   virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const = 0;
 };
 
+
+/**
+ * \ingroup ipv6
+ * \ingroup traffic-control
+ *
+ * Ipv6FlowHashPacketFilter classifies the IPv6 packets into a number of
+ * Buckets based on the hash of their flow (addresses, protocol and ports).
+ * The hash is computed only once per packet and stored in the queue disc
+ * item (see QueueDiscItem::GetFlowHash), so that it is shared with the other
+ * users of the hash of the flow (e.g., the traffic control layer selecting
+ * the transmission queue of a multi-queue device).
+ */
+class Ipv6FlowHashPacketFilter : public Ipv6PacketFilter {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  Ipv6FlowHashPacketFilter ();
+  virtual ~Ipv6FlowHashPacketFilter ();
+
+private:
+  virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const;
+
+  uint32_t m_buckets;        //!< Number of buckets
+  uint32_t m_perturbation;   //!< Value combined with the hash of the flow
+};
+
 } // namespace ns3
 
 #endif /* IPV6_PACKET_FILTER */
@@ -17,7 +17,9 @@
  */
 
 #include "ns3/log.h"
+#include "ns3/hash.h"
 #include "ipv6-queue-disc-item.h"
+#include <cstring>
 
 namespace ns3 {
 
@@ -96,45 +98,72 @@ Ipv6QueueDiscItem::GetUint8Value (QueueItem::Uint8Values field, uint8_t& value)
 }
 
 bool
-Ipv6QueueDiscItem::IsEcnCapable(void) const
+Ipv6QueueDiscItem::IsEcnCapable (void) const
 {
   NS_LOG_FUNCTION (this);
-  Ptr<Packet> p = GetPacket();
-  Ipv6Header ipvh;
-  p->PeekHeader(ipvh);
-  if(ipvh.GetEcn()==Ipv6Header::ECN_ECT1 || ipvh.GetEcn()==Ipv6Header::ECN_ECT0)
-    return true;
-
-  return false;
+  Ipv6Header::EcnType ecn = m_header.GetEcn ();
+  return ecn == Ipv6Header::ECN_ECT1 || ecn == Ipv6Header::ECN_ECT0;
 }
 
 bool
-Ipv6QueueDiscItem::Mark(void)
+Ipv6QueueDiscItem::Mark (void)
 {
   NS_LOG_FUNCTION (this);
-  if(IsEcnCapable())
-  {
-    Ptr<Packet> p = GetPacket();
-    Ipv6Header ipvh;
-    p->RemoveHeader(ipvh);
-    ipvh.SetEcn(Ipv6Header::ECN_CE);
-    p->AddHeader(ipvh);
-    return true;
-  }
+  if (IsMarked ())
+    {
+      return true;
+    }
+  if (!IsEcnCapable ())
+    {
+      return false;
+    }
+  m_header.SetEcn (Ipv6Header::ECN_CE);
+  if (m_headerAdded)
+    {
+      // Rare case (e.g., a requeued packet): overwrite the serialized header
+      // with the cached one, without parsing it again
+      Ptr<Packet> p = GetPacket ();
+      p->RemoveAtStart (m_header.GetSerializedSize ());
+      p->AddHeader (m_header);
+    }
   return true;
 }
 
 bool
-Ipv6QueueDiscItem::IsMarked(void) const
+Ipv6QueueDiscItem::IsMarked (void) const
 {
   NS_LOG_FUNCTION (this);
-  Ptr<Packet> p = GetPacket();
-  Ipv6Header ipvh;
-  p->PeekHeader(ipvh);
-  if(ipvh.GetEcn()==Ipv6Header::ECN_CE)
-    return true; 
+  return m_header.GetEcn () == Ipv6Header::ECN_CE;
+}
+
+uint32_t
+Ipv6QueueDiscItem::Hash (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  // source address, destination address, next header and ports
+  uint8_t buf[37];
+  m_header.GetSourceAddress ().Serialize (buf);
+  m_header.GetDestinationAddress ().Serialize (buf + 16);
+  buf[32] = m_header.GetNextHeader ();
+  std::memset (buf + 33, 0, 4);
+
+  // The ports are only looked for right after the basic header: packets with
+  // extension headers are hashed on the addresses only
+  if (buf[32] == 6 || buf[32] == 17)
+    {
+      // TCP and UDP ports are the first four bytes of the transport header
+      uint32_t offset = m_headerAdded ? m_header.GetSerializedSize () : 0;
+      uint8_t data[44];
+      Ptr<Packet> p = GetPacket ();
+      if (p->GetSize () >= offset + 4)
+        {
+          p->CopyData (data, offset + 4);
+          std::memcpy (buf + 33, data + offset, 4);
+        }
+    }
 
-  return false;
+  return ns3::Hash32 ((const char*) buf, sizeof (buf));
 }
 
 } // namespace ns3
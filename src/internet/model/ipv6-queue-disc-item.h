@@ -35,6 +35,13 @@ namespace ns3 {
  * Ipv6QueueDiscItem is a subclass of QueueDiscItem which stores IPv6 packets.
  * Header and payload are kept separate to allow the queue disc to manipulate
  * the header, which is added to the packet when the packet is dequeued.
+ *
+ * The parsed header stored in the item remains valid after it is added to
+ * the packet, hence classification, hashing and ECN marking always operate on
+ * it and never deserialize the header from the packet. The packet buffer is
+ * written only once, when the header is added at the handoff to the device,
+ * unless a packet whose header has been already added is marked (e.g., a
+ * requeued packet), in which case the serialized header is overwritten.
  */
 class Ipv6QueueDiscItem : public QueueDiscItem {
 public:
@@ -73,9 +80,7 @@ public:
   /*
    * The values for the fields of the Ipv6 header are taken from m_header and
    * thus might differ from those present in the packet in case the header is
-   * modified after being added to the packet. However, this function is likely
-   * to be called before the header is added to the packet (i.e., before the
-   * packet is dequeued from the queue disc)
+   * modified by someone else after being added to the packet.
    */
   virtual bool GetUint8Value (Uint8Values field, uint8_t &value) const;
   
@@ -86,8 +91,8 @@ public:
   bool IsEcnCapable (void) const;
 
   /**
-   * \brief Sets a congestion experienced field in the packet if there is congestion and if the packet has ect filed set on
-   * \returns true if the packet has been marked and false otherwise
+   * \brief Sets the congestion experienced codepoint if the packet is ECN capable
+   * \returns true if the packet has been marked or was already marked, false otherwise
    */
   virtual bool Mark (void);
 
@@ -97,6 +102,17 @@ public:
    */  
   virtual bool IsMarked (void) const;
 
+  /**
+   * \brief Compute the hash of the 5-tuple of the packet
+   *
+   * The source and destination addresses, the next header and, for
+   * TCP and UDP packets, the source and destination ports are
+   * hashed.
+   *
+   * \returns the hash of the 5-tuple
+   */
+  virtual uint32_t Hash (void) const;
+
 private:
   /**
    * \brief Default constructor
@@ -118,7 +134,7 @@ private:
    */
   Ipv6QueueDiscItem &operator = (const Ipv6QueueDiscItem &);
 
-  Ipv6Header m_header;  //!< The IPv6 header.
+  Ipv6Header m_header;  //!< The IPv6 header, also after being added to the packet.
   bool m_headerAdded;   //!< True if the header has already been added to the packet.
 };
 
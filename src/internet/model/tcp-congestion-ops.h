@@ -78,6 +78,10 @@ public:
   /**
    * \brief Get the slow start threshold after a loss event
    *
+   * The method is also called when an ECN echo is received, with the
+   * congestion state set to CA_CWR; in that case the returned value is used
+   * for the congestion window as well.
+   *
    * Is guaranteed that the congestion control state (TcpAckState_t) is
    * changed BEFORE the invocation of this method.
    * The implementator should return the slow start threshold (and not change
@@ -136,6 +140,23 @@ public:
   {
   }
 
+  /**
+   * \brief Whether the receiver must echo each CE mark precisely
+   *
+   * By default, the receiver sets ECE on all its ACKs from the reception of
+   * a CE mark until the reception of CWR, as in RFC 3168. Congestion controls
+   * that estimate the extent of the congestion from the echoes, like DCTCP,
+   * return true: then ECE is set on an ACK if and only if the last data
+   * segment received was marked, and a delayed ACK is sent as soon as the
+   * CE codepoint of the incoming segments changes.
+   *
+   * \return true if CE marks must be echoed precisely
+   */
+  virtual bool NeedsAccurateEcnEcho (void) const
+  {
+    return false;
+  }
+
   // Present in Linux but not in ns-3 yet:
   /* call when cwnd event occurs (optional) */
   // void (*cwnd_event)(struct sock *sk, enum tcp_ca_event ev);
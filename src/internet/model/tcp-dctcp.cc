@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-dctcp.h"
+#include "ns3/tcp-socket-base.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpDctcp");
+NS_OBJECT_ENSURE_REGISTERED (TcpDctcp);
+
+TypeId
+TcpDctcp::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpDctcp")
+    .SetParent<TcpNewReno> ()
+    .AddConstructor<TcpDctcp> ()
+    .SetGroupName ("Internet")
+    .AddAttribute ("G", "Weight of the last window in the estimation of alpha",
+                   DoubleValue (0.0625),
+                   MakeDoubleAccessor (&TcpDctcp::m_g),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("InitialAlpha", "Value of alpha before the first estimation",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&TcpDctcp::m_alpha),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddTraceSource ("Alpha",
+                     "Estimation of the extent of the congestion",
+                     MakeTraceSourceAccessor (&TcpDctcp::m_alpha),
+                     "ns3::TracedValueCallback::Double")
+  ;
+  return tid;
+}
+
+TcpDctcp::TcpDctcp (void)
+  : TcpNewReno (),
+    m_alpha (1.0),
+    m_g (0.0625),
+    m_ackedBytesEcn (0),
+    m_ackedBytesTotal (0),
+    m_nextSeq (0),
+    m_nextSeqValid (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpDctcp::TcpDctcp (const TcpDctcp& sock)
+  : TcpNewReno (sock),
+    m_alpha (sock.m_alpha),
+    m_g (sock.m_g),
+    m_ackedBytesEcn (sock.m_ackedBytesEcn),
+    m_ackedBytesTotal (sock.m_ackedBytesTotal),
+    m_nextSeq (sock.m_nextSeq),
+    m_nextSeqValid (sock.m_nextSeqValid)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpDctcp::~TcpDctcp (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ptr<TcpCongestionOps>
+TcpDctcp::Fork (void)
+{
+  return CopyObject<TcpDctcp> (this);
+}
+
+std::string
+TcpDctcp::GetName () const
+{
+  return "TcpDctcp";
+}
+
+bool
+TcpDctcp::NeedsAccurateEcnEcho (void) const
+{
+  return true;
+}
+
+void
+TcpDctcp::PktsAcked (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked,
+                     const Time &rtt)
+{
+  NS_LOG_FUNCTION (this << tcb << segmentsAcked << rtt);
+
+  uint32_t bytesAcked = segmentsAcked * tcb->m_segmentSize;
+  m_ackedBytesTotal += bytesAcked;
+  if (tcb->m_ecnFlags & TcpSocketState::ECN_ECE_RCVD)
+    {
+      m_ackedBytesEcn += bytesAcked;
+    }
+
+  if (!m_nextSeqValid)
+    {
+      m_nextSeq = tcb->m_nextTxSequence;
+      m_nextSeqValid = true;
+    }
+
+  if (tcb->m_lastAckedSeq >= m_nextSeq)
+    {
+      // A window of data has been acked: update alpha (Equation 1)
+      double fraction = 0.0;
+      if (m_ackedBytesTotal > 0)
+        {
+          fraction = static_cast<double> (m_ackedBytesEcn) / m_ackedBytesTotal;
+        }
+      m_alpha = (1.0 - m_g) * m_alpha + m_g * fraction;
+      NS_LOG_INFO (m_ackedBytesEcn << " bytes marked out of " << m_ackedBytesTotal <<
+                   ", alpha updated to " << m_alpha);
+
+      m_ackedBytesEcn = 0;
+      m_ackedBytesTotal = 0;
+      m_nextSeq = tcb->m_nextTxSequence;
+    }
+}
+
+uint32_t
+TcpDctcp::GetSsThresh (Ptr<const TcpSocketState> tcb,
+                       uint32_t bytesInFlight)
+{
+  NS_LOG_FUNCTION (this << tcb << bytesInFlight);
+
+  if (tcb->m_congState != TcpSocketState::CA_CWR)
+    {
+      return TcpNewReno::GetSsThresh (tcb, bytesInFlight);
+    }
+
+  // Equation 2
+  uint32_t ssThresh = static_cast<uint32_t> (tcb->m_cWnd * (1.0 - m_alpha / 2.0));
+  NS_LOG_DEBUG ("ECN echo with alpha " << m_alpha << ": ssThresh " << ssThresh);
+  return std::max (2 * tcb->m_segmentSize, ssThresh);
+}
+
+} // namespace ns3
@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef TCPDCTCP_H
+#define TCPDCTCP_H
+
+#include "ns3/tcp-congestion-ops.h"
+#include "ns3/traced-value.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup congestionOps
+ *
+ * \brief An implementation of Data Center TCP (DCTCP)
+ *
+ * DCTCP reacts to the extent of the congestion, rather than to its
+ * presence only. The sender estimates the fraction F of the bytes acked
+ * with ECE in each window of data, and updates once per window
+ *
+ *         alpha = (1 - g) * alpha + g * F              (1)
+ *
+ * When an ECE is received, cwnd is reduced (once per window, in the
+ * CA_CWR state of TcpSocketBase) as
+ *
+ *         cwnd = cwnd * (1 - alpha / 2)                (2)
+ *
+ * while packet losses are handled as in NewReno. The window growth is the
+ * one of NewReno as well.
+ *
+ * DCTCP needs ECN on both ends (attribute "UseEcn" of TcpSocketBase), a
+ * receiver which echoes each CE mark precisely (see
+ * TcpCongestionOps::NeedsAccurateEcnEcho) and switches that mark packets as
+ * soon as the instantaneous queue exceeds a threshold K (see the
+ * "StepMarking" attribute of RedQueueDisc).
+ *
+ * More information: http://doi.acm.org/10.1145/1851182.1851192 and RFC 8257
+ */
+class TcpDctcp : public TcpNewReno
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Create an unbound tcp socket.
+   */
+  TcpDctcp (void);
+
+  /**
+   * \brief Copy constructor
+   * \param sock the object to copy
+   */
+  TcpDctcp (const TcpDctcp& sock);
+  virtual ~TcpDctcp (void);
+
+  virtual std::string GetName () const;
+
+  /**
+   * \brief Get the slow start threshold
+   *
+   * After an ECN echo, the window is reduced following Equation 2;
+   * after a loss, it is halved as in NewReno.
+   *
+   * \param tcb internal congestion state
+   * \param bytesInFlight bytes in flight
+   *
+   * \return the slow start threshold value
+   */
+  virtual uint32_t GetSsThresh (Ptr<const TcpSocketState> tcb,
+                                uint32_t bytesInFlight);
+
+  /**
+   * \brief Account the bytes acked, with and without ECE
+   *
+   * Once all the data outstanding at the previous update has been acked,
+   * alpha is updated following Equation 1.
+   *
+   * \param tcb internal congestion state
+   * \param segmentsAcked count of segments acked
+   * \param rtt last rtt
+   */
+  virtual void PktsAcked (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked,
+                          const Time &rtt);
+
+  virtual bool NeedsAccurateEcnEcho (void) const;
+
+  virtual Ptr<TcpCongestionOps> Fork ();
+
+private:
+  TracedValue<double> m_alpha;      //!< Estimation of the extent of the congestion
+  double m_g;                       //!< Weight of the last window in the estimation
+  uint32_t m_ackedBytesEcn;         //!< Bytes acked with ECE in this window
+  uint32_t m_ackedBytesTotal;       //!< Bytes acked in this window
+  SequenceNumber32 m_nextSeq;       //!< End of the observation window
+  bool m_nextSeqValid;              //!< True if m_nextSeq has been set
+};
+
+} // namespace ns3
+
+#endif // TCPDCTCP_H
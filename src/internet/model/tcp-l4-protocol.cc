@@ -42,6 +42,7 @@
 #include "tcp-socket-factory-impl.h"
 #include "tcp-socket-base.h"
 #include "tcp-congestion-ops.h"
+#include "tcp-pacing-wheel.h"
 #include "rtt-estimator.h"
 
 #include <vector>
@@ -156,6 +157,12 @@ TcpL4Protocol::DoDispose (void)
   NS_LOG_FUNCTION (this);
   m_sockets.clear ();
 
+  if (m_pacingWheel != 0)
+    {
+      m_pacingWheel->Dispose ();
+      m_pacingWheel = 0;
+    }
+
   if (m_endPoints != 0)
     {
       delete m_endPoints;
@@ -202,6 +209,16 @@ TcpL4Protocol::CreateSocket (void)
   return CreateSocket (m_congestionTypeId);
 }
 
+Ptr<TcpPacingWheel>
+TcpL4Protocol::GetPacingWheel (void)
+{
+  if (m_pacingWheel == 0)
+    {
+      m_pacingWheel = CreateObject<TcpPacingWheel> ();
+    }
+  return m_pacingWheel;
+}
+
 Ipv4EndPoint *
 TcpL4Protocol::Allocate (void)
 {
@@ -41,6 +41,7 @@ class TcpSocketBase;
 class Ipv4EndPoint;
 class Ipv6EndPoint;
 class NetDevice;
+class TcpPacingWheel;
 
 
 /**
@@ -115,6 +116,15 @@ public:
    */
   Ptr<Socket> CreateSocket (TypeId congestionTypeId);
 
+  /**
+   * \brief Get the timer wheel shared by the paced sockets of this node
+   *
+   * The wheel is created the first time this method is called.
+   *
+   * \return the pacing timer wheel
+   */
+  Ptr<TcpPacingWheel> GetPacingWheel (void);
+
   /**
    * \brief Allocate an IPv4 Endpoint
    * \return the Endpoint
@@ -299,6 +309,7 @@ private:
   TypeId m_rttTypeId;              //!< The RTT Estimator TypeId
   TypeId m_congestionTypeId;       //!< The socket TypeId
   std::vector<Ptr<TcpSocketBase> > m_sockets;      //!< list of sockets
+  Ptr<TcpPacingWheel> m_pacingWheel;               //!< timer wheel of the paced sockets
   IpL4Protocol::DownTargetCallback m_downTarget;   //!< Callback to send packets over IPv4
   IpL4Protocol::DownTargetCallback6 m_downTarget6; //!< Callback to send packets over IPv6
 
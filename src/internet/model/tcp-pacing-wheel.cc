@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tcp-pacing-wheel.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpPacingWheel");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpPacingWheel);
+
+TypeId
+TcpPacingWheel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpPacingWheel")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpPacingWheel> ()
+    .AddAttribute ("Granularity",
+                   "The width of the interval covered by a slot of the wheel",
+                   TimeValue (MicroSeconds (10)),
+                   MakeTimeAccessor (&TcpPacingWheel::m_granularity),
+                   MakeTimeChecker (TimeStep (1)))
+    .AddAttribute ("Slots",
+                   "The number of slots of the wheel",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&TcpPacingWheel::m_nSlots),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+TcpPacingWheel::TcpPacingWheel ()
+  : m_nPending (0),
+    m_eventTick (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpPacingWheel::~TcpPacingWheel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpPacingWheel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_event.Cancel ();
+  m_slots.clear ();
+  m_due.clear ();
+  m_nPending = 0;
+  Object::DoDispose ();
+}
+
+uint32_t
+TcpPacingWheel::GetNPending (void) const
+{
+  return m_nPending;
+}
+
+void
+TcpPacingWheel::ScheduleAt (Time when, Callback<void> cb)
+{
+  NS_LOG_FUNCTION (this << when);
+
+  if (m_slots.empty ())
+    {
+      m_slots.resize (m_nSlots);
+    }
+
+  int64_t granularity = m_granularity.GetTimeStep ();
+  // Round up, so that the callback is never invoked before the given time
+  uint64_t tick = (std::max (when, Simulator::Now ()).GetTimeStep () + granularity - 1) / granularity;
+
+  Entry entry;
+  entry.tick = tick;
+  entry.cb = cb;
+  m_slots[tick % m_nSlots].push_back (entry);
+  m_nPending++;
+
+  ScheduleTick (tick);
+}
+
+void
+TcpPacingWheel::ScheduleTick (uint64_t tick)
+{
+  NS_LOG_FUNCTION (this << tick);
+
+  if (m_event.IsRunning () && m_eventTick <= tick)
+    {
+      return;
+    }
+
+  m_event.Cancel ();
+  m_eventTick = tick;
+  Time expire = TimeStep (tick * m_granularity.GetTimeStep ());
+  m_event = Simulator::Schedule (expire - Simulator::Now (), &TcpPacingWheel::Expire, this);
+}
+
+void
+TcpPacingWheel::Expire (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint64_t tick = m_eventTick;
+  std::vector<Entry> &slot = m_slots[tick % m_nSlots];
+
+  // Move the callbacks due in this interval out of the slot, keeping those
+  // due in the next rounds of the wheel
+  std::vector<Entry> due;
+  due.swap (m_due);
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < slot.size (); i++)
+    {
+      if (slot[i].tick <= tick)
+        {
+          due.push_back (slot[i]);
+        }
+      else
+        {
+          slot[kept++] = slot[i];
+        }
+    }
+  slot.resize (kept);
+  m_nPending -= due.size ();
+
+  NS_LOG_LOGIC ("Invoking " << due.size () << " callbacks, " << m_nPending << " left");
+
+  // The callbacks may add new entries to the wheel
+  for (std::vector<Entry>::iterator it = due.begin (); it != due.end (); it++)
+    {
+      it->cb ();
+    }
+  due.clear ();
+  due.swap (m_due);
+
+  if (m_nPending == 0)
+    {
+      return;
+    }
+
+  // The entries of the wheel are due no earlier than the current interval,
+  // hence the first non empty slot is the next interval to check
+  for (uint32_t d = 1; d <= m_nSlots; d++)
+    {
+      if (!m_slots[(tick + d) % m_nSlots].empty ())
+        {
+          ScheduleTick (tick + d);
+          break;
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_PACING_WHEEL_H
+#define TCP_PACING_WHEEL_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Timer wheel releasing the paced segments of the TCP sockets of a node
+ *
+ * The paced sockets of a node do not schedule a simulator event for each
+ * segment they hold back. Instead, they register a callback on the timer wheel
+ * of their TcpL4Protocol, which is invoked once the time to send the next
+ * segment has come.
+ *
+ * The wheel is made of a circular array of Slots, each covering an interval
+ * of Granularity. A callback is stored in the slot of the interval its
+ * expiration time falls in, and is invoked at the end of that interval, i.e.,
+ * with a delay smaller than Granularity. The expiration times farther than
+ * Slots * Granularity are wrapped around the wheel and skipped until their
+ * round comes.
+ *
+ * A single simulator event is pending at any time, at the end of the first
+ * interval holding some callbacks. Hence the cost of pacing does not grow
+ * with the number of sockets of the node.
+ */
+class TcpPacingWheel : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpPacingWheel ();
+  virtual ~TcpPacingWheel ();
+
+  /**
+   * \brief Invoke a callback at the given time
+   *
+   * The callback is invoked at the end of the interval of Granularity which
+   * the given time falls in, or as soon as possible if the given time is in
+   * the past. Callbacks cannot be cancelled.
+   *
+   * \param when the time the callback is due
+   * \param cb the callback
+   */
+  void ScheduleAt (Time when, Callback<void> cb);
+
+  /**
+   * \brief Get the number of callbacks waiting on the wheel
+   * \return the number of callbacks waiting on the wheel
+   */
+  uint32_t GetNPending (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// A callback waiting on the wheel
+  struct Entry
+  {
+    uint64_t tick;          //!< Index of the interval the callback is due in
+    Callback<void> cb;      //!< The callback
+  };
+
+  /**
+   * \brief Make sure the wheel event expires no later than the given tick
+   * \param tick the index of the interval
+   */
+  void ScheduleTick (uint64_t tick);
+
+  /**
+   * \brief Invoke the callbacks due in the current interval and schedule the
+   * event for the next interval holding some callbacks
+   */
+  void Expire (void);
+
+  Time m_granularity;                         //!< Width of the interval covered by a slot
+  uint32_t m_nSlots;                          //!< Number of slots of the wheel
+  std::vector<std::vector<Entry> > m_slots;   //!< Callbacks, per slot
+  std::vector<Entry> m_due;                   //!< Callbacks being invoked
+  uint32_t m_nPending;                        //!< Number of callbacks on the wheel
+  uint64_t m_eventTick;                       //!< Interval the wheel event expires at
+  EventId m_event;                            //!< The wheel event
+};
+
+} // namespace ns3
+
+#endif /* TCP_PACING_WHEEL_H */
@@ -51,6 +51,7 @@
 #include "tcp-option-ts.h"
 #include "rtt-estimator.h"
 #include "tcp-congestion-ops.h"
+#include "tcp-pacing-wheel.h"
 
 #include <math.h>
 #include <algorithm>
@@ -129,6 +130,24 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_limitedTx),
                    MakeBooleanChecker ())
+    .AddAttribute ("UseEcn", "Negotiate Explicit Congestion Notification (RFC 3168)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Pacing", "Spread the transmission of the segments over the RTT",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_pacing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PacingSsGain",
+                   "Ratio of the pacing rate to cwnd/RTT in slow start",
+                   DoubleValue (2.0),
+                   MakeDoubleAccessor (&TcpSocketBase::m_pacingSsGain),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("PacingCaGain",
+                   "Ratio of the pacing rate to cwnd/RTT in congestion avoidance",
+                   DoubleValue (1.2),
+                   MakeDoubleAccessor (&TcpSocketBase::m_pacingCaGain),
+                   MakeDoubleChecker<double> (0))
     .AddTraceSource ("RTO",
                      "Retransmission timeout",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_rto),
@@ -238,7 +257,8 @@ TcpSocketState::TcpSocketState (void)
     m_congState (CA_OPEN),
     m_highTxMark (0),
     // Change m_nextTxSequence for non-zero initial sequence number
-    m_nextTxSequence (0)
+    m_nextTxSequence (0),
+    m_ecnFlags (0)
 {
 }
 
@@ -252,7 +272,8 @@ TcpSocketState::TcpSocketState (const TcpSocketState &other)
     m_lastAckedSeq (other.m_lastAckedSeq),
     m_congState (other.m_congState),
     m_highTxMark (other.m_highTxMark),
-    m_nextTxSequence (other.m_nextTxSequence)
+    m_nextTxSequence (other.m_nextTxSequence),
+    m_ecnFlags (other.m_ecnFlags)
 {
 }
 
@@ -317,6 +338,13 @@ TcpSocketBase::TcpSocketBase (void)
     m_retxThresh (3),
     m_limitedTx (false),
     m_retransOut (0),
+    m_useEcn (false),
+    m_cwrRecover (0),
+    m_pacing (false),
+    m_pacingSsGain (2.0),
+    m_pacingCaGain (1.2),
+    m_pacingNextTx (Seconds (0.0)),
+    m_pacingPending (false),
     m_congestionControl (0),
     m_isFirstPartialAck (true)
 {
@@ -389,6 +417,13 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_retxThresh (sock.m_retxThresh),
     m_limitedTx (sock.m_limitedTx),
     m_retransOut (sock.m_retransOut),
+    m_useEcn (sock.m_useEcn),
+    m_cwrRecover (sock.m_cwrRecover),
+    m_pacing (sock.m_pacing),
+    m_pacingSsGain (sock.m_pacingSsGain),
+    m_pacingCaGain (sock.m_pacingCaGain),
+    m_pacingNextTx (sock.m_pacingNextTx),
+    m_pacingPending (false),
     m_isFirstPartialAck (sock.m_isFirstPartialAck),
     m_txTrace (sock.m_txTrace),
     m_rxTrace (sock.m_rxTrace)
@@ -1136,6 +1171,7 @@ TcpSocketBase::ForwardUp (Ptr<Packet> packet, Ipv4Header header, uint16_t port,
   Address toAddress = InetSocketAddress (header.GetDestination (),
                                          m_endPoint->GetLocalPort ());
 
+  ReceivedEcn (packet, header.GetEcn () == Ipv4Header::ECN_CE);
   DoForwardUp (packet, fromAddress, toAddress);
 }
 
@@ -1153,9 +1189,64 @@ TcpSocketBase::ForwardUp6 (Ptr<Packet> packet, Ipv6Header header, uint16_t port,
   Address toAddress = Inet6SocketAddress (header.GetDestinationAddress (),
                                           m_endPoint6->GetLocalPort ());
 
+  ReceivedEcn (packet, header.GetEcn () == Ipv6Header::ECN_CE);
   DoForwardUp (packet, fromAddress, toAddress);
 }
 
+void
+TcpSocketBase::ReceivedEcn (Ptr<const Packet> packet, bool ceMarked)
+{
+  NS_LOG_FUNCTION (this << packet << ceMarked);
+
+  if (!(m_tcb->m_ecnFlags & TcpSocketState::ECN_OK))
+    {
+      return;
+    }
+
+  TcpHeader tcpHeader;
+  packet->PeekHeader (tcpHeader);
+
+  if (m_congestionControl->NeedsAccurateEcnEcho ())
+    {
+      // Echo the CE codepoint of the last data segment, ignoring CWR
+      if (packet->GetSize () == tcpHeader.GetSerializedSize ())
+        {
+          return;
+        }
+      bool demandCwr = m_tcb->m_ecnFlags & TcpSocketState::ECN_DEMAND_CWR;
+      if (ceMarked != demandCwr && m_delAckCount > 0)
+        {
+          // Acknowledge the segments received so far with their own codepoint
+          NS_LOG_DEBUG ("CE codepoint changed, send the delayed ACK");
+          m_delAckEvent.Cancel ();
+          m_delAckCount = 0;
+          SendEmptyPacket (TcpHeader::ACK);
+        }
+      if (ceMarked)
+        {
+          m_tcb->m_ecnFlags |= TcpSocketState::ECN_DEMAND_CWR;
+        }
+      else
+        {
+          m_tcb->m_ecnFlags &= ~TcpSocketState::ECN_DEMAND_CWR;
+        }
+      return;
+    }
+
+  // The peer has reduced its window: stop echoing the previous CE
+  // (RFC 3168, sec. 6.1.3). A CE on the same segment starts a new echo.
+  if (tcpHeader.GetFlags () & TcpHeader::CWR)
+    {
+      NS_LOG_DEBUG ("CWR received, stop setting ECE");
+      m_tcb->m_ecnFlags &= ~TcpSocketState::ECN_DEMAND_CWR;
+    }
+  if (ceMarked)
+    {
+      NS_LOG_DEBUG ("CE received, set ECE until CWR is received");
+      m_tcb->m_ecnFlags |= TcpSocketState::ECN_DEMAND_CWR;
+    }
+}
+
 void
 TcpSocketBase::ForwardIcmp (Ipv4Address icmpSource, uint8_t icmpTtl,
                             uint8_t icmpType, uint8_t icmpCode,
@@ -1309,7 +1400,8 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
       break;
     case CLOSED:
       // Send RST if the incoming packet is not a RST
-      if ((tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG)) != TcpHeader::RST)
+      if ((tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                     | TcpHeader::CWR | TcpHeader::ECE)) != TcpHeader::RST)
         { // Since m_endPoint is not configured yet, we cannot use SendRST here
           TcpHeader h;
           Ptr<Packet> p = Create<Packet> ();
@@ -1368,8 +1460,9 @@ TcpSocketBase::ProcessEstablished (Ptr<Packet> packet, const TcpHeader& tcpHeade
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are handled separately.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::CWR | TcpHeader::ECE);
 
   // Different flags are different events
   if (tcpflags == TcpHeader::ACK)
@@ -1461,6 +1554,15 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 
   m_tcb->m_lastAckedSeq = ackNumber;
 
+  if ((m_tcb->m_ecnFlags & TcpSocketState::ECN_OK) && (tcpHeader.GetFlags () & TcpHeader::ECE))
+    {
+      m_tcb->m_ecnFlags |= TcpSocketState::ECN_ECE_RCVD;
+    }
+  else
+    {
+      m_tcb->m_ecnFlags &= ~TcpSocketState::ECN_ECE_RCVD;
+    }
+
   if (ackNumber == m_txBuffer->HeadSequence ()
       && ackNumber < m_tcb->m_nextTxSequence
       && packet->GetSize () == 0)
@@ -1487,19 +1589,29 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 
           NS_LOG_DEBUG ("OPEN -> DISORDER");
         }
-      else if (m_tcb->m_congState == TcpSocketState::CA_DISORDER)
+      else if (m_tcb->m_congState == TcpSocketState::CA_DISORDER
+               || m_tcb->m_congState == TcpSocketState::CA_CWR)
         {
           if ((m_dupAckCount == m_retxThresh) && (m_highRxAckMark >= m_recover))
             {
               // triple duplicate ack triggers fast retransmit (RFC2582 sec.3 bullet #1)
               NS_LOG_DEBUG (TcpSocketState::TcpCongStateName[m_tcb->m_congState] <<
                             " -> RECOVERY");
+              bool inCwr = (m_tcb->m_congState == TcpSocketState::CA_CWR);
               m_recover = m_tcb->m_highTxMark;
               m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_RECOVERY);
               m_tcb->m_congState = TcpSocketState::CA_RECOVERY;
 
-              m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb,
-                                                                    BytesInFlight ());
+              // ssThresh has already been reduced for this window by an ECN echo
+              if (!inCwr)
+                {
+                  m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb,
+                                                                        BytesInFlight ());
+                }
+              if (m_tcb->m_ecnFlags & TcpSocketState::ECN_OK)
+                {
+                  m_tcb->m_ecnFlags |= TcpSocketState::ECN_QUEUE_CWR;
+                }
               m_tcb->m_cWnd = m_tcb->m_ssThresh + m_dupAckCount * m_tcb->m_segmentSize;
 
               NS_LOG_INFO (m_dupAckCount << " dupack. Enter fast recovery mode." <<
@@ -1523,6 +1635,13 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
           SendPendingData (m_connected);
         }
 
+      // A dupack may carry an ECN echo as well (RFC 3168, sec. 6.1.2)
+      if ((m_tcb->m_ecnFlags & TcpSocketState::ECN_ECE_RCVD)
+          && m_tcb->m_congState == TcpSocketState::CA_DISORDER)
+        {
+          EnterCwr ();
+        }
+
       // Artificially call PktsAcked. After all, one segment has been ACKed.
       m_congestionControl->PktsAcked (m_tcb, 1, m_lastRtt);
     }
@@ -1573,6 +1692,25 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 
           NS_LOG_DEBUG ("DISORDER -> OPEN");
         }
+      else if (m_tcb->m_congState == TcpSocketState::CA_CWR)
+        {
+          m_congestionControl->PktsAcked (m_tcb, segsAcked, m_lastRtt);
+          m_dupAckCount = 0;
+          m_retransOut = 0;
+
+          // Wait for the segment carrying CWR to be acknowledged, so that
+          // the echoes of the CE that caused the reduction are ignored.
+          if (ackNumber > m_cwrRecover)
+            {
+              m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+              m_tcb->m_congState = TcpSocketState::CA_OPEN;
+              NS_LOG_DEBUG ("CWR -> OPEN");
+            }
+          else
+            {
+              callCongestionControl = false;
+            }
+        }
       else if (m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
         {
           if (ackNumber < m_recover)
@@ -1661,6 +1799,15 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
           NS_LOG_DEBUG ("LOSS -> OPEN");
         }
 
+      // React to an ECN echo at most once per window (RFC 3168, sec. 6.1.2)
+      if ((m_tcb->m_ecnFlags & TcpSocketState::ECN_ECE_RCVD)
+          && (m_tcb->m_congState == TcpSocketState::CA_OPEN
+              || m_tcb->m_congState == TcpSocketState::CA_DISORDER))
+        {
+          EnterCwr ();
+          callCongestionControl = false;
+        }
+
       if (callCongestionControl)
         {
           m_congestionControl->IncreaseWindow (m_tcb, newSegsAcked);
@@ -1703,8 +1850,9 @@ TcpSocketBase::ProcessListen (Ptr<Packet> packet, const TcpHeader& tcpHeader,
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are handled separately.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::CWR | TcpHeader::ECE);
 
   // Fork a socket if received a SYN. Do nothing otherwise.
   // C.f.: the LISTEN part in tcp_v4_do_rcv() in tcp_ipv4.c in Linux kernel
@@ -1732,8 +1880,9 @@ TcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are handled separately.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::CWR | TcpHeader::ECE);
 
   if (tcpflags == 0)
     { // Bare data, accept it and move to ESTABLISHED state. This is not a normal behaviour. Remove this?
@@ -1755,6 +1904,12 @@ TcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const TcpHeader& tcpHeader)
       m_state = SYN_RCVD;
       m_synCount = m_synRetries;
       m_rxBuffer->SetNextRxSequence (tcpHeader.GetSequenceNumber () + SequenceNumber32 (1));
+      if (m_useEcn && (tcpHeader.GetFlags () & TcpHeader::ECE)
+          && (tcpHeader.GetFlags () & TcpHeader::CWR))
+        {
+          NS_LOG_INFO ("ECN negotiated");
+          m_tcb->m_ecnFlags = TcpSocketState::ECN_OK;
+        }
       SendEmptyPacket (TcpHeader::SYN | TcpHeader::ACK);
     }
   else if (tcpflags == (TcpHeader::SYN | TcpHeader::ACK)
@@ -1768,6 +1923,13 @@ TcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const TcpHeader& tcpHeader)
       m_rxBuffer->SetNextRxSequence (tcpHeader.GetSequenceNumber () + SequenceNumber32 (1));
       m_tcb->m_highTxMark = ++m_tcb->m_nextTxSequence;
       m_txBuffer->SetHeadSequence (m_tcb->m_nextTxSequence);
+      // An ECN-setup SYN-ACK has ECE set and CWR cleared (RFC 3168, sec. 6.1.1)
+      if (m_useEcn && (tcpHeader.GetFlags () & TcpHeader::ECE)
+          && !(tcpHeader.GetFlags () & TcpHeader::CWR))
+        {
+          NS_LOG_INFO ("ECN negotiated");
+          m_tcb->m_ecnFlags = TcpSocketState::ECN_OK;
+        }
       SendEmptyPacket (TcpHeader::ACK);
       SendPendingData (m_connected);
       Simulator::ScheduleNow (&TcpSocketBase::ConnectionSucceeded, this);
@@ -1794,8 +1956,9 @@ TcpSocketBase::ProcessSynRcvd (Ptr<Packet> packet, const TcpHeader& tcpHeader,
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are handled separately.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::CWR | TcpHeader::ECE);
 
   if (tcpflags == 0
       || (tcpflags == TcpHeader::ACK
@@ -1885,8 +2048,9 @@ TcpSocketBase::ProcessWait (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are handled separately.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::CWR | TcpHeader::ECE);
 
   if (packet->GetSize () > 0 && tcpflags != TcpHeader::ACK)
     { // Bare data, accept it
@@ -1957,8 +2121,9 @@ TcpSocketBase::ProcessClosing (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are handled separately.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::CWR | TcpHeader::ECE);
 
   if (tcpflags == TcpHeader::ACK)
     {
@@ -1989,8 +2154,9 @@ TcpSocketBase::ProcessLastAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are handled separately.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::CWR | TcpHeader::ECE);
 
   if (tcpflags == 0)
     {
@@ -2191,6 +2357,23 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
       ++s;
     }
 
+  bool isAck = flags == TcpHeader::ACK;
+  if (flags & TcpHeader::SYN)
+    { // ECN-setup SYN and SYN-ACK (RFC 3168, sec. 6.1.1)
+      if (!(flags & TcpHeader::ACK) && m_useEcn)
+        {
+          flags |= TcpHeader::ECE | TcpHeader::CWR;
+        }
+      else if ((flags & TcpHeader::ACK) && (m_tcb->m_ecnFlags & TcpSocketState::ECN_OK))
+        {
+          flags |= TcpHeader::ECE;
+        }
+    }
+  else if ((flags & TcpHeader::ACK) && (m_tcb->m_ecnFlags & TcpSocketState::ECN_DEMAND_CWR))
+    { // Echo the CE received
+      flags |= TcpHeader::ECE;
+    }
+
   header.SetFlags (flags);
   header.SetSequenceNumber (s);
   header.SetAckNumber (m_rxBuffer->NextRxSequence ());
@@ -2212,7 +2395,6 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
   uint16_t windowSize = AdvertisedWindowSize ();
   bool hasSyn = flags & TcpHeader::SYN;
   bool hasFin = flags & TcpHeader::FIN;
-  bool isAck = flags == TcpHeader::ACK;
   if (hasSyn)
     {
       if (m_winScalingEnabled)
@@ -2406,6 +2588,13 @@ TcpSocketBase::CompleteFork (Ptr<Packet> p, const TcpHeader& h,
   // Set the sequence number and send SYN+ACK
   m_rxBuffer->SetNextRxSequence (h.GetSequenceNumber () + SequenceNumber32 (1));
 
+  // An ECN-setup SYN has both ECE and CWR set (RFC 3168, sec. 6.1.1)
+  if (m_useEcn && (h.GetFlags () & TcpHeader::ECE) && (h.GetFlags () & TcpHeader::CWR))
+    {
+      NS_LOG_INFO ("ECN negotiated");
+      m_tcb->m_ecnFlags = TcpSocketState::ECN_OK;
+    }
+
   SendEmptyPacket (TcpHeader::SYN | TcpHeader::ACK);
 }
 
@@ -2445,25 +2634,39 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
     {
       m_delAckEvent.Cancel ();
       m_delAckCount = 0;
+      if (m_tcb->m_ecnFlags & TcpSocketState::ECN_DEMAND_CWR)
+        {
+          flags |= TcpHeader::ECE;
+        }
+    }
+
+  // Only new data is sent ECN-capable (RFC 3168, sec. 6.1.5), and the
+  // first new segment after a window reduction carries CWR
+  bool isEct = (m_tcb->m_ecnFlags & TcpSocketState::ECN_OK) && !isRetransmission;
+  if (isEct && (m_tcb->m_ecnFlags & TcpSocketState::ECN_QUEUE_CWR))
+    {
+      flags |= TcpHeader::CWR;
+      m_tcb->m_ecnFlags &= ~TcpSocketState::ECN_QUEUE_CWR;
     }
 
   /*
    * Add tags for each socket option.
    * Note that currently the socket adds both IPv4 tag and IPv6 tag
    * if both options are set. Once the packet got to layer three, only
-   * the corresponding tags will be read.
+   * the corresponding tags will be read. The ECN field is set through
+   * the same tags.
    */
-  if (GetIpTos ())
+  if (GetIpTos () || isEct)
     {
       SocketIpTosTag ipTosTag;
-      ipTosTag.SetTos (GetIpTos ());
+      ipTosTag.SetTos (isEct ? (GetIpTos () & 0xfc) | Ipv4Header::ECN_ECT0 : GetIpTos ());
       p->AddPacketTag (ipTosTag);
     }
 
-  if (IsManualIpv6Tclass ())
+  if (IsManualIpv6Tclass () || isEct)
     {
       SocketIpv6TclassTag ipTclassTag;
-      ipTclassTag.SetTclass (GetIpv6Tclass ());
+      ipTclassTag.SetTclass (isEct ? (GetIpv6Tclass () & 0xfc) | Ipv6Header::ECN_ECT0 : GetIpv6Tclass ());
       p->AddPacketTag (ipTclassTag);
     }
 
@@ -2641,10 +2844,30 @@ TcpSocketBase::SendPendingData (bool withAck)
                     " cWnd: " << m_tcb->m_cWnd <<
                     " unAck: " << UnAckDataCount ());
 
+      // Pacing: hold off sending until the previous segment has been spread
+      // over its share of the RTT. The socket is woken up by the timer wheel
+      // of the node, so no event is scheduled per socket
+      if (m_pacing && m_tcp != 0 && Simulator::Now () < m_pacingNextTx)
+        {
+          if (!m_pacingPending)
+            {
+              NS_LOG_LOGIC ("Pacing. Wait to send until " << m_pacingNextTx);
+              m_pacingPending = true;
+              m_tcp->GetPacingWheel ()->ScheduleAt (m_pacingNextTx,
+                                                    MakeCallback (&TcpSocketBase::PacingTimerExpired,
+                                                                  Ptr<TcpSocketBase> (this)));
+            }
+          break;
+        }
+
       uint32_t s = std::min (w, m_tcb->m_segmentSize);  // Send no more than window
       uint32_t sz = SendDataPacket (m_tcb->m_nextTxSequence, s, withAck);
       nPacketsSent++;                             // Count sent this loop
       m_tcb->m_nextTxSequence += sz;                     // Advance next tx sequence
+      if (m_pacing)
+        {
+          m_pacingNextTx = Simulator::Now () + GetPacingDelay (sz);
+        }
     }
   if (nPacketsSent > 0)
     {
@@ -2653,6 +2876,32 @@ TcpSocketBase::SendPendingData (bool withAck)
   return (nPacketsSent > 0);
 }
 
+Time
+TcpSocketBase::GetPacingDelay (uint32_t bytes) const
+{
+  NS_LOG_FUNCTION (this << bytes);
+  Time rtt = m_rtt->GetEstimate ();
+  if (m_rtt->GetNSamples () == 0 || rtt.IsZero () || m_tcb->m_cWnd == 0u)
+    {
+      return Seconds (0.0);
+    }
+  double gain = (m_tcb->m_cWnd < m_tcb->m_ssThresh) ? m_pacingSsGain : m_pacingCaGain;
+  if (gain <= 0)
+    {
+      return Seconds (0.0);
+    }
+  // bytes / (gain * cWnd / rtt)
+  return Seconds (rtt.GetSeconds () * bytes / (gain * m_tcb->m_cWnd.Get ()));
+}
+
+void
+TcpSocketBase::PacingTimerExpired (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_pacingPending = false;
+  SendPendingData (m_connected);
+}
+
 uint32_t
 TcpSocketBase::UnAckDataCount () const
 {
@@ -2887,6 +3136,26 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
     }
 }
 
+void
+TcpSocketBase::EnterCwr ()
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_LOG_DEBUG (TcpSocketState::TcpCongStateName[m_tcb->m_congState] << " -> CWR");
+  m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_CWR);
+  m_tcb->m_congState = TcpSocketState::CA_CWR;
+
+  // Same reduction of a fast retransmit, without any retransmission
+  m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb, BytesInFlight ());
+  m_tcb->m_cWnd = m_tcb->m_ssThresh;
+  m_cwrRecover = m_tcb->m_highTxMark;
+  m_tcb->m_ecnFlags |= TcpSocketState::ECN_QUEUE_CWR;
+
+  NS_LOG_INFO ("ECN echo received. Reset cwnd to " << m_tcb->m_cWnd <<
+               ", ssthresh to " << m_tcb->m_ssThresh <<
+               " until seqnum " << m_cwrRecover << " is acked");
+}
+
 // Retransmit timeout
 void
 TcpSocketBase::ReTxTimeout ()
@@ -3026,6 +3295,10 @@ TcpSocketBase::Retransmit ()
       m_tcb->m_congState = TcpSocketState::CA_LOSS;
       m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb, BytesInFlight ());
       m_tcb->m_cWnd = m_tcb->m_segmentSize;
+      if (m_tcb->m_ecnFlags & TcpSocketState::ECN_OK)
+        {
+          m_tcb->m_ecnFlags |= TcpSocketState::ECN_QUEUE_CWR;
+        }
     }
 
   m_tcb->m_nextTxSequence = m_txBuffer->HeadSequence (); // Restart from highest Ack
@@ -129,7 +129,7 @@ public:
                     *  we see some SACKs or dupacks. It is split of "Open" */
     CA_CWR,       /**< cWnd was reduced due to some Congestion Notification event.
                     *  It can be ECN, ICMP source quench, local device congestion.
-                    *  Not used in NS-3 right now. */
+                    *  In NS-3 it is entered on ECN echoes only. */
     CA_RECOVERY,  /**< CWND was reduced, we are fast-retransmitting. */
     CA_LOSS,      /**< CWND was reduced due to RTO timeout or SACK reneging. */
     CA_LAST_STATE /**< Used only in debug messages */
@@ -150,6 +150,21 @@ public:
    */
   static const char* const TcpCongStateName[TcpSocketState::CA_LAST_STATE];
 
+  /**
+   * \brief Flags of the ECN state of the connection (RFC 3168)
+   *
+   * As in Linux, the flags of the sender side (ECN_QUEUE_CWR) and of the
+   * receiver side (ECN_DEMAND_CWR) are kept together, since a connection
+   * can play both roles at the same time.
+   */
+  typedef enum
+  {
+    ECN_OK         = 1, /**< ECN has been negotiated in the handshake */
+    ECN_QUEUE_CWR  = 2, /**< cWnd has been reduced, CWR must be set on the next new segment */
+    ECN_DEMAND_CWR = 4, /**< CE has been received, ECE must be set on ACKs until CWR is received */
+    ECN_ECE_RCVD   = 8  /**< The ACK being processed carries ECE */
+  } EcnFlags_t;
+
   // Congestion control
   TracedValue<uint32_t>  m_cWnd;            //!< Congestion window
   TracedValue<uint32_t>  m_ssThresh;        //!< Slow start threshold
@@ -164,6 +179,9 @@ public:
   TracedValue<SequenceNumber32> m_highTxMark; //!< Highest seqno ever sent, regardless of ReTx
   TracedValue<SequenceNumber32> m_nextTxSequence; //!< Next seqnum to be sent (SND.NXT), ReTx pushes it back
 
+  // ECN
+  uint8_t                m_ecnFlags;        //!< ECN state of the connection, see EcnFlags_t
+
   /**
    * \brief Get cwnd in segments rather than bytes
    *
@@ -265,6 +283,22 @@ public:
  *
  * The algorithm is implemented in the ReceivedAck method.
  *
+ * Explicit Congestion Notification
+ * --------------------------
+ *
+ * ECN (RFC 3168) is enabled by setting the attribute "UseEcn" to true on
+ * both ends. It is negotiated in the handshake through the ECE and CWR flags;
+ * when it succeeds, new data segments are sent as ECT(0) through the IP_TOS
+ * (or IPV6_TCLASS) path, while SYNs, pure ACKs and retransmissions are not.
+ *
+ * The receiver echoes a CE codepoint by setting ECE on its ACKs, until a
+ * segment with CWR arrives. The sender reacts to ECE once per window, in
+ * the CA_OPEN and CA_DISORDER states (that is, also on duplicate ACKs): it
+ * enters the CA_CWR state, and sets both cWnd and ssThresh to the value
+ * returned by TcpCongestionOps::GetSsThresh, without retransmitting anything.
+ * The state is left when all the data outstanding at the time of the
+ * reduction has been acknowledged.
+ *
  */
 class TcpSocketBase : public TcpSocket
 {
@@ -607,6 +641,25 @@ protected:
    */
   bool SendPendingData (bool withAck = false);
 
+  /**
+   * \brief Get the time needed to send the given amount of data at the
+   * pacing rate
+   *
+   * The pacing rate is the congestion window divided by the smoothed RTT,
+   * multiplied by PacingSsGain in slow start and by PacingCaGain otherwise.
+   *
+   * \param bytes the amount of data
+   * \returns the transmission time at the pacing rate, or zero if no RTT
+   *          sample has been taken yet
+   */
+  Time GetPacingDelay (uint32_t bytes) const;
+
+  /**
+   * \brief Send the data held back by pacing, called by the pacing timer
+   * wheel of the node
+   */
+  void PacingTimerExpired (void);
+
   /**
    * \brief Extract at most maxSize bytes from the TxBuffer at sequence seq, add the
    *        TCP header, and send to TcpL4Protocol
@@ -859,6 +912,22 @@ protected:
    */
   virtual void NewAck (SequenceNumber32 const& seq, bool resetRTO);
 
+  /**
+   * \brief Process the ECN codepoint of an incoming segment
+   *
+   * Called by ForwardUp() and ForwardUp6() with the codepoint of the IP
+   * header, before the segment is processed.
+   *
+   * \param packet the packet, starting with the TCP header
+   * \param ceMarked true if the IP header carries the CE codepoint
+   */
+  void ReceivedEcn (Ptr<const Packet> packet, bool ceMarked);
+
+  /**
+   * \brief Reduce cWnd in response to an ECN echo, entering CA_CWR
+   */
+  virtual void EnterCwr (void);
+
   /**
    * \brief Call Retransmit() upon RTO event
    */
@@ -1032,6 +1101,17 @@ protected:
   bool                   m_limitedTx;    //!< perform limited transmit
   uint32_t               m_retransOut;   //!< Number of retransmission in this window
 
+  // Explicit Congestion Notification
+  bool                   m_useEcn;       //!< Negotiate ECN (RFC 3168)
+  SequenceNumber32       m_cwrRecover;   //!< Highest Tx seqnum when CA_CWR was entered
+
+  // Pacing
+  bool   m_pacing;          //!< Pacing enabled
+  double m_pacingSsGain;    //!< Gain applied to cwnd/RTT in slow start
+  double m_pacingCaGain;    //!< Gain applied to cwnd/RTT in congestion avoidance
+  Time   m_pacingNextTx;    //!< Earliest time the next segment can be sent
+  bool   m_pacingPending;   //!< Socket waiting on the pacing timer wheel
+
   // Transmission Control Block
   Ptr<TcpSocketState>    m_tcb;               //!< Congestion control informations
   Ptr<TcpCongestionOps>  m_congestionControl; //!< Congestion control
@@ -237,6 +237,17 @@ UdpHeader::Deserialize (Buffer::Iterator start)
   return GetSerializedSize ();
 }
 
+bool
+UdpHeader::CopyTo (Header &header) const
+{
+  if (m_calcChecksum)
+    {
+      return false;
+    }
+  static_cast<UdpHeader &> (header) = *this;
+  return true;
+}
+
 uint16_t
 UdpHeader::GetChecksum ()
 {
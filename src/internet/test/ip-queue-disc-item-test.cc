@@ -0,0 +1,236 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-queue-disc-item.h"
+#include "ns3/ipv6-queue-disc-item.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv4-packet-filter.h"
+#include "ns3/ipv6-packet-filter.h"
+#include "ns3/udp-header.h"
+#include "ns3/uinteger.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the header cached by an Ipv4QueueDiscItem is kept
+ * consistent with the packet when the item is marked before and after the
+ * header is added to the packet
+ */
+class Ipv4QueueDiscItemTestCase : public TestCase
+{
+public:
+  Ipv4QueueDiscItemTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv4QueueDiscItemTestCase::Ipv4QueueDiscItemTestCase ()
+  : TestCase ("Marking of the header cached by the IPv4 queue disc items")
+{
+}
+
+void
+Ipv4QueueDiscItemTestCase::DoRun (void)
+{
+  Ipv4Header hdr;
+  hdr.SetSource (Ipv4Address ("10.0.0.1"));
+  hdr.SetDestination (Ipv4Address ("10.0.0.2"));
+  hdr.SetPayloadSize (100);
+  hdr.SetProtocol (17);
+  hdr.SetEcn (Ipv4Header::ECN_ECT0);
+  hdr.EnableChecksum ();
+
+  for (uint32_t addFirst = 0; addFirst < 2; addFirst++)
+    {
+      Ptr<Ipv4QueueDiscItem> item = Create<Ipv4QueueDiscItem> (Create<Packet> (100), Address (),
+                                                                Ipv4L3Protocol::PROT_NUMBER, hdr);
+      NS_TEST_EXPECT_MSG_EQ (item->GetPacketSize (), 120, "Wrong size of the item");
+      if (addFirst)
+        {
+          item->AddHeader ();
+        }
+      NS_TEST_EXPECT_MSG_EQ (item->IsEcnCapable (), true, "The item should be ECN capable");
+      NS_TEST_EXPECT_MSG_EQ (item->IsMarked (), false, "The item should not be marked yet");
+      NS_TEST_EXPECT_MSG_EQ (item->Mark (), true, "The item should be marked");
+      NS_TEST_EXPECT_MSG_EQ (item->IsMarked (), true, "The item should be marked");
+      NS_TEST_EXPECT_MSG_EQ (item->GetHeader ().GetEcn (), Ipv4Header::ECN_CE, "The cached header should be marked");
+      if (!addFirst)
+        {
+          item->AddHeader ();
+        }
+      NS_TEST_EXPECT_MSG_EQ (item->GetPacketSize (), 120, "Wrong size of the item");
+
+      Ipv4Header sent;
+      sent.EnableChecksum ();
+      item->GetPacket ()->PeekHeader (sent);
+      NS_TEST_EXPECT_MSG_EQ (sent.GetEcn (), Ipv4Header::ECN_CE, "The packet should be marked");
+      NS_TEST_EXPECT_MSG_EQ (sent.IsChecksumOk (), true, "The checksum should be updated");
+      NS_TEST_EXPECT_MSG_EQ (sent.GetSource (), hdr.GetSource (), "Wrong source address");
+      NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetSize (), 120, "The header should be added once");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the header cached by an Ipv6QueueDiscItem is kept
+ * consistent with the packet when the item is marked before and after the
+ * header is added to the packet
+ */
+class Ipv6QueueDiscItemTestCase : public TestCase
+{
+public:
+  Ipv6QueueDiscItemTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv6QueueDiscItemTestCase::Ipv6QueueDiscItemTestCase ()
+  : TestCase ("Marking of the header cached by the IPv6 queue disc items")
+{
+}
+
+void
+Ipv6QueueDiscItemTestCase::DoRun (void)
+{
+  Ipv6Header hdr;
+  hdr.SetSourceAddress (Ipv6Address ("2001:1::1"));
+  hdr.SetDestinationAddress (Ipv6Address ("2001:1::2"));
+  hdr.SetPayloadLength (100);
+  hdr.SetNextHeader (17);
+  hdr.SetEcn (Ipv6Header::ECN_ECT1);
+
+  for (uint32_t addFirst = 0; addFirst < 2; addFirst++)
+    {
+      Ptr<Ipv6QueueDiscItem> item = Create<Ipv6QueueDiscItem> (Create<Packet> (100), Address (),
+                                                                Ipv6L3Protocol::PROT_NUMBER, hdr);
+      if (addFirst)
+        {
+          item->AddHeader ();
+        }
+      NS_TEST_EXPECT_MSG_EQ (item->IsEcnCapable (), true, "The item should be ECN capable");
+      NS_TEST_EXPECT_MSG_EQ (item->Mark (), true, "The item should be marked");
+      NS_TEST_EXPECT_MSG_EQ (item->IsMarked (), true, "The item should be marked");
+      if (!addFirst)
+        {
+          item->AddHeader ();
+        }
+
+      Ipv6Header sent;
+      item->GetPacket ()->PeekHeader (sent);
+      NS_TEST_EXPECT_MSG_EQ (sent.GetEcn (), Ipv6Header::ECN_CE, "The packet should be marked");
+      NS_TEST_EXPECT_MSG_EQ (sent.GetSourceAddress (), hdr.GetSourceAddress (), "Wrong source address");
+      NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetSize (), 140, "The header should be added once");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the flow hash stored in the IP queue disc items and the flow
+ * hash packet filters
+ */
+class IpFlowHashTestCase : public TestCase
+{
+public:
+  IpFlowHashTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Create an IPv4 queue disc item carrying a UDP datagram
+   * \param src the source address
+   * \param srcPort the source port
+   * \return the queue disc item
+   */
+  Ptr<Ipv4QueueDiscItem> CreateItem (const char *src, uint16_t srcPort);
+};
+
+IpFlowHashTestCase::IpFlowHashTestCase ()
+  : TestCase ("Flow hash stored in the IP queue disc items")
+{
+}
+
+Ptr<Ipv4QueueDiscItem>
+IpFlowHashTestCase::CreateItem (const char *src, uint16_t srcPort)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  UdpHeader udp;
+  udp.SetSourcePort (srcPort);
+  udp.SetDestinationPort (9);
+  p->AddHeader (udp);
+  Ipv4Header hdr;
+  hdr.SetSource (Ipv4Address (src));
+  hdr.SetDestination (Ipv4Address ("10.0.0.2"));
+  hdr.SetPayloadSize (p->GetSize ());
+  hdr.SetProtocol (17);
+  return Create<Ipv4QueueDiscItem> (p, Address (), Ipv4L3Protocol::PROT_NUMBER, hdr);
+}
+
+void
+IpFlowHashTestCase::DoRun (void)
+{
+  Ptr<Ipv4QueueDiscItem> a1 = CreateItem ("10.0.0.1", 1000);
+  Ptr<Ipv4QueueDiscItem> a2 = CreateItem ("10.0.0.1", 1000);
+  Ptr<Ipv4QueueDiscItem> b = CreateItem ("10.0.0.1", 1001);
+  Ptr<Ipv4QueueDiscItem> c = CreateItem ("10.0.0.3", 1000);
+
+  NS_TEST_EXPECT_MSG_EQ (a1->GetFlowHash (), a1->Hash (), "The flow hash should be computed by Hash");
+  NS_TEST_EXPECT_MSG_EQ (a1->GetFlowHash (), a2->GetFlowHash (), "Same flow, different hash");
+  NS_TEST_EXPECT_MSG_NE (a1->GetFlowHash (), b->GetFlowHash (), "The ports should be hashed");
+  NS_TEST_EXPECT_MSG_NE (a1->GetFlowHash (), c->GetFlowHash (), "The addresses should be hashed");
+  NS_TEST_EXPECT_MSG_NE (a1->GetFlowHash (1), a1->GetFlowHash (2), "The perturbation should be used");
+
+  // The hash is stored in the item, also once the header is added
+  a2->AddHeader ();
+  NS_TEST_EXPECT_MSG_EQ (a2->GetFlowHash (), a1->GetFlowHash (), "The hash should be stored");
+  a2->SetFlowHash (7);
+  NS_TEST_EXPECT_MSG_EQ (a2->GetFlowHash (), 7, "The hash should have been set");
+
+  Ptr<Ipv4FlowHashPacketFilter> filter = CreateObject<Ipv4FlowHashPacketFilter> ();
+  filter->SetAttribute ("Buckets", UintegerValue (16));
+  NS_TEST_EXPECT_MSG_EQ (filter->Classify (a1), (int32_t)(a1->GetFlowHash () % 16), "Wrong bucket");
+  NS_TEST_EXPECT_MSG_EQ (filter->Classify (a2), 7, "The stored hash should be used");
+  filter->SetAttribute ("Perturbation", UintegerValue (5));
+  NS_TEST_EXPECT_MSG_EQ (filter->Classify (a1), (int32_t)(a1->GetFlowHash (5) % 16), "Wrong bucket");
+
+  Ptr<Ipv6FlowHashPacketFilter> filter6 = CreateObject<Ipv6FlowHashPacketFilter> ();
+  NS_TEST_EXPECT_MSG_EQ (filter6->Classify (a1), PacketFilter::PF_NO_MATCH, "IPv4 packets should not match");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 and IPv6 queue disc items TestSuite
+ */
+static class IpQueueDiscItemTestSuite : public TestSuite
+{
+public:
+  IpQueueDiscItemTestSuite ()
+    : TestSuite ("ip-queue-disc-item", UNIT)
+  {
+    AddTestCase (new Ipv4QueueDiscItemTestCase (), TestCase::QUICK);
+    AddTestCase (new Ipv6QueueDiscItemTestCase (), TestCase::QUICK);
+    AddTestCase (new IpFlowHashTestCase (), TestCase::QUICK);
+  }
+} g_ipQueueDiscItemTestSuite;
@@ -0,0 +1,213 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/tcp-congestion-ops.h"
+#include "ns3/tcp-socket-base.h"
+#include "ns3/tcp-dctcp.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpDctcpTestSuite");
+
+/**
+ * \brief Testing the estimation of alpha on TcpDctcp
+ *
+ * A window of segments is acked one by one, and the first markedSegments of
+ * them carry the ECE flag; once the whole window is acked, alpha must be
+ * updated exactly once with the fraction of marked bytes.
+ */
+class TcpDctcpAlphaTest : public TestCase
+{
+public:
+  TcpDctcpAlphaTest (uint32_t segmentSize, uint32_t windowSegments,
+                     uint32_t markedSegments, double initialAlpha, double g,
+                     const std::string &name);
+
+private:
+  virtual void DoRun (void);
+  void AlphaTrace (double oldValue, double newValue);
+
+  uint32_t m_segmentSize;
+  uint32_t m_windowSegments;
+  uint32_t m_markedSegments;
+  double m_initialAlpha;
+  double m_g;
+  uint32_t m_alphaUpdates;
+  double m_alpha;
+};
+
+TcpDctcpAlphaTest::TcpDctcpAlphaTest (uint32_t segmentSize,
+                                      uint32_t windowSegments,
+                                      uint32_t markedSegments,
+                                      double initialAlpha, double g,
+                                      const std::string &name)
+  : TestCase (name),
+    m_segmentSize (segmentSize),
+    m_windowSegments (windowSegments),
+    m_markedSegments (markedSegments),
+    m_initialAlpha (initialAlpha),
+    m_g (g),
+    m_alphaUpdates (0),
+    m_alpha (initialAlpha)
+{
+}
+
+void
+TcpDctcpAlphaTest::AlphaTrace (double oldValue, double newValue)
+{
+  m_alphaUpdates++;
+  m_alpha = newValue;
+}
+
+void
+TcpDctcpAlphaTest::DoRun ()
+{
+  Ptr<TcpSocketState> state = CreateObject<TcpSocketState> ();
+  state->m_segmentSize = m_segmentSize;
+  state->m_cWnd = m_windowSegments * m_segmentSize;
+  state->m_lastAckedSeq = SequenceNumber32 (1);
+  state->m_nextTxSequence = SequenceNumber32 (1 + m_windowSegments * m_segmentSize);
+
+  Ptr<TcpDctcp> cong = CreateObject <TcpDctcp> ();
+  cong->SetAttribute ("InitialAlpha", DoubleValue (m_initialAlpha));
+  cong->SetAttribute ("G", DoubleValue (m_g));
+  cong->TraceConnectWithoutContext ("Alpha", MakeCallback (&TcpDctcpAlphaTest::AlphaTrace, this));
+
+  NS_TEST_ASSERT_MSG_EQ (cong->NeedsAccurateEcnEcho (), true,
+                         "DCTCP must ask for an accurate ECN echo");
+
+  for (uint32_t i = 0; i < m_windowSegments; ++i)
+    {
+      state->m_lastAckedSeq += m_segmentSize;
+      if (i < m_markedSegments)
+        {
+          state->m_ecnFlags |= TcpSocketState::ECN_ECE_RCVD;
+        }
+      else
+        {
+          state->m_ecnFlags &= ~TcpSocketState::ECN_ECE_RCVD;
+        }
+      cong->PktsAcked (state, 1, MilliSeconds (1));
+
+      if (i < m_windowSegments - 1)
+        {
+          NS_TEST_ASSERT_MSG_EQ (m_alphaUpdates, 0, "Alpha updated before the end of the window");
+        }
+    }
+
+  double fraction = static_cast<double> (m_markedSegments) / m_windowSegments;
+  NS_TEST_ASSERT_MSG_EQ (m_alphaUpdates, 1, "Alpha not updated once per window");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_alpha, (1 - m_g) * m_initialAlpha + m_g * fraction, 1e-9,
+                             "Alpha not updated following the DCTCP equation");
+}
+
+/**
+ * \brief Testing the window reduction on TcpDctcp
+ *
+ * In CA_CWR the window must be reduced according to alpha; on loss, it must
+ * be halved as in NewReno.
+ */
+class TcpDctcpSsThreshTest : public TestCase
+{
+public:
+  TcpDctcpSsThreshTest (uint32_t cWnd, uint32_t segmentSize, double alpha,
+                        TcpSocketState::TcpCongState_t congState,
+                        const std::string &name);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_cWnd;
+  uint32_t m_segmentSize;
+  double m_alpha;
+  TcpSocketState::TcpCongState_t m_congState;
+};
+
+TcpDctcpSsThreshTest::TcpDctcpSsThreshTest (uint32_t cWnd, uint32_t segmentSize,
+                                            double alpha,
+                                            TcpSocketState::TcpCongState_t congState,
+                                            const std::string &name)
+  : TestCase (name),
+    m_cWnd (cWnd),
+    m_segmentSize (segmentSize),
+    m_alpha (alpha),
+    m_congState (congState)
+{
+}
+
+void
+TcpDctcpSsThreshTest::DoRun ()
+{
+  Ptr<TcpSocketState> state = CreateObject<TcpSocketState> ();
+  state->m_cWnd = m_cWnd;
+  state->m_segmentSize = m_segmentSize;
+  state->m_congState = m_congState;
+
+  Ptr<TcpDctcp> cong = CreateObject <TcpDctcp> ();
+  cong->SetAttribute ("InitialAlpha", DoubleValue (m_alpha));
+
+  uint32_t expected;
+  if (m_congState == TcpSocketState::CA_CWR)
+    {
+      expected = static_cast<uint32_t> (m_cWnd * (1 - m_alpha / 2));
+    }
+  else
+    {
+      expected = m_cWnd / 2;
+    }
+  expected = std::max (2 * m_segmentSize, expected);
+
+  NS_TEST_ASSERT_MSG_EQ (cong->GetSsThresh (state, m_cWnd), expected,
+                         "DCTCP window reduction not correct");
+}
+
+// -------------------------------------------------------------------
+
+static class TcpDctcpTestSuite : public TestSuite
+{
+public:
+  TcpDctcpTestSuite () : TestSuite ("tcp-dctcp-test", UNIT)
+  {
+    AddTestCase (new TcpDctcpAlphaTest (536, 10, 0, 1.0, 0.0625,
+                                        "DCTCP alpha decreases without marks"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpDctcpAlphaTest (1446, 20, 5, 0.5, 0.0625,
+                                        "DCTCP alpha with a quarter of the bytes marked"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpDctcpAlphaTest (1446, 8, 8, 0.0, 0.5,
+                                        "DCTCP alpha increases with all the bytes marked"),
+                 TestCase::QUICK);
+
+    AddTestCase (new TcpDctcpSsThreshTest (40 * 1446, 1446, 0.25, TcpSocketState::CA_CWR,
+                                           "DCTCP reduction on ECN echo with alpha = 0.25"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpDctcpSsThreshTest (40 * 1446, 1446, 1.0, TcpSocketState::CA_CWR,
+                                           "DCTCP reduction on ECN echo with alpha = 1"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpDctcpSsThreshTest (2 * 536, 536, 0.1, TcpSocketState::CA_CWR,
+                                           "DCTCP reduction on ECN echo bounded to 2 segments"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpDctcpSsThreshTest (40 * 1446, 1446, 0.25, TcpSocketState::CA_RECOVERY,
+                                           "DCTCP reduction on loss as NewReno"),
+                 TestCase::QUICK);
+  }
+} g_tcpDctcpTest;
+
+} // namespace ns3
@@ -0,0 +1,453 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-general-test.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/boolean.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpEcnTestSuite");
+
+/**
+ * \brief Error model which sets the CE codepoint on a data segment
+ *
+ * The model checks the ECN codepoint of the segments it sees, and sets CE
+ * on the data segment with the configured sequence number, if it is
+ * ECN-capable. It can also drop the first transmission of another data
+ * segment.
+ */
+class TcpCeMarkErrorModel : public ErrorModel
+{
+public:
+  static TypeId GetTypeId (void);
+  TcpCeMarkErrorModel ();
+
+  void SetSeqToMark (SequenceNumber32 seq) { m_seqToMark = seq; }
+  void SetSeqToDrop (SequenceNumber32 seq) { m_seqToDrop = seq; }
+
+  uint32_t m_ectData;     //!< Data segments sent ECN-capable
+  uint32_t m_notEctData;  //!< Data segments sent not ECN-capable
+  uint32_t m_ectControl;  //!< Segments without data sent ECN-capable
+  uint32_t m_marked;      //!< Segments marked CE
+  uint32_t m_dropped;     //!< Segments dropped
+
+protected:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void) { }
+
+private:
+  SequenceNumber32 m_seqToMark;
+  SequenceNumber32 m_seqToDrop;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (TcpCeMarkErrorModel);
+
+TypeId
+TcpCeMarkErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpCeMarkErrorModel")
+    .SetParent<ErrorModel> ()
+    .AddConstructor<TcpCeMarkErrorModel> ()
+  ;
+  return tid;
+}
+
+TcpCeMarkErrorModel::TcpCeMarkErrorModel ()
+  : m_ectData (0),
+    m_notEctData (0),
+    m_ectControl (0),
+    m_marked (0),
+    m_dropped (0),
+    m_seqToMark (0),
+    m_seqToDrop (0)
+{
+}
+
+bool
+TcpCeMarkErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  Ipv4Header ipHeader;
+  TcpHeader tcpHeader;
+
+  p->RemoveHeader (ipHeader);
+  p->PeekHeader (tcpHeader);
+
+  bool isEct = ipHeader.GetEcn () != Ipv4Header::ECN_NotECT;
+  bool isData = p->GetSize () > tcpHeader.GetSerializedSize ();
+  if (isData && m_dropped == 0 && tcpHeader.GetSequenceNumber () == m_seqToDrop)
+    {
+      m_dropped++;
+      return true;
+    }
+  if (!isData)
+    {
+      m_ectControl += isEct;
+    }
+  else if (!isEct)
+    {
+      m_notEctData++;
+    }
+  else
+    {
+      m_ectData++;
+      if (tcpHeader.GetSequenceNumber () == m_seqToMark)
+        {
+          ipHeader.SetEcn (Ipv4Header::ECN_CE);
+          m_marked++;
+        }
+    }
+
+  p->AddHeader (ipHeader);
+  return false;
+}
+
+/**
+ * \brief Check the ECN negotiation and the reaction to a CE mark
+ *
+ * The sender transmits 40 segments; the segment with sequence number 5001
+ * is marked CE on its way to the receiver. If ECN is enabled on both ends,
+ * all the data segments must be ECN-capable, the receiver must echo the mark
+ * through ECE until it gets a CWR, and the sender must halve its window
+ * entering the CA_CWR state, without any retransmission. Otherwise, nothing
+ * must be ECN-capable and the flags must not be used after the handshake.
+ */
+class TcpEcnTest : public TcpGeneralTest
+{
+public:
+  TcpEcnTest (bool senderEcn, bool receiverEcn, const std::string &desc);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual Ptr<TcpSocketMsgBase> CreateReceiverSocket (Ptr<Node> node);
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel ();
+
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void CongStateTrace (const TcpSocketState::TcpCongState_t oldValue,
+                               const TcpSocketState::TcpCongState_t newValue);
+  virtual void UpdatedRttHistory (const SequenceNumber32 & seq, uint32_t sz,
+                                  bool isRetransmission, SocketWho who);
+  virtual void FinalChecks ();
+
+  virtual void ConfigureEnvironment ();
+
+private:
+  bool m_senderEcn;
+  bool m_receiverEcn;
+  Ptr<TcpCeMarkErrorModel> m_errorModel;
+  uint32_t m_eceSent;
+  uint32_t m_cwrSent;
+  uint32_t m_cwrEntered;
+  uint32_t m_retransmissions;
+  uint32_t m_cWndBeforeCwr;
+};
+
+TcpEcnTest::TcpEcnTest (bool senderEcn, bool receiverEcn, const std::string &desc)
+  : TcpGeneralTest (desc),
+    m_senderEcn (senderEcn),
+    m_receiverEcn (receiverEcn),
+    m_eceSent (0),
+    m_cwrSent (0),
+    m_cwrEntered (0),
+    m_retransmissions (0),
+    m_cWndBeforeCwr (0)
+{
+}
+
+void
+TcpEcnTest::ConfigureEnvironment ()
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetAppPktCount (40);
+  SetPropagationDelay (MilliSeconds (5));
+}
+
+Ptr<TcpSocketMsgBase>
+TcpEcnTest::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("UseEcn", BooleanValue (m_senderEcn));
+  return socket;
+}
+
+Ptr<TcpSocketMsgBase>
+TcpEcnTest::CreateReceiverSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateReceiverSocket (node);
+  socket->SetAttribute ("UseEcn", BooleanValue (m_receiverEcn));
+  return socket;
+}
+
+Ptr<ErrorModel>
+TcpEcnTest::CreateReceiverErrorModel ()
+{
+  m_errorModel = CreateObject<TcpCeMarkErrorModel> ();
+  m_errorModel->SetSeqToMark (SequenceNumber32 (5001));
+  return m_errorModel;
+}
+
+void
+TcpEcnTest::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  uint8_t flags = h.GetFlags ();
+  bool negotiated = m_senderEcn && m_receiverEcn;
+
+  if (flags & TcpHeader::SYN)
+    {
+      if (who == SENDER)
+        {
+          NS_TEST_ASSERT_MSG_EQ (((flags & TcpHeader::ECE) && (flags & TcpHeader::CWR)), m_senderEcn,
+                                 "ECN-setup SYN not consistent with the sender configuration");
+        }
+      else
+        {
+          NS_TEST_ASSERT_MSG_EQ (((flags & TcpHeader::ECE) != 0), negotiated,
+                                 "ECN-setup SYN-ACK not consistent with the configuration");
+          NS_TEST_ASSERT_MSG_EQ (((flags & TcpHeader::CWR) != 0), false,
+                                 "CWR set in a SYN-ACK");
+        }
+      return;
+    }
+
+  if (who == RECEIVER && (flags & TcpHeader::ECE))
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_errorModel->m_marked, 1,
+                             "ECE sent without any CE received");
+      m_eceSent++;
+    }
+  if (who == SENDER && (flags & TcpHeader::CWR))
+    {
+      NS_TEST_ASSERT_MSG_GT (p->GetSize (), 0, "CWR set on a segment without data");
+      NS_TEST_ASSERT_MSG_EQ (m_cwrEntered, 1, "CWR sent without reducing the window");
+      m_cwrSent++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (((flags & TcpHeader::ECE) && who == SENDER), false,
+                         "ECE sent by the sender");
+  NS_TEST_ASSERT_MSG_EQ (((flags & TcpHeader::CWR) && who == RECEIVER), false,
+                         "CWR sent by the receiver");
+}
+
+void
+TcpEcnTest::CongStateTrace (const TcpSocketState::TcpCongState_t oldValue,
+                            const TcpSocketState::TcpCongState_t newValue)
+{
+  NS_TEST_ASSERT_MSG_NE (newValue, TcpSocketState::CA_RECOVERY, "Unexpected fast recovery");
+  NS_TEST_ASSERT_MSG_NE (newValue, TcpSocketState::CA_LOSS, "Unexpected loss");
+
+  if (newValue == TcpSocketState::CA_CWR)
+    {
+      m_cwrEntered++;
+      Ptr<TcpSocketState> tcb = GetTcb (SENDER);
+      // the state is changed before the reduction
+      m_cWndBeforeCwr = tcb->m_cWnd;
+    }
+}
+
+void
+TcpEcnTest::UpdatedRttHistory (const SequenceNumber32 & seq, uint32_t sz,
+                               bool isRetransmission, SocketWho who)
+{
+  if (who == SENDER && isRetransmission && sz > 0)
+    {
+      m_retransmissions++;
+    }
+}
+
+void
+TcpEcnTest::FinalChecks ()
+{
+  bool negotiated = m_senderEcn && m_receiverEcn;
+  Ptr<TcpSocketState> tcb = GetTcb (SENDER);
+
+  NS_TEST_ASSERT_MSG_EQ (m_errorModel->m_ectControl, 0,
+                         "Segments without data sent ECN-capable");
+  NS_TEST_ASSERT_MSG_EQ (m_retransmissions, 0, "Unexpected retransmissions");
+
+  if (negotiated)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_errorModel->m_notEctData, 0,
+                             "Data segments sent not ECN-capable");
+      NS_TEST_ASSERT_MSG_EQ (m_errorModel->m_ectData, 40,
+                             "Not all the data segments have been sent");
+      NS_TEST_ASSERT_MSG_EQ (m_errorModel->m_marked, 1, "The segment has not been marked");
+      NS_TEST_ASSERT_MSG_GT (m_eceSent, 0, "CE not echoed");
+      NS_TEST_ASSERT_MSG_EQ (m_cwrEntered, 1, "Window not reduced once");
+      NS_TEST_ASSERT_MSG_EQ (m_cwrSent, 1, "CWR not sent once");
+      NS_TEST_ASSERT_MSG_LT (tcb->m_ssThresh.Get (), m_cWndBeforeCwr,
+                             "Slow start threshold not reduced");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_errorModel->m_ectData, 0,
+                             "Data segments sent ECN-capable");
+      NS_TEST_ASSERT_MSG_EQ (m_errorModel->m_marked, 0, "Unexpected mark");
+      NS_TEST_ASSERT_MSG_EQ (m_eceSent, 0, "Unexpected ECE");
+      NS_TEST_ASSERT_MSG_EQ (m_cwrSent, 0, "Unexpected CWR");
+      NS_TEST_ASSERT_MSG_EQ (m_cwrEntered, 0, "Unexpected window reduction");
+    }
+}
+
+/**
+ * \brief Check the reaction to an ECN echo carried by duplicate ACKs
+ *
+ * The segment with sequence number 5001 is lost, and the segment 6001 is
+ * marked CE: the receiver echoes the mark on the duplicate ACKs it sends
+ * for the hole (the ACK of 5501 is not a duplicate, since it acknowledges
+ * the delayed segment 4501). The sender must enter CA_CWR from CA_DISORDER
+ * on the first duplicate ACK, then fast recovery on the third one, and
+ * reduce its slow start threshold only once (RFC 3168, sec. 6.1.2).
+ */
+class TcpEcnDupAckTest : public TcpGeneralTest
+{
+public:
+  TcpEcnDupAckTest (const std::string &desc);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual Ptr<TcpSocketMsgBase> CreateReceiverSocket (Ptr<Node> node);
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel ();
+
+  virtual void Rx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void CongStateTrace (const TcpSocketState::TcpCongState_t oldValue,
+                               const TcpSocketState::TcpCongState_t newValue);
+  virtual void FinalChecks ();
+
+  virtual void ConfigureEnvironment ();
+
+private:
+  Ptr<TcpCeMarkErrorModel> m_errorModel;
+  uint32_t m_eceDupAcks;
+  uint32_t m_cwrEntered;
+  uint32_t m_recoveryEntered;
+  uint32_t m_ssThreshAtCwr;
+  uint32_t m_ssThreshAtRecovery;
+};
+
+TcpEcnDupAckTest::TcpEcnDupAckTest (const std::string &desc)
+  : TcpGeneralTest (desc),
+    m_eceDupAcks (0),
+    m_cwrEntered (0),
+    m_recoveryEntered (0),
+    m_ssThreshAtCwr (0),
+    m_ssThreshAtRecovery (0)
+{
+}
+
+void
+TcpEcnDupAckTest::ConfigureEnvironment ()
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetAppPktCount (40);
+  SetPropagationDelay (MilliSeconds (5));
+}
+
+Ptr<TcpSocketMsgBase>
+TcpEcnDupAckTest::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("UseEcn", BooleanValue (true));
+  return socket;
+}
+
+Ptr<TcpSocketMsgBase>
+TcpEcnDupAckTest::CreateReceiverSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateReceiverSocket (node);
+  socket->SetAttribute ("UseEcn", BooleanValue (true));
+  return socket;
+}
+
+Ptr<ErrorModel>
+TcpEcnDupAckTest::CreateReceiverErrorModel ()
+{
+  m_errorModel = CreateObject<TcpCeMarkErrorModel> ();
+  m_errorModel->SetSeqToDrop (SequenceNumber32 (5001));
+  m_errorModel->SetSeqToMark (SequenceNumber32 (6001));
+  return m_errorModel;
+}
+
+void
+TcpEcnDupAckTest::Rx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who == SENDER && (h.GetFlags () & TcpHeader::ECE)
+      && h.GetAckNumber () == SequenceNumber32 (5001))
+    {
+      m_eceDupAcks++;
+    }
+}
+
+void
+TcpEcnDupAckTest::CongStateTrace (const TcpSocketState::TcpCongState_t oldValue,
+                                  const TcpSocketState::TcpCongState_t newValue)
+{
+  NS_TEST_ASSERT_MSG_NE (newValue, TcpSocketState::CA_LOSS, "Unexpected loss");
+
+  // the states are changed before the reductions
+  if (newValue == TcpSocketState::CA_CWR)
+    {
+      NS_TEST_ASSERT_MSG_EQ (oldValue, TcpSocketState::CA_DISORDER,
+                             "CA_CWR not entered from CA_DISORDER");
+      m_cwrEntered++;
+    }
+  else if (newValue == TcpSocketState::CA_RECOVERY)
+    {
+      NS_TEST_ASSERT_MSG_EQ (oldValue, TcpSocketState::CA_CWR,
+                             "Fast recovery not entered from CA_CWR");
+      m_recoveryEntered++;
+      m_ssThreshAtCwr = GetTcb (SENDER)->m_ssThresh;
+    }
+  else if (oldValue == TcpSocketState::CA_RECOVERY)
+    {
+      m_ssThreshAtRecovery = GetTcb (SENDER)->m_ssThresh;
+    }
+}
+
+void
+TcpEcnDupAckTest::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_EQ (m_errorModel->m_dropped, 1, "The segment has not been dropped");
+  NS_TEST_ASSERT_MSG_EQ (m_errorModel->m_marked, 1, "The segment has not been marked");
+  NS_TEST_ASSERT_MSG_GT (m_eceDupAcks, 0, "CE not echoed on duplicate ACKs");
+  NS_TEST_ASSERT_MSG_EQ (m_cwrEntered, 1, "Window not reduced once on the ECN echo");
+  NS_TEST_ASSERT_MSG_EQ (m_recoveryEntered, 1, "Fast recovery not entered once");
+  NS_TEST_ASSERT_MSG_EQ (m_ssThreshAtRecovery, m_ssThreshAtCwr,
+                         "Slow start threshold reduced again by fast recovery");
+}
+
+//-----------------------------------------------------------------------------
+
+static class TcpEcnTestSuite : public TestSuite
+{
+public:
+  TcpEcnTestSuite () : TestSuite ("tcp-ecn-test", UNIT)
+  {
+    AddTestCase (new TcpEcnTest (true, true, "ECN negotiated, CE echoed and reacted to"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpEcnTest (true, false, "ECN refused by the receiver"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpEcnTest (false, true, "ECN not requested by the sender"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpEcnTest (false, false, "ECN disabled"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpEcnDupAckTest ("ECN echo on duplicate ACKs"),
+                 TestCase::QUICK);
+  }
+} g_tcpEcnTestSuite;
+
+} // namespace ns3
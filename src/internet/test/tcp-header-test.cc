@@ -59,7 +59,7 @@ void TcpHeaderGetSetTestCase::DoRun (void)
   uint16_t destinationPort;   //!< Destination port
   SequenceNumber32 sequenceNumber;  //!< Sequence number
   SequenceNumber32 ackNumber;       //!< ACK number
-  uint8_t flags;              //!< Flags (really a uint6_t)
+  uint8_t flags;              //!< Flags, including ECE and CWR
   uint16_t windowSize;        //!< Window size
   uint16_t urgentPointer;     //!< Urgent pointer
   TcpHeader header;
@@ -72,7 +72,7 @@ void TcpHeaderGetSetTestCase::DoRun (void)
       destinationPort = GET_RANDOM_UINT16 (x);
       sequenceNumber = SequenceNumber32 (GET_RANDOM_UINT32 (x));
       ackNumber = SequenceNumber32 (GET_RANDOM_UINT32 (x));
-      flags = GET_RANDOM_UINT6 (x);
+      flags = GET_RANDOM_UINT8 (x);
       windowSize = GET_RANDOM_UINT16 (x);
       urgentPointer = GET_RANDOM_UINT16 (x);
 
@@ -0,0 +1,236 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-general-test.h"
+#include "ns3/tcp-pacing-wheel.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpPacingTestSuite");
+
+/**
+ * \brief Check the expiration times of the callbacks of the pacing timer wheel
+ *
+ * The wheel has 4 slots of 10 us. The callbacks must be invoked at the end of
+ * the interval their time falls in, also when they wrap around the wheel or
+ * are scheduled by another callback.
+ */
+class TcpPacingWheelTest : public TestCase
+{
+public:
+  TcpPacingWheelTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Record the time a callback is invoked
+   * \param id the identifier of the callback
+   */
+  void Expired (uint32_t id);
+
+  /**
+   * \brief Record the time a callback is invoked, and schedule another one
+   * \param id the identifier of the callback
+   */
+  void ExpiredAndReschedule (uint32_t id);
+
+  Ptr<TcpPacingWheel> m_wheel;          //!< The wheel under test
+  std::vector<uint32_t> m_ids;          //!< The callbacks invoked, in order
+  std::vector<Time> m_times;            //!< The time the callbacks were invoked
+};
+
+TcpPacingWheelTest::TcpPacingWheelTest ()
+  : TestCase ("Expiration times of the pacing timer wheel")
+{
+}
+
+void
+TcpPacingWheelTest::Expired (uint32_t id)
+{
+  m_ids.push_back (id);
+  m_times.push_back (Simulator::Now ());
+}
+
+void
+TcpPacingWheelTest::ExpiredAndReschedule (uint32_t id)
+{
+  Expired (id);
+  m_wheel->ScheduleAt (Simulator::Now () + MicroSeconds (3),
+                       MakeCallback (&TcpPacingWheelTest::Expired, this).Bind (id + 1));
+}
+
+void
+TcpPacingWheelTest::DoRun (void)
+{
+  m_wheel = CreateObject<TcpPacingWheel> ();
+  m_wheel->SetAttribute ("Granularity", TimeValue (MicroSeconds (10)));
+  m_wheel->SetAttribute ("Slots", UintegerValue (4));
+
+  // wraps around the wheel twice
+  m_wheel->ScheduleAt (MicroSeconds (95), MakeCallback (&TcpPacingWheelTest::Expired, this).Bind (5u));
+  m_wheel->ScheduleAt (MicroSeconds (25), MakeCallback (&TcpPacingWheelTest::ExpiredAndReschedule, this).Bind (2u));
+  m_wheel->ScheduleAt (MicroSeconds (5), MakeCallback (&TcpPacingWheelTest::Expired, this).Bind (0u));
+  m_wheel->ScheduleAt (MicroSeconds (10), MakeCallback (&TcpPacingWheelTest::Expired, this).Bind (1u));
+  // same slot as the first one, but in the first round
+  m_wheel->ScheduleAt (MicroSeconds (55), MakeCallback (&TcpPacingWheelTest::Expired, this).Bind (4u));
+  NS_TEST_EXPECT_MSG_EQ (m_wheel->GetNPending (), 5, "Wrong number of pending callbacks");
+
+  Simulator::Run ();
+
+  uint32_t ids[] = { 0, 1, 2, 3, 4, 5 };
+  Time times[] = { MicroSeconds (10), MicroSeconds (10), MicroSeconds (30),
+                   MicroSeconds (40), MicroSeconds (60), MicroSeconds (100) };
+  NS_TEST_ASSERT_MSG_EQ (m_ids.size (), 6, "Wrong number of callbacks invoked");
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_ids[i], ids[i], "Callbacks invoked in the wrong order");
+      NS_TEST_EXPECT_MSG_EQ (m_times[i], times[i], "Callback " << m_ids[i] << " invoked at the wrong time");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_wheel->GetNPending (), 0, "Callbacks left on the wheel");
+
+  m_wheel->Dispose ();
+  m_wheel = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Check the spacing of the segments sent by a paced socket
+ *
+ * The sender transmits 100 segments at once. Once the first RTT sample is
+ * taken, with pacing enabled each data segment must follow the previous one
+ * by at least the time needed to send it at the pacing rate, i.e., cwnd/RTT
+ * multiplied by the pacing gain. Without pacing, the segments of each window
+ * leave back-to-back.
+ */
+class TcpPacingTest : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   * \param pacing true to enable pacing on the sender
+   * \param desc the test description
+   */
+  TcpPacingTest (bool pacing, const std::string &desc);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void FinalChecks ();
+  virtual void ConfigureEnvironment ();
+
+private:
+  bool m_pacing;              //!< Pacing enabled on the sender
+  uint32_t m_dataSent;        //!< Data segments sent
+  uint32_t m_backToBack;      //!< Data segments sent at the same time as the previous one
+  Time m_lastTx;              //!< Time of the last data segment
+  Time m_minNextTx;           //!< Earliest time allowed for the next data segment
+};
+
+TcpPacingTest::TcpPacingTest (bool pacing, const std::string &desc)
+  : TcpGeneralTest (desc),
+    m_pacing (pacing),
+    m_dataSent (0),
+    m_backToBack (0),
+    m_lastTx (Seconds (-1)),
+    m_minNextTx (Seconds (0))
+{
+}
+
+void
+TcpPacingTest::ConfigureEnvironment ()
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetAppPktCount (100);
+  SetAppPktInterval (Seconds (0));
+  SetPropagationDelay (MilliSeconds (50));
+}
+
+Ptr<TcpSocketMsgBase>
+TcpPacingTest::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("Pacing", BooleanValue (m_pacing));
+  return socket;
+}
+
+void
+TcpPacingTest::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who != SENDER || p->GetSize () == 0)
+    {
+      return;
+    }
+
+  Time now = Simulator::Now ();
+  m_dataSent++;
+  if (now == m_lastTx)
+    {
+      m_backToBack++;
+    }
+
+  if (m_pacing)
+    {
+      NS_TEST_ASSERT_MSG_GT_OR_EQ (now, m_minNextTx, "Segment " << m_dataSent << " sent too early");
+    }
+
+  Ptr<RttEstimator> rtt = GetRttEstimator (SENDER);
+  Ptr<TcpSocketState> tcb = GetTcb (SENDER);
+  if (rtt->GetNSamples () > 0)
+    {
+      double gain = tcb->m_cWnd < tcb->m_ssThresh ? 2.0 : 1.2;
+      m_minNextTx = now + Seconds (rtt->GetEstimate ().GetSeconds () * p->GetSize ()
+                                   / (gain * tcb->m_cWnd.Get ()));
+    }
+  m_lastTx = now;
+}
+
+void
+TcpPacingTest::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_EQ (m_dataSent, 100, "Not all the data segments have been sent");
+  if (m_pacing)
+    {
+      // only the segment sent before the first RTT sample may leave in a burst
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (m_backToBack, 1, "Segments sent back-to-back with pacing");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_GT (m_backToBack, 50, "Segments not sent back-to-back without pacing");
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+static class TcpPacingTestSuite : public TestSuite
+{
+public:
+  TcpPacingTestSuite () : TestSuite ("tcp-pacing-test", UNIT)
+  {
+    AddTestCase (new TcpPacingWheelTest (), TestCase::QUICK);
+    AddTestCase (new TcpPacingTest (true, "Segments paced over the RTT"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpPacingTest (false, "Segments sent in bursts without pacing"),
+                 TestCase::QUICK);
+  }
+} g_tcpPacingTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// This program measures the throughput of the enqueue and dequeue operations
+// of the DropTailQueue and of the RingBufferQueue. The queue is first filled
+// with a backlog of packets, then a packet is enqueued and another one is
+// dequeued the given number of times, so that the items keep moving along
+// the queue storage. The program prints the enqueue/dequeue pairs per second
+// of wall clock time for each queue type.
+//
+// $ ./waf --run="queue-bench --pairs=100000000 --backlog=100"
+//
+
+#include <iostream>
+#include <string>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+using namespace ns3;
+
+static void
+Bench (std::string queueType, uint32_t pairs, uint32_t backlog)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (queueType);
+  factory.Set ("MaxPackets", UintegerValue (backlog + 1));
+  Ptr<Queue> queue = factory.Create<Queue> ();
+
+  for (uint32_t i = 0; i < backlog; i++)
+    {
+      queue->Enqueue (Create<QueueItem> (Create<Packet> (1000)));
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Ptr<QueueItem> item = Create<QueueItem> (Create<Packet> (1000));
+  for (uint32_t i = 0; i < pairs; i++)
+    {
+      queue->Enqueue (item);
+      item = queue->Dequeue ();
+    }
+  int64_t elapsed = clock.End ();
+
+  std::cout << queueType << ": " << pairs << " enqueue/dequeue pairs in "
+            << elapsed << " ms";
+  if (elapsed > 0)
+    {
+      std::cout << ", " << pairs * 1000.0 / elapsed << " pairs/s";
+    }
+  std::cout << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t pairs = 100000000;
+  uint32_t backlog = 100;
+
+  CommandLine cmd;
+  cmd.AddValue ("pairs", "Number of enqueue/dequeue pairs", pairs);
+  cmd.AddValue ("backlog", "Number of packets in the queue during the test", backlog);
+  cmd.Parse (argc, argv);
+
+  Bench ("ns3::DropTailQueue", pairs, backlog);
+  Bench ("ns3::RingBufferQueue", pairs, backlog);
+
+  return 0;
+}
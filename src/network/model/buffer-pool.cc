@@ -0,0 +1,255 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "buffer-pool.h"
+#include "ns3/core-config.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <new>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BufferPool");
+
+namespace {
+
+/** Log2 of the size of the blocks of the smallest size class. */
+const uint32_t POOL_MIN_SHIFT = 4;
+/** Number of size classes: blocks up to 64 KiB are pooled. */
+const uint32_t POOL_CLASSES = 13;
+/** Size of the blocks of the biggest size class. */
+const uint32_t POOL_MAX_SIZE = 1 << (POOL_MIN_SHIFT + POOL_CLASSES - 1);
+
+/** A free block, linked in the list of its size class. */
+struct FreeBlock
+{
+  FreeBlock *next; //!< Next free block of the same size class.
+};
+
+/** Maximum number of free blocks cached in a size class. */
+uint32_t g_maxCachedBlocks = 1024;
+/** Maximum number of bytes cached by a thread. */
+uint64_t g_maxCachedBytes = 16 << 20;
+/** Whether the cache of the main thread has been released at exit. */
+bool g_destroyed = false;
+
+/** The free lists of the calling thread, one per size class. */
+__thread FreeBlock *g_freeLists[POOL_CLASSES];
+/** Number of blocks in each free list of the calling thread. */
+__thread uint32_t g_freeCounts[POOL_CLASSES];
+/** Number of bytes cached by the calling thread. */
+__thread uint64_t g_cachedBytes;
+/** Number of blocks allocated by the calling thread. */
+__thread uint64_t g_allocations;
+/** Number of allocations served from a free list. */
+__thread uint64_t g_hits;
+/** Number of blocks freed by the calling thread. */
+__thread uint64_t g_deallocations;
+
+#ifdef HAVE_PTHREAD_H
+/** Whether the calling thread releases its cache when it exits. */
+__thread bool g_releaseAtExit;
+/** Key whose destructor releases the cache of an exiting thread. */
+pthread_key_t g_releaseKey;
+/** Guard of the creation of g_releaseKey. */
+pthread_once_t g_releaseKeyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Release the cache of an exiting thread.
+ * \param arg unused
+ */
+void
+ReleaseAtExit (void *arg)
+{
+  BufferPool::Release ();
+}
+
+/** Create g_releaseKey. */
+void
+CreateReleaseKey (void)
+{
+  pthread_key_create (&g_releaseKey, &ReleaseAtExit);
+}
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * \param size a requested size, not bigger than POOL_MAX_SIZE
+ * \returns the size class of \p size
+ */
+inline uint32_t
+GetSizeClass (uint32_t size)
+{
+  uint32_t sizeClass = 0;
+  while ((1u << (POOL_MIN_SHIFT + sizeClass)) < size)
+    {
+      sizeClass++;
+    }
+  return sizeClass;
+}
+
+/**
+ * \brief Release the cache of the main thread when the program exits
+ */
+struct LocalStaticDestructor
+{
+  ~LocalStaticDestructor ()
+  {
+    BufferPool::Release ();
+    g_destroyed = true;
+  }
+} g_localStaticDestructor; //!< Local static destructor
+
+} // unnamed namespace
+
+uint32_t
+BufferPool::GetCapacity (uint32_t size)
+{
+  if (size > POOL_MAX_SIZE)
+    {
+      return size;
+    }
+  return 1u << (POOL_MIN_SHIFT + GetSizeClass (size));
+}
+
+uint32_t
+BufferPool::GetMaxCapacity (void)
+{
+  return POOL_MAX_SIZE;
+}
+
+uint8_t *
+BufferPool::Allocate (uint32_t size, uint32_t &capacity)
+{
+  NS_LOG_FUNCTION (size);
+  g_allocations++;
+  if (size > POOL_MAX_SIZE)
+    {
+      capacity = size;
+      return static_cast<uint8_t *> (::operator new (size));
+    }
+  uint32_t sizeClass = GetSizeClass (size);
+  capacity = 1u << (POOL_MIN_SHIFT + sizeClass);
+  FreeBlock *block = g_freeLists[sizeClass];
+  if (block != 0)
+    {
+      g_freeLists[sizeClass] = block->next;
+      g_freeCounts[sizeClass]--;
+      g_cachedBytes -= capacity;
+      g_hits++;
+      return reinterpret_cast<uint8_t *> (block);
+    }
+  return static_cast<uint8_t *> (::operator new (capacity));
+}
+
+void
+BufferPool::Deallocate (uint8_t *block, uint32_t capacity)
+{
+  NS_LOG_FUNCTION (static_cast<void *> (block) << capacity);
+  g_deallocations++;
+  if (capacity > POOL_MAX_SIZE)
+    {
+      ::operator delete (block);
+      return;
+    }
+  uint32_t sizeClass = GetSizeClass (capacity);
+  NS_ASSERT_MSG (capacity == 1u << (POOL_MIN_SHIFT + sizeClass),
+                 "Block of " << capacity << " bytes not allocated by the pool");
+  if (g_destroyed
+      || g_freeCounts[sizeClass] >= g_maxCachedBlocks
+      || g_cachedBytes + capacity > g_maxCachedBytes)
+    {
+      ::operator delete (block);
+      return;
+    }
+#ifdef HAVE_PTHREAD_H
+  if (!g_releaseAtExit)
+    {
+      pthread_once (&g_releaseKeyOnce, &CreateReleaseKey);
+      pthread_setspecific (g_releaseKey, &g_releaseAtExit);
+      g_releaseAtExit = true;
+    }
+#endif /* HAVE_PTHREAD_H */
+  FreeBlock *freeBlock = reinterpret_cast<FreeBlock *> (block);
+  freeBlock->next = g_freeLists[sizeClass];
+  g_freeLists[sizeClass] = freeBlock;
+  g_freeCounts[sizeClass]++;
+  g_cachedBytes += capacity;
+}
+
+BufferPool::Statistics
+BufferPool::GetStatistics (void)
+{
+  Statistics stats;
+  stats.allocations = g_allocations;
+  stats.hits = g_hits;
+  stats.deallocations = g_deallocations;
+  stats.cachedBlocks = 0;
+  for (uint32_t i = 0; i < POOL_CLASSES; ++i)
+    {
+      stats.cachedBlocks += g_freeCounts[i];
+    }
+  stats.cachedBytes = g_cachedBytes;
+  return stats;
+}
+
+void
+BufferPool::SetMaxCachedBlocks (uint32_t blocks)
+{
+  NS_LOG_FUNCTION (blocks);
+  g_maxCachedBlocks = blocks;
+}
+
+uint32_t
+BufferPool::GetMaxCachedBlocks (void)
+{
+  return g_maxCachedBlocks;
+}
+
+void
+BufferPool::SetMaxCachedBytes (uint64_t bytes)
+{
+  NS_LOG_FUNCTION (bytes);
+  g_maxCachedBytes = bytes;
+}
+
+uint64_t
+BufferPool::GetMaxCachedBytes (void)
+{
+  return g_maxCachedBytes;
+}
+
+void
+BufferPool::Release (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  for (uint32_t i = 0; i < POOL_CLASSES; ++i)
+    {
+      while (g_freeLists[i] != 0)
+        {
+          FreeBlock *block = g_freeLists[i];
+          g_freeLists[i] = block->next;
+          ::operator delete (block);
+        }
+      g_freeCounts[i] = 0;
+    }
+  g_cachedBytes = 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Per-thread pool of memory blocks for the packet data structures
+ *
+ * The storage of Buffer and PacketMetadata is allocated from this pool
+ * instead of going through new and delete for every packet. Blocks are
+ * segregated in power-of-two size classes, from 16 bytes to 64 KiB, so
+ * that a freed block can be reused by any request of the same class,
+ * whatever the exact size it was allocated for. Requests larger than the
+ * biggest class bypass the pool.
+ *
+ * Each thread caches the blocks it frees in its own free lists, hence
+ * no lock is taken, also when packets are created and destroyed by the
+ * worker threads of the MultithreadedSimulatorImpl. A block may be
+ * freed by a thread other than the one which allocated it: it then
+ * joins the cache of the freeing thread. The blocks cached by a thread
+ * are released when the thread exits (or, for the main thread, when
+ * the program exits).
+ *
+ * The number of blocks cached in each size class and the number of
+ * bytes cached by each thread are capped; the blocks freed beyond the
+ * caps are returned to the system.
+ */
+class BufferPool
+{
+public:
+  /** Allocation statistics of the pool of the calling thread. */
+  struct Statistics
+  {
+    uint64_t allocations;   //!< Number of blocks allocated.
+    uint64_t hits;          //!< Number of allocations served by the pool.
+    uint64_t deallocations; //!< Number of blocks freed.
+    uint64_t cachedBlocks;  //!< Number of free blocks currently in the pool.
+    uint64_t cachedBytes;   //!< Number of bytes currently in the pool.
+  };
+
+  /**
+   * \brief Allocate a block of memory
+   *
+   * The block can hold at least \p size bytes. Its actual size is
+   * returned in \p capacity and must be passed back to Deallocate.
+   *
+   * \param size the minimum size of the block
+   * \param capacity the actual size of the block
+   * \returns the allocated block
+   */
+  static uint8_t *Allocate (uint32_t size, uint32_t &capacity);
+  /**
+   * \brief Free a block of memory
+   *
+   * \param block the block to free
+   * \param capacity the size of the block, as returned by Allocate
+   */
+  static void Deallocate (uint8_t *block, uint32_t capacity);
+  /**
+   * \param size a requested size
+   * \returns the size of the block Allocate returns for \p size
+   */
+  static uint32_t GetCapacity (uint32_t size);
+  /**
+   * \returns the size of the blocks of the biggest size class; the
+   * bigger blocks are not cached
+   */
+  static uint32_t GetMaxCapacity (void);
+
+  /**
+   * \returns the allocation statistics of the calling thread
+   */
+  static Statistics GetStatistics (void);
+  /**
+   * \brief Set the maximum number of free blocks a thread caches in
+   * each size class
+   *
+   * Zero disables the caching. This applies to all the threads and
+   * should be set before the simulation starts.
+   *
+   * \param blocks the maximum number of blocks (1024 by default)
+   */
+  static void SetMaxCachedBlocks (uint32_t blocks);
+  /**
+   * \returns the maximum number of free blocks a thread caches in each
+   * size class
+   */
+  static uint32_t GetMaxCachedBlocks (void);
+  /**
+   * \brief Set the maximum number of bytes a thread caches, over all the
+   * size classes
+   *
+   * This applies to all the threads and should be set before the
+   * simulation starts.
+   *
+   * \param bytes the maximum number of bytes (16 MiB by default)
+   */
+  static void SetMaxCachedBytes (uint64_t bytes);
+  /**
+   * \returns the maximum number of bytes a thread caches
+   */
+  static uint64_t GetMaxCachedBytes (void);
+  /**
+   * \brief Free all the blocks cached by the calling thread
+   */
+  static void Release (void);
+};
+
+} // namespace ns3
+
+#endif /* BUFFER_POOL_H */
@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "buffer.h"
+#include "buffer-pool.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
@@ -51,96 +52,38 @@ NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
 uint32_t Buffer::g_recommendedStart = 0;
+bool Buffer::g_scatterGather = false;
+/* In scatter-gather mode, the bytes of a buffer which would be copied to
+ * make room for bytes added at its start become a segment instead, when
+ * there are more of them than this: copying a few bytes is cheaper than
+ * iterating over several segments.
+ */
+static const uint32_t g_minSegmentSize = 128;
 #ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
+/* The size of the biggest buffer data freed so far by the calling thread,
+ * among those cached by the BufferPool. New buffer data are allocated with
+ * at least this size, so that the headers added to a new packet rarely
+ * trigger a reallocation, and their memory is recycled by the BufferPool.
  */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
-{
-  NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
-    }
-}
+static __thread uint32_t g_maxSize = 0;
 
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
-    {
-      Buffer::Deallocate (data);
-    }
-  else
+  if (data->m_size - 1 + sizeof (struct Buffer::Data) <= BufferPool::GetMaxCapacity ())
     {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      g_maxSize = std::max (g_maxSize, data->m_size);
     }
+  Deallocate (data);
 }
 
 Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
-    {
-      g_freeList = new Buffer::FreeList ();
-    }
-  else if (IS_INITIALIZED (g_freeList))
-    {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
-    }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
-  return data;
+  return Allocate (std::max (dataSize, g_maxSize));
 }
 #else /* BUFFER_FREE_LIST */
 void
@@ -169,7 +112,13 @@ Buffer::Allocate (uint32_t reqSize)
     }
   NS_ASSERT (reqSize >= 1);
   uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
+#ifdef BUFFER_FREE_LIST
+  /* the data area covers the whole block returned by the pool */
+  uint8_t *b = BufferPool::Allocate (size, size);
+  reqSize = size + 1 - sizeof (struct Buffer::Data);
+#else
   uint8_t *b = new uint8_t [size];
+#endif
   struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
   data->m_size = reqSize;
   data->m_count = 1;
@@ -182,22 +131,29 @@ Buffer::Deallocate (struct Buffer::Data *data)
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
   uint8_t *buf = reinterpret_cast<uint8_t *> (data);
+#ifdef BUFFER_FREE_LIST
+  BufferPool::Deallocate (buf, data->m_size - 1 + sizeof (struct Buffer::Data));
+#else
   delete [] buf;
+#endif
 }
 
 Buffer::Buffer ()
+  : m_chain (0)
 {
   NS_LOG_FUNCTION (this);
   Initialize (0);
 }
 
 Buffer::Buffer (uint32_t dataSize)
+  : m_chain (0)
 {
   NS_LOG_FUNCTION (this << dataSize);
   Initialize (dataSize);
 }
 
 Buffer::Buffer (uint32_t dataSize, bool initialize)
+  : m_chain (0)
 {
   NS_LOG_FUNCTION (this << dataSize << initialize);
   if (initialize == true)
@@ -270,6 +226,12 @@ Buffer::operator = (Buffer const&o)
       m_data = o.m_data;
       m_data->m_count++;
     }
+  if (o.m_chain != 0)
+    {
+      o.m_chain->m_count++;
+    }
+  ReleaseChain ();
+  m_chain = o.m_chain;
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
   m_zeroAreaStart = o.m_zeroAreaStart;
@@ -290,6 +252,100 @@ Buffer::~Buffer ()
     {
       Recycle (m_data);
     }
+  ReleaseChain ();
+}
+
+uint32_t
+Buffer::GetNSegments (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (m_chain == 0)
+    {
+      return 1;
+    }
+  return 1 + m_chain->m_segments.size ();
+}
+
+void
+Buffer::EnableScatterGather (bool enable)
+{
+  NS_LOG_FUNCTION (enable);
+  g_scatterGather = enable;
+}
+
+bool
+Buffer::IsScatterGatherEnabled (void)
+{
+  return g_scatterGather;
+}
+
+Buffer
+Buffer::CopyHead (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Buffer head (0, false);
+  head.m_data = m_data;
+  head.m_data->m_count++;
+  head.m_maxZeroAreaStart = m_zeroAreaStart;
+  head.m_zeroAreaStart = m_zeroAreaStart;
+  head.m_zeroAreaEnd = m_zeroAreaEnd;
+  head.m_start = m_start;
+  head.m_end = m_end;
+  return head;
+}
+
+void
+Buffer::SetHead (const Buffer &head)
+{
+  NS_LOG_FUNCTION (this << &head);
+  NS_ASSERT (head.m_chain == 0);
+  head.m_data->m_count++;
+  m_data->m_count--;
+  if (m_data->m_count == 0)
+    {
+      Recycle (m_data);
+    }
+  m_data = head.m_data;
+  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  m_maxZeroAreaStart = head.m_maxZeroAreaStart;
+  m_zeroAreaStart = head.m_zeroAreaStart;
+  m_zeroAreaEnd = head.m_zeroAreaEnd;
+  m_start = head.m_start;
+  m_end = head.m_end;
+}
+
+void
+Buffer::MakeChainWritable (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_chain == 0)
+    {
+      m_chain = new Chain ();
+      m_chain->m_count = 1;
+      m_chain->m_size = 0;
+    }
+  else if (m_chain->m_count > 1)
+    {
+      m_chain->m_count--;
+      m_chain = new Chain (*m_chain);
+      m_chain->m_count = 1;
+    }
+}
+
+void
+Buffer::ReleaseChain (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_chain == 0)
+    {
+      return;
+    }
+  m_chain->m_count--;
+  if (m_chain->m_count == 0)
+    {
+      delete m_chain;
+    }
+  m_chain = 0;
 }
 
 uint32_t
@@ -323,6 +379,32 @@ Buffer::AddAtStart (uint32_t start)
       // update dirty area
       m_data->m_dirtyStart = m_start;
     } 
+  else if (g_scatterGather && GetInternalSize () > g_minSegmentSize)
+    {
+      /* do not copy the bytes of the buffer: they become the second
+       * segment and the new bytes go to a new first segment.
+       */
+      Buffer head = CopyHead ();
+      MakeChainWritable ();
+      m_chain->m_segments.insert (m_chain->m_segments.begin (), head);
+      m_chain->m_size += head.GetSize ();
+      struct Buffer::Data *newData = Buffer::Create (start);
+      m_data->m_count--;
+      if (m_data->m_count == 0)
+        {
+          Buffer::Recycle (m_data);
+        }
+      m_data = newData;
+
+      m_end = std::max (start, std::min (m_data->m_size, g_recommendedStart));
+      m_start = m_end - start;
+      m_zeroAreaStart = m_end;
+      m_zeroAreaEnd = m_end;
+
+      // update dirty area
+      m_data->m_dirtyStart = m_start;
+      m_data->m_dirtyEnd = m_end;
+    }
   else
     {
       uint32_t newSize = GetInternalSize () + start;
@@ -355,6 +437,14 @@ Buffer::AddAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
+  if (m_chain != 0)
+    {
+      // the bytes are added to the last segment
+      MakeChainWritable ();
+      m_chain->m_segments.back ().AddAtEnd (end);
+      m_chain->m_size += end;
+      return;
+    }
   bool isDirty = m_data->m_count > 1 && m_end < m_data->m_dirtyEnd;
   if (GetInternalEnd () + end <= m_data->m_size && !isDirty)
     {
@@ -400,7 +490,8 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
+  if (m_chain == 0 && o.m_chain == 0 &&
+      m_data->m_count == 1 &&
       m_end == m_zeroAreaEnd &&
       m_end == m_data->m_dirtyEnd &&
       o.m_start == o.m_zeroAreaStart &&
@@ -426,6 +517,36 @@ Buffer::AddAtEnd (const Buffer &o)
       return;
     }
 
+  if (g_scatterGather)
+    {
+      /* append references to the segments of o rather than copies
+       * of their bytes.
+       */
+      if (o.GetSize () == 0)
+        {
+          return;
+        }
+      if (GetSize () == 0)
+        {
+          *this = o;
+          return;
+        }
+      Buffer src = o; // o might be this buffer
+      MakeChainWritable ();
+      if (src.m_end != src.m_start)
+        {
+          m_chain->m_segments.push_back (src.CopyHead ());
+        }
+      if (src.m_chain != 0)
+        {
+          m_chain->m_segments.insert (m_chain->m_segments.end (),
+                                      src.m_chain->m_segments.begin (),
+                                      src.m_chain->m_segments.end ());
+        }
+      m_chain->m_size += src.GetSize ();
+      return;
+    }
+
   Buffer dst = CreateFullCopy ();
   Buffer src = o.CreateFullCopy ();
 
@@ -442,6 +563,39 @@ Buffer::RemoveAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (CheckInternalState ());
+  if (m_chain != 0 && start >= m_end - m_start)
+    {
+      /* the first segment is removed: drop the next segments which are
+       * removed as well, and make the first remaining one the first
+       * segment. The bytes left to remove are removed from it below.
+       */
+      start -= m_end - m_start;
+      MakeChainWritable ();
+      std::vector<Buffer> &segments = m_chain->m_segments;
+      std::vector<Buffer>::iterator i = segments.begin ();
+      while (i != segments.end () && start >= i->GetSize ())
+        {
+          start -= i->GetSize ();
+          m_chain->m_size -= i->GetSize ();
+          ++i;
+        }
+      if (i == segments.end ())
+        {
+          ReleaseChain ();
+          start = m_end - m_start;
+        }
+      else
+        {
+          Buffer head = *i;
+          m_chain->m_size -= head.GetSize ();
+          segments.erase (segments.begin (), i + 1);
+          if (segments.empty ())
+            {
+              ReleaseChain ();
+            }
+          SetHead (head);
+        }
+    }
   uint32_t newStart = m_start + start;
   if (newStart <= m_zeroAreaStart)
     {
@@ -487,6 +641,37 @@ Buffer::RemoveAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
+  if (m_chain != 0 && end > 0)
+    {
+      // remove the bytes from the last segments first
+      MakeChainWritable ();
+      std::vector<Buffer> &segments = m_chain->m_segments;
+      while (end > 0 && !segments.empty ())
+        {
+          Buffer &last = segments.back ();
+          uint32_t size = last.GetSize ();
+          if (end < size)
+            {
+              last.RemoveAtEnd (end);
+              m_chain->m_size -= end;
+              end = 0;
+            }
+          else
+            {
+              segments.pop_back ();
+              m_chain->m_size -= size;
+              end -= size;
+            }
+        }
+      if (segments.empty ())
+        {
+          ReleaseChain ();
+        }
+      if (end == 0)
+        {
+          return;
+        }
+    }
   uint32_t newEnd = m_end - std::min (end, m_end - m_start);
   if (newEnd > m_zeroAreaEnd)
     {
@@ -530,11 +715,42 @@ Buffer::CreateFragment (uint32_t start, uint32_t length) const
   return tmp;
 }
 
+Buffer
+Buffer::CreateUnsharedCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (CheckInternalState ());
+  if (m_chain != 0)
+    {
+      // gathering the segments copies them
+      return CreateFullCopy ();
+    }
+  Buffer tmp = *this;
+  struct Buffer::Data *newData = Buffer::Create (m_data->m_size);
+  memcpy (newData->m_data + m_start, m_data->m_data + m_start, GetInternalSize ());
+  // this buffer still refers to the old data
+  tmp.m_data->m_count--;
+  tmp.m_data = newData;
+  tmp.m_data->m_dirtyStart = m_start;
+  tmp.m_data->m_dirtyEnd = m_end;
+  NS_ASSERT (tmp.CheckInternalState ());
+  return tmp;
+}
+
 Buffer 
 Buffer::CreateFullCopy (void) const
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
+  if (m_chain != 0)
+    {
+      // gather the segments
+      uint32_t size = GetSize ();
+      Buffer tmp;
+      tmp.AddAtEnd (size);
+      CopyData (tmp.m_data->m_data + tmp.m_start, size);
+      return tmp;
+    }
   if (m_zeroAreaEnd - m_zeroAreaStart != 0) 
     {
       Buffer tmp;
@@ -559,6 +775,10 @@ uint32_t
 Buffer::GetSerializedSize (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_chain != 0)
+    {
+      return CreateFullCopy ().GetSerializedSize ();
+    }
   uint32_t dataStart = (m_zeroAreaStart - m_start + 3) & (~0x3);
   uint32_t dataEnd = (m_end - m_zeroAreaEnd + 3) & (~0x3);
 
@@ -579,6 +799,10 @@ uint32_t
 Buffer::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  if (m_chain != 0)
+    {
+      return CreateFullCopy ().Serialize (buffer, maxSize);
+    }
   uint32_t* p = reinterpret_cast<uint32_t *> (buffer);
   uint32_t size = 0;
 
@@ -715,6 +939,19 @@ void
 Buffer::CopyData (std::ostream *os, uint32_t size) const
 {
   NS_LOG_FUNCTION (this << &os << size);
+  if (m_chain != 0)
+    {
+      Buffer head = CopyHead ();
+      head.CopyData (os, size);
+      size -= std::min (size, head.GetSize ());
+      for (std::vector<Buffer>::const_iterator i = m_chain->m_segments.begin ();
+           i != m_chain->m_segments.end () && size > 0; ++i)
+        {
+          i->CopyData (os, size);
+          size -= std::min (size, i->GetSize ());
+        }
+      return;
+    }
   if (size > 0)
     {
       uint32_t tmpsize = std::min (m_zeroAreaStart-m_start, size);
@@ -744,6 +981,16 @@ uint32_t
 Buffer::CopyData (uint8_t *buffer, uint32_t size) const
 {
   NS_LOG_FUNCTION (this << &buffer << size);
+  if (m_chain != 0)
+    {
+      uint32_t copied = CopyHead ().CopyData (buffer, size);
+      for (std::vector<Buffer>::const_iterator i = m_chain->m_segments.begin ();
+           i != m_chain->m_segments.end () && copied < size; ++i)
+        {
+          copied += i->CopyData (buffer + copied, size - copied);
+        }
+      return copied;
+    }
   uint32_t originalSize = size;
   if (size > 0)
     {
@@ -783,7 +1030,7 @@ uint32_t
 Buffer::Iterator::GetDistanceFrom (Iterator const &o) const
 {
   NS_LOG_FUNCTION (this << &o);
-  NS_ASSERT (m_data == o.m_data);
+  NS_ASSERT (m_data == o.m_data || m_buffer != 0 || o.m_buffer != 0);
   int32_t diff = m_current - o.m_current;
   if (diff < 0)
     {
@@ -825,16 +1072,97 @@ bool
 Buffer::Iterator::Check (uint32_t i) const
 {
   NS_LOG_FUNCTION (this << &i);
+  if (m_buffer != 0 && i >= m_dataStart && i < m_dataEnd)
+    {
+      // check against the zero area of the segment which holds i
+      return GetSegmentByte (m_buffer, i) != 0;
+    }
   return i >= m_dataStart && 
          !(i >= m_zeroStart && i < m_zeroEnd) &&
          i <= m_dataEnd;
 }
 
+uint8_t *
+Buffer::Iterator::GetSegmentByte (const Buffer *buffer, uint32_t i)
+{
+  NS_LOG_FUNCTION (buffer << i);
+  NS_ASSERT (buffer != 0 && buffer->m_chain != 0);
+  const std::vector<Buffer> &segments = buffer->m_chain->m_segments;
+  const Buffer *segment = buffer;
+  // offset of the start of the segment in the virtual bytes
+  uint32_t start = buffer->m_start;
+  uint32_t size = buffer->m_end - buffer->m_start;
+  for (std::vector<Buffer>::const_iterator next = segments.begin ();
+       i >= start + size && next != segments.end (); ++next)
+    {
+      start += size;
+      segment = &*next;
+      size = segment->m_end - segment->m_start;
+    }
+  NS_ASSERT (i < start + size);
+  uint32_t offset = segment->m_start + (i - start);
+  if (offset < segment->m_zeroAreaStart)
+    {
+      return segment->m_data->m_data + offset;
+    }
+  else if (offset < segment->m_zeroAreaEnd)
+    {
+      return 0;
+    }
+  else
+    {
+      return segment->m_data->m_data + offset - (segment->m_zeroAreaEnd - segment->m_zeroAreaStart);
+    }
+}
+
+uint8_t
+Buffer::Iterator::SlowPeekU8 (const Buffer *buffer, uint32_t i)
+{
+  NS_LOG_FUNCTION (buffer << i);
+  uint8_t *byte = GetSegmentByte (buffer, i);
+  return (byte == 0) ? 0 : *byte;
+}
+
+void
+Buffer::Iterator::SlowWrite (const Buffer *buffer, uint32_t i, uint8_t const *data, uint32_t size)
+{
+  NS_LOG_FUNCTION (buffer << i << &data << size);
+  for (uint32_t j = 0; j < size; j++)
+    {
+      uint8_t *byte = GetSegmentByte (buffer, i + j);
+      NS_ASSERT (byte != 0);
+      *byte = data[j];
+    }
+}
+
+void
+Buffer::Iterator::SlowWriteU8 (const Buffer *buffer, uint32_t i, uint8_t data, uint32_t len)
+{
+  NS_LOG_FUNCTION (buffer << i << static_cast<uint32_t> (data) << len);
+  for (uint32_t j = 0; j < len; j++)
+    {
+      uint8_t *byte = GetSegmentByte (buffer, i + j);
+      NS_ASSERT (byte != 0);
+      *byte = data;
+    }
+}
+
 
 void 
 Buffer::Iterator::Write (Iterator start, Iterator end)
 {
   NS_LOG_FUNCTION (this << &start << &end);
+  if (m_buffer != 0 || start.m_buffer != 0 || end.m_buffer != 0)
+    {
+      // multi-segment buffers are copied byte by byte
+      NS_ASSERT (start.m_current <= end.m_current);
+      uint32_t size = end.m_current - start.m_current;
+      for (uint32_t i = 0; i < size; i++)
+        {
+          WriteU8 (start.ReadU8 ());
+        }
+      return;
+    }
   NS_ASSERT (start.m_data == end.m_data);
   NS_ASSERT (start.m_current <= end.m_current);
   NS_ASSERT (start.m_zeroStart == end.m_zeroStart);
@@ -955,6 +1283,12 @@ Buffer::Iterator::Write (uint8_t const*buffer, uint32_t size)
   NS_LOG_FUNCTION (this << &buffer << size);
   NS_ASSERT_MSG (CheckNoZero (m_current, size),
                  GetWriteErrorMessage ());
+  if (m_buffer != 0)
+    {
+      SlowWrite (m_buffer, m_current, buffer, size);
+      m_current += size;
+      return;
+    }
   uint8_t *to;
   if (m_current <= m_zeroStart)
     {
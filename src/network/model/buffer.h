@@ -59,6 +59,10 @@ namespace ns3 {
  * In every other case, the BufferData must be copied before
  * being modified.
  *
+ * The BufferData instances are allocated from the BufferPool. Their
+ * size is rounded up to the size class of the pool, and the extra
+ * bytes are available to the Buffer instances which reference them.
+ *
  * To understand the way the Buffer::Add and Buffer::Remove methods
  * work, you first need to understand the "virtual offsets" used to
  * keep track of the content of buffers. Each Buffer instance
@@ -88,9 +92,23 @@ namespace ns3 {
  * \endverbatim
  *
  * A simple state invariant is that m_start <= m_zeroStart <= m_zeroEnd <= m_end
+ *
+ * When the scatter-gather mode is enabled (see EnableScatterGather),
+ * a Buffer may be made of several segments: the first one is described
+ * by the fields above, and the next ones are Buffer instances stored in
+ * a copy-on-write Buffer::Chain. Appending a buffer to another one then
+ * only appends references to its segments, and removing bytes from a
+ * multi-segment buffer, or fragmenting it, only drops or trims segments,
+ * whatever their size. The zero area of the iterators over a
+ * multi-segment buffer covers all the bytes, so that their inline
+ * accessors, whose code is the same as for a single segment, always fall
+ * back to out-of-line ones which look up the segment of each byte. The
+ * operations which need the bytes to be contiguous, such as PeekData or
+ * Serialize, gather the segments in a single BufferData.
  */
 class Buffer 
 {
+  struct Chain;
 public:
   /**
    * \brief iterator in a Buffer instance
@@ -397,6 +415,44 @@ private:
      * \param buffer the buffer this iterator refers to
      */
     inline void Construct (const Buffer *buffer);
+    /**
+     * \param buffer a multi-segment buffer
+     * \param i an offset in the virtual bytes of the iterators over \p buffer
+     * \returns a pointer to the byte at offset \p i, in the segment which
+     * holds it, or zero if this byte is in the zero area of the segment.
+     */
+    static uint8_t *GetSegmentByte (const Buffer *buffer, uint32_t i);
+    /**
+     * \param buffer a multi-segment buffer
+     * \param i an offset in the virtual bytes of the iterators over \p buffer
+     * \returns the byte at offset \p i
+     *
+     * \warning this is the slow version, please use PeekU8 (void)
+     */
+    static uint8_t SlowPeekU8 (const Buffer *buffer, uint32_t i);
+    /**
+     * Write bytes in the segments of a multi-segment buffer
+     *
+     * \param buffer a multi-segment buffer
+     * \param i an offset in the virtual bytes of the iterators over \p buffer
+     * \param data the bytes to write at offset \p i
+     * \param size the number of bytes to write
+     *
+     * \warning this is the slow version, please use Write (uint8_t const*, uint32_t)
+     */
+    static void SlowWrite (const Buffer *buffer, uint32_t i, uint8_t const *data, uint32_t size);
+    /**
+     * Write the same byte several times in the segments of a
+     * multi-segment buffer
+     *
+     * \param buffer a multi-segment buffer
+     * \param i an offset in the virtual bytes of the iterators over \p buffer
+     * \param data the byte to write
+     * \param len the number of times data must be written
+     *
+     * \warning this is the slow version, please use WriteU8 (uint8_t, uint32_t)
+     */
+    static void SlowWriteU8 (const Buffer *buffer, uint32_t i, uint8_t data, uint32_t len);
     /**
      * Checks that the [start, end) is not in the "virtual zero area".
      *
@@ -476,12 +532,40 @@ private:
      * to this pointer.
      */
     uint8_t *m_data;
+    /**
+     * the multi-segment buffer this iterator refers to, or zero if the
+     * buffer has a single segment. In the former case, the "virtual zero
+     * area" covers all the bytes.
+     */
+    const Buffer *m_buffer;
   };
 
   /**
    * \return the number of bytes stored in this buffer.
    */
   inline uint32_t GetSize (void) const;
+  /**
+   * \return the number of segments of this buffer, one unless the
+   * scatter-gather mode is enabled.
+   */
+  uint32_t GetNSegments (void) const;
+
+  /**
+   * \brief Enable or disable the scatter-gather mode
+   *
+   * In this mode, appending a buffer to another one, or adding bytes
+   * at the start of a buffer whose data is shared with another buffer,
+   * make a multi-segment buffer which references the data of the
+   * original buffers instead of copying it. Fragments of multi-segment
+   * buffers reference the same segments.
+   *
+   * \param enable true to enable the mode, false to disable it
+   */
+  static void EnableScatterGather (bool enable = true);
+  /**
+   * \returns true if the scatter-gather mode is enabled
+   */
+  static bool IsScatterGatherEnabled (void);
 
   /**
    * \return a pointer to the start of the internal 
@@ -549,9 +633,20 @@ private:
    */
   Buffer CreateFragment (uint32_t start, uint32_t length) const;
 
+  /**
+   * \return a copy of this Buffer which shares no internal structure with
+   * it, so that the two can be used by different threads.
+   *
+   * The copy of a multi-segment buffer has a single segment.
+   */
+  Buffer CreateUnsharedCopy (void) const;
+
   /**
    * \return an Iterator which points to the
    * start of this Buffer.
+   *
+   * An Iterator over a multi-segment buffer refers to the buffer itself,
+   * which must outlive it.
    */
   inline Buffer::Iterator Begin (void) const;
   /**
@@ -683,9 +778,29 @@ private:
    * \brief Create a full copy of the buffer, including
    * all the internal structures.
    *
+   * The copy of a multi-segment buffer has a single segment.
+   *
    * \returns a copy of the buffer
    */
   Buffer CreateFullCopy (void) const;
+  /**
+   * \returns a buffer made of the first segment of this buffer only
+   */
+  Buffer CopyHead (void) const;
+  /**
+   * \brief Make a buffer the first segment of this buffer
+   * \param head a buffer with a single segment
+   */
+  void SetHead (const Buffer &head);
+  /**
+   * \brief Make sure this buffer owns its chain of segments, creating
+   * an empty one if needed, before it is modified.
+   */
+  void MakeChainWritable (void);
+  /**
+   * \brief Release the chain of segments of this buffer
+   */
+  void ReleaseChain (void);
 
   /**
    * \brief Transform a "Virtual byte buffer" into a "Real byte buffer"
@@ -783,19 +898,29 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
+  /**
+   * the segments which follow the first one, or zero if this buffer
+   * has a single segment
+   */
+  struct Chain *m_chain;
 
-#ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
-#endif
+  /**
+   * whether the scatter-gather mode is enabled
+   */
+  static bool g_scatterGather;
+};
+
+/**
+ * \brief The segments of a multi-segment Buffer but the first one
+ *
+ * The chain is shared by the copies of a buffer and copied before
+ * being modified.
+ */
+struct Buffer::Chain
+{
+  uint32_t m_count;                 //!< Number of buffers which reference this chain
+  uint32_t m_size;                  //!< Number of bytes in the segments
+  std::vector<Buffer> m_segments;   //!< The segments, each with a single segment
 };
 
 } // namespace ns3
@@ -811,7 +936,8 @@ Buffer::Iterator::Iterator ()
     m_dataStart (0),
     m_dataEnd (0),
     m_current (0),
-    m_data (0)
+    m_data (0),
+    m_buffer (0)
 {
 }
 Buffer::Iterator::Iterator (Buffer const*buffer)
@@ -833,6 +959,17 @@ Buffer::Iterator::Construct (const Buffer *buffer)
   m_dataStart = buffer->m_start;
   m_dataEnd = buffer->m_end;
   m_data = buffer->m_data->m_data;
+  m_buffer = 0;
+  if (buffer->m_chain != 0)
+    {
+      /* the zero area covers all the bytes: the inline accessors fall
+       * back to the out-of-line ones, which look up the segments.
+       */
+      m_zeroStart = 0;
+      m_zeroEnd = 0xffffffff;
+      m_dataEnd += buffer->m_chain->m_size;
+      m_buffer = buffer;
+    }
 }
 
 void 
@@ -870,11 +1007,16 @@ Buffer::Iterator::WriteU8 (uint8_t data)
       m_data[m_current] = data;
       m_current++;
     }
-  else
+  else if (m_buffer == 0)
     {
       m_data[m_current - (m_zeroEnd-m_zeroStart)] = data;
       m_current++;
     }
+  else
+    {
+      SlowWriteU8 (m_buffer, m_current, data, 1);
+      m_current++;
+    }
 }
 
 void 
@@ -882,17 +1024,22 @@ Buffer::Iterator::WriteU8 (uint8_t  data, uint32_t len)
 {
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + len),
                  GetWriteErrorMessage ());
-  if (m_current <= m_zeroStart)
+  if (m_current + len <= m_zeroStart)
     {
       std::memset (&(m_data[m_current]), data, len);
       m_current += len;
     }
-  else
+  else if (m_buffer == 0)
     {
       uint8_t *buffer = &m_data[m_current - (m_zeroEnd-m_zeroStart)];
       std::memset (buffer, data, len);
       m_current += len;
     }
+  else
+    {
+      SlowWriteU8 (m_buffer, m_current, data, len);
+      m_current += len;
+    }
 }
 
 void 
@@ -905,10 +1052,18 @@ Buffer::Iterator::WriteHtonU16 (uint16_t data)
     {
       buffer = &m_data[m_current];
     }
-  else
+  else if (m_buffer == 0)
     {
       buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
     }
+  else
+    {
+      uint8_t bytes[2] = { static_cast<uint8_t> ((data >> 8) & 0xff),
+                           static_cast<uint8_t> ((data >> 0) & 0xff) };
+      SlowWrite (m_buffer, m_current, bytes, 2);
+      m_current += 2;
+      return;
+    }
   buffer[0] = (data >> 8)& 0xff;
   buffer[1] = (data >> 0)& 0xff;
   m_current+= 2;
@@ -925,10 +1080,20 @@ Buffer::Iterator::WriteHtonU32 (uint32_t data)
     {
       buffer = &m_data[m_current];
     }
-  else
+  else if (m_buffer == 0)
     {
       buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
     }
+  else
+    {
+      uint8_t bytes[4] = { static_cast<uint8_t> ((data >> 24) & 0xff),
+                           static_cast<uint8_t> ((data >> 16) & 0xff),
+                           static_cast<uint8_t> ((data >> 8) & 0xff),
+                           static_cast<uint8_t> ((data >> 0) & 0xff) };
+      SlowWrite (m_buffer, m_current, bytes, 4);
+      m_current += 4;
+      return;
+    }
   buffer[0] = (data >> 24)& 0xff;
   buffer[1] = (data >> 16)& 0xff;
   buffer[2] = (data >> 8)& 0xff;
@@ -1000,14 +1165,18 @@ Buffer::Iterator::PeekU8 (void)
       uint8_t data = m_data[m_current];
       return data;
     }
-  else if (m_current < m_zeroEnd)
+  else if (m_current >= m_zeroEnd)
+    {
+      uint8_t data = m_data[m_current - (m_zeroEnd-m_zeroStart)];
+      return data;
+    }
+  else if (m_buffer == 0)
     {
       return 0;
     }
   else
     {
-      uint8_t data = m_data[m_current - (m_zeroEnd-m_zeroStart)];
-      return data;
+      return SlowPeekU8 (m_buffer, m_current);
     }
 }
 
@@ -1047,16 +1216,26 @@ Buffer::Buffer (Buffer const&o)
     m_zeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaEnd (o.m_zeroAreaEnd),
     m_start (o.m_start),
-    m_end (o.m_end)
+    m_end (o.m_end),
+    m_chain (o.m_chain)
 {
   m_data->m_count++;
+  if (m_chain != 0)
+    {
+      m_chain->m_count++;
+    }
   NS_ASSERT (CheckInternalState ());
 }
 
 uint32_t 
 Buffer::GetSize (void) const
 {
-  return m_end - m_start;
+  uint32_t size = m_end - m_start;
+  if (m_chain != 0)
+    {
+      size += m_chain->m_size;
+    }
+  return size;
 }
 
 Buffer::Iterator 
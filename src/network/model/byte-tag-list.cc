@@ -187,6 +187,22 @@ ByteTagList::~ByteTagList ()
   m_used = 0;
 }
 
+ByteTagList
+ByteTagList::CreateUnsharedCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  ByteTagList copy = *this;
+  if (m_data != 0)
+    {
+      struct ByteTagListData *data = copy.Allocate (m_used);
+      std::memcpy (&data->data, &m_data->data, m_used);
+      data->dirty = m_used;
+      copy.Deallocate (copy.m_data);
+      copy.m_data = data;
+    }
+  return copy;
+}
+
 TagBuffer
 ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
 {
@@ -163,6 +163,12 @@ private:
   ByteTagList &operator = (const ByteTagList &o);
   ~ByteTagList ();
 
+  /**
+   * \returns a copy of this ByteTagList which shares no data with it, so
+   * that the two can be used by different threads
+   */
+  ByteTagList CreateUnsharedCopy (void) const;
+
   /**
    * \param tid the typeid of the tag added
    * \param bufferSize the size of the tag when its serialization will 
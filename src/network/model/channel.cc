@@ -22,6 +22,7 @@
 
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
+#include "ns3/object-vector.h"
 
 namespace ns3 {
 
@@ -39,7 +40,14 @@ Channel::GetTypeId (void)
                    TypeId::ATTR_GET,
                    UintegerValue (0),
                    MakeUintegerAccessor (&Channel::m_id),
-                   MakeUintegerChecker<uint32_t> ());
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DeviceList", "The list of devices attached to this Channel.",
+                   TypeId::ATTR_GET,
+                   ObjectVectorValue (),
+                   MakeObjectVectorAccessor (&Channel::GetDevice,
+                                             &Channel::GetNDevices),
+                   MakeObjectVectorChecker<NetDevice> ())
+  ;
   return tid;
 }
 
@@ -99,6 +99,23 @@ public:
    * i.e.: (field1 val1 field2 val2 field3 val3) field4 val4 field5 val5
    */
   virtual void Print (std::ostream &os) const = 0;
+  /**
+   * \param header a header of the same type as this header
+   * \returns true if this header was copied into \p header, false
+   *          if it must be serialized instead
+   *
+   * This method is used by Packet::AddHeader to carry the header as an
+   * object when the virtual header mode is enabled (see
+   * Packet::EnableVirtualHeaders), and by Packet::RemoveHeader and
+   * Packet::PeekHeader to hand the copy to the receiver instead of
+   * deserializing the header. The state copied must be the state
+   * Deserialize would restore from the output of Serialize.
+   *
+   * Headers are not copied by default. A header which implements this
+   * method should decline when its serialization has side effects the
+   * receiver relies upon, such as the computation of a checksum.
+   */
+  virtual bool CopyTo (Header &header) const;
 };
 
 
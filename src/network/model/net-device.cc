@@ -72,7 +72,8 @@ std::ostream & operator << (std::ostream &os, const QueueItem &item)
 }
 
 NetDeviceQueue::NetDeviceQueue()
-  : m_stopped (false)
+  : m_stoppedByDevice (false),
+    m_stoppedByQueueLimits (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -85,19 +86,19 @@ NetDeviceQueue::~NetDeviceQueue ()
 bool
 NetDeviceQueue::IsStopped (void) const
 {
-  return m_stopped;
+  return m_stoppedByDevice || m_stoppedByQueueLimits;
 }
 
 void
 NetDeviceQueue::Start (void)
 {
-  m_stopped = false;
+  m_stoppedByDevice = false;
 }
 
 void
 NetDeviceQueue::Stop (void)
 {
-  m_stopped = true;
+  m_stoppedByDevice = true;
 }
 
 void
@@ -105,8 +106,9 @@ NetDeviceQueue::Wake (void)
 {
   Start ();
 
-  // Request the queue disc to dequeue a packet
-  if (!m_wakeCallback.IsNull ())
+  // Request the queue disc to dequeue a packet, unless the queue limits
+  // do not allow to send more data to the device
+  if (!m_stoppedByQueueLimits && !m_wakeCallback.IsNull ())
   {
       m_wakeCallback ();
   }
@@ -118,6 +120,72 @@ NetDeviceQueue::SetWakeCallback (WakeCallback cb)
   m_wakeCallback = cb;
 }
 
+void
+NetDeviceQueue::NotifyQueuedBytes (uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << bytes);
+  if (!m_queueLimits)
+    {
+      return;
+    }
+  m_queueLimits->Queued (bytes);
+  if (m_queueLimits->Available () >= 0)
+    {
+      return;
+    }
+  NS_LOG_DEBUG ("The queue limits have been exceeded, stop the transmission queue");
+  m_stoppedByQueueLimits = true;
+}
+
+void
+NetDeviceQueue::NotifyTransmittedBytes (uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << bytes);
+  if (!m_queueLimits || bytes == 0)
+    {
+      return;
+    }
+  m_queueLimits->Completed (bytes);
+  if (m_queueLimits->Available () < 0 || !m_stoppedByQueueLimits)
+    {
+      return;
+    }
+  NS_LOG_DEBUG ("There is room below the queue limits, restart the transmission queue");
+  m_stoppedByQueueLimits = false;
+  // Request the queue disc to dequeue a packet
+  if (!m_stoppedByDevice && !m_wakeCallback.IsNull ())
+  {
+      m_wakeCallback ();
+  }
+}
+
+void
+NetDeviceQueue::ResetQueueLimits ()
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_queueLimits)
+    {
+      return;
+    }
+  m_queueLimits->Reset ();
+  m_stoppedByQueueLimits = false;
+}
+
+void
+NetDeviceQueue::SetQueueLimits (Ptr<QueueLimits> ql)
+{
+  NS_LOG_FUNCTION (this << ql);
+  m_queueLimits = ql;
+  ResetQueueLimits ();
+}
+
+Ptr<QueueLimits>
+NetDeviceQueue::GetQueueLimits ()
+{
+  NS_LOG_FUNCTION (this);
+  return m_queueLimits;
+}
+
 
 NS_OBJECT_ENSURE_REGISTERED (NetDeviceQueueInterface);
 
@@ -217,4 +285,30 @@ NetDevice::~NetDevice ()
   NS_LOG_FUNCTION (this);
 }
 
+bool
+NetDevice::SendToTxQueue (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber, uint8_t txq)
+{
+  NS_LOG_FUNCTION (this << packet << dest << protocolNumber << static_cast<uint32_t> (txq));
+  return Send (packet, dest, protocolNumber);
+}
+
+uint32_t
+NetDevice::SendBatch (std::vector<BatchItem> &batch)
+{
+  NS_LOG_FUNCTION (this << batch.size ());
+  uint32_t sent = 0;
+  while (sent < batch.size ()
+         && Send (batch[sent].packet, batch[sent].dest, batch[sent].protocolNumber))
+    {
+      sent++;
+    }
+  return sent;
+}
+
+uint32_t
+NetDevice::GetMaxSendBatchSize (void) const
+{
+  return 0;
+}
+
 } // namespace ns3
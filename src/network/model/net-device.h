@@ -31,6 +31,7 @@
 #include "address.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
+#include "ns3/queue-limits.h"
 
 namespace ns3 {
 
@@ -156,7 +157,14 @@ std::ostream& operator<< (std::ostream& os, const QueueItem &item);
  * stopped or not) and data used by techniques such as Byte Queue Limits.
  *
  * This class roughly models the struct netdev_queue of Linux.
- * \todo Implement BQL
+ *
+ * A device transmission queue may be stopped by the device (e.g., because
+ * its queue is full) or by the queue limits object, if any. Devices
+ * supporting Byte Queue Limits notify the bytes they enqueue
+ * (NotifyQueuedBytes) and the bytes they transmit (NotifyTransmittedBytes),
+ * so that the amount of data held by the device is limited to what is
+ * needed to avoid starvation, and the standing queue builds up in the
+ * queue disc instead.
  */
 class NetDeviceQueue : public SimpleRefCount<NetDeviceQueue>
 {
@@ -207,8 +215,47 @@ public:
    */
   virtual void SetWakeCallback (WakeCallback cb);
 
+  /**
+   * \brief Called by the netdevice to report the number of bytes queued to the device queue
+   * \param bytes number of bytes queued to the device queue
+   *
+   * If the queue limits are exceeded, the transmission queue is stopped.
+   * This is the analogous to the netdev_tx_sent_queue function of the Linux kernel.
+   */
+  virtual void NotifyQueuedBytes (uint32_t bytes);
+
+  /**
+   * \brief Called by the netdevice to report the number of bytes it is going to transmit
+   * \param bytes number of bytes the device is going to transmit
+   *
+   * If the transmission queue was stopped by the queue limits and there is
+   * room again, the transmission queue is restarted and the wake callback
+   * is invoked, unless the queue has been stopped by the device.
+   * This is the analogous to the netdev_tx_completed_queue function of the Linux kernel.
+   */
+  virtual void NotifyTransmittedBytes (uint32_t bytes);
+
+  /**
+   * \brief Reset queue limits state
+   */
+  void ResetQueueLimits ();
+
+  /**
+   * \brief Set queue limits to this queue
+   * \param ql the queue limits associated to this queue
+   */
+  void SetQueueLimits (Ptr<QueueLimits> ql);
+
+  /**
+   * \brief Get queue limits to this queue
+   * \return the queue limits associated to this queue
+   */
+  Ptr<QueueLimits> GetQueueLimits ();
+
 private:
-  bool m_stopped;   //!< Status of the transmission queue
+  bool m_stoppedByDevice;         //!< True if the queue has been stopped by the device
+  bool m_stoppedByQueueLimits;    //!< True if the queue has been stopped by a queue limits object
+  Ptr<QueueLimits> m_queueLimits; //!< Queue limits object
   WakeCallback m_wakeCallback;   //!< Wake callback
 };
 
@@ -528,6 +575,65 @@ public:
    * \return whether the Send operation succeeded 
    */
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber) = 0;
+
+  /**
+   * \param packet packet sent from above down to Network Device
+   * \param dest mac address of the destination (already resolved)
+   * \param protocolNumber identifies the type of payload contained in
+   *        this packet. Used to call the right L3Protocol when the packet
+   *        is received.
+   * \param txq the index of the device transmission queue selected for
+   *        the packet
+   *
+   *  Called from higher layer (e.g., the traffic control layer) to send a
+   *  packet through the given transmission queue of a multi-queue device,
+   *  similarly to the queue mapping of the Linux sk_buff. The default
+   *  implementation calls Send, which suits devices having a single
+   *  transmission queue or selecting the queue by themselves (e.g., based
+   *  on the priority of the packet).
+   *
+   * \return whether the Send operation succeeded
+   */
+  virtual bool SendToTxQueue (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber, uint8_t txq);
+
+  /**
+   * \brief A packet to be sent by means of SendBatch, along with its
+   *        destination and protocol number
+   */
+  struct BatchItem
+  {
+    Ptr<Packet> packet;       //!< packet sent from above down to Network Device
+    Address dest;             //!< mac address of the destination (already resolved)
+    uint16_t protocolNumber;  //!< identifies the type of payload contained in the packet
+  };
+
+  /**
+   * \param batch the packets to send, in order
+   *
+   * Called from higher layer (e.g., the traffic control layer) to send a
+   * burst of packets with a single call, similarly to the xmit_more hint
+   * of Linux, so that the device can amortize the per-packet work (e.g.,
+   * starting the transmission or checking whether its transmission queue
+   * has to be stopped) across the batch.
+   *
+   * The device accepts the packets in order and stops at the first packet
+   * it cannot accept, hence the accepted packets are always a prefix of the
+   * batch. Callers are expected not to pass more packets than returned by
+   * GetMaxSendBatchSize. The default implementation calls Send for each
+   * packet.
+   *
+   * \return the number of packets accepted by the device
+   */
+  virtual uint32_t SendBatch (std::vector<BatchItem> &batch);
+
+  /**
+   * \return the maximum number of packets that SendBatch can currently
+   *         accept (e.g., the room left in the device queue), or zero if
+   *         this device does not implement SendBatch more efficiently than
+   *         by calling Send for each packet. The default implementation
+   *         returns zero.
+   */
+  virtual uint32_t GetMaxSendBatchSize (void) const;
   /**
    * \returns the node base class which contains this network
    *          interface.
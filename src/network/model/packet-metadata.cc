@@ -24,6 +24,7 @@
 #include "ns3/log.h"
 #include "packet-metadata.h"
 #include "buffer.h"
+#include "buffer-pool.h"
 #include "header.h"
 #include "trailer.h"
 
@@ -36,17 +37,6 @@ bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
-
-PacketMetadata::DataFreeList::~DataFreeList ()
-{
-  NS_LOG_FUNCTION (this);
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
-}
 
 void 
 PacketMetadata::Enable (void)
@@ -70,6 +60,12 @@ PacketMetadata::EnableChecking (void)
   m_enableChecking = true;
 }
 
+bool
+PacketMetadata::IsEnabled (void)
+{
+  return m_enable;
+}
+
 void
 PacketMetadata::ReserveCopy (uint32_t size)
 {
@@ -576,20 +572,6 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
-    {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
-    }
-  NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
   return PacketMetadata::Allocate (m_maxSize);
 }
 
@@ -597,22 +579,8 @@ void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
-    {
-      PacketMetadata::Deallocate (data);
-      return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
-    {
-      PacketMetadata::Deallocate (data);
-    } 
-  else 
-    {
-      m_freeList.push_back (data);
-    }
+  PacketMetadata::Deallocate (data);
 }
 
 struct PacketMetadata::Data *
@@ -625,9 +593,12 @@ PacketMetadata::Allocate (uint32_t n)
       n = PACKET_METADATA_DATA_M_DATA_SIZE;
     }
   size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
-  uint8_t *buf = new uint8_t [size];
+  uint32_t capacity;
+  uint8_t *buf = BufferPool::Allocate (size, capacity);
   struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
-  data->m_size = n;
+  // the extra bytes of the block are usable, within the 16 bit m_size
+  data->m_size = std::min<uint32_t> (n + capacity - size, 0xffff);
+  data->m_capacity = capacity;
   data->m_count = 1;
   data->m_dirtyEnd = 0;
   return data;
@@ -637,7 +608,7 @@ PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
   uint8_t *buf = (uint8_t *)data;
-  delete [] buf;
+  BufferPool::Deallocate (buf, data->m_capacity);
 }
 
 
@@ -651,6 +622,18 @@ PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
   return fragment;
 }
 
+PacketMetadata
+PacketMetadata::CreateUnsharedCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketMetadata copy = *this;
+  if (copy.m_data != 0)
+    {
+      copy.ReserveCopy (0);
+    }
+  return copy;
+}
+
 void 
 PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
@@ -1109,10 +1092,10 @@ PacketMetadata::ItemIterator::Next (void)
       item.type = PacketMetadata::Item::HEADER;
       if (!item.isFragment)
         {
-          ns3::Buffer tmp = m_buffer;
-          tmp.RemoveAtStart (m_offset);
-          tmp.RemoveAtEnd (tmp.GetSize () - item.currentSize);
-          item.current = tmp.Begin ();
+          m_item = m_buffer;
+          m_item.RemoveAtStart (m_offset);
+          m_item.RemoveAtEnd (m_item.GetSize () - item.currentSize);
+          item.current = m_item.Begin ();
         }
     }
   else if (tid.IsChildOf (Trailer::GetTypeId ()))
@@ -1120,10 +1103,10 @@ PacketMetadata::ItemIterator::Next (void)
       item.type = PacketMetadata::Item::TRAILER;
       if (!item.isFragment)
         {
-          ns3::Buffer tmp = m_buffer;
-          tmp.RemoveAtEnd (tmp.GetSize () - (m_offset + smallItem.size));
-          tmp.RemoveAtStart (tmp.GetSize () - item.currentSize);
-          item.current = tmp.End ();
+          m_item = m_buffer;
+          m_item.RemoveAtEnd (m_item.GetSize () - (m_offset + smallItem.size));
+          m_item.RemoveAtStart (m_item.GetSize () - item.currentSize);
+          item.current = m_item.End ();
         }
     }
   else 
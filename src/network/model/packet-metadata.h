@@ -116,7 +116,8 @@ public:
     uint32_t currentTrimedFromEnd;
     /**
      * an iterator which can be fed to Deserialize. Valid only
-     * if isFragment and isPayload are false.
+     * if isFragment and isPayload are false, and until the next
+     * call to ItemIterator::Next.
      */
     Buffer::Iterator current;
   };
@@ -146,6 +147,7 @@ public:
 private:
     const PacketMetadata *m_metadata; //!< pointer to the metadata
     Buffer m_buffer; //!< buffer the metadata refers to
+    Buffer m_item; //!< bytes of the last item, which its iterator refers to
     uint16_t m_current; //!< current position
     uint32_t m_offset; //!< offset
     bool m_hasReadTail; //!< true if the metadata tail has been read
@@ -159,13 +161,23 @@ private:
    * \brief Enable the packet metadata checking
    */
   static void EnableChecking (void);
+  /**
+   * \returns true if the packet metadata is enabled
+   */
+  static bool IsEnabled (void);
 
   /**
    * \brief Constructor
+   *
+   * The metadata of a lean packet allocates no storage and records no
+   * item: its owner must not call any of the methods which add or remove
+   * items. See Packet::EnableLeanMode.
+   *
    * \param uid packet uid
    * \param size size of the header
+   * \param lean true for the metadata of a lean packet
    */
-  inline PacketMetadata (uint64_t uid, uint32_t size);
+  inline PacketMetadata (uint64_t uid, uint32_t size, bool lean = false);
   /**
    * \brief Copy constructor
    * \param o the object to copy
@@ -217,6 +229,12 @@ private:
    */
   PacketMetadata CreateFragment (uint32_t start, uint32_t end) const;
 
+  /**
+   * \return a copy of this metadata which shares no data with it, so that
+   * the two can be used by different threads
+   */
+  PacketMetadata CreateUnsharedCopy (void) const;
+
   /**
    * \brief Add a metadata at the metadata start
    * \param o the metadata to add
@@ -238,6 +256,11 @@ private:
    */
   void RemoveAtEnd (uint32_t end);
 
+  /**
+   * \returns true if this is the metadata of a lean packet
+   */
+  inline bool IsLean (void) const;
+
   /**
    * \brief Get the packet Uid
    * \return the packet Uid
@@ -416,6 +439,9 @@ private:
     /** max of the m_used field over all objects which
      * reference this struct Data instance */
     uint16_t m_dirtyEnd;
+    /** size (in bytes) of the BufferPool block holding this
+     * struct Data instance */
+    uint32_t m_capacity;
     /** variable-sized buffer of bytes */
     uint8_t m_data[PACKET_METADATA_DATA_M_DATA_SIZE]; 
   };
@@ -491,16 +517,6 @@ private:
     uint64_t packetUid;
   };
 
-  /**
-   * \brief Class to hold all the metadata
-   */
-  class DataFreeList : public std::vector<struct Data *>
-  {
-public:
-    ~DataFreeList ();
-  };
-
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
   PacketMetadata ();
@@ -656,7 +672,6 @@ public:
    */
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
 
@@ -686,13 +701,20 @@ public:
 
 namespace ns3 {
 
-PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size, bool lean)
+  : m_data (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
     m_packetUid (uid)
 {
+  if (lean)
+    {
+      // printing cannot be enabled once lean packets exist
+      m_metadataSkipped = true;
+      return;
+    }
+  m_data = PacketMetadata::Create (10);
   memset (m_data->m_data, 0xff, 4);
   if (size > 0)
     {
@@ -706,9 +728,11 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_used (o.m_used),
     m_packetUid (o.m_packetUid)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -716,15 +740,19 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (m_data != 0)
         {
-          PacketMetadata::Recycle (m_data);
+          m_data->m_count--;
+          if (m_data->m_count == 0) 
+            {
+              PacketMetadata::Recycle (m_data);
+            }
         }
       m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      if (m_data != 0)
+        {
+          m_data->m_count++;
+        }
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
@@ -734,13 +762,21 @@ PacketMetadata::operator = (PacketMetadata const& o)
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
+  if (m_data == 0)
+    {
+      return;
+    }
   m_data->m_count--;
   if (m_data->m_count == 0) 
     {
       PacketMetadata::Recycle (m_data);
     }
 }
+bool
+PacketMetadata::IsLean (void) const
+{
+  return m_data == 0;
+}
 
 } // namespace ns3
 
@@ -154,10 +154,68 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 
 }
 
+uint32_t
+PacketTagList::FindInline (TypeId tid) const
+{
+  // Compare the uid with the four 16-bit fields of the index at once:
+  // the fields equal to the uid become zero, and the lowest zero field
+  // is the only one reliably flagged by the borrow trick below.  The
+  // free slots never match, since no TypeId has a zero uid.
+  const uint64_t ones = 0x0001000100010001ULL;
+  uint64_t x = m_inlineIndex ^ (ones * tid.GetUid ());
+  uint64_t zero = (x - ones) & ~x & (ones << 15);
+  if (zero == 0)
+    {
+      return INLINE_TAGS;
+    }
+  return __builtin_ctzll (zero) / 16;
+}
+
+void
+PacketTagList::UpdateTagMask (void)
+{
+  m_tagMask = 0;
+  for (uint32_t i = 0; i < m_nInline; ++i)
+    {
+      m_tagMask |= GetTagBit ((m_inlineIndex >> (16 * i)) & 0xffff);
+    }
+  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+    {
+      m_tagMask |= GetTagBit (cur->tid.GetUid ());
+    }
+}
+
 bool
 PacketTagList::Remove (Tag & tag)
 {
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
+  TypeId tid = tag.GetInstanceTypeId ();
+  if ((m_tagMask & GetTagBit (tid.GetUid ())) == 0)
+    {
+      return false;
+    }
+  bool found;
+  uint32_t i = FindInline (tid);
+  if (i != INLINE_TAGS)
+    {
+      tag.Deserialize (TagBuffer (m_inlineData[i],
+                                  m_inlineData[i] + TagData::MAX_SIZE));
+      // keep the remaining slots in order
+      uint64_t below = (1ULL << (16 * i)) - 1;
+      m_inlineIndex = (m_inlineIndex & below) | ((m_inlineIndex >> 16) & ~below);
+      std::memmove (m_inlineData[i], m_inlineData[i + 1],
+                    (m_nInline - i - 1) * TagData::MAX_SIZE);
+      m_nInline--;
+      found = true;
+    }
+  else
+    {
+      found = COWTraverse (tag, &PacketTagList::RemoveWriter);
+    }
+  if (found)
+    {
+      UpdateTagMask ();
+    }
+  return found;
 }
 
 // COWWriter implementing Remove
@@ -196,7 +254,19 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
 bool
 PacketTagList::Replace (Tag & tag)
 {
-  bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
+  TypeId tid = tag.GetInstanceTypeId ();
+  bool found = false;
+  if ((m_tagMask & GetTagBit (tid.GetUid ())) != 0)
+    {
+      uint32_t i = FindInline (tid);
+      if (i != INLINE_TAGS)
+        {
+          tag.Serialize (TagBuffer (m_inlineData[i],
+                                    m_inlineData[i] + tag.GetSerializedSize ()));
+          return true;
+        }
+      found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
+    }
   if (!found)
     {
       Add (tag);
@@ -243,21 +313,38 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
 void 
 PacketTagList::Add (const Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
+  PacketTagList *self = const_cast<PacketTagList *> (this);
   // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  if ((m_tagMask & GetTagBit (tid.GetUid ())) != 0)
     {
-      NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (), "Error: cannot add the same kind of tag twice.");
+      NS_ASSERT_MSG (FindInline (tid) == INLINE_TAGS, "Error: cannot add the same kind of tag twice.");
+      for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+        {
+          NS_ASSERT_MSG (cur->tid != tid, "Error: cannot add the same kind of tag twice.");
+        }
+    }
+  self->m_tagMask |= GetTagBit (tid.GetUid ());
+  // the inline slots are only used while the list is empty, so that
+  // the tags of the list remain more recent than the inline ones
+  if (m_next == 0 && m_nInline < INLINE_TAGS)
+    {
+      uint8_t *data = self->m_inlineData[m_nInline];
+      tag.Serialize (TagBuffer (data, data + tag.GetSerializedSize ()));
+      self->m_inlineIndex |= static_cast<uint64_t> (tid.GetUid ()) << (16 * m_nInline);
+      self->m_nInline++;
+      return;
     }
   struct TagData * head = new struct TagData ();
   head->count = 1;
   head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
+  head->tid = tid;
   head->next = m_next;
-  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
   tag.Serialize (TagBuffer (head->data, head->data + tag.GetSerializedSize ()));
 
-  const_cast<PacketTagList *> (this)->m_next = head;
+  self->m_next = head;
 }
 
 bool
@@ -265,6 +352,18 @@ PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
+  if ((m_tagMask & GetTagBit (tid.GetUid ())) == 0)
+    {
+      /* no tag of this type for sure */
+      return false;
+    }
+  uint32_t i = FindInline (tid);
+  if (i != INLINE_TAGS)
+    {
+      tag.Deserialize (TagBuffer (const_cast<uint8_t *> (m_inlineData[i]),
+                                  const_cast<uint8_t *> (m_inlineData[i]) + TagData::MAX_SIZE));
+      return true;
+    }
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
@@ -278,11 +377,54 @@ PacketTagList::Peek (Tag &tag) const
   return false;
 }
 
+PacketTagList
+PacketTagList::CreateUnsharedCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketTagList copy;
+  copy.m_tagMask = m_tagMask;
+  copy.m_nInline = m_nInline;
+  copy.m_inlineIndex = m_inlineIndex;
+  std::memcpy (copy.m_inlineData, m_inlineData, m_nInline * TagData::MAX_SIZE);
+  struct TagData **prevNext = &copy.m_next;
+  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+    {
+      struct TagData *node = new struct TagData (*cur);
+      node->count = 1;
+      node->next = 0;
+      *prevNext = node;
+      prevNext = &node->next;
+    }
+  return copy;
+}
+
 const struct PacketTagList::TagData *
 PacketTagList::Head (void) const
 {
   return m_next;
 }
 
+uint32_t
+PacketTagList::GetNInlineTags (void) const
+{
+  return m_nInline;
+}
+
+TypeId
+PacketTagList::GetInlineTagTypeId (uint32_t i) const
+{
+  NS_ASSERT (i < m_nInline);
+  TypeId tid;
+  tid.SetUid ((m_inlineIndex >> (16 * i)) & 0xffff);
+  return tid;
+}
+
+const uint8_t *
+PacketTagList::GetInlineTagData (uint32_t i) const
+{
+  NS_ASSERT (i < m_nInline);
+  return m_inlineData[i];
+}
+
 } /* namespace ns3 */
 
@@ -27,6 +27,7 @@
 
 #include <stdint.h>
 #include <ostream>
+#include <cstring>
 #include "ns3/type-id.h"
 
 namespace ns3 {
@@ -120,6 +121,29 @@ class Tag;
  *       shared. This portion is copied before the #Remove or #Replace is
  *       performed.
  *
+ * \par <b> Inline storage </b>
+ * \n
+ * Most packets carry only a handful of tags, so the first #INLINE_TAGS
+ * tags added to an empty list are not put in the tree, but serialized
+ * in slots held by the PacketTagList itself; only the tags added beyond
+ * them go through the copy-on-write list described above.  Copying a
+ * PacketTagList copies its occupied slots, which is cheaper than the
+ * allocation of a TagData per tag.  The uids of the TypeId's of the
+ * slots are packed in a single 64-bit index, so that the slot holding a
+ * tag type is found with a few arithmetic operations on that word rather
+ * than by a scan of the slots.  A bit mask summarizes the types of all
+ * the tags of the list, so that looking for a tag the packet does not
+ * carry usually costs a single test; the tags kept in the list are
+ * still found by walking it.
+ *
+ * The slots make every Packet larger: on 64-bit platforms, a
+ * PacketTagList takes 112 bytes instead of the 8 bytes of a single
+ * pointer (#INLINE_TAGS buffers of TagData::MAX_SIZE bytes, plus the
+ * index, the mask and the slot count).
+ *
+ * Since the slots are only used while the tree is empty, the tags in the
+ * tree are always more recent than the tags in the slots.
+ *
  * \par <b> Memory Management: </b>
  * \n
  * Packet tags must serialize to a finite maximum size, see TagData
@@ -167,6 +191,14 @@ public:
     uint32_t count;           /**< Number of incoming links */
   };  /* struct TagData */
 
+  /**
+   * \brief Number of tags stored inline in the PacketTagList
+   */
+  enum InlineTags_e
+  {
+    INLINE_TAGS = 4           /**< Number of inline tag slots, at most 4 (see #m_inlineIndex) */
+  };
+
   /**
    * Create a new PacketTagList.
    */
@@ -176,8 +208,9 @@ public:
    *
    * \param [in] o The PacketTagList to copy.
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This copies the inline tags of \pname{o}, then makes a
+   * light-weight copy of its list by pointing to the same
+   * \ref TagData as \pname{o}.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -186,7 +219,8 @@ public:
    * \param [in] o The PacketTagList to copy.
    * \returns the copied object
    *
-   * This makes a light-weight copy by #RemoveAll, then
+   * This copies the inline tags of \pname{o}, then makes a
+   * light-weight copy of its list by #RemoveAll, then
    * pointing to the same \ref TagData as \pname{o}.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
@@ -198,7 +232,8 @@ public:
   inline ~PacketTagList ();
 
   /**
-   * Add a tag to the head of this branch.
+   * Add a tag to the inline slots if the list has none, otherwise
+   * to the head of this branch.
    *
    * \param [in] tag The tag to add
    */
@@ -234,11 +269,46 @@ public:
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns a copy of this list which shares no \ref TagData with it, so
+   * that the two can be used by different threads
+   */
+  PacketTagList CreateUnsharedCopy (void) const;
+  /**
+   * \returns pointer to head of tag list, without the inline tags
    */
   const struct PacketTagList::TagData *Head (void) const;
+  /**
+   * \returns the number of tags stored inline
+   */
+  uint32_t GetNInlineTags (void) const;
+  /**
+   * \param [in] i The index of an inline tag, less than GetNInlineTags()
+   * \returns the type of the tag serialized in the inline slot \pname{i}
+   */
+  TypeId GetInlineTagTypeId (uint32_t i) const;
+  /**
+   * \param [in] i The index of an inline tag, less than GetNInlineTags()
+   * \returns the serialization buffer of the inline slot \pname{i},
+   *          of TagData::MAX_SIZE bytes
+   */
+  const uint8_t *GetInlineTagData (uint32_t i) const;
 
 private:
+  /**
+   * \param [in] uid The uid of the TypeId of a tag type
+   * \returns the bit of #m_tagMask which stands for the tag type
+   */
+  static inline uint32_t GetTagBit (uint16_t uid);
+  /**
+   * \param [in] tid A tag type
+   * \returns the index of the inline slot holding \pname{tid},
+   *          or #INLINE_TAGS if there is none.
+   */
+  uint32_t FindInline (TypeId tid) const;
+  /**
+   * Recompute #m_tagMask from the inline tags and the list.
+   */
+  void UpdateTagMask (void);
   /**
    * Typedef of method function pointer for copy-on-write operations
    *
@@ -291,6 +361,24 @@ private:
    * Pointer to first \ref TagData on the list
    */
   struct TagData *m_next;
+  /**
+   * Bit mask of the types of all the tags, see #GetTagBit
+   */
+  uint32_t m_tagMask;
+  /**
+   * Number of occupied inline slots
+   */
+  uint32_t m_nInline;
+  /**
+   * Types of the tags serialized in the inline slots: bits 16 i to
+   * 16 i + 15 hold the uid of the TypeId of the tag of slot i, and are
+   * zero if the slot is free
+   */
+  uint64_t m_inlineIndex;
+  /**
+   * Serialization buffers of the inline slots
+   */
+  uint8_t m_inlineData[INLINE_TAGS][TagData::MAX_SIZE];
 };
 
 } // namespace ns3
@@ -302,33 +390,47 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_next (),
+    m_tagMask (0),
+    m_nInline (0),
+    m_inlineIndex (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_next (o.m_next),
+    m_tagMask (o.m_tagMask),
+    m_nInline (o.m_nInline),
+    m_inlineIndex (o.m_inlineIndex)
 {
   if (m_next != 0)
     {
       m_next->count++;
     }
+  std::memcpy (m_inlineData, o.m_inlineData, m_nInline * TagData::MAX_SIZE);
 }
 
 PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o)
     {
       return *this;
     }
-  RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  if (m_next != o.m_next)
     {
-      m_next->count++;
+      RemoveAll ();
+      m_next = o.m_next;
+      if (m_next != 0)
+        {
+          m_next->count++;
+        }
     }
+  m_tagMask = o.m_tagMask;
+  m_nInline = o.m_nInline;
+  m_inlineIndex = o.m_inlineIndex;
+  std::memcpy (m_inlineData, o.m_inlineData, m_nInline * TagData::MAX_SIZE);
   return *this;
 }
 
@@ -359,6 +461,15 @@ PacketTagList::RemoveAll (void)
       delete prev;
     }
   m_next = 0;
+  m_nInline = 0;
+  m_inlineIndex = 0;
+  m_tagMask = 0;
+}
+
+uint32_t
+PacketTagList::GetTagBit (uint16_t uid)
+{
+  return 1u << (uid & 31);
 }
 
 } // namespace ns3
@@ -19,6 +19,7 @@
  */
 #include "packet.h"
 #include "ns3/assert.h"
+#include "ns3/abort.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include <string>
@@ -29,6 +30,8 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
 uint32_t Packet::m_globalUid = 0;
+bool Packet::m_leanMode = false;
+bool Packet::m_virtualHeaderMode = false;
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -81,39 +84,49 @@ ByteTagIterator::ByteTagIterator (ByteTagList::Iterator i)
 }
 
 
-PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *head)
-  : m_current (head)
+PacketTagIterator::PacketTagIterator (const PacketTagList &list)
+  : m_list (&list),
+    m_current (list.Head ()),
+    m_nInline (list.GetNInlineTags ())
 {
 }
 bool
 PacketTagIterator::HasNext (void) const
 {
-  return m_current != 0;
+  return m_current != 0 || m_nInline != 0;
 }
 PacketTagIterator::Item
 PacketTagIterator::Next (void)
 {
   NS_ASSERT (HasNext ());
-  const struct PacketTagList::TagData *prev = m_current;
-  m_current = m_current->next;
-  return PacketTagIterator::Item (prev);
+  // the list holds the most recent tags, then come the inline ones
+  if (m_current != 0)
+    {
+      const struct PacketTagList::TagData *prev = m_current;
+      m_current = m_current->next;
+      return PacketTagIterator::Item (prev->tid, prev->data);
+    }
+  m_nInline--;
+  return PacketTagIterator::Item (m_list->GetInlineTagTypeId (m_nInline),
+                                  m_list->GetInlineTagData (m_nInline));
 }
 
-PacketTagIterator::Item::Item (const struct PacketTagList::TagData *data)
-  : m_data (data)
+PacketTagIterator::Item::Item (TypeId tid, const uint8_t *data)
+  : m_tid (tid),
+    m_data (data)
 {
 }
 TypeId
 PacketTagIterator::Item::GetTypeId (void) const
 {
-  return m_data->tid;
+  return m_tid;
 }
 void
 PacketTagIterator::Item::GetTag (Tag &tag) const
 {
-  NS_ASSERT (tag.GetInstanceTypeId () == m_data->tid);
-  tag.Deserialize (TagBuffer ((uint8_t*)m_data->data,
-                              (uint8_t*)m_data->data
+  NS_ASSERT (tag.GetInstanceTypeId () == m_tid);
+  tag.Deserialize (TagBuffer ((uint8_t*)m_data,
+                              (uint8_t*)m_data
                               + PacketTagList::TagData::MAX_SIZE));
 }
 
@@ -127,6 +140,25 @@ Packet::Copy (void) const
   return Ptr<Packet> (new Packet (*this), false);
 }
 
+Ptr<Packet>
+Packet::CreateUnsharedCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<Packet> copy = Ptr<Packet> (new Packet (m_buffer.CreateUnsharedCopy (),
+                                              m_byteTagList.CreateUnsharedCopy (),
+                                              m_packetTagList.CreateUnsharedCopy (),
+                                              m_metadata.CreateUnsharedCopy ()),
+                                  false);
+  // the header objects are shared: write their bytes in the new buffer
+  copy->m_virtualHeaders = m_virtualHeaders;
+  copy->SerializeVirtualHeaders ();
+  if (m_nixVector)
+    {
+      copy->m_nixVector = m_nixVector->Copy ();
+    }
+  return copy;
+}
+
 Packet::Packet ()
   : m_buffer (),
     m_byteTagList (),
@@ -137,17 +169,18 @@ Packet::Packet ()
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32
+                | __atomic_fetch_add (&m_globalUid, 1, __ATOMIC_RELAXED), 0, m_leanMode),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 
 Packet::Packet (const Packet &o)
   : m_buffer (o.m_buffer),
     m_byteTagList (o.m_byteTagList),
     m_packetTagList (o.m_packetTagList),
-    m_metadata (o.m_metadata)
+    m_metadata (o.m_metadata),
+    m_virtualHeaders (o.m_virtualHeaders)
 {
   o.m_nixVector ? m_nixVector = o.m_nixVector->Copy ()
     : m_nixVector = 0;
@@ -164,6 +197,7 @@ Packet::operator = (const Packet &o)
   m_byteTagList = o.m_byteTagList;
   m_packetTagList = o.m_packetTagList;
   m_metadata = o.m_metadata;
+  m_virtualHeaders = o.m_virtualHeaders;
   o.m_nixVector ? m_nixVector = o.m_nixVector->Copy () 
     : m_nixVector = 0;
   return *this;
@@ -179,10 +213,10 @@ Packet::Packet (uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32
+                | __atomic_fetch_add (&m_globalUid, 1, __ATOMIC_RELAXED), size, m_leanMode),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
@@ -205,10 +239,10 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32
+                | __atomic_fetch_add (&m_globalUid, 1, __ATOMIC_RELAXED), size, m_leanMode),
     m_nixVector (0)
 {
-  m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
@@ -228,7 +262,14 @@ Ptr<Packet>
 Packet::CreateFragment (uint32_t start, uint32_t length) const
 {
   NS_LOG_FUNCTION (this << start << length);
+  SerializeVirtualHeaders ();
   Buffer buffer = m_buffer.CreateFragment (start, length);
+  if (IsLean ())
+    {
+      Ptr<Packet> ret = Ptr<Packet> (new Packet (buffer, m_byteTagList, m_packetTagList, m_metadata), false);
+      ret->SetNixVector (GetNixVector ());
+      return ret;
+    }
   ByteTagList byteTagList = m_byteTagList;
   byteTagList.Adjust (-start);
   NS_ASSERT (m_buffer.GetSize () >= start + length);
@@ -258,26 +299,53 @@ Packet::AddHeader (const Header &header)
 {
   uint32_t size = header.GetSerializedSize ();
   NS_LOG_FUNCTION (this << header.GetInstanceTypeId ().GetName () << size);
-  m_buffer.AddAtStart (size);
-  m_byteTagList.Adjust (size);
-  m_byteTagList.AddAtStart (size);
-  header.Serialize (m_buffer.Begin ());
-  m_metadata.AddHeader (header, size);
+  if (m_virtualHeaderMode && m_virtualHeaders.Add (header, size))
+    {
+      // only reserve the bytes of the header
+      m_buffer.AddAtStart (size);
+    }
+  else
+    {
+      SerializeVirtualHeaders ();
+      m_buffer.AddAtStart (size);
+      header.Serialize (m_buffer.Begin ());
+    }
+  if (!IsLean ())
+    {
+      m_byteTagList.Adjust (size);
+      m_byteTagList.AddAtStart (size);
+      m_metadata.AddHeader (header, size);
+    }
 }
 uint32_t
 Packet::RemoveHeader (Header &header)
 {
-  uint32_t deserialized = header.Deserialize (m_buffer.Begin ());
+  uint32_t deserialized = PeekVirtualHeader (header);
+  if (deserialized != 0)
+    {
+      m_virtualHeaders.RemoveFirst ();
+    }
+  else
+    {
+      deserialized = header.Deserialize (m_buffer.Begin ());
+    }
   NS_LOG_FUNCTION (this << header.GetInstanceTypeId ().GetName () << deserialized);
   m_buffer.RemoveAtStart (deserialized);
-  m_byteTagList.Adjust (-deserialized);
-  m_metadata.RemoveHeader (header, deserialized);
+  if (!IsLean ())
+    {
+      m_byteTagList.Adjust (-deserialized);
+      m_metadata.RemoveHeader (header, deserialized);
+    }
   return deserialized;
 }
 uint32_t
 Packet::PeekHeader (Header &header) const
 {
-  uint32_t deserialized = header.Deserialize (m_buffer.Begin ());
+  uint32_t deserialized = PeekVirtualHeader (header);
+  if (deserialized == 0)
+    {
+      deserialized = header.Deserialize (m_buffer.Begin ());
+    }
   NS_LOG_FUNCTION (this << header.GetInstanceTypeId ().GetName () << deserialized);
   return deserialized;
 }
@@ -286,24 +354,32 @@ Packet::AddTrailer (const Trailer &trailer)
 {
   uint32_t size = trailer.GetSerializedSize ();
   NS_LOG_FUNCTION (this << trailer.GetInstanceTypeId ().GetName () << size);
-  m_byteTagList.AddAtEnd (GetSize ());
+  if (!IsLean ())
+    {
+      m_byteTagList.AddAtEnd (GetSize ());
+      m_metadata.AddTrailer (trailer, size);
+    }
   m_buffer.AddAtEnd (size);
   Buffer::Iterator end = m_buffer.End ();
   trailer.Serialize (end);
-  m_metadata.AddTrailer (trailer, size);
 }
 uint32_t
 Packet::RemoveTrailer (Trailer &trailer)
 {
+  SerializeVirtualHeaders ();
   uint32_t deserialized = trailer.Deserialize (m_buffer.End ());
   NS_LOG_FUNCTION (this << trailer.GetInstanceTypeId ().GetName () << deserialized);
   m_buffer.RemoveAtEnd (deserialized);
-  m_metadata.RemoveTrailer (trailer, deserialized);
+  if (!IsLean ())
+    {
+      m_metadata.RemoveTrailer (trailer, deserialized);
+    }
   return deserialized;
 }
 uint32_t
 Packet::PeekTrailer (Trailer &trailer)
 {
+  SerializeVirtualHeaders ();
   uint32_t deserialized = trailer.Deserialize (m_buffer.End ());
   NS_LOG_FUNCTION (this << trailer.GetInstanceTypeId ().GetName () << deserialized);
   return deserialized;
@@ -313,6 +389,12 @@ void
 Packet::AddAtEnd (Ptr<const Packet> packet)
 {
   NS_LOG_FUNCTION (this << packet << packet->GetSize ());
+  packet->SerializeVirtualHeaders ();
+  if (IsLean ())
+    {
+      m_buffer.AddAtEnd (packet->m_buffer);
+      return;
+    }
   m_byteTagList.AddAtEnd (GetSize ());
   ByteTagList copy = packet->m_byteTagList;
   copy.AddAtStart (0);
@@ -325,6 +407,11 @@ void
 Packet::AddPaddingAtEnd (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
+  if (IsLean ())
+    {
+      m_buffer.AddAtEnd (size);
+      return;
+    }
   m_byteTagList.AddAtEnd (GetSize ());
   m_buffer.AddAtEnd (size);
   m_metadata.AddPaddingAtEnd (size);
@@ -333,16 +420,24 @@ void
 Packet::RemoveAtEnd (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
+  SerializeVirtualHeaders ();
   m_buffer.RemoveAtEnd (size);
-  m_metadata.RemoveAtEnd (size);
+  if (!IsLean ())
+    {
+      m_metadata.RemoveAtEnd (size);
+    }
 }
 void 
 Packet::RemoveAtStart (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
+  SerializeVirtualHeaders ();
   m_buffer.RemoveAtStart (size);
-  m_byteTagList.Adjust (-size);
-  m_metadata.RemoveAtStart (size);
+  if (!IsLean ())
+    {
+      m_byteTagList.Adjust (-size);
+      m_metadata.RemoveAtStart (size);
+    }
 }
 
 void 
@@ -355,12 +450,14 @@ Packet::RemoveAllByteTags (void)
 uint32_t 
 Packet::CopyData (uint8_t *buffer, uint32_t size) const
 {
+  SerializeVirtualHeaders ();
   return m_buffer.CopyData (buffer, size);
 }
 
 void
 Packet::CopyData (std::ostream *os, uint32_t size) const
 {
+  SerializeVirtualHeaders ();
   return m_buffer.CopyData (os, size);
 }
 
@@ -411,6 +508,7 @@ Packet::ToString() const
 void 
 Packet::Print (std::ostream &os) const
 {
+  SerializeVirtualHeaders ();
   PacketMetadata::ItemIterator i = m_metadata.BeginItem (m_buffer);
   while (i.HasNext ())
     {
@@ -528,6 +626,7 @@ Packet::Print (std::ostream &os) const
 PacketMetadata::ItemIterator 
 Packet::BeginItem (void) const
 {
+  SerializeVirtualHeaders ();
   return m_metadata.BeginItem (m_buffer);
 }
 
@@ -535,6 +634,7 @@ void
 Packet::EnablePrinting (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  NS_ABORT_MSG_IF (m_leanMode, "Packet printing cannot be enabled in lean mode");
   PacketMetadata::Enable ();
 }
 
@@ -542,9 +642,67 @@ void
 Packet::EnableChecking (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  NS_ABORT_MSG_IF (m_leanMode, "Packet checking cannot be enabled in lean mode");
   PacketMetadata::EnableChecking ();
 }
 
+void
+Packet::EnableLeanMode (bool enable)
+{
+  NS_LOG_FUNCTION (enable);
+  NS_ABORT_MSG_IF (enable && PacketMetadata::IsEnabled (),
+                   "The lean mode cannot be enabled together with packet printing or checking");
+  m_leanMode = enable;
+}
+
+bool
+Packet::IsLeanModeEnabled (void)
+{
+  return m_leanMode;
+}
+
+void
+Packet::EnableScatterGather (bool enable)
+{
+  NS_LOG_FUNCTION (enable);
+  Buffer::EnableScatterGather (enable);
+}
+
+bool
+Packet::IsScatterGatherEnabled (void)
+{
+  return Buffer::IsScatterGatherEnabled ();
+}
+
+void
+Packet::EnableVirtualHeaders (bool enable)
+{
+  NS_LOG_FUNCTION (enable);
+  m_virtualHeaderMode = enable;
+}
+
+bool
+Packet::IsVirtualHeadersEnabled (void)
+{
+  return m_virtualHeaderMode;
+}
+
+uint32_t
+Packet::PeekVirtualHeader (Header &header) const
+{
+  if (m_virtualHeaders.IsEmpty ())
+    {
+      return 0;
+    }
+  uint32_t size = m_virtualHeaders.Peek (header);
+  if (size == 0)
+    {
+      // not the most recent header: read it from the bytes
+      SerializeVirtualHeaders ();
+    }
+  return size;
+}
+
 uint32_t Packet::GetSerializedSize (void) const
 {
   uint32_t size = 0;
@@ -590,6 +748,7 @@ uint32_t Packet::GetSerializedSize (void) const
 uint32_t 
 Packet::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
+  SerializeVirtualHeaders ();
   uint32_t* p = reinterpret_cast<uint32_t *> (buffer);
   uint32_t size = 0;
 
@@ -791,6 +950,7 @@ void
 Packet::AddByteTag (const Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ().GetName () << tag.GetSerializedSize ());
+  NS_ABORT_MSG_IF (IsLean (), "Byte tags cannot be added to lean packets");
   ByteTagList *list = const_cast<ByteTagList *> (&m_byteTagList);
   TagBuffer buffer = list->Add (tag.GetInstanceTypeId (), tag.GetSerializedSize (), 
                                 0,
@@ -881,7 +1041,7 @@ Packet::PrintPacketTags (std::ostream &os) const
 PacketTagIterator 
 Packet::GetPacketTagIterator (void) const
 {
-  return PacketTagIterator (m_packetTagList.Head ());
+  return PacketTagIterator (m_packetTagList);
 }
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet)
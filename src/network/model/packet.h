@@ -28,6 +28,7 @@
 #include "tag.h"
 #include "byte-tag-list.h"
 #include "packet-tag-list.h"
+#include "virtual-header-list.h"
 #include "nix-vector.h"
 #include "ns3/mac48-address.h"
 #include "ns3/callback.h"
@@ -152,10 +153,12 @@ private:
     friend class PacketTagIterator;
     /**
      * Constructor
-     * \param data the data to copy.
+     * \param tid the type of the tag
+     * \param data the serialized tag
      */
-    Item (const struct PacketTagList::TagData *data);
-    const struct PacketTagList::TagData *m_data; //!< the tag data
+    Item (TypeId tid, const uint8_t *data);
+    TypeId m_tid;         //!< the type of the tag
+    const uint8_t *m_data; //!< the serialized tag
   };
   /**
    * \returns true if calling Next is safe, false otherwise.
@@ -169,10 +172,12 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param list the tags of the packet
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
+  PacketTagIterator (const PacketTagList &list);
+  const PacketTagList *m_list;  //!< the tags of the packet
+  const struct PacketTagList::TagData *m_current;  //!< actual position over the list of tags in a packet
+  uint32_t m_nInline;  //!< number of inline tags not visited yet
 };
 
 /**
@@ -197,6 +202,19 @@ private:
  * call Packet::EnableChecking: its runtime cost is lower than
  * Packet::EnablePrinting.
  *
+ * - In lean mode (see Packet::EnableLeanMode), the packets carry neither
+ * metadata nor byte tags: adding or removing headers, trailers and bytes
+ * only updates the byte buffer.
+ *
+ * - In scatter-gather mode (see Packet::EnableScatterGather), the byte
+ * buffer of a packet may reference the bytes of several other packets,
+ * so that concatenating and fragmenting packets copies no bytes.
+ *
+ * - In virtual header mode (see Packet::EnableVirtualHeaders), the
+ * headers which support it are carried as objects: their bytes are
+ * reserved in the byte buffer, but they are only serialized when the
+ * bytes of the packet are read.
+ *
  * - The set of tags contain simulation-specific information which cannot
  * be stored in the packet byte buffer because the protocol headers or trailers
  * have no standard-conformant field for this information. So-called
@@ -424,6 +442,17 @@ public:
    */
   Ptr<Packet> Copy (void) const;
 
+  /**
+   * \brief performs a deep copy of the packet.
+   *
+   * \returns a copy of the packet which shares no dataset with the
+   * original, so that the two can be used by different threads.
+   *
+   * The copy keeps the uid of the original.  The headers carried as
+   * objects (see EnableVirtualHeaders) are serialized in its bytes.
+   */
+  Ptr<Packet> CreateUnsharedCopy (void) const;
+
   /**
    * \brief Returns the packet's Uid.
    *
@@ -502,6 +531,90 @@ public:
    */
   static void EnableChecking (void);
 
+  /**
+   * \brief Enable or disable the lean packet mode.
+   *
+   * The packets created while the lean mode is enabled are lean: they
+   * allocate no metadata, and their byte tag list is never updated when
+   * headers, trailers and bytes are added or removed, nor when they are
+   * fragmented or concatenated. Hence they cannot be printed and byte tags
+   * cannot be added to them, which aborts the program. Only the bytes of
+   * a packet appended to a lean packet are appended, its metadata and byte
+   * tags are dropped. The copies and the fragments of a lean packet are
+   * lean.
+   *
+   * The lean mode cannot be enabled together with the packet metadata, and
+   * the metadata cannot be enabled once lean packets have been created.
+   * It is meant for large simulations which never print packets nor use
+   * byte tags (such as those added by the FlowMonitor): it is best enabled
+   * during the simulation setup, before any packet is created.
+   *
+   * \param enable true to enable the lean mode, false to disable it
+   */
+  static void EnableLeanMode (bool enable = true);
+  /**
+   * \returns true if the lean packet mode is enabled
+   */
+  static bool IsLeanModeEnabled (void);
+  /**
+   * \returns true if this packet is lean, i.e., it carries neither
+   * metadata nor byte tags
+   *
+   * \sa EnableLeanMode
+   */
+  inline bool IsLean (void) const;
+  /**
+   * \brief Enable or disable the scatter-gather byte buffers
+   *
+   * In this mode, AddAtEnd appends references to the bytes of the packet
+   * instead of copying them, and the fragments created by CreateFragment
+   * reference the bytes of the original packet, hence aggregating,
+   * fragmenting or segmenting packets only costs a few operations per
+   * buffer involved, whatever the number of bytes. Adding a header to a
+   * packet whose bytes are shared with another packet does not copy them
+   * either, unless there are only a few of them. Only Serialize gathers
+   * the bytes in a single buffer.
+   *
+   * The mode only changes the representation of the packets, and it can
+   * be enabled or disabled at any time.
+   *
+   * \param enable true to enable the mode, false to disable it
+   */
+  static void EnableScatterGather (bool enable = true);
+  /**
+   * \returns true if the scatter-gather mode is enabled
+   */
+  static bool IsScatterGatherEnabled (void);
+  /**
+   * \brief Enable or disable the virtual header mode
+   *
+   * In this mode, AddHeader keeps a copy of the header object instead of
+   * serializing it, if the header supports it (see Header::CopyTo): only
+   * the bytes of the header are reserved at the start of the packet.
+   * RemoveHeader and PeekHeader hand a copy of the object to the
+   * receiver if it is the most recent header carried by the packet and
+   * the receiver header has the same type, which saves both the
+   * serialization and the deserialization of the header when packets
+   * go down and up the protocol stacks. The headers carried by a packet
+   * are serialized as soon as another operation needs its bytes: when
+   * they are copied (by the pcap and ascii traces for instance) or
+   * serialized, when trailers or bytes are removed, when the packet is
+   * fragmented, appended to another packet or printed, or when a header
+   * which is not carried as an object is added or read.
+   *
+   * The TCP, UDP and IPv4 headers decline to be carried as objects when
+   * their checksum is enabled, hence the mode only pays off in
+   * simulations which disable the checksums (the default) and capture
+   * few packets. It can be enabled or disabled at any time.
+   *
+   * \param enable true to enable the mode, false to disable it
+   */
+  static void EnableVirtualHeaders (bool enable = true);
+  /**
+   * \returns true if the virtual header mode is enabled
+   */
+  static bool IsVirtualHeadersEnabled (void);
+
   /**
    * \brief Returns number of bytes required for packet
    * serialization.
@@ -719,15 +832,35 @@ private:
    */
   uint32_t Deserialize (uint8_t const*buffer, uint32_t size);
 
+  /**
+   * \brief Serialize the headers carried as objects in the reserved
+   * bytes of the buffer
+   */
+  inline void SerializeVirtualHeaders (void) const;
+  /**
+   * \brief Copy the most recent header carried as an object
+   *
+   * If the packet carries headers as objects but the most recent one is
+   * not of the type of \p header, they are serialized.
+   *
+   * \param header the header to copy into
+   * \returns the serialized size of the header, or zero if it was not
+   *          copied and must be deserialized
+   */
+  uint32_t PeekVirtualHeader (Header &header) const;
+
   Buffer m_buffer;                //!< the packet buffer (it's actual contents)
   ByteTagList m_byteTagList;      //!< the ByteTag list
   PacketTagList m_packetTagList;  //!< the packet's Tag list
   PacketMetadata m_metadata;      //!< the packet's metadata
+  mutable VirtualHeaderList m_virtualHeaders; //!< the headers carried as objects
 
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  static uint32_t m_globalUid; //!< Global counter of packets Uid, accessed atomically
+  static bool m_leanMode; //!< Whether new packets are lean
+  static bool m_virtualHeaderMode; //!< Whether headers are carried as objects
 };
 
 /**
@@ -794,6 +927,22 @@ Packet::GetSize (void) const
   return m_buffer.GetSize ();
 }
 
+bool
+Packet::IsLean (void) const
+{
+  return m_metadata.IsLean ();
+}
+
+void
+Packet::SerializeVirtualHeaders (void) const
+{
+  if (!m_virtualHeaders.IsEmpty ())
+    {
+      m_virtualHeaders.Serialize (m_buffer.Begin ());
+      m_virtualHeaders.RemoveAll ();
+    }
+}
+
 } // namespace ns3
 
 #endif /* PACKET_H */
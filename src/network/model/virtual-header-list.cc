@@ -0,0 +1,248 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "virtual-header-list.h"
+#include "header.h"
+#include "ns3/core-config.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <typeinfo>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("VirtualHeaderList");
+
+namespace {
+
+/** Number of header types whose objects can be cached at once. */
+const uint32_t POOL_SLOTS = 64;
+/** Maximum number of header objects cached for a header type. */
+const uint32_t POOL_DEPTH = 256;
+
+/** The free nodes cached for a header type. */
+struct PoolSlot
+{
+  uint16_t uid;    //!< The uid of the TypeId of the cached headers.
+  uint16_t n;      //!< Number of cached nodes.
+  void *free;      //!< The first cached node.
+};
+
+/** The pool of the calling thread, indexed by the uid of the TypeId's. */
+__thread PoolSlot g_slots[POOL_SLOTS];
+/** Whether the pool of the main thread has been released at exit. */
+bool g_destroyed = false;
+
+#ifdef HAVE_PTHREAD_H
+/** Whether the calling thread releases its pool when it exits. */
+__thread bool g_releaseAtExit;
+/** Key whose destructor releases the pool of an exiting thread. */
+pthread_key_t g_releaseKey;
+/** Guard of the creation of g_releaseKey. */
+pthread_once_t g_releaseKeyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Release the pool of an exiting thread.
+ * \param arg unused
+ */
+void
+ReleaseAtExit (void *arg)
+{
+  VirtualHeaderList::Release ();
+}
+
+/** Create g_releaseKey. */
+void
+CreateReleaseKey (void)
+{
+  pthread_key_create (&g_releaseKey, &ReleaseAtExit);
+}
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * \brief Release the pool of the main thread when the program exits
+ */
+struct LocalStaticDestructor
+{
+  ~LocalStaticDestructor ()
+  {
+    VirtualHeaderList::Release ();
+    g_destroyed = true;
+  }
+} g_localStaticDestructor; //!< Local static destructor
+
+} // unnamed namespace
+
+bool
+VirtualHeaderList::Add (const Header &header, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << &header << size);
+  if (size == 0)
+    {
+      return false;
+    }
+  TypeId tid = header.GetInstanceTypeId ();
+  PoolSlot &slot = g_slots[tid.GetUid () % POOL_SLOTS];
+  Node *node;
+  if (slot.free != 0 && slot.uid == tid.GetUid ())
+    {
+      node = static_cast<Node *> (slot.free);
+      slot.free = node->next;
+      slot.n--;
+    }
+  else
+    {
+      if (!tid.HasConstructor ())
+        {
+          return false;
+        }
+      Callback<ObjectBase *> constructor = tid.GetConstructor ();
+      ObjectBase *instance = constructor ();
+      Header *copy = dynamic_cast<Header *> (instance);
+      if (copy == 0)
+        {
+          delete instance;
+          return false;
+        }
+      node = new Node;
+      node->header = copy;
+      node->tid = tid;
+    }
+  if (typeid (header) != typeid (*node->header) || !header.CopyTo (*node->header))
+    {
+      Free (node);
+      return false;
+    }
+  node->size = size;
+  node->count = 1;
+  node->next = m_head;
+  m_head = node;
+  return true;
+}
+
+uint32_t
+VirtualHeaderList::Peek (Header &header) const
+{
+  NS_LOG_FUNCTION (this << &header);
+  if (m_head == 0
+      || typeid (header) != typeid (*m_head->header)
+      || !m_head->header->CopyTo (header))
+    {
+      return 0;
+    }
+  return m_head->size;
+}
+
+void
+VirtualHeaderList::RemoveFirst (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_head != 0);
+  Node *head = m_head;
+  m_head = head->next;
+  if (m_head != 0)
+    {
+      m_head->count++;
+    }
+  Unref (head);
+}
+
+void
+VirtualHeaderList::Serialize (Buffer::Iterator start) const
+{
+  NS_LOG_FUNCTION (this << &start);
+  if (m_head != 0)
+    {
+      Serialize (m_head, start);
+    }
+}
+
+void
+VirtualHeaderList::Serialize (const Node *node, Buffer::Iterator start)
+{
+  if (node->next != 0)
+    {
+      Buffer::Iterator next = start;
+      next.Next (node->size);
+      Serialize (node->next, next);
+    }
+  node->header->Serialize (start);
+}
+
+void
+VirtualHeaderList::Unref (Node *node)
+{
+  while (node != 0)
+    {
+      NS_ASSERT (node->count > 0);
+      node->count--;
+      if (node->count > 0)
+        {
+          return;
+        }
+      Node *next = node->next;
+      Free (node);
+      node = next;
+    }
+}
+
+void
+VirtualHeaderList::Free (Node *node)
+{
+  PoolSlot &slot = g_slots[node->tid.GetUid () % POOL_SLOTS];
+  if (g_destroyed
+      || (slot.free != 0 && slot.uid != node->tid.GetUid ())
+      || slot.n >= POOL_DEPTH)
+    {
+      delete node->header;
+      delete node;
+      return;
+    }
+#ifdef HAVE_PTHREAD_H
+  if (!g_releaseAtExit)
+    {
+      pthread_once (&g_releaseKeyOnce, &CreateReleaseKey);
+      pthread_setspecific (g_releaseKey, &g_releaseAtExit);
+      g_releaseAtExit = true;
+    }
+#endif /* HAVE_PTHREAD_H */
+  node->next = static_cast<Node *> (slot.free);
+  slot.free = node;
+  slot.uid = node->tid.GetUid ();
+  slot.n++;
+}
+
+void
+VirtualHeaderList::Release (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  for (uint32_t i = 0; i < POOL_SLOTS; ++i)
+    {
+      while (g_slots[i].free != 0)
+        {
+          Node *node = static_cast<Node *> (g_slots[i].free);
+          g_slots[i].free = node->next;
+          delete node->header;
+          delete node;
+        }
+      g_slots[i].n = 0;
+    }
+}
+
+} // namespace ns3
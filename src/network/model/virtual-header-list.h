@@ -0,0 +1,216 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef VIRTUAL_HEADER_LIST_H
+#define VIRTUAL_HEADER_LIST_H
+
+#include <stdint.h>
+#include "buffer.h"
+#include "ns3/type-id.h"
+
+namespace ns3 {
+
+class Header;
+
+/**
+ * \ingroup packet
+ *
+ * \brief List of the headers a packet carries as objects
+ *
+ * This class is private to the Packet implementation of the virtual
+ * header mode (see Packet::EnableVirtualHeaders) and users should never
+ * have to access it directly.
+ *
+ * The list holds copies of the headers added to the packet, most recent
+ * first. The bytes of these headers are reserved at the start of the
+ * byte buffer of the packet, but they are written only when
+ * the headers are serialized by Serialize, and a receiver which removes
+ * a header of the same type gets a copy of the object instead of
+ * deserializing it.
+ *
+ * As in PacketTagList, the list is a singly-linked list of reference
+ * counted nodes, shared by the copies of a packet: Add prepends a node
+ * and RemoveFirst moves the head of the list to the next node, so that the
+ * nodes are never modified once they are linked. The nodes freed by a
+ * thread are cached with their header object in a small per-thread
+ * pool, indexed by the TypeId of the header, so that adding a header
+ * usually only copies it into a recycled object of the same type.
+ */
+class VirtualHeaderList
+{
+public:
+  inline VirtualHeaderList ();
+  /**
+   * \param o the list to copy
+   *
+   * The copy shares the nodes of \p o.
+   */
+  inline VirtualHeaderList (const VirtualHeaderList &o);
+  /**
+   * \param o the list to copy
+   * \returns this list
+   */
+  inline VirtualHeaderList &operator = (const VirtualHeaderList &o);
+  inline ~VirtualHeaderList ();
+
+  /**
+   * \brief Add a copy of a header at the head of the list
+   *
+   * \param header the header to add
+   * \param size the serialized size of the header
+   * \returns false if the header cannot be carried as an object (see
+   * Header::CopyTo), in which case the list is unchanged
+   */
+  bool Add (const Header &header, uint32_t size);
+  /**
+   * \brief Copy the most recent header of the list
+   *
+   * \param header the header to copy into
+   * \returns the serialized size of the header, or zero if the list is
+   * empty or if its most recent header is not of the type of \p header
+   */
+  uint32_t Peek (Header &header) const;
+  /**
+   * \brief Remove the most recent header of the list
+   */
+  void RemoveFirst (void);
+  /**
+   * \brief Remove all the headers of the list
+   */
+  inline void RemoveAll (void);
+  /**
+   * \returns true if the list holds no header
+   */
+  inline bool IsEmpty (void) const;
+  /**
+   * \brief Serialize the headers of the list
+   *
+   * The innermost header is serialized first, so that the checksums
+   * computed by the outer headers cover its bytes.
+   *
+   * \param start the position of the most recent header in the buffer
+   */
+  void Serialize (Buffer::Iterator start) const;
+
+  /**
+   * \brief Free the header objects cached by the calling thread
+   */
+  static void Release (void);
+
+private:
+  /** A header carried as an object. */
+  struct Node
+  {
+    Header *header; //!< The copy of the header.
+    TypeId tid;     //!< The TypeId of the header.
+    uint32_t size;  //!< Serialized size of the header.
+    uint32_t count; //!< Number of incoming links.
+    Node *next;     //!< Next (less recent) header, or zero.
+  };
+
+  /**
+   * \param node the node of a header
+   * \param start the position of the header of \p node in the buffer
+   *
+   * Serialize the headers from the last one to the header of \p node.
+   */
+  static void Serialize (const Node *node, Buffer::Iterator start);
+  /**
+   * \brief Drop a link to a node, and free the nodes which are no
+   * longer linked
+   *
+   * \param node the node
+   */
+  static void Unref (Node *node);
+  /**
+   * \param node a node which is no longer linked
+   *
+   * The node is cached by the pool of the calling thread, or deleted if
+   * the pool is full.
+   */
+  static void Free (Node *node);
+
+  Node *m_head; //!< The most recent header, or zero.
+};
+
+} // namespace ns3
+
+/****************************************************
+ *  Implementation of inline methods for performance
+ ****************************************************/
+
+namespace ns3 {
+
+VirtualHeaderList::VirtualHeaderList ()
+  : m_head (0)
+{
+}
+
+VirtualHeaderList::VirtualHeaderList (const VirtualHeaderList &o)
+  : m_head (o.m_head)
+{
+  if (m_head != 0)
+    {
+      m_head->count++;
+    }
+}
+
+VirtualHeaderList &
+VirtualHeaderList::operator = (const VirtualHeaderList &o)
+{
+  if (m_head == o.m_head)
+    {
+      return *this;
+    }
+  if (o.m_head != 0)
+    {
+      o.m_head->count++;
+    }
+  if (m_head != 0)
+    {
+      Unref (m_head);
+    }
+  m_head = o.m_head;
+  return *this;
+}
+
+VirtualHeaderList::~VirtualHeaderList ()
+{
+  if (m_head != 0)
+    {
+      Unref (m_head);
+    }
+}
+
+void
+VirtualHeaderList::RemoveAll (void)
+{
+  if (m_head != 0)
+    {
+      Unref (m_head);
+      m_head = 0;
+    }
+}
+
+bool
+VirtualHeaderList::IsEmpty (void) const
+{
+  return m_head == 0;
+}
+
+} // namespace ns3
+
+#endif /* VIRTUAL_HEADER_LIST_H */
@@ -19,6 +19,8 @@
  */
 
 #include "ns3/buffer.h"
+#include "ns3/buffer-pool.h"
+#include "ns3/system-thread.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/double.h"
 #include "ns3/test.h"
@@ -361,6 +363,338 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 //-----------------------------------------------------------------------------
+/**
+ * \brief Check the size classes, the caps and the statistics of the
+ * BufferPool, and that the pool of each thread is independent
+ */
+class BufferPoolTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferPoolTest ();
+private:
+  /**
+   * Allocate and free some blocks, and record the statistics of the
+   * calling thread
+   */
+  void AllocateAndFree (void);
+
+  BufferPool::Statistics m_threadStats; //!< Statistics of the other thread
+};
+
+BufferPoolTest::BufferPoolTest ()
+  : TestCase ("BufferPool")
+{
+}
+
+void
+BufferPoolTest::AllocateAndFree (void)
+{
+  uint32_t capacity;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      uint8_t *block = BufferPool::Allocate (1000, capacity);
+      BufferPool::Deallocate (block, capacity);
+    }
+  m_threadStats = BufferPool::GetStatistics ();
+}
+
+void
+BufferPoolTest::DoRun (void)
+{
+  NS_TEST_EXPECT_MSG_EQ (BufferPool::GetCapacity (1), 16, "Wrong size of the smallest class");
+  NS_TEST_EXPECT_MSG_EQ (BufferPool::GetCapacity (17), 32, "Wrong size class");
+  NS_TEST_EXPECT_MSG_EQ (BufferPool::GetCapacity (1500), 2048, "Wrong size class");
+  NS_TEST_EXPECT_MSG_EQ (BufferPool::GetCapacity (65536), 65536, "Wrong size of the biggest class");
+  NS_TEST_EXPECT_MSG_EQ (BufferPool::GetCapacity (70000), 70000, "Big blocks should not be rounded");
+
+  BufferPool::Release ();
+  BufferPool::Statistics before = BufferPool::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (before.cachedBlocks, 0, "Pool not released");
+  NS_TEST_EXPECT_MSG_EQ (before.cachedBytes, 0, "Pool not released");
+
+  // the blocks of a size class are reused for any size of the class
+  uint8_t *blocks[10];
+  uint32_t capacity;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      blocks[i] = BufferPool::Allocate (100, capacity);
+      NS_TEST_EXPECT_MSG_EQ (capacity, 128, "Wrong capacity");
+    }
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      BufferPool::Deallocate (blocks[i], capacity);
+    }
+  BufferPool::Statistics stats = BufferPool::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.cachedBlocks, 10, "The blocks should be cached");
+  NS_TEST_EXPECT_MSG_EQ (stats.cachedBytes, 1280, "The blocks should be cached");
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      blocks[i] = BufferPool::Allocate (120, capacity);
+    }
+  stats = BufferPool::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.allocations - before.allocations, 20, "Wrong number of allocations");
+  NS_TEST_EXPECT_MSG_EQ (stats.hits - before.hits, 10, "The cached blocks should be reused");
+  NS_TEST_EXPECT_MSG_EQ (stats.cachedBlocks, 0, "The cached blocks should be reused");
+
+  // caps on the number of blocks and of bytes
+  uint32_t maxBlocks = BufferPool::GetMaxCachedBlocks ();
+  uint64_t maxBytes = BufferPool::GetMaxCachedBytes ();
+  BufferPool::SetMaxCachedBlocks (4);
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      BufferPool::Deallocate (blocks[i], capacity);
+    }
+  stats = BufferPool::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.deallocations - before.deallocations, 20, "Wrong number of deallocations");
+  NS_TEST_EXPECT_MSG_EQ (stats.cachedBlocks, 4, "The blocks cap should be enforced");
+  BufferPool::SetMaxCachedBlocks (maxBlocks);
+  BufferPool::SetMaxCachedBytes (4 * 128 + 2048);
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      blocks[i] = BufferPool::Allocate (2000, capacity);
+    }
+  BufferPool::Deallocate (blocks[0], capacity);
+  BufferPool::Deallocate (blocks[1], capacity);
+  stats = BufferPool::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.cachedBlocks, 5, "The bytes cap should be enforced");
+  NS_TEST_EXPECT_MSG_EQ (stats.cachedBytes, 4 * 128 + 2048, "The bytes cap should be enforced");
+  BufferPool::SetMaxCachedBytes (maxBytes);
+
+  // the buffers recycle their data through the pool
+  BufferPool::Release ();
+  before = BufferPool::GetStatistics ();
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Buffer buffer;
+      buffer.AddAtStart (40);
+      buffer.AddAtEnd (1000);
+      buffer.Begin ().WriteU8 (1);
+    }
+  stats = BufferPool::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.allocations - before.allocations, stats.deallocations - before.deallocations,
+                         "All the buffer data should have been freed");
+  NS_TEST_EXPECT_MSG_GT (stats.hits - before.hits, 90, "The buffer data should be recycled");
+
+#ifdef HAVE_PTHREAD_H
+  // another thread uses its own pool
+  before = BufferPool::GetStatistics ();
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&BufferPoolTest::AllocateAndFree, this));
+  thread->Start ();
+  thread->Join ();
+  stats = BufferPool::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.allocations, before.allocations, "The other thread should use its own pool");
+  NS_TEST_EXPECT_MSG_EQ (stats.cachedBlocks, before.cachedBlocks, "The other thread should use its own pool");
+  NS_TEST_EXPECT_MSG_EQ (m_threadStats.allocations, 10, "Wrong number of allocations in the other thread");
+  NS_TEST_EXPECT_MSG_EQ (m_threadStats.hits, 9, "Wrong number of hits in the other thread");
+  NS_TEST_EXPECT_MSG_EQ (m_threadStats.cachedBlocks, 1, "Wrong number of blocks cached by the other thread");
+#endif /* HAVE_PTHREAD_H */
+
+  BufferPool::Release ();
+}
+//-----------------------------------------------------------------------------
+/**
+ * \brief Check the multi-segment buffers of the scatter-gather mode
+ */
+class BufferScatterGatherTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferScatterGatherTest ();
+private:
+  /**
+   * \param size the number of bytes of the buffer
+   * \param seed the value of the first byte
+   * \returns a buffer holding size bytes, from seed on
+   */
+  Buffer MakeBuffer (uint32_t size, uint8_t seed);
+  /**
+   * \param b a buffer
+   * \returns the bytes of the buffer
+   */
+  std::vector<uint8_t> GetBytes (const Buffer &b);
+  /**
+   * \param b a buffer
+   * \returns the bytes of the buffer, read one by one with an iterator
+   */
+  std::vector<uint8_t> ReadBytes (const Buffer &b);
+};
+
+BufferScatterGatherTest::BufferScatterGatherTest ()
+  : TestCase ("Buffer scatter-gather")
+{
+}
+
+Buffer
+BufferScatterGatherTest::MakeBuffer (uint32_t size, uint8_t seed)
+{
+  Buffer b;
+  b.AddAtStart (size);
+  Buffer::Iterator i = b.Begin ();
+  for (uint32_t j = 0; j < size; j++)
+    {
+      i.WriteU8 (seed + j);
+    }
+  return b;
+}
+
+std::vector<uint8_t>
+BufferScatterGatherTest::GetBytes (const Buffer &b)
+{
+  std::vector<uint8_t> bytes (b.GetSize ());
+  if (!bytes.empty ())
+    {
+      b.CopyData (&bytes[0], b.GetSize ());
+    }
+  return bytes;
+}
+
+std::vector<uint8_t>
+BufferScatterGatherTest::ReadBytes (const Buffer &b)
+{
+  std::vector<uint8_t> bytes;
+  Buffer::Iterator i = b.Begin ();
+  while (!i.IsEnd ())
+    {
+      bytes.push_back (i.ReadU8 ());
+    }
+  return bytes;
+}
+
+void
+BufferScatterGatherTest::DoRun (void)
+{
+  bool enabled = Buffer::IsScatterGatherEnabled ();
+  Buffer::EnableScatterGather ();
+
+  // a buffer with real bytes, virtual zero bytes and real bytes again
+  Buffer zeroes (500);
+  zeroes.AddAtStart (20);
+  zeroes.Begin ().WriteU8 (7, 20);
+  zeroes.AddAtEnd (4);
+  Buffer::Iterator z = zeroes.End ();
+  z.Prev (4);
+  z.WriteHtonU32 (0x01020304);
+
+  Buffer a = MakeBuffer (300, 0);
+  Buffer c = MakeBuffer (200, 100);
+  std::vector<uint8_t> expected = GetBytes (a);
+  std::vector<uint8_t> bytes = GetBytes (zeroes);
+  expected.insert (expected.end (), bytes.begin (), bytes.end ());
+  bytes = GetBytes (c);
+  expected.insert (expected.end (), bytes.begin (), bytes.end ());
+
+  Buffer x = a;
+  x.AddAtEnd (zeroes);
+  x.AddAtEnd (c);
+  NS_TEST_EXPECT_MSG_EQ (x.GetNSegments (), 3, "The buffers should have been chained");
+  NS_TEST_EXPECT_MSG_EQ (x.GetSize (), expected.size (), "Wrong size");
+  NS_TEST_EXPECT_MSG_EQ ((GetBytes (x) == expected), true, "Wrong bytes copied");
+  NS_TEST_EXPECT_MSG_EQ ((ReadBytes (x) == expected), true, "Wrong bytes read");
+  NS_TEST_EXPECT_MSG_EQ (a.GetSize (), 300, "The original buffer should not change");
+
+  // multi-byte reads across the segment boundaries
+  Buffer::Iterator i = x.Begin ();
+  i.Next (298);
+  uint32_t value = i.ReadNtohU32 ();
+  NS_TEST_EXPECT_MSG_EQ (value, 0x2a2b0707, "Wrong bytes read across segments");
+  i = x.End ();
+  i.Prev (202);
+  value = i.ReadNtohU32 ();
+  NS_TEST_EXPECT_MSG_EQ (value, 0x03046465, "Wrong bytes read across segments");
+  value = i.ReadNtohU16 ();
+  NS_TEST_EXPECT_MSG_EQ (value, 0x6667, "Wrong bytes read in the last segment");
+  i.Prev (x.GetSize () - 196);
+  NS_TEST_EXPECT_MSG_EQ (i.IsStart (), true, "Wrong iterator position");
+  NS_TEST_EXPECT_MSG_EQ (i.GetSize (), x.GetSize (), "Wrong iterator size");
+
+  // fragments, and removal of bytes across segments
+  Buffer fragment = x.CreateFragment (250, 400);
+  NS_TEST_EXPECT_MSG_EQ (fragment.GetNSegments (), 2, "The fragment should reference two segments");
+  NS_TEST_EXPECT_MSG_EQ ((GetBytes (fragment)
+                          == std::vector<uint8_t> (expected.begin () + 250, expected.begin () + 650)),
+                         true, "Wrong fragment bytes");
+  Buffer y = x;
+  y.RemoveAtStart (330);
+  y.RemoveAtEnd (210);
+  NS_TEST_EXPECT_MSG_EQ (y.GetNSegments (), 1, "Only a part of the second segment should remain");
+  NS_TEST_EXPECT_MSG_EQ ((ReadBytes (y)
+                          == std::vector<uint8_t> (expected.begin () + 330, expected.end () - 210)),
+                         true, "Wrong bytes after removal");
+  NS_TEST_EXPECT_MSG_EQ ((GetBytes (x) == expected), true, "The original buffer should not change");
+
+  // headers and trailers
+  x.AddAtStart (8);
+  x.Begin ().WriteHtonU32 (0xdeadbeef);
+  i = x.Begin ();
+  i.Next (4);
+  i.WriteHtonU32 (0xcafedeca);
+  x.AddAtEnd (4);
+  i = x.End ();
+  i.Prev (4);
+  i.WriteHtonU32 (0x0a0b0c0d);
+  i = x.Begin ();
+  value = i.ReadNtohU32 ();
+  NS_TEST_EXPECT_MSG_EQ (value, 0xdeadbeef, "Wrong header");
+  value = i.ReadNtohU32 ();
+  NS_TEST_EXPECT_MSG_EQ (value, 0xcafedeca, "Wrong header");
+  i = x.End ();
+  i.Prev (4);
+  value = i.ReadNtohU32 ();
+  NS_TEST_EXPECT_MSG_EQ (value, 0x0a0b0c0d, "Wrong trailer");
+  NS_TEST_EXPECT_MSG_EQ ((GetBytes (c) == std::vector<uint8_t> (expected.end () - 200, expected.end ())),
+                         true, "The appended buffer should not change");
+
+  // bytes added at the start of a buffer shared with another one
+  Buffer big = MakeBuffer (1000, 1);
+  Buffer shared = big;
+  big.RemoveAtStart (10);
+  shared.AddAtStart (20);
+  big.AddAtStart (30);
+  NS_TEST_EXPECT_MSG_EQ (big.GetNSegments (), 2, "The bytes should not have been copied");
+  big.Begin ().WriteU8 (0xff, 30);
+  bytes = ReadBytes (big);
+  NS_TEST_EXPECT_MSG_EQ (bytes.size (), 1020, "Wrong size");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)bytes[29], 0xff, "Wrong header");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)bytes[30], 11, "Wrong payload");
+
+  // writes across segments
+  Buffer w = MakeBuffer (300, 0);
+  w.AddAtEnd (MakeBuffer (300, 0));
+  i = w.Begin ();
+  i.Next (298);
+  i.WriteHtonU32 (0x11223344);
+  i.Prev (4);
+  value = i.ReadNtohU32 ();
+  NS_TEST_EXPECT_MSG_EQ (value, 0x11223344, "Wrong bytes written across segments");
+  uint8_t data[6] = { 1, 2, 3, 4, 5, 6 };
+  i = w.Begin ();
+  i.Next (297);
+  i.Write (data, 6);
+  i.Prev (6);
+  uint8_t read[6];
+  i.Read (read, 6);
+  NS_TEST_EXPECT_MSG_EQ ((std::vector<uint8_t> (data, data + 6) == std::vector<uint8_t> (read, read + 6)),
+                         true, "Wrong bytes written across segments");
+
+  // gathering
+  expected = GetBytes (x);
+  Buffer s;
+  std::vector<uint8_t> serialized (x.GetSerializedSize ());
+  NS_TEST_EXPECT_MSG_EQ (x.Serialize (&serialized[0], serialized.size ()), 1, "Serialization failed");
+  // the size given to Deserialize accounts for the size prefix written by Packet
+  s.Deserialize (&serialized[0], serialized.size () + 4);
+  NS_TEST_EXPECT_MSG_EQ ((GetBytes (s) == expected), true, "Wrong deserialized bytes");
+  uint8_t const *peek = x.PeekData ();
+  NS_TEST_EXPECT_MSG_EQ (x.GetNSegments (), 1, "The buffer should have been gathered");
+  NS_TEST_EXPECT_MSG_EQ ((std::vector<uint8_t> (peek, peek + x.GetSize ()) == expected), true,
+                         "Wrong gathered bytes");
+
+  Buffer::EnableScatterGather (false);
+  Buffer v = MakeBuffer (300, 0);
+  v.AddAtEnd (MakeBuffer (300, 0));
+  NS_TEST_EXPECT_MSG_EQ (v.GetNSegments (), 1, "The buffers should have been copied");
+  Buffer::EnableScatterGather (enabled);
+}
+//-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -371,6 +705,8 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferPoolTest, TestCase::QUICK);
+  AddTestCase (new BufferScatterGatherTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/dynamic-queue-limits.h"
+#include "ns3/net-device.h"
+#include "ns3/uinteger.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check the limit computed by the DQL algorithm
+ */
+class DynamicQueueLimitsTestCase : public TestCase
+{
+public:
+  DynamicQueueLimitsTestCase ();
+  virtual void DoRun (void);
+};
+
+DynamicQueueLimitsTestCase::DynamicQueueLimitsTestCase ()
+  : TestCase ("Sanity check on the dynamic queue limits algorithm")
+{
+}
+
+void
+DynamicQueueLimitsTestCase::DoRun (void)
+{
+  Ptr<DynamicQueueLimits> dql = CreateObject<DynamicQueueLimits> ();
+
+  NS_TEST_EXPECT_MSG_EQ (dql->Available (), 0, "The initial limit should be zero");
+
+  dql->Queued (1500);
+  NS_TEST_EXPECT_MSG_EQ (dql->Available (), -1500, "The queue should be over limit");
+
+  // The queue was over limit and it is now empty: it is considered starved
+  // and the limit is increased by the amount of completed bytes
+  dql->Completed (1500);
+  NS_TEST_EXPECT_MSG_EQ (dql->Available (), 1500, "The limit should have been increased");
+
+  dql->Queued (1000);
+  NS_TEST_EXPECT_MSG_EQ (dql->Available (), 500, "The available room should have decreased");
+  dql->Completed (1000);
+  NS_TEST_EXPECT_MSG_EQ (dql->Available (), 1500, "The limit should not have changed");
+
+  // The limit cannot grow beyond MaxLimit
+  dql->SetAttribute ("MaxLimit", UintegerValue (2000));
+  dql->Queued (4000);
+  dql->Completed (4000);
+  NS_TEST_EXPECT_MSG_EQ (dql->Available (), 2000, "The limit should be capped to MaxLimit");
+
+  dql->Reset ();
+  NS_TEST_EXPECT_MSG_EQ (dql->Available (), 0, "The limit should have been reset");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check that a netdevice queue is stopped and woken up by the queue
+ * limits, independently of the device stopping the queue
+ */
+class NetDeviceQueueLimitsTestCase : public TestCase
+{
+public:
+  NetDeviceQueueLimitsTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /// Wake callback
+  void Wake (void);
+  uint32_t m_nWakes; //!< Number of times the wake callback was invoked
+};
+
+NetDeviceQueueLimitsTestCase::NetDeviceQueueLimitsTestCase ()
+  : TestCase ("Check the interaction between the netdevice queue and the queue limits"),
+    m_nWakes (0)
+{
+}
+
+void
+NetDeviceQueueLimitsTestCase::Wake (void)
+{
+  m_nWakes++;
+}
+
+void
+NetDeviceQueueLimitsTestCase::DoRun (void)
+{
+  Ptr<NetDeviceQueue> txq = Create<NetDeviceQueue> ();
+  txq->SetWakeCallback (MakeCallback (&NetDeviceQueueLimitsTestCase::Wake, this));
+
+  // Without queue limits, the notifications have no effect
+  txq->NotifyQueuedBytes (1500);
+  NS_TEST_EXPECT_MSG_EQ (txq->IsStopped (), false, "The queue should not be stopped");
+  txq->NotifyTransmittedBytes (1500);
+  NS_TEST_EXPECT_MSG_EQ (m_nWakes, 0, "The wake callback should not have been invoked");
+
+  txq->SetQueueLimits (CreateObject<DynamicQueueLimits> ());
+
+  txq->NotifyQueuedBytes (1500);
+  NS_TEST_EXPECT_MSG_EQ (txq->IsStopped (), true, "The queue should have been stopped by the queue limits");
+  txq->NotifyTransmittedBytes (1500);
+  NS_TEST_EXPECT_MSG_EQ (txq->IsStopped (), false, "The queue should have been restarted");
+  NS_TEST_EXPECT_MSG_EQ (m_nWakes, 1, "The wake callback should have been invoked");
+
+  // The queue is stopped by both the queue limits and the device
+  txq->NotifyQueuedBytes (3000);
+  txq->Stop ();
+  txq->NotifyTransmittedBytes (3000);
+  NS_TEST_EXPECT_MSG_EQ (txq->IsStopped (), true, "The queue is still stopped by the device");
+  NS_TEST_EXPECT_MSG_EQ (m_nWakes, 1, "The wake callback should not have been invoked");
+  txq->Wake ();
+  NS_TEST_EXPECT_MSG_EQ (txq->IsStopped (), false, "The queue should have been woken up");
+  NS_TEST_EXPECT_MSG_EQ (m_nWakes, 2, "The wake callback should have been invoked");
+
+  // The device wakes the queue up, which is still stopped by the queue limits
+  txq->NotifyQueuedBytes (6000);
+  txq->Wake ();
+  NS_TEST_EXPECT_MSG_EQ (txq->IsStopped (), true, "The queue is still stopped by the queue limits");
+  NS_TEST_EXPECT_MSG_EQ (m_nWakes, 2, "The wake callback should not have been invoked");
+  txq->NotifyTransmittedBytes (6000);
+  NS_TEST_EXPECT_MSG_EQ (txq->IsStopped (), false, "The queue should have been restarted");
+  NS_TEST_EXPECT_MSG_EQ (m_nWakes, 3, "The wake callback should have been invoked");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Dynamic queue limits TestSuite
+ */
+static class DynamicQueueLimitsTestSuite : public TestSuite
+{
+public:
+  DynamicQueueLimitsTestSuite ()
+    : TestSuite ("dynamic-queue-limits", UNIT)
+  {
+    AddTestCase (new DynamicQueueLimitsTestCase (), TestCase::QUICK);
+    AddTestCase (new NetDeviceQueueLimitsTestCase (), TestCase::QUICK);
+  }
+} g_dynamicQueueLimitsTestSuite;
@@ -27,6 +27,7 @@
 #include <iostream>
 #include <iomanip>
 #include <ctime>
+#include <cstring>
 
 using namespace ns3;
 
@@ -727,6 +728,59 @@ PacketTagListTest::DoRun (void)
     NS_TEST_EXPECT_MSG_EQ (ref.Peek (t10), false, "missing tag");
   }
 
+  { // Inline storage
+    std::cout << GetName () << "check inline storage" << std::endl;
+    NS_TEST_EXPECT_MSG_EQ (ref.GetNInlineTags (), (uint32_t)PacketTagList::INLINE_TAGS,
+                           "first tags not inline");
+    int listed = 0;
+    for (const PacketTagList::TagData *cur = ref.Head (); cur != 0; cur = cur->next)
+      {
+        listed++;
+      }
+    NS_TEST_EXPECT_MSG_EQ (listed, tagLast - PacketTagList::INLINE_TAGS,
+                           "overflow tags not listed");
+
+    // a tag added back while the list is not empty goes to the list
+    PacketTagList ptl = ref;
+    ptl.Remove (t1);
+    ptl.Add (t1);
+    NS_TEST_EXPECT_MSG_EQ (ptl.GetNInlineTags (), (uint32_t)PacketTagList::INLINE_TAGS - 1,
+                           "tag re-added inline");
+    CheckRefList (ref, "inline re-add orig");
+    CheckRefList (ptl, "inline re-add copy");
+
+    // removing a middle slot keeps the index of the other slots right
+    PacketTagList mid = ref;
+    mid.Remove (t3);
+    NS_TEST_EXPECT_MSG_EQ (mid.GetNInlineTags (), (uint32_t)PacketTagList::INLINE_TAGS - 1,
+                           "middle inline tag not removed");
+    NS_TEST_EXPECT_MSG_EQ ((mid.GetInlineTagTypeId (2) == t4.GetTypeId ()), true,
+                           "inline slots not shifted");
+    CheckRefList (mid, "inline middle remove", 3);
+
+    // the iteration goes from the most recent tag to the oldest
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddPacketTag (t1);
+    p->AddPacketTag (t2);
+    p->AddPacketTag (t3);
+    p->AddPacketTag (t4);
+    p->AddPacketTag (t5);
+    p->AddPacketTag (t6);
+    p->AddPacketTag (t7);
+    TypeId order[] = { t7.GetTypeId (), t6.GetTypeId (), t5.GetTypeId (), t4.GetTypeId (),
+                       t3.GetTypeId (), t2.GetTypeId (), t1.GetTypeId () };
+    int n = 0;
+    PacketTagIterator i = p->GetPacketTagIterator ();
+    while (i.HasNext ())
+      {
+        PacketTagIterator::Item item = i.Next ();
+        NS_TEST_EXPECT_MSG_EQ ((n < tagLast && item.GetTypeId () == order[n]), true,
+                               "wrong iteration order at tag " << n);
+        n++;
+      }
+    NS_TEST_EXPECT_MSG_EQ (n, tagLast, "wrong number of tags iterated");
+  }
+
   { // Copy ctor, assignment
     std::cout << GetName () << "check copy and assignment" << std::endl;
     { PacketTagList ptl (ref);
@@ -847,6 +901,214 @@ PacketTagListTest::DoRun (void)
     
 }
 
+//--------------------------------------
+/**
+ * \brief Check that the lean packets only update their byte buffer
+ */
+class PacketLeanModeTest : public TestCase
+{
+public:
+  PacketLeanModeTest ();
+private:
+  void DoRun (void);
+};
+
+PacketLeanModeTest::PacketLeanModeTest ()
+  : TestCase ("Lean packets")
+{
+}
+
+void
+PacketLeanModeTest::DoRun (void)
+{
+  Packet::EnableLeanMode ();
+  Ptr<Packet> p = Create<Packet> (100);
+  Ptr<Packet> q = Create<Packet> (50);
+  Packet::EnableLeanMode (false);
+  NS_TEST_EXPECT_MSG_EQ (p->IsLean (), true, "The packet should be lean");
+  NS_TEST_EXPECT_MSG_EQ (q->GetUid (), p->GetUid () + 1, "The lean packets should have unique ids");
+
+  p->AddHeader (ATestHeader<10> ());
+  p->AddHeader (ATestHeader<20> ());
+  p->AddTrailer (ATestTrailer<5> ());
+  p->AddPacketTag (ATestTag<1> ());
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 135, "Wrong size of the lean packet");
+  NS_TEST_EXPECT_MSG_EQ (p->ToString (), "", "Lean packets cannot be printed");
+
+  Ptr<Packet> copy = p->Copy ();
+  NS_TEST_EXPECT_MSG_EQ (copy->IsLean (), true, "The copy of a lean packet should be lean");
+  ATestTag<1> tag;
+  NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (tag), true, "The packet tags should be kept");
+
+  ATestHeader<20> h20;
+  ATestHeader<10> h10;
+  ATestTrailer<5> t5;
+  copy->RemoveHeader (h20);
+  copy->RemoveHeader (h10);
+  copy->RemoveTrailer (t5);
+  NS_TEST_EXPECT_MSG_EQ (h20.m_error || h10.m_error || t5.m_error, false, "Wrong headers read");
+  NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), 100, "Wrong size after removing the headers");
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 135, "The original packet should not change");
+
+  Ptr<Packet> frag = p->CreateFragment (0, 30);
+  NS_TEST_EXPECT_MSG_EQ (frag->IsLean (), true, "The fragment of a lean packet should be lean");
+  frag->AddAtEnd (q);
+  frag->AddPaddingAtEnd (10);
+  frag->RemoveAtStart (20);
+  frag->RemoveAtEnd (5);
+  NS_TEST_EXPECT_MSG_EQ (frag->GetSize (), 65, "Wrong size of the reassembled packet");
+  frag->RemoveHeader (h10);
+  NS_TEST_EXPECT_MSG_EQ (h10.m_error, false, "Wrong header read");
+
+  // regular packets are not affected, also when lean packets are appended
+  Ptr<Packet> r = Create<Packet> (10);
+  NS_TEST_EXPECT_MSG_EQ (r->IsLean (), false, "The packet should not be lean");
+  r->AddByteTag (ATestTag<2> ());
+  r->AddAtEnd (p);
+  r->AddHeader (ATestHeader<4> ());
+  NS_TEST_EXPECT_MSG_EQ (r->GetSize (), 149, "Wrong size of the regular packet");
+  ByteTagIterator it = r->GetByteTagIterator ();
+  NS_TEST_ASSERT_MSG_EQ (it.HasNext (), true, "The byte tag should be kept");
+  ByteTagIterator::Item item = it.Next ();
+  NS_TEST_EXPECT_MSG_EQ (item.GetStart (), 4, "Wrong start of the byte tag");
+  NS_TEST_EXPECT_MSG_EQ (item.GetEnd (), 14, "Wrong end of the byte tag");
+}
+
+//--------------------------------------
+/**
+ * \brief A header which can be carried as an object, and counts its
+ * deserializations
+ */
+class AVirtualTestHeader : public Header
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("anon::AVirtualTestHeader")
+      .SetParent<Header> ()
+      .SetGroupName ("Network")
+      .HideFromDocumentation ()
+      .AddConstructor<AVirtualTestHeader> ()
+    ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const {
+    return 4;
+  }
+  virtual void Serialize (Buffer::Iterator iter) const {
+    iter.WriteHtonU32 (m_value);
+  }
+  virtual uint32_t Deserialize (Buffer::Iterator iter) {
+    m_value = iter.ReadNtohU32 ();
+    g_deserialized++;
+    return 4;
+  }
+  virtual void Print (std::ostream &os) const {
+  }
+  virtual bool CopyTo (Header &header) const {
+    static_cast<AVirtualTestHeader &> (header) = *this;
+    return true;
+  }
+  AVirtualTestHeader (uint32_t value = 0)
+    : m_value (value) {}
+
+  uint32_t m_value; //!< The value of the header
+  static uint32_t g_deserialized; //!< Number of headers deserialized
+};
+
+uint32_t AVirtualTestHeader::g_deserialized = 0;
+
+/**
+ * \brief Check the headers carried as objects in virtual header mode
+ */
+class PacketVirtualHeadersTest : public TestCase
+{
+public:
+  PacketVirtualHeadersTest ();
+private:
+  void DoRun (void);
+};
+
+PacketVirtualHeadersTest::PacketVirtualHeadersTest ()
+  : TestCase ("Virtual headers")
+{
+}
+
+void
+PacketVirtualHeadersTest::DoRun (void)
+{
+  bool enabled = Packet::IsVirtualHeadersEnabled ();
+  Packet::EnableVirtualHeaders ();
+  AVirtualTestHeader::g_deserialized = 0;
+
+  // headers handed over as objects
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (AVirtualTestHeader (1));
+  p->AddHeader (AVirtualTestHeader (2));
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 108, "The bytes of the headers should be reserved");
+  Ptr<Packet> copy = p->Copy ();
+  AVirtualTestHeader h;
+  NS_TEST_EXPECT_MSG_EQ (copy->PeekHeader (h), 4, "Wrong size of the header");
+  NS_TEST_EXPECT_MSG_EQ (h.m_value, 2, "Wrong header peeked");
+  NS_TEST_EXPECT_MSG_EQ (copy->RemoveHeader (h), 4, "Wrong size of the header");
+  NS_TEST_EXPECT_MSG_EQ (h.m_value, 2, "Wrong header removed");
+  copy->RemoveHeader (h);
+  NS_TEST_EXPECT_MSG_EQ (h.m_value, 1, "Wrong header removed");
+  NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), 100, "Wrong size after removing the headers");
+  NS_TEST_EXPECT_MSG_EQ (AVirtualTestHeader::g_deserialized, 0, "No header should have been deserialized");
+
+  // reading the bytes serializes the headers
+  uint8_t bytes[8];
+  p->CopyData (bytes, 8);
+  uint8_t expected[8] = { 0, 0, 0, 2, 0, 0, 0, 1 };
+  NS_TEST_EXPECT_MSG_EQ (memcmp (bytes, expected, 8), 0, "Wrong serialized headers");
+  p->RemoveHeader (h);
+  NS_TEST_EXPECT_MSG_EQ (h.m_value, 2, "Wrong header deserialized");
+  NS_TEST_EXPECT_MSG_EQ (AVirtualTestHeader::g_deserialized, 1, "The header should have been deserialized");
+
+  // headers of other types are read from the bytes
+  Ptr<Packet> q = Create<Packet> (10);
+  q->AddHeader (AVirtualTestHeader (3));
+  q->AddHeader (ATestHeader<6> ());
+  q->AddHeader (AVirtualTestHeader (0x04040404));
+  ATestHeader<4> h4;
+  NS_TEST_EXPECT_MSG_EQ (q->PeekHeader (h4), 4, "Wrong size of the header");
+  NS_TEST_EXPECT_MSG_EQ (h4.m_error, false, "Wrong serialized header");
+  q->RemoveHeader (h);
+  NS_TEST_EXPECT_MSG_EQ (h.m_value, 0x04040404, "Wrong header deserialized");
+  ATestHeader<6> h6;
+  q->RemoveHeader (h6);
+  NS_TEST_EXPECT_MSG_EQ (h6.m_error, false, "Wrong header deserialized");
+  q->RemoveHeader (h);
+  NS_TEST_EXPECT_MSG_EQ (h.m_value, 3, "Wrong header deserialized");
+
+  // fragments and concatenations see the serialized headers
+  Ptr<Packet> r = Create<Packet> (10);
+  r->AddHeader (AVirtualTestHeader (5));
+  Ptr<Packet> frag = r->CreateFragment (0, 4);
+  frag->RemoveHeader (h);
+  NS_TEST_EXPECT_MSG_EQ (h.m_value, 5, "Wrong fragment");
+  Ptr<Packet> s = Create<Packet> (0);
+  s->AddAtEnd (r);
+  s->RemoveHeader (h);
+  NS_TEST_EXPECT_MSG_EQ (h.m_value, 5, "Wrong concatenation");
+
+  Packet::EnableVirtualHeaders (false);
+  Ptr<Packet> t = Create<Packet> (10);
+  t->AddHeader (AVirtualTestHeader (6));
+  uint32_t deserialized = AVirtualTestHeader::g_deserialized;
+  t->RemoveHeader (h);
+  NS_TEST_EXPECT_MSG_EQ (AVirtualTestHeader::g_deserialized, deserialized + 1,
+                         "The header should have been serialized");
+  Packet::EnableVirtualHeaders (enabled);
+}
 //-----------------------------------------------------------------------------
 class PacketTestSuite : public TestSuite
 {
@@ -859,6 +1121,8 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new PacketLeanModeTest, TestCase::QUICK);
+  AddTestCase (new PacketVirtualHeadersTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite;
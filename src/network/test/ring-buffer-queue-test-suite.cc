@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ring-buffer-queue.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check that the ring buffer queue behaves as a drop tail queue in
+ * packet mode, also when the items wrap around the end of the buffer
+ */
+class RingBufferQueuePacketModeTestCase : public TestCase
+{
+public:
+  RingBufferQueuePacketModeTestCase ();
+  virtual void DoRun (void);
+};
+
+RingBufferQueuePacketModeTestCase::RingBufferQueuePacketModeTestCase ()
+  : TestCase ("Sanity check on the ring buffer queue in packet mode")
+{
+}
+
+void
+RingBufferQueuePacketModeTestCase::DoRun (void)
+{
+  Ptr<RingBufferQueue> queue = CreateObject<RingBufferQueue> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxPackets", UintegerValue (3)), true,
+                         "Verify that we can actually set the attribute");
+
+  Ptr<Packet> p[5];
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      p[i] = Create<Packet> (100 + i);
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 0, "There should be no packets in there");
+  NS_TEST_EXPECT_MSG_EQ ((queue->Peek () == 0), true, "There should be no packet to peek");
+  queue->Enqueue (Create<QueueItem> (p[0]));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCapacity (), 3, "The buffer should be sized from MaxPackets");
+  queue->Enqueue (Create<QueueItem> (p[1]));
+  queue->Enqueue (Create<QueueItem> (p[2]));
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (Create<QueueItem> (p[3])), false, "The fourth packet should be dropped");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 3, "There should be still three packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNBytes (), 303, "Wrong number of bytes in the queue");
+
+  Ptr<QueueItem> item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p[0]->GetUid (), "Was this the first packet ?");
+
+  // The next items wrap around the end of the buffer
+  queue->Enqueue (Create<QueueItem> (p[3]));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 3, "There should be three packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->Peek ()->GetPacket ()->GetUid (), p[1]->GetUid (), "Was this the second packet ?");
+  for (uint32_t i = 1; i < 4; i++)
+    {
+      item = queue->Dequeue ();
+      NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove a packet");
+      NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p[i]->GetUid (), "The packets should be dequeued in order");
+    }
+  NS_TEST_EXPECT_MSG_EQ ((queue->Dequeue () == 0), true, "There are really no packets in there");
+
+  // The buffer is resized if MaxPackets is increased, keeping the items in order
+  queue->Enqueue (Create<QueueItem> (p[0]));
+  queue->Enqueue (Create<QueueItem> (p[1]));
+  queue->Enqueue (Create<QueueItem> (p[2]));
+  queue->SetMaxPackets (5);
+  queue->Enqueue (Create<QueueItem> (p[3]));
+  queue->Enqueue (Create<QueueItem> (p[4]));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCapacity (), 5, "The buffer should have been resized");
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      item = queue->Remove ();
+      NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p[i]->GetUid (), "The packets should be removed in order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), 6, "Wrong number of dropped packets");
+
+  // The queue releases the items it stores when it is destroyed
+  queue->Enqueue (Create<QueueItem> (p[0]));
+  queue = 0;
+  NS_TEST_EXPECT_MSG_EQ (p[0]->GetReferenceCount (), 1, "The item should have been released");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check that the ring buffer grows in byte mode
+ */
+class RingBufferQueueByteModeTestCase : public TestCase
+{
+public:
+  RingBufferQueueByteModeTestCase ();
+  virtual void DoRun (void);
+};
+
+RingBufferQueueByteModeTestCase::RingBufferQueueByteModeTestCase ()
+  : TestCase ("Sanity check on the ring buffer queue in byte mode")
+{
+}
+
+void
+RingBufferQueueByteModeTestCase::DoRun (void)
+{
+  Ptr<RingBufferQueue> queue = CreateObject<RingBufferQueue> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", EnumValue (Queue::QUEUE_MODE_BYTES)), true,
+                         "Verify that we can actually set the attribute");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxBytes", UintegerValue (1000)), true,
+                         "Verify that we can actually set the attribute");
+
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      packets.push_back (Create<Packet> (100));
+      NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (Create<QueueItem> (packets[i])), true, "The packet should be enqueued");
+      // dequeue and enqueue again the oldest packet to move the head of the buffer
+      if (i == 2)
+        {
+          Ptr<QueueItem> item = queue->Dequeue ();
+          queue->Enqueue (item);
+          packets.push_back (packets[0]);
+          packets.erase (packets.begin ());
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (Create<QueueItem> (Create<Packet> (100))), false, "The queue should be full");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (queue->GetCapacity (), 10, "The buffer should have grown");
+
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Ptr<QueueItem> item = queue->Dequeue ();
+      NS_TEST_EXPECT_MSG_EQ (item->GetPacket (), packets[i], "The packets should be dequeued in order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNBytes (), 0, "The queue should be empty");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Ring buffer queue TestSuite
+ */
+static class RingBufferQueueTestSuite : public TestSuite
+{
+public:
+  RingBufferQueueTestSuite ()
+    : TestSuite ("ring-buffer-queue", UNIT)
+  {
+    AddTestCase (new RingBufferQueuePacketModeTestCase (), TestCase::QUICK);
+    AddTestCase (new RingBufferQueueByteModeTestCase (), TestCase::QUICK);
+  }
+} g_ringBufferQueueTestSuite;
@@ -0,0 +1,171 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ring-buffer-queue.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RingBufferQueue");
+
+NS_OBJECT_ENSURE_REGISTERED (RingBufferQueue);
+
+TypeId RingBufferQueue::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RingBufferQueue")
+    .SetParent<Queue> ()
+    .SetGroupName ("Network")
+    .AddConstructor<RingBufferQueue> ()
+  ;
+  return tid;
+}
+
+RingBufferQueue::RingBufferQueue () :
+  Queue (),
+  m_ring (),
+  m_head (0),
+  m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RingBufferQueue::~RingBufferQueue ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+uint32_t
+RingBufferQueue::GetCapacity (void) const
+{
+  return m_ring.size ();
+}
+
+bool
+RingBufferQueue::DoEnqueue (Ptr<QueueItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  NS_ASSERT (m_size == GetNPackets ());
+
+  if (m_size == m_ring.size ())
+    {
+      // In packet mode, the base class ensures that the queue does not hold
+      // more than MaxPackets items
+      uint32_t capacity = 2 * m_ring.size ();
+      if (GetMode () == QUEUE_MODE_PACKETS && GetMaxPackets () > m_size)
+        {
+          capacity = GetMaxPackets ();
+        }
+      Resize (capacity > m_size ? capacity : m_size + 1);
+    }
+
+  uint32_t tail = m_head + m_size;
+  if (tail >= m_ring.size ())
+    {
+      tail -= m_ring.size ();
+    }
+  // the buffer holds a reference to the item
+  m_ring[tail] = GetPointer (item);
+  m_size++;
+
+  return true;
+}
+
+Ptr<QueueItem>
+RingBufferQueue::Pop (void)
+{
+  NS_ASSERT (m_size > 0);
+
+  // hand the reference held by the buffer over to the caller
+  Ptr<QueueItem> item = Ptr<QueueItem> (m_ring[m_head], false);
+  m_ring[m_head] = 0;
+  if (++m_head == m_ring.size ())
+    {
+      m_head = 0;
+    }
+  m_size--;
+
+  return item;
+}
+
+Ptr<QueueItem>
+RingBufferQueue::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_size == GetNPackets ());
+
+  Ptr<QueueItem> item = Pop ();
+
+  NS_LOG_LOGIC ("Popped " << item);
+
+  return item;
+}
+
+Ptr<QueueItem>
+RingBufferQueue::DoRemove (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_size == GetNPackets ());
+
+  Ptr<QueueItem> item = Pop ();
+
+  NS_LOG_LOGIC ("Removed " << item);
+
+  return item;
+}
+
+Ptr<const QueueItem>
+RingBufferQueue::DoPeek (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_size == GetNPackets ());
+
+  return m_ring[m_head];
+}
+
+void
+RingBufferQueue::Resize (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+  NS_ASSERT (capacity >= m_size);
+
+  std::vector<QueueItem *> ring (capacity, 0);
+  for (uint32_t i = 0, j = m_head; i < m_size; i++)
+    {
+      ring[i] = m_ring[j];
+      if (++j == m_ring.size ())
+        {
+          j = 0;
+        }
+    }
+  m_ring.swap (ring);
+  m_head = 0;
+}
+
+void
+RingBufferQueue::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  while (m_size > 0)
+    {
+      Pop ();
+    }
+  m_ring.clear ();
+  m_head = 0;
+}
+
+} // namespace ns3
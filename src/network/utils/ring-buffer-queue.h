@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RING_BUFFER_QUEUE_H
+#define RING_BUFFER_QUEUE_H
+
+#include <vector>
+#include "ns3/queue.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup queue
+ *
+ * \brief A FIFO packet queue that drops tail-end packets on overflow and
+ * stores the items in a circular buffer
+ *
+ * RingBufferQueue behaves as a DropTailQueue, but the items are stored in a
+ * contiguous circular buffer rather than in a std::deque, thus enqueue and
+ * dequeue operations never allocate memory once the buffer has been sized.
+ * In packet mode, the buffer is sized from the MaxPackets attribute the
+ * first time an item is enqueued (and resized if MaxPackets is increased
+ * afterwards). In byte mode, the buffer doubles its size when it is full.
+ *
+ * The buffer holds a reference to each item, which is transferred to the
+ * caller on dequeue without incrementing and decrementing the reference
+ * count.
+ */
+class RingBufferQueue : public Queue
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief RingBufferQueue Constructor
+   *
+   * Creates a ring buffer queue with a maximum size of 100 packets by default
+   */
+  RingBufferQueue ();
+
+  virtual ~RingBufferQueue ();
+
+  /**
+   * \brief Get the number of items the circular buffer can store without
+   * being resized
+   * \return the capacity of the circular buffer
+   */
+  uint32_t GetCapacity (void) const;
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueItem> item);
+  virtual Ptr<QueueItem> DoDequeue (void);
+  virtual Ptr<QueueItem> DoRemove (void);
+  virtual Ptr<const QueueItem> DoPeek (void) const;
+
+  /**
+   * \brief Take the item at the head of the buffer, along with the
+   * reference held by the buffer
+   * \return the item at the head of the buffer
+   */
+  Ptr<QueueItem> Pop (void);
+  /**
+   * \brief Resize the circular buffer, keeping the stored items in order
+   * \param capacity the new capacity, which must not be smaller than the
+   *        number of stored items
+   */
+  void Resize (uint32_t capacity);
+  /**
+   * \brief Release the references to the stored items and empty the buffer
+   */
+  void Clear (void);
+
+  std::vector<QueueItem *> m_ring; //!< the circular buffer
+  uint32_t m_head;                 //!< index of the oldest item
+  uint32_t m_size;                 //!< number of items in the buffer
+};
+
+} // namespace ns3
+
+#endif /* RING_BUFFER_QUEUE_H */
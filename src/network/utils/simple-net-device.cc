@@ -27,6 +27,8 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/boolean.h"
 #include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/object-factory.h"
 #include "ns3/tag.h"
 #include "ns3/simulator.h"
 #include "ns3/drop-tail-queue.h"
@@ -205,6 +207,11 @@ SimpleNetDevice::GetTypeId (void)
                    StringValue ("ns3::DropTailQueue"),
                    MakePointerAccessor (&SimpleNetDevice::m_queue),
                    MakePointerChecker<Queue> ())
+    .AddAttribute ("NTxQueues",
+                   "The number of transmission queues exposed to the traffic control layer",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&SimpleNetDevice::m_nTxQueues),
+                   MakeUintegerChecker<uint8_t> (1))
     .AddAttribute ("DataRate",
                    "The default data rate for point to point links. Zero means infinite",
                    DataRateValue (DataRate ("0b/s")),
@@ -224,7 +231,8 @@ SimpleNetDevice::SimpleNetDevice ()
     m_node (0),
     m_mtu (0xffff),
     m_ifIndex (0),
-    m_linkUp (false)
+    m_linkUp (false),
+    m_lastTxQueue (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -287,6 +295,19 @@ SimpleNetDevice::GetQueue () const
   return m_queue;
 }
 
+Ptr<Queue>
+SimpleNetDevice::GetTxQueue (uint8_t i) const
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (i));
+  if (i == 0)
+    {
+      return m_queue;
+    }
+  NS_ASSERT_MSG (i <= m_txQueues.size (), "Transmission queue " << static_cast<uint32_t> (i)
+                 << " does not exist");
+  return m_txQueues[i - 1];
+}
+
 void
 SimpleNetDevice::SetQueue (Ptr<Queue> q)
 {
@@ -428,6 +449,21 @@ bool
 SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address& dest, uint16_t protocolNumber)
 {
   NS_LOG_FUNCTION (this << p << source << dest << protocolNumber);
+  return DoSendFrom (p, source, dest, protocolNumber, 0);
+}
+
+bool
+SimpleNetDevice::SendToTxQueue (Ptr<Packet> p, const Address& dest, uint16_t protocolNumber, uint8_t txq)
+{
+  NS_LOG_FUNCTION (this << p << dest << protocolNumber << static_cast<uint32_t> (txq));
+  return DoSendFrom (p, m_address, dest, protocolNumber, txq);
+}
+
+bool
+SimpleNetDevice::DoSendFrom (Ptr<Packet> p, const Address& source, const Address& dest,
+                             uint16_t protocolNumber, uint8_t txq)
+{
+  NS_LOG_FUNCTION (this << p << source << dest << protocolNumber << static_cast<uint32_t> (txq));
   if (p->GetSize () > GetMtu ())
     {
       return false;
@@ -444,11 +480,20 @@ SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address&
 
   p->AddPacketTag (tag);
 
-  if (m_queue->Enqueue (Create<QueueItem> (p)))
+  Ptr<Queue> queue = GetTxQueue (txq);
+  if (queue->Enqueue (Create<QueueItem> (p)))
     {
-      if (m_queue->GetNPackets () == 1 && !TransmitCompleteEvent.IsRunning ())
+      Ptr<NetDeviceQueue> devQueue;
+      if (m_queueInterface)
+        {
+          devQueue = m_queueInterface->GetTxQueue (txq);
+          devQueue->NotifyQueuedBytes (p->GetSize ());
+        }
+      // the other device queues are empty if no transmission is ongoing
+      if (queue->GetNPackets () == 1 && !TransmitCompleteEvent.IsRunning ())
         {
-          p = m_queue->Dequeue ()->GetPacket ();
+          p = queue->Dequeue ()->GetPacket ();
+          m_lastTxQueue = txq;
           p->RemovePacketTag (tag);
           Time txTime = Time (0);
           if (m_bps > DataRate (0))
@@ -457,6 +502,11 @@ SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address&
             }
           m_channel->Send (p, protocolNumber, to, from, this);
           TransmitCompleteEvent = Simulator::Schedule (txTime, &SimpleNetDevice::TransmitComplete, this);
+          // The packet leaves the device when it is handed to the channel
+          if (devQueue)
+            {
+              devQueue->NotifyTransmittedBytes (p->GetSize ());
+            }
         }
       return true;
     }
@@ -466,19 +516,142 @@ SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address&
   return true;
 }
 
+uint32_t
+SimpleNetDevice::SendBatch (std::vector<BatchItem> &batch)
+{
+  NS_LOG_FUNCTION (this << batch.size ());
+
+  // Enqueue all the packets first, then notify the queue limits and start
+  // the transmission only once for the whole batch
+  uint32_t sent = 0;
+  uint32_t bytes = 0;
+  for (; sent < batch.size (); sent++)
+    {
+      Ptr<Packet> p = batch[sent].packet;
+      if (p->GetSize () > GetMtu ())
+        {
+          break;
+        }
+
+      SimpleTag tag;
+      tag.SetSrc (m_address);
+      tag.SetDst (Mac48Address::ConvertFrom (batch[sent].dest));
+      tag.SetProto (batch[sent].protocolNumber);
+
+      p->AddPacketTag (tag);
+
+      if (m_queue->Enqueue (Create<QueueItem> (p)))
+        {
+          bytes += p->GetSize ();
+        }
+      else
+        {
+          // As in SendFrom, the packet is sent anyway
+          p->RemovePacketTag (tag);
+          m_channel->Send (p, tag.GetProto (), tag.GetDst (), tag.GetSrc (), this);
+        }
+    }
+
+  Ptr<NetDeviceQueue> txq;
+  if (m_queueInterface)
+    {
+      txq = m_queueInterface->GetTxQueue (0);
+      txq->NotifyQueuedBytes (bytes);
+    }
+
+  if (m_queue->GetNPackets () && !TransmitCompleteEvent.IsRunning ())
+    {
+      Ptr<Packet> packet = m_queue->Dequeue ()->GetPacket ();
+      SimpleTag tag;
+      packet->RemovePacketTag (tag);
+      Time txTime = Time (0);
+      if (m_bps > DataRate (0))
+        {
+          txTime = m_bps.CalculateBytesTxTime (packet->GetSize ());
+        }
+      m_channel->Send (packet, tag.GetProto (), tag.GetDst (), tag.GetSrc (), this);
+      TransmitCompleteEvent = Simulator::Schedule (txTime, &SimpleNetDevice::TransmitComplete, this);
+      if (txq)
+        {
+          txq->NotifyTransmittedBytes (packet->GetSize ());
+        }
+    }
+  return sent;
+}
+
+uint32_t
+SimpleNetDevice::GetMaxSendBatchSize (void) const
+{
+  uint32_t room = 0;
+  if (m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS)
+    {
+      if (m_queue->GetNPackets () < m_queue->GetMaxPackets ())
+        {
+          room = m_queue->GetMaxPackets () - m_queue->GetNPackets ();
+        }
+    }
+  else if (m_queue->GetNBytes () + m_mtu <= m_queue->GetMaxBytes ())
+    {
+      // assume MTU-sized packets
+      room = (m_queue->GetMaxBytes () - m_queue->GetNBytes ()) / m_mtu;
+    }
+  // the first packet is transmitted right away if no transmission is ongoing
+  if (room && !TransmitCompleteEvent.IsRunning ())
+    {
+      room++;
+    }
+  return room;
+}
+
+
+Ptr<Packet>
+SimpleNetDevice::DequeueNext (uint8_t &txq)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t nTxQueues = m_txQueues.size () + 1;
+  for (uint32_t i = 1; i <= nTxQueues; i++)
+    {
+      txq = (m_lastTxQueue + i) % nTxQueues;
+      Ptr<QueueItem> item = GetTxQueue (txq)->Dequeue ();
+      if (item != 0)
+        {
+          m_lastTxQueue = txq;
+          return item->GetPacket ();
+        }
+    }
+  return 0;
+}
+
+bool
+SimpleNetDevice::HasQueuedPackets (void) const
+{
+  if (m_queue->GetNPackets ())
+    {
+      return true;
+    }
+  for (uint32_t i = 0; i < m_txQueues.size (); i++)
+    {
+      if (m_txQueues[i]->GetNPackets ())
+        {
+          return true;
+        }
+    }
+  return false;
+}
 
 void
 SimpleNetDevice::TransmitComplete ()
 {
   NS_LOG_FUNCTION (this);
 
-  if (m_queue->GetNPackets () == 0)
+  uint8_t txq;
+  Ptr<Packet> packet = DequeueNext (txq);
+  if (packet == 0)
     {
       return;
     }
 
-  Ptr<Packet> packet = m_queue->Dequeue ()->GetPacket ();
-
   SimpleTag tag;
   packet->RemovePacketTag (tag);
 
@@ -488,7 +661,7 @@ SimpleNetDevice::TransmitComplete ()
 
   m_channel->Send (packet, proto, dst, src, this);
 
-  if (m_queue->GetNPackets ())
+  if (HasQueuedPackets ())
     {
       Time txTime = Time (0);
       if (m_bps > DataRate (0))
@@ -498,7 +671,12 @@ SimpleNetDevice::TransmitComplete ()
       TransmitCompleteEvent = Simulator::Schedule (txTime, &SimpleNetDevice::TransmitComplete, this);
     }
 
-  return;
+  // Notify the queue limits only now that the next transmission (if any) has
+  // been scheduled, since this may wake the upper layers up
+  if (m_queueInterface)
+    {
+      m_queueInterface->GetTxQueue (txq)->NotifyTransmittedBytes (packet->GetSize ());
+    }
 }
 
 Ptr<Node> 
@@ -537,7 +715,13 @@ SimpleNetDevice::DoDispose (void)
   m_channel = 0;
   m_node = 0;
   m_receiveErrorModel = 0;
+  m_queueInterface = 0;
   m_queue->DequeueAll ();
+  for (uint32_t i = 0; i < m_txQueues.size (); i++)
+    {
+      m_txQueues[i]->DequeueAll ();
+    }
+  m_txQueues.clear ();
   if (TransmitCompleteEvent.IsRunning ())
     {
       TransmitCompleteEvent.Cancel ();
@@ -546,6 +730,36 @@ SimpleNetDevice::DoDispose (void)
 }
 
 
+void
+SimpleNetDevice::NotifyNewAggregate (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_queueInterface == 0)
+    {
+      Ptr<NetDeviceQueueInterface> ndqi = this->GetObject<NetDeviceQueueInterface> ();
+      //verify that it's a valid netdevice queue interface and that
+      //the netdevice queue interface was not set before
+      if (ndqi != 0)
+        {
+          m_queueInterface = ndqi;
+          // expose the transmission queues, each with a device queue
+          // configured as the TxQueue
+          ndqi->SetTxQueuesN (m_nTxQueues);
+          ObjectFactory factory;
+          factory.SetTypeId (m_queue->GetInstanceTypeId ());
+          for (uint32_t i = 1; i < m_nTxQueues; i++)
+            {
+              Ptr<Queue> queue = factory.Create<Queue> ();
+              queue->SetMode (m_queue->GetMode ());
+              queue->SetMaxPackets (m_queue->GetMaxPackets ());
+              queue->SetMaxBytes (m_queue->GetMaxBytes ());
+              m_txQueues.push_back (queue);
+            }
+        }
+    }
+  NetDevice::NotifyNewAggregate ();
+}
+
 void
 SimpleNetDevice::SetPromiscReceiveCallback (PromiscReceiveCallback cb)
 {
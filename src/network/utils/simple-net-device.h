@@ -50,6 +50,12 @@ class ErrorModel;
  *
  * By default the device is in Broadcast mode, with infinite bandwidth.
  *
+ * The device may expose multiple transmission queues (NTxQueues attribute)
+ * to the traffic control layer, each with its own device queue. The
+ * packets are taken from the device queues in a round robin fashion. The
+ * additional device queues are created, with the same type and limits as
+ * the TxQueue, when the traffic control layer sets up the device.
+ *
  * \brief simple net device for simple things and testing
  */
 class SimpleNetDevice : public NetDevice
@@ -97,6 +103,15 @@ public:
    */
   Ptr<Queue> GetQueue (void) const;
 
+  /**
+   * Get the device queue of the given transmission queue. The device queue
+   * of the first transmission queue is the one returned by GetQueue.
+   *
+   * \param i the index of the transmission queue
+   * \returns Ptr to the queue.
+   */
+  Ptr<Queue> GetTxQueue (uint8_t i) const;
+
   /**
    * Attach a receive ErrorModel to the SimpleNetDevice.
    *
@@ -126,6 +141,9 @@ public:
   virtual bool IsBridge (void) const;
   virtual bool Send (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber);
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber);
+  virtual bool SendToTxQueue (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber, uint8_t txq);
+  virtual uint32_t SendBatch (std::vector<BatchItem> &batch);
+  virtual uint32_t GetMaxSendBatchSize (void) const;
   virtual Ptr<Node> GetNode (void) const;
   virtual void SetNode (Ptr<Node> node);
   virtual bool NeedsArp (void) const;
@@ -138,6 +156,7 @@ public:
 
 protected:
   virtual void DoDispose (void);
+  virtual void NotifyNewAggregate (void);
 private:
   Ptr<SimpleChannel> m_channel; //!< the channel the device is connected to
   NetDevice::ReceiveCallback m_rxCallback; //!< Receive callback
@@ -164,6 +183,32 @@ private:
    */
   void TransmitComplete (void);
 
+  /**
+   * Send a packet through the given transmission queue.
+   *
+   * \param packet packet sent from above down to Network Device
+   * \param source source mac address
+   * \param dest mac address of the destination
+   * \param protocolNumber the type of payload contained in this packet
+   * \param txq the index of the transmission queue
+   * \return whether the Send operation succeeded
+   */
+  bool DoSendFrom (Ptr<Packet> packet, const Address& source, const Address& dest,
+                   uint16_t protocolNumber, uint8_t txq);
+
+  /**
+   * Dequeue a packet from the device queues in a round robin fashion.
+   *
+   * \param txq the index of the transmission queue the packet is taken from
+   * \return the packet, or 0 if all the device queues are empty
+   */
+  Ptr<Packet> DequeueNext (uint8_t &txq);
+
+  /**
+   * \return true if any device queue holds packets
+   */
+  bool HasQueuedPackets (void) const;
+
   bool m_linkUp; //!< Flag indicating whether or not the link is up
 
   /**
@@ -173,6 +218,10 @@ private:
   bool m_pointToPointMode;
 
   Ptr<Queue> m_queue; //!< The Queue for outgoing packets.
+  uint8_t m_nTxQueues; //!< The number of transmission queues
+  std::vector<Ptr<Queue> > m_txQueues; //!< The Queues of the transmission queues but the first one
+  uint8_t m_lastTxQueue; //!< The transmission queue of the last packet sent
+  Ptr<NetDeviceQueueInterface> m_queueInterface; //!< NetDevice queue interface (for Byte Queue Limits)
   DataRate m_bps; //!< The device nominal Data rate. Zero means infinite
   EventId TransmitCompleteEvent; //!< the Tx Complete event
 
@@ -21,6 +21,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
+#include "ns3/multithreaded-simulator-impl.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -96,13 +97,29 @@ PointToPointChannel::TransmitStart (
   NS_ASSERT (m_link[1].m_state != INITIALIZING);
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
-
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
-                                  txTime + m_delay, &PointToPointNetDevice::Receive,
-                                  m_link[wire].m_dst, p);
+  PointToPointNetDevice *dst = PeekPointer (m_link[wire].m_dst);
+
+  // The receiver may be executed concurrently by another thread (see
+  // MultithreadedSimulatorImpl::IsRemoteContext).  The reference counts
+  // are not atomic, so the pointer to its node is not copied, and neither
+  // the packet nor the pointer to its device is shared with it.
+  uint32_t context = dst->m_node->GetId ();
+  if (MultithreadedSimulatorImpl::IsRemoteContext (context))
+    {
+      Simulator::ScheduleWithContext (context, txTime + m_delay, &PointToPointNetDevice::Receive,
+                                      dst, p->CreateUnsharedCopy ());
+    }
+  else
+    {
+      Simulator::ScheduleWithContext (context, txTime + m_delay, &PointToPointNetDevice::Receive,
+                                      m_link[wire].m_dst, p);
+    }
 
   // Call the tx anim callback on the net device
-  m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+  if (!m_txrxPointToPoint.IsEmpty ())
+    {
+      m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+    }
   return true;
 }
 
@@ -25,6 +25,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/object-factory.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
@@ -77,6 +78,11 @@ PointToPointNetDevice::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&PointToPointNetDevice::m_queue),
                    MakePointerChecker<Queue> ())
+    .AddAttribute ("NTxQueues",
+                   "The number of transmission queues exposed to the traffic control layer",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&PointToPointNetDevice::m_nTxQueues),
+                   MakeUintegerChecker<uint8_t> (1))
 
     //
     // Trace sources at the "top" of the net device, where packets transition
@@ -176,6 +182,7 @@ PointToPointNetDevice::PointToPointNetDevice ()
   :
     m_txMachineState (READY),
     m_channel (0),
+    m_currentTxQueue (0),
     m_linkUp (false),
     m_currentPkt (0)
 {
@@ -218,6 +225,19 @@ PointToPointNetDevice::NotifyNewAggregate (void)
       if (ndqi != 0)
         {
           m_queueInterface = ndqi;
+          // expose the transmission queues, each with a device queue
+          // configured as the TxQueue
+          ndqi->SetTxQueuesN (m_nTxQueues);
+          ObjectFactory factory;
+          factory.SetTypeId (m_queue->GetInstanceTypeId ());
+          for (uint32_t i = 1; i < m_nTxQueues; i++)
+            {
+              Ptr<Queue> queue = factory.Create<Queue> ();
+              queue->SetMode (m_queue->GetMode ());
+              queue->SetMaxPackets (m_queue->GetMaxPackets ());
+              queue->SetMaxBytes (m_queue->GetMaxBytes ());
+              m_txQueues.push_back (queue);
+            }
         }
     }
   NetDevice::NotifyNewAggregate ();
@@ -232,6 +252,7 @@ PointToPointNetDevice::DoDispose ()
   m_receiveErrorModel = 0;
   m_currentPkt = 0;
   m_queue = 0;
+  m_txQueues.clear ();
   m_queueInterface = 0;
   NetDevice::DoDispose ();
 }
@@ -297,23 +318,28 @@ PointToPointNetDevice::TransmitComplete (void)
   NS_ASSERT_MSG (m_currentPkt != 0, "PointToPointNetDevice::TransmitComplete(): m_currentPkt zero");
 
   m_phyTxEndTrace (m_currentPkt);
+  uint32_t txBytes = m_currentPkt->GetSize ();
   m_currentPkt = 0;
 
   Ptr<NetDeviceQueue> txq;
   if (m_queueInterface)
   {
-    txq = m_queueInterface->GetTxQueue (0);
+    txq = m_queueInterface->GetTxQueue (m_currentTxQueue);
   }
 
-  Ptr<QueueItem> item = m_queue->Dequeue ();
-  if (item == 0)
+  uint8_t next;
+  Ptr<Packet> p = DequeueNext (next);
+  if (p == 0)
     {
       NS_LOG_LOGIC ("No pending packets in device queue after tx complete");
       if (txq)
       {
-        NS_LOG_DEBUG ("The device queue is being woken up (" << m_queue->GetNPackets () <<
-                      " packets and " << m_queue->GetNBytes () << " bytes inside)");
-        txq->Wake ();
+        NS_LOG_DEBUG ("The device queues are being woken up");
+        for (uint8_t i = 0; i < m_queueInterface->GetNTxQueues (); i++)
+          {
+            m_queueInterface->GetTxQueue (i)->Wake ();
+          }
+        txq->NotifyTransmittedBytes (txBytes);
       }
       return;
     }
@@ -325,22 +351,48 @@ PointToPointNetDevice::TransmitComplete (void)
   // to the device while the machine state is busy, thus causing the assert in
   // TransmitStart to fail.
   //
-  if (txq && txq->IsStopped ())
+  Ptr<Queue> queue = GetTxQueue (next);
+  if (m_queueInterface && m_queueInterface->GetTxQueue (next)->IsStopped ())
     {
-      if ((m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
-           m_queue->GetNPackets () < m_queue->GetMaxPackets ()) ||
-          (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
-           m_queue->GetNBytes () + m_mtu <= m_queue->GetMaxBytes ()))
+      if ((queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
+           queue->GetNPackets () < queue->GetMaxPackets ()) ||
+          (queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
+           queue->GetNBytes () + m_mtu <= queue->GetMaxBytes ()))
         {
-          NS_LOG_DEBUG ("The device queue is being started (" << m_queue->GetNPackets () <<
-                        " packets and " << m_queue->GetNBytes () << " bytes inside)");
-          txq->Start ();
+          NS_LOG_DEBUG ("The device queue is being started (" << queue->GetNPackets () <<
+                        " packets and " << queue->GetNBytes () << " bytes inside)");
+          m_queueInterface->GetTxQueue (next)->Start ();
         }
     }
-  Ptr<Packet> p = item->GetPacket ();
   m_snifferTrace (p);
   m_promiscSnifferTrace (p);
   TransmitStart (p);
+
+  // Report the completed transmission to the queue limits only now that the
+  // machine state is busy again, since this may wake the upper layers
+  if (txq)
+    {
+      txq->NotifyTransmittedBytes (txBytes);
+    }
+}
+
+Ptr<Packet>
+PointToPointNetDevice::DequeueNext (uint8_t &txq)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t nTxQueues = m_txQueues.size () + 1;
+  for (uint32_t i = 1; i <= nTxQueues; i++)
+    {
+      txq = (m_currentTxQueue + i) % nTxQueues;
+      Ptr<QueueItem> item = GetTxQueue (txq)->Dequeue ();
+      if (item != 0)
+        {
+          m_currentTxQueue = txq;
+          return item->GetPacket ();
+        }
+    }
+  return 0;
 }
 
 bool
@@ -432,6 +484,19 @@ PointToPointNetDevice::GetQueue (void) const
   return m_queue;
 }
 
+Ptr<Queue>
+PointToPointNetDevice::GetTxQueue (uint8_t i) const
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (i));
+  if (i == 0)
+    {
+      return m_queue;
+    }
+  NS_ASSERT_MSG (i <= m_txQueues.size (), "Transmission queue " << static_cast<uint32_t> (i)
+                 << " does not exist");
+  return m_txQueues[i - 1];
+}
+
 void
 PointToPointNetDevice::NotifyLinkUp (void)
 {
@@ -555,16 +620,28 @@ PointToPointNetDevice::Send (
   Ptr<Packet> packet, 
   const Address &dest, 
   uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packet << dest << protocolNumber);
+  return SendToTxQueue (packet, dest, protocolNumber, 0);
+}
+
+bool
+PointToPointNetDevice::SendToTxQueue (
+  Ptr<Packet> packet,
+  const Address &dest,
+  uint16_t protocolNumber,
+  uint8_t index)
 {
   Ptr<NetDeviceQueue> txq;
   if (m_queueInterface)
   {
-    txq = m_queueInterface->GetTxQueue (0);
+    txq = m_queueInterface->GetTxQueue (index);
   }
 
   NS_ASSERT_MSG (!txq || !txq->IsStopped (), "Send should not be called when the device is stopped");
 
-  NS_LOG_FUNCTION (this << packet << dest << protocolNumber);
+  NS_LOG_FUNCTION (this << packet << dest << protocolNumber << static_cast<uint32_t> (index));
+  Ptr<Queue> queue = GetTxQueue (index);
   NS_LOG_LOGIC ("p=" << packet << ", dest=" << &dest);
   NS_LOG_LOGIC ("UID is " << packet->GetUid ());
 
@@ -589,25 +666,31 @@ PointToPointNetDevice::Send (
   //
   // We should enqueue and dequeue the packet to hit the tracing hooks.
   //
-  if (m_queue->Enqueue (Create<QueueItem> (packet)))
+  if (queue->Enqueue (Create<QueueItem> (packet)))
     {
+      if (txq)
+        {
+          txq->NotifyQueuedBytes (packet->GetSize ());
+        }
+
       //
       // If the channel is ready for transition we send the packet right now
       // 
       if (m_txMachineState == READY)
         {
-          packet = m_queue->Dequeue ()->GetPacket ();
+          packet = queue->Dequeue ()->GetPacket ();
+          m_currentTxQueue = index;
           // We have enqueued a packet and dequeued a (possibly different) packet. We
           // need to check if there is still room for another packet only if the queue
           // is in byte mode (the enqueued packet might be larger than the dequeued
           // packet, thus leaving no room for another packet)
           if (txq)
             {
-              if (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
-                  m_queue->GetNBytes () + m_mtu > m_queue->GetMaxBytes ())
+              if (queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
+                  queue->GetNBytes () + m_mtu > queue->GetMaxBytes ())
                 {
-                  NS_LOG_DEBUG ("The device queue is being stopped (" << m_queue->GetNPackets () <<
-                                " packets and " << m_queue->GetNBytes () << " bytes inside)");
+                  NS_LOG_DEBUG ("The device queue is being stopped (" << queue->GetNPackets () <<
+                                " packets and " << queue->GetNBytes () << " bytes inside)");
                   txq->Stop ();
                 }
             }
@@ -620,13 +703,13 @@ PointToPointNetDevice::Send (
       // we stop the queue
       if (txq)
         {
-          if ((m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
-               m_queue->GetNPackets () >= m_queue->GetMaxPackets ()) ||
-              (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
-               m_queue->GetNBytes () + m_mtu > m_queue->GetMaxBytes ()))
+          if ((queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
+               queue->GetNPackets () >= queue->GetMaxPackets ()) ||
+              (queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
+               queue->GetNBytes () + m_mtu > queue->GetMaxBytes ()))
             {
-              NS_LOG_DEBUG ("The device queue is being stopped (" << m_queue->GetNPackets () <<
-                            " packets and " << m_queue->GetNBytes () << " bytes inside)");
+              NS_LOG_DEBUG ("The device queue is being stopped (" << queue->GetNPackets () <<
+                            " packets and " << queue->GetNBytes () << " bytes inside)");
               txq->Stop ();
             }
         }
@@ -639,13 +722,123 @@ PointToPointNetDevice::Send (
   m_macTxDropTrace (packet);
   if (txq)
   {
-    NS_LOG_ERROR ("BUG! Device queue full when the queue is not stopped! (" << m_queue->GetNPackets () <<
-                  " packets and " << m_queue->GetNBytes () << " bytes inside)");
+    NS_LOG_ERROR ("BUG! Device queue full when the queue is not stopped! (" << queue->GetNPackets () <<
+                  " packets and " << queue->GetNBytes () << " bytes inside)");
     txq->Stop ();
   }
   return false;
 }
 
+uint32_t
+PointToPointNetDevice::SendBatch (std::vector<BatchItem> &batch)
+{
+  Ptr<NetDeviceQueue> txq;
+  if (m_queueInterface)
+  {
+    txq = m_queueInterface->GetTxQueue (0);
+  }
+
+  NS_ASSERT_MSG (!txq || !txq->IsStopped (), "Send should not be called when the device is stopped");
+
+  NS_LOG_FUNCTION (this << batch.size ());
+
+  if (batch.empty ())
+    {
+      return 0;
+    }
+
+  if (IsLinkUp () == false)
+    {
+      m_macTxDropTrace (batch[0].packet);
+      return 0;
+    }
+
+  //
+  // Enqueue the packets as long as there is room in the queue. The first
+  // packet is transmitted right away if the channel is ready, while notifying
+  // the queue limits and checking whether the queue has to be stopped is done
+  // once for the whole batch.
+  //
+  uint32_t sent = 0;
+  uint32_t bytes = 0;
+  while (sent < batch.size () &&
+         ((m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
+           m_queue->GetNPackets () < m_queue->GetMaxPackets ()) ||
+          (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
+           m_queue->GetNBytes () + m_mtu <= m_queue->GetMaxBytes ())))
+    {
+      Ptr<Packet> packet = batch[sent].packet;
+      AddHeader (packet, batch[sent].protocolNumber);
+      m_macTxTrace (packet);
+
+      if (!m_queue->Enqueue (Create<QueueItem> (packet)))
+        {
+          // As in Send, stop the tx queue, so that the upper layers do not
+          // send packets until there is room in the queue again
+          m_macTxDropTrace (packet);
+          if (txq)
+            {
+              NS_LOG_ERROR ("BUG! Device queue full when the queue is not stopped! (" << m_queue->GetNPackets () <<
+                            " packets and " << m_queue->GetNBytes () << " bytes inside)");
+              txq->Stop ();
+            }
+          break;
+        }
+      bytes += packet->GetSize ();
+      sent++;
+
+      if (m_txMachineState == READY)
+        {
+          packet = m_queue->Dequeue ()->GetPacket ();
+          m_snifferTrace (packet);
+          m_promiscSnifferTrace (packet);
+          TransmitStart (packet);
+        }
+    }
+
+  if (txq)
+    {
+      if (bytes)
+        {
+          txq->NotifyQueuedBytes (bytes);
+        }
+      if ((m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
+           m_queue->GetNPackets () >= m_queue->GetMaxPackets ()) ||
+          (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
+           m_queue->GetNBytes () + m_mtu > m_queue->GetMaxBytes ()))
+        {
+          NS_LOG_DEBUG ("The device queue is being stopped (" << m_queue->GetNPackets () <<
+                        " packets and " << m_queue->GetNBytes () << " bytes inside)");
+          txq->Stop ();
+        }
+    }
+  return sent;
+}
+
+uint32_t
+PointToPointNetDevice::GetMaxSendBatchSize (void) const
+{
+  uint32_t room = 0;
+  if (m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS)
+    {
+      if (m_queue->GetNPackets () < m_queue->GetMaxPackets ())
+        {
+          room = m_queue->GetMaxPackets () - m_queue->GetNPackets ();
+        }
+    }
+  else if (m_queue->GetNBytes () + m_mtu <= m_queue->GetMaxBytes ())
+    {
+      // assume MTU-sized packets
+      room = (m_queue->GetMaxBytes () - m_queue->GetNBytes ()) / m_mtu;
+    }
+  // the first packet is transmitted right away if the channel is ready
+  if (room && m_txMachineState == READY)
+    {
+      room++;
+    }
+  return room;
+}
+
 bool
 PointToPointNetDevice::SendFrom (Ptr<Packet> packet, 
                                  const Address &source, 
@@ -58,6 +58,13 @@ class ErrorModel;
  * Key parameters or objects that can be specified for this device 
  * include a queue, data rate, and interframe transmission gap (the 
  * propagation delay is set in the PointToPointChannel).
+ *
+ * The device may expose multiple transmission queues (NTxQueues attribute)
+ * to the traffic control layer, each with its own device queue, which is
+ * stopped and started independently of the others. The packets are taken
+ * from the device queues in a round robin fashion. The additional device
+ * queues are created, with the same type and limits as the TxQueue, when
+ * the traffic control layer sets up the device.
  */
 class PointToPointNetDevice : public NetDevice
 {
@@ -127,6 +134,15 @@ public:
    */
   Ptr<Queue> GetQueue (void) const;
 
+  /**
+   * Get the device queue of the given transmission queue. The device queue
+   * of the first transmission queue is the one returned by GetQueue.
+   *
+   * \param i the index of the transmission queue
+   * \returns Ptr to the queue.
+   */
+  Ptr<Queue> GetTxQueue (uint8_t i) const;
+
   /**
    * Attach a receive ErrorModel to the PointToPointNetDevice.
    *
@@ -177,6 +193,9 @@ public:
 
   virtual bool Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber);
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber);
+  virtual bool SendToTxQueue (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber, uint8_t txq);
+  virtual uint32_t SendBatch (std::vector<BatchItem> &batch);
+  virtual uint32_t GetMaxSendBatchSize (void) const;
 
   virtual Ptr<Node> GetNode (void) const;
   virtual void SetNode (Ptr<Node> node);
@@ -227,6 +246,11 @@ private:
   virtual void DoDispose (void);
 
 private:
+  /**
+   * The channel reads the node of the receiving device without copying
+   * its pointer, see PointToPointChannel::TransmitStart.
+   */
+  friend class PointToPointChannel;
 
   /**
    * \returns the address of the remote device connected to this device
@@ -277,6 +301,14 @@ private:
    */
   void TransmitComplete (void);
 
+  /**
+   * Dequeue a packet from the device queues in a round robin fashion.
+   *
+   * \param txq the index of the transmission queue the packet is taken from
+   * \return the packet, or 0 if all the device queues are empty
+   */
+  Ptr<Packet> DequeueNext (uint8_t &txq);
+
   /**
    * \brief Make the link up and running
    *
@@ -323,6 +355,10 @@ private:
    */
   Ptr<Queue> m_queue;
 
+  uint8_t m_nTxQueues;                  //!< The number of transmission queues
+  std::vector<Ptr<Queue> > m_txQueues;  //!< The Queues of the transmission queues but the first one
+  uint8_t m_currentTxQueue;             //!< The transmission queue of the packet being transmitted
+
   /**
    * Error model for receive packet events
    */
@@ -92,6 +92,13 @@ PppHeader::Deserialize (Buffer::Iterator start)
   return GetSerializedSize ();
 }
 
+bool
+PppHeader::CopyTo (Header &header) const
+{
+  static_cast<PppHeader &> (header) = *this;
+  return true;
+}
+
 void
 PppHeader::SetProtocol (uint16_t protocol)
 {
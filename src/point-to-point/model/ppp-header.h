@@ -78,6 +78,7 @@ public:
   virtual void Serialize (Buffer::Iterator start) const;
   virtual uint32_t Deserialize (Buffer::Iterator start);
   virtual uint32_t GetSerializedSize (void) const;
+  virtual bool CopyTo (Header &header) const;
 
   /**
    * \brief Set the protocol type carried by this PPP packet
@@ -23,6 +23,14 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/config.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace ns3;
 
@@ -100,6 +108,268 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test class for the transmission queues of a multi-queue
+ * PointToPoint device
+ *
+ * It fills the device queue of a transmission queue and checks that only
+ * that transmission queue is stopped, and that all the packets are
+ * transmitted.
+ */
+class PointToPointMultiQueueTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultiQueueTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Receive callback
+   *
+   * \param device the receiving device
+   * \param packet the received packet
+   * \param protocol the protocol
+   * \param from the sender
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  uint32_t m_received; //!< Packets received
+};
+
+PointToPointMultiQueueTest::PointToPointMultiQueueTest ()
+  : TestCase ("PointToPoint multi-queue"),
+    m_received (0)
+{
+}
+
+bool
+PointToPointMultiQueueTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                     uint16_t protocol, const Address &from)
+{
+  m_received++;
+  return true;
+}
+
+void
+PointToPointMultiQueueTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  Ptr<Queue> queue = CreateObject<DropTailQueue> ();
+  queue->SetMaxPackets (2);
+  devA->SetQueue (queue);
+  devA->SetAttribute ("NTxQueues", UintegerValue (2));
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointMultiQueueTest::Receive, this));
+
+  Ptr<NetDeviceQueueInterface> ifaceA = CreateObject<NetDeviceQueueInterface> ();
+  devA->AggregateObject (ifaceA);
+  ifaceA->CreateTxQueues ();
+  NS_TEST_ASSERT_MSG_EQ (ifaceA->GetNTxQueues (), 2, "The device should have two transmission queues");
+  NS_TEST_ASSERT_MSG_EQ (devA->GetTxQueue (1)->GetMaxPackets (), 2, "The device queues should have the same limits");
+
+  // the first packet is transmitted right away, the next two fill the
+  // device queue of the first transmission queue
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (devA->SendToTxQueue (Create<Packet> (100), devB->GetAddress (), 0x800, 0),
+                             true, "The packet should be accepted");
+    }
+  NS_TEST_EXPECT_MSG_EQ (ifaceA->GetTxQueue (0)->IsStopped (), true, "The first queue should be stopped");
+  NS_TEST_EXPECT_MSG_EQ (ifaceA->GetTxQueue (1)->IsStopped (), false, "The second queue should not be stopped");
+  NS_TEST_EXPECT_MSG_EQ (devA->SendToTxQueue (Create<Packet> (100), devB->GetAddress (), 0x800, 1),
+                         true, "The packet should be accepted");
+  NS_TEST_EXPECT_MSG_EQ (devA->GetQueue ()->GetNPackets (), 2, "Wrong number of packets in the first queue");
+  NS_TEST_EXPECT_MSG_EQ (devA->GetTxQueue (1)->GetNPackets (), 1, "Wrong number of packets in the second queue");
+
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, 4, "Not all the packets have been received");
+  NS_TEST_EXPECT_MSG_EQ (ifaceA->GetTxQueue (0)->IsStopped (), false, "The first queue should have been woken");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test class for PointToPoint links between the partitions of a
+ * MultithreadedSimulatorImpl
+ *
+ * It forwards packets both ways along a chain of nodes, once with the
+ * DefaultSimulatorImpl and once with the MultithreadedSimulatorImpl, which
+ * runs each node in its own partition, and checks that every node receives
+ * the same packets at the same times in both runs.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedTest ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * \brief Run the simulation of the chain
+   *
+   * \param simulatorType the simulator implementation to use
+   * \return the packets received by each node, with their reception time
+   */
+  std::vector<std::vector<std::string> > RunChain (const std::string &simulatorType);
+
+  /**
+   * \brief Send a packet whose bytes depend on its sequence number
+   *
+   * \param device NetDevice to send from
+   * \param seq the sequence number of the packet
+   */
+  void Send (Ptr<NetDevice> device, uint32_t seq);
+
+  /**
+   * \brief Receive callback: record the packet and forward it, with one
+   * more byte, on the other device of the node
+   *
+   * \param device the receiving device
+   * \param packet the received packet
+   * \param protocol the protocol
+   * \param from the sender
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  /// Packets received by each node.  Each node only touches its own vector.
+  std::vector<std::vector<std::string> > m_received;
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest ()
+  : TestCase ("PointToPoint in ns3::MultithreadedSimulatorImpl")
+{
+}
+
+void
+PointToPointMultithreadedTest::Send (Ptr<NetDevice> device, uint32_t seq)
+{
+  uint8_t data[128];
+  uint32_t size = 64 + seq % 64;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      data[i] = seq + i;
+    }
+  device->Send (Create<Packet> (data, size), device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointMultithreadedTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                        uint16_t protocol, const Address &from)
+{
+  Ptr<Node> node = device->GetNode ();
+  std::string bytes (packet->GetSize (), 0);
+  packet->CopyData (reinterpret_cast<uint8_t *> (&bytes[0]), bytes.size ());
+  std::ostringstream oss;
+  oss << Simulator::Now ().GetTimeStep () << " " << bytes;
+  m_received[node->GetId ()].push_back (oss.str ());
+
+  uint8_t id = node->GetId ();
+  for (uint32_t i = 0; i < node->GetNDevices (); i++)
+    {
+      if (node->GetDevice (i) != device)
+        {
+          Ptr<Packet> copy = packet->Copy ();
+          copy->AddAtEnd (Create<Packet> (&id, 1));
+          node->GetDevice (i)->Send (copy, node->GetDevice (i)->GetBroadcast (), protocol);
+        }
+    }
+  return true;
+}
+
+std::vector<std::vector<std::string> >
+PointToPointMultithreadedTest::RunChain (const std::string &simulatorType)
+{
+  const uint32_t nNodes = 8;
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulatorType));
+
+  NodeContainer nodes;
+  nodes.Create (nNodes);
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i + 1 < nNodes; i++)
+    {
+      devices.Add (p2p.Install (nodes.Get (i), nodes.Get (i + 1)));
+    }
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      devices.Get (i)->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::Receive, this));
+    }
+
+  // both ends send faster than the links can carry the growing packets, so
+  // that the queues also drop some of them
+  m_received.assign (nNodes, std::vector<std::string> ());
+  for (uint32_t seq = 0; seq < 200; seq++)
+    {
+      Simulator::ScheduleWithContext (0, MicroSeconds (60 * seq),
+                                      &PointToPointMultithreadedTest::Send, this,
+                                      devices.Get (0), seq);
+      Simulator::ScheduleWithContext (nNodes - 1, MicroSeconds (60 * seq),
+                                      &PointToPointMultithreadedTest::Send, this,
+                                      devices.Get (devices.GetN () - 1), seq + 1000);
+    }
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+  return m_received;
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  std::vector<std::vector<std::string> > expected = RunChain ("ns3::DefaultSimulatorImpl");
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (3));
+  std::vector<std::vector<std::string> > received = RunChain ("ns3::MultithreadedSimulatorImpl");
+
+  NS_TEST_ASSERT_MSG_EQ (received.size (), expected.size (), "Wrong number of nodes");
+  for (uint32_t i = 0; i < expected.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_NE (expected[i].size (), 0, "Node " << i << " should have received packets");
+      NS_TEST_ASSERT_MSG_EQ (received[i].size (), expected[i].size (),
+                             "Node " << i << " received a different number of packets");
+      for (uint32_t j = 0; j < expected[i].size (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ ((received[i][j] == expected[i][j]), true,
+                                 "Node " << i << " received a different packet " << j);
+        }
+    }
+}
+
+void
+PointToPointMultithreadedTest::DoTeardown (void)
+{
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (0));
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -116,6 +386,8 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointMultiQueueTest, TestCase::QUICK);
+  AddTestCase (new PointToPointMultithreadedTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
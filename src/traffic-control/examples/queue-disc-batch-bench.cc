@@ -0,0 +1,184 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+//        node 0                          node 1
+//  +----------------+              +----------------+
+//  |   generator    |              |                |
+//  |   pfifo_fast   |              |                |
+//  |  p2p device    |--------------|  p2p device    |
+//  +----------------+              +----------------+
+//
+// This program measures the rate at which packets traverse the traffic
+// control layer (queue disc enqueue, dequeue and transmission to the
+// device) when the device accepts batches of packets (SendBatch) and when
+// it does not, in which case the packets are sent one by one.  A generator
+// sends bursts of packets to the traffic control layer at the line rate.
+// The bursts are larger than the device queue, hence the device queue is
+// periodically filled up and drained, and the queue disc sends up to a
+// quota of packets every time the device wakes it up.  The program prints the packets received per
+// second of wall clock time in both cases.
+//
+// $ ./waf --run="queue-disc-batch-bench --packets=2000000"
+//
+
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("QueueDiscBatchBench");
+
+/**
+ * A PointToPointNetDevice which does not accept batches of packets, so that
+ * the queue disc sends the packets one by one.
+ */
+class NoBatchPointToPointNetDevice : public PointToPointNetDevice
+{
+public:
+  virtual uint32_t GetMaxSendBatchSize (void) const
+  {
+    return 0;
+  }
+};
+
+/**
+ * A queue disc item with no header to add.
+ */
+class BenchQueueDiscItem : public QueueDiscItem
+{
+public:
+  BenchQueueDiscItem (Ptr<Packet> p, const Address & addr, uint16_t protocol)
+    : QueueDiscItem (p, addr, protocol)
+  {
+  }
+  virtual void AddHeader (void)
+  {
+  }
+  virtual bool Mark (void)
+  {
+    return false;
+  }
+  virtual bool IsMarked (void) const
+  {
+    return false;
+  }
+};
+
+static uint32_t g_packets = 1000000;
+static uint32_t g_size = 1000;
+static uint32_t g_burst = 256;
+static uint32_t g_sent = 0;
+static uint32_t g_received = 0;
+
+static void
+Generate (Ptr<TrafficControlLayer> tc, Ptr<NetDevice> device, Time interval)
+{
+  for (uint32_t i = 0; i < g_burst && g_sent < g_packets; i++, g_sent++)
+    {
+      tc->Send (device, Create<BenchQueueDiscItem> (Create<Packet> (g_size), device->GetBroadcast (), 0x0800));
+    }
+  if (g_sent < g_packets)
+    {
+      Simulator::Schedule (interval, &Generate, tc, device, interval);
+    }
+}
+
+static bool
+Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  g_received++;
+  return true;
+}
+
+static void
+Run (bool batch, std::string dataRate)
+{
+  g_sent = 0;
+  g_received = 0;
+
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<PointToPointNetDevice> device;
+      if (batch)
+        {
+          device = CreateObject<PointToPointNetDevice> ();
+        }
+      else
+        {
+          device = CreateObject<NoBatchPointToPointNetDevice> ();
+        }
+      device->SetAttribute ("DataRate", StringValue (dataRate));
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetQueue (CreateObject<DropTailQueue> ());
+      device->Attach (channel);
+      nodes.Get (i)->AddDevice (device);
+      nodes.Get (i)->AggregateObject (CreateObject<TrafficControlLayer> ());
+      devices.Add (device);
+    }
+  devices.Get (1)->SetReceiveCallback (MakeCallback (&Receive));
+
+  TrafficControlHelper tch = TrafficControlHelper::Default ();
+  tch.Install (devices);
+
+  // send bursts at the line rate
+  Time interval = DataRate (dataRate).CalculateBytesTxTime (g_size * g_burst);
+  Simulator::ScheduleWithContext (0, Seconds (0), &Generate,
+                                  nodes.Get (0)->GetObject<TrafficControlLayer> (),
+                                  devices.Get (0), interval);
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t elapsed = clock.End ();
+
+  std::cout << (batch ? "batch:      " : "one by one: ") << g_received
+            << " packets of " << g_size << " bytes in " << elapsed << " ms";
+  if (elapsed > 0)
+    {
+      std::cout << ", " << g_received * 1000.0 / elapsed << " packets/s";
+    }
+  std::cout << std::endl;
+
+  Simulator::Destroy ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string dataRate = "10Gbps";
+
+  CommandLine cmd;
+  cmd.AddValue ("packets", "Number of packets to send", g_packets);
+  cmd.AddValue ("size", "Size of the packets, in bytes", g_size);
+  cmd.AddValue ("burst", "Number of packets sent to the traffic control layer at once", g_burst);
+  cmd.AddValue ("dataRate", "Data rate of the devices", dataRate);
+  cmd.Parse (argc, argv);
+
+  Run (false, dataRate);
+  Run (true, dataRate);
+
+  return 0;
+}
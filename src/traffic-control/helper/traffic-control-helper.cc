@@ -24,6 +24,7 @@
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
 #include "ns3/traffic-control-layer.h"
+#include "ns3/queue-limits.h"
 #include "traffic-control-helper.h"
 
 namespace ns3 {
@@ -114,6 +115,28 @@ TrafficControlHelper::Default (void)
   return helper;
 }
 
+void
+TrafficControlHelper::SetQueueLimits (std::string type,
+                                      std::string n01, const AttributeValue& v01,
+                                      std::string n02, const AttributeValue& v02,
+                                      std::string n03, const AttributeValue& v03,
+                                      std::string n04, const AttributeValue& v04,
+                                      std::string n05, const AttributeValue& v05,
+                                      std::string n06, const AttributeValue& v06,
+                                      std::string n07, const AttributeValue& v07,
+                                      std::string n08, const AttributeValue& v08)
+{
+  m_queueLimitsFactory.SetTypeId (type);
+  m_queueLimitsFactory.Set (n01, v01);
+  m_queueLimitsFactory.Set (n02, v02);
+  m_queueLimitsFactory.Set (n03, v03);
+  m_queueLimitsFactory.Set (n04, v04);
+  m_queueLimitsFactory.Set (n05, v05);
+  m_queueLimitsFactory.Set (n06, v06);
+  m_queueLimitsFactory.Set (n07, v07);
+  m_queueLimitsFactory.Set (n08, v08);
+}
+
 uint16_t
 TrafficControlHelper::SetRootQueueDisc (std::string type,
                                         std::string n01, const AttributeValue& v01,
@@ -353,6 +376,18 @@ TrafficControlHelper::Install (Ptr<NetDevice> d)
   // Set the root queue disc on the device
   tc->SetRootQueueDiscOnDevice (d, m_queueDiscs[0]);
 
+  // Set the queue limits on the device transmission queues, now that the
+  // netdevice queue interface has been aggregated to the device
+  if (m_queueLimitsFactory.GetTypeId ().GetUid ())
+    {
+      Ptr<NetDeviceQueueInterface> ndqi = d->GetObject<NetDeviceQueueInterface> ();
+      NS_ASSERT (ndqi);
+      for (uint8_t i = 0; i < ndqi->GetNTxQueues (); i++)
+        {
+          ndqi->GetTxQueue (i)->SetQueueLimits (m_queueLimitsFactory.Create<QueueLimits> ());
+        }
+    }
+
   return container;
 }
 
@@ -387,5 +422,15 @@ TrafficControlHelper::Uninstall (NetDeviceContainer c)
     }
 }
 
+QueueDiscStats
+TrafficControlHelper::GetStats (const QueueDiscContainer &c)
+{
+  QueueDiscStats stats;
+  for (QueueDiscContainer::ConstIterator i = c.Begin (); i != c.End (); ++i)
+    {
+      stats.Add ((*i)->GetQueueDiscStats ());
+    }
+  return stats;
+}
 
 } // namespace ns3
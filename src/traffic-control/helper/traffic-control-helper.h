@@ -190,6 +190,40 @@ public:
                              std::string n14 = "", const AttributeValue &v14 = EmptyAttributeValue (),
                              std::string n15 = "", const AttributeValue &v15 = EmptyAttributeValue ());
 
+  /**
+   * Helper function used to set the queue limits (of the given type and with
+   * the given attributes) on the transmission queues of the devices the
+   * queue discs are installed on. The queue limits are only effective with
+   * the devices supporting Byte Queue Limits (e.g., point-to-point and CSMA).
+   *
+   * \param type the type of queue limits
+   * \param n01 the name of the attribute to set on the queue limits
+   * \param v01 the value of the attribute to set on the queue limits
+   * \param n02 the name of the attribute to set on the queue limits
+   * \param v02 the value of the attribute to set on the queue limits
+   * \param n03 the name of the attribute to set on the queue limits
+   * \param v03 the value of the attribute to set on the queue limits
+   * \param n04 the name of the attribute to set on the queue limits
+   * \param v04 the value of the attribute to set on the queue limits
+   * \param n05 the name of the attribute to set on the queue limits
+   * \param v05 the value of the attribute to set on the queue limits
+   * \param n06 the name of the attribute to set on the queue limits
+   * \param v06 the value of the attribute to set on the queue limits
+   * \param n07 the name of the attribute to set on the queue limits
+   * \param v07 the value of the attribute to set on the queue limits
+   * \param n08 the name of the attribute to set on the queue limits
+   * \param v08 the value of the attribute to set on the queue limits
+   */
+  void SetQueueLimits (std::string type,
+                       std::string n01 = "", const AttributeValue &v01 = EmptyAttributeValue (),
+                       std::string n02 = "", const AttributeValue &v02 = EmptyAttributeValue (),
+                       std::string n03 = "", const AttributeValue &v03 = EmptyAttributeValue (),
+                       std::string n04 = "", const AttributeValue &v04 = EmptyAttributeValue (),
+                       std::string n05 = "", const AttributeValue &v05 = EmptyAttributeValue (),
+                       std::string n06 = "", const AttributeValue &v06 = EmptyAttributeValue (),
+                       std::string n07 = "", const AttributeValue &v07 = EmptyAttributeValue (),
+                       std::string n08 = "", const AttributeValue &v08 = EmptyAttributeValue ());
+
   /**
    * Helper function used to add the given number of internal queues (of the given
    * type and with the given attributes) to the queue disc having the given handle.
@@ -456,9 +490,22 @@ public:
    */
   void Uninstall (Ptr<NetDevice> d);
 
+  /**
+   * \param c set of queue discs
+   * \returns the sum of the statistics of the given queue discs
+   *
+   * This method adds up the received, dropped, marked and requeued packets
+   * and bytes of the given queue discs, with the drops and marks broken down
+   * by reason, e.g., to report the ECN marks of all the bottleneck links of
+   * a topology at the end of a simulation.
+   */
+  static QueueDiscStats GetStats (const QueueDiscContainer &c);
+
 private:
   /// QueueDisc factory, stores the configuration of all the queue discs
   std::vector<QueueDiscFactory> m_queueDiscFactory;
+  /// Factory to create a queue limits object
+  ObjectFactory m_queueLimitsFactory;
   /// Vector of all the created queue discs
   std::vector<Ptr<QueueDisc> > m_queueDiscs;
 };
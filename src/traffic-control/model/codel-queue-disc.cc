@@ -27,6 +27,7 @@
 
 #include "ns3/log.h"
 #include "ns3/enum.h"
+#include "ns3/boolean.h"
 #include "ns3/uinteger.h"
 #include "ns3/abort.h"
 #include "codel-queue-disc.h"
@@ -146,6 +147,11 @@ CoDelTimestampTag::GetTxTime (void) const
 
 NS_OBJECT_ENSURE_REGISTERED (CoDelQueueDisc);
 
+const char * const CoDelQueueDisc::OVERLIMIT_DROP = "Overlimit drop";
+const char * const CoDelQueueDisc::TARGET_EXCEEDED_DROP = "Target exceeded drop";
+const char * const CoDelQueueDisc::TARGET_EXCEEDED_MARK = "Target exceeded mark";
+const char * const CoDelQueueDisc::CE_THRESHOLD_EXCEEDED_MARK = "CE threshold exceeded mark";
+
 TypeId CoDelQueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::CoDelQueueDisc")
@@ -183,6 +189,16 @@ TypeId CoDelQueueDisc::GetTypeId (void)
                    StringValue ("5ms"),
                    MakeTimeAccessor (&CoDelQueueDisc::m_target),
                    MakeTimeChecker ())
+    .AddAttribute ("UseEcn",
+                   "True to mark ECN capable packets with CE instead of dropping them",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&CoDelQueueDisc::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CeThreshold",
+                   "The CoDel CE threshold: ECN capable packets whose sojourn time exceeds it are marked (requires UseEcn)",
+                   TimeValue (Time::Max ()),
+                   MakeTimeAccessor (&CoDelQueueDisc::m_ceThreshold),
+                   MakeTimeChecker ())
     .AddTraceSource ("Count",
                      "CoDel count",
                      MakeTraceSourceAccessor (&CoDelQueueDisc::m_count),
@@ -280,7 +296,7 @@ CoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   if (m_mode == Queue::QUEUE_MODE_PACKETS && (GetInternalQueue (0)->GetNPackets () + 1 > m_maxPackets))
     {
       NS_LOG_LOGIC ("Queue full (at max packets) -- droppping pkt");
-      Drop (item);
+      Drop (item, OVERLIMIT_DROP);
       ++m_dropOverLimit;
       return false;
     }
@@ -288,7 +304,7 @@ CoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   if (m_mode == Queue::QUEUE_MODE_BYTES && (GetInternalQueue (0)->GetNBytes () + item->GetPacketSize () > m_maxBytes))
     {
       NS_LOG_LOGIC ("Queue full (packet would exceed max bytes) -- droppping pkt");
-      Drop (item);
+      Drop (item, OVERLIMIT_DROP);
       ++m_dropOverLimit;
       return false;
     }
@@ -396,8 +412,18 @@ CoDelQueueDisc::DoDequeue (void)
               // A large amount of packets in queue might result in drop
               // rates so high that the next drop should happen now,
               // hence the while loop.
+              if (m_useEcn && Mark (item, TARGET_EXCEEDED_MARK))
+                {
+                  // An ECN capable packet is marked and delivered instead:
+                  // no further packet needs to be examined.
+                  NS_LOG_LOGIC ("Sojourn time is still above target and it's time for next drop; marking " << p);
+                  ++m_count;
+                  NewtonStep ();
+                  m_dropNext = ControlLaw (m_dropNext);
+                  break;
+                }
               NS_LOG_LOGIC ("Sojourn time is still above target and it's time for next drop; dropping " << p);
-              Drop (item);
+              Drop (item, TARGET_EXCEEDED_DROP);
 
               ++m_dropCount;
               ++m_count;
@@ -439,29 +465,39 @@ CoDelQueueDisc::DoDequeue (void)
       NS_LOG_LOGIC ("Not in dropping state; decide if we have to enter the state and drop the first packet");
       if (okToDrop)
         {
-          // Drop the first packet and enter dropping state unless the queue is empty
-          NS_LOG_LOGIC ("Sojourn time goes above target, dropping the first packet " << p << " and entering the dropping state");
-          ++m_dropCount;
-          Drop (item);
-
-          if (GetInternalQueue (0)->IsEmpty ())
+          if (m_useEcn && Mark (item, TARGET_EXCEEDED_MARK))
             {
-              m_dropping = false;
-              okToDrop = false;
-              NS_LOG_LOGIC ("Queue empty");
-              ++m_states;
+              // Mark the first packet and enter dropping state
+              NS_LOG_LOGIC ("Sojourn time goes above target, marking the first packet " << p << " and entering the dropping state");
+              m_dropping = true;
             }
           else
             {
-              item = StaticCast<QueueDiscItem> (GetInternalQueue (0)->Dequeue ());
-              p = item->GetPacket ();
+              // Drop the first packet and enter dropping state unless the queue is empty
+              NS_LOG_LOGIC ("Sojourn time goes above target, dropping the first packet " << p << " and entering the dropping state");
+              ++m_dropCount;
+              Drop (item, TARGET_EXCEEDED_DROP);
 
-              NS_LOG_LOGIC ("Popped " << item);
-              NS_LOG_LOGIC ("Number packets remaining " << GetInternalQueue (0)->GetNPackets ());
-              NS_LOG_LOGIC ("Number bytes remaining " << GetInternalQueue (0)->GetNBytes ());
+              if (GetInternalQueue (0)->IsEmpty ())
+                {
+                  m_dropping = false;
+                  okToDrop = false;
+                  item = 0;
+                  NS_LOG_LOGIC ("Queue empty");
+                  ++m_states;
+                }
+              else
+                {
+                  item = StaticCast<QueueDiscItem> (GetInternalQueue (0)->Dequeue ());
+                  p = item->GetPacket ();
 
-              okToDrop = OkToDrop (p, now);
-              m_dropping = true;
+                  NS_LOG_LOGIC ("Popped " << item);
+                  NS_LOG_LOGIC ("Number packets remaining " << GetInternalQueue (0)->GetNPackets ());
+                  NS_LOG_LOGIC ("Number bytes remaining " << GetInternalQueue (0)->GetNBytes ());
+
+                  okToDrop = OkToDrop (p, now);
+                  m_dropping = true;
+                }
             }
           ++m_state3;
           /*
@@ -486,6 +522,13 @@ CoDelQueueDisc::DoDequeue (void)
           NS_LOG_LOGIC ("Scheduled next drop at " << (double)m_dropNext / 1000000 << " now " << (double)now / 1000000);
         }
     }
+  // Shallow marking: mark the delivered packet if its sojourn time exceeds
+  // the CE threshold, regardless of the state of the control law
+  if (m_useEcn && item != 0 && m_sojourn.Get () > m_ceThreshold
+      && Mark (item, CE_THRESHOLD_EXCEEDED_MARK))
+    {
+      NS_LOG_LOGIC ("Sojourn time above CE threshold, marking " << p);
+    }
   ++m_states;
   return item;
 }
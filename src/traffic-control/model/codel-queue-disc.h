@@ -78,6 +78,12 @@ public:
 
   virtual ~CoDelQueueDisc ();
 
+  // Reasons for dropping and marking packets
+  static const char * const OVERLIMIT_DROP; //!< Overlimit dropped packets
+  static const char * const TARGET_EXCEEDED_DROP; //!< Sojourn time above target
+  static const char * const TARGET_EXCEEDED_MARK; //!< Sojourn time above target, marked instead of dropped
+  static const char * const CE_THRESHOLD_EXCEEDED_MARK; //!< Sojourn time above CE threshold
+
   /**
    * \brief Set the operating mode of this device.
    *
@@ -228,6 +234,8 @@ private:
   uint32_t m_maxPackets;                  //!< Max # of packets accepted by the queue
   uint32_t m_maxBytes;                    //!< Max # of bytes accepted by the queue
   uint32_t m_minBytes;                    //!< Minimum bytes in queue to allow a packet drop
+  bool m_useEcn;                          //!< True if ECN capable packets are marked instead of dropped
+  Time m_ceThreshold;                     //!< Sojourn time above which ECN capable packets are marked
   Time m_interval;                        //!< 100 ms sliding minimum time window width
   Time m_target;                          //!< 5 ms target queue delay
   TracedValue<uint32_t> m_count;          //!< Number of packets dropped since entering drop state
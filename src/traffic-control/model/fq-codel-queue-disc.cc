@@ -0,0 +1,439 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/queue.h"
+#include "fq-codel-queue-disc.h"
+#include "codel-queue-disc.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FqCoDelQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (FqCoDelFlow);
+
+TypeId FqCoDelFlow::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FqCoDelFlow")
+    .SetParent<QueueDiscClass> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<FqCoDelFlow> ()
+  ;
+  return tid;
+}
+
+FqCoDelFlow::FqCoDelFlow ()
+  : m_deficit (0),
+    m_status (INACTIVE)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FqCoDelFlow::~FqCoDelFlow ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FqCoDelFlow::SetDeficit (int32_t deficit)
+{
+  NS_LOG_FUNCTION (this << deficit);
+  m_deficit = deficit;
+}
+
+int32_t
+FqCoDelFlow::GetDeficit (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_deficit;
+}
+
+void
+FqCoDelFlow::IncreaseDeficit (int32_t deficit)
+{
+  NS_LOG_FUNCTION (this << deficit);
+  m_deficit += deficit;
+}
+
+void
+FqCoDelFlow::SetStatus (FlowStatus status)
+{
+  NS_LOG_FUNCTION (this);
+  m_status = status;
+}
+
+FqCoDelFlow::FlowStatus
+FqCoDelFlow::GetStatus (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_status;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (FqCoDelQueueDisc);
+
+const char * const FqCoDelQueueDisc::UNCLASSIFIED_DROP = "Unclassified drop";
+const char * const FqCoDelQueueDisc::OVERLIMIT_DROP = "Overlimit drop";
+
+TypeId FqCoDelQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FqCoDelQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<FqCoDelQueueDisc> ()
+    .AddAttribute ("Interval",
+                   "The CoDel algorithm interval for each FQCoDel queue",
+                   StringValue ("100ms"),
+                   MakeTimeAccessor (&FqCoDelQueueDisc::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("Target",
+                   "The CoDel algorithm target queue delay for each FQCoDel queue",
+                   StringValue ("5ms"),
+                   MakeTimeAccessor (&FqCoDelQueueDisc::m_target),
+                   MakeTimeChecker ())
+    .AddAttribute ("PacketLimit",
+                   "The hard limit on the real queue size, measured in packets",
+                   UintegerValue (10 * 1024),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_limit),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Flows",
+                   "The number of queues into which the incoming packets are classified",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_flows),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("DropBatchSize",
+                   "The maximum number of packets dropped from the fat flow",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_dropBatchSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Quantum",
+                   "The number of bytes each queue gets to dequeue on each round of the scheduling algorithm",
+                   UintegerValue (1514),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::SetQuantum,
+                                         &FqCoDelQueueDisc::GetQuantum),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Perturbation",
+                   "The salt used as an additional input to the hash function used to classify packets",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_perturbation),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("UseEcn",
+                   "True to mark ECN capable packets with CE instead of dropping them",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&FqCoDelQueueDisc::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CeThreshold",
+                   "The FqCoDel CE threshold for marking packets (requires UseEcn)",
+                   TimeValue (Time::Max ()),
+                   MakeTimeAccessor (&FqCoDelQueueDisc::m_ceThreshold),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+FqCoDelQueueDisc::FqCoDelQueueDisc ()
+  : m_quantum (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FqCoDelQueueDisc::~FqCoDelQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FqCoDelQueueDisc::SetQuantum (uint32_t quantum)
+{
+  NS_LOG_FUNCTION (this << quantum);
+  m_quantum = quantum;
+}
+
+uint32_t
+FqCoDelQueueDisc::GetQuantum (void) const
+{
+  return m_quantum;
+}
+
+Ptr<FqCoDelFlow>
+FqCoDelQueueDisc::GetFlow (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  uint32_t h;
+  if (GetNPacketFilters () == 0)
+    {
+      h = item->GetFlowHash (m_perturbation) % m_flows;
+    }
+  else
+    {
+      int32_t ret = Classify (item);
+      if (ret == PacketFilter::PF_NO_MATCH)
+        {
+          return 0;
+        }
+      h = ret % m_flows;
+    }
+
+  Ptr<FqCoDelFlow> flow = m_flowsByBucket[h];
+  if (flow == 0)
+    {
+      NS_LOG_DEBUG ("Creating a new flow queue with index " << h);
+      flow = m_flowFactory.Create<FqCoDelFlow> ();
+      Ptr<QueueDisc> qd = m_queueDiscFactory.Create<QueueDisc> ();
+      qd->SetParentDropCallback (MakeCallback (&FqCoDelQueueDisc::FlowDropped, this));
+      qd->SetParentMarkCallback (MakeCallback (&FqCoDelQueueDisc::ChildMarked, this));
+      qd->Initialize ();
+      flow->SetQueueDisc (qd);
+      AddQueueDiscClass (flow);
+      m_flowsByBucket[h] = flow;
+    }
+  return flow;
+}
+
+bool
+FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  Ptr<FqCoDelFlow> flow = GetFlow (item);
+  if (flow == 0)
+    {
+      NS_LOG_DEBUG ("No filter has been able to classify this packet, drop it.");
+      Drop (item, UNCLASSIFIED_DROP);
+      return false;
+    }
+
+  if (flow->GetStatus () == FqCoDelFlow::INACTIVE)
+    {
+      flow->SetStatus (FqCoDelFlow::NEW_FLOW);
+      flow->SetDeficit (m_quantum);
+      m_newFlows.push_back (flow);
+    }
+
+  bool retval = flow->GetQueueDisc ()->Enqueue (item);
+
+  // If the flow queue disc drops the packet, the drop is accounted
+  // by FlowDropped, which is set as its parent drop callback
+
+  NS_LOG_DEBUG ("Packet enqueued into flow " << flow << "; flow backlog " << flow->GetQueueDisc ()->GetNPackets ());
+
+  if (GetNPackets () > m_limit)
+    {
+      FqCoDelDrop ();
+    }
+
+  return retval;
+}
+
+Ptr<QueueDiscItem>
+FqCoDelQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<FqCoDelFlow> flow;
+  Ptr<QueueDiscItem> item;
+
+  do
+    {
+      bool found = false;
+
+      while (!found && !m_newFlows.empty ())
+        {
+          flow = m_newFlows.front ();
+
+          if (flow->GetDeficit () <= 0)
+            {
+              flow->IncreaseDeficit (m_quantum);
+              flow->SetStatus (FqCoDelFlow::OLD_FLOW);
+              m_oldFlows.push_back (flow);
+              m_newFlows.pop_front ();
+            }
+          else
+            {
+              NS_LOG_DEBUG ("Found a new flow with positive deficit");
+              found = true;
+            }
+        }
+
+      while (!found && !m_oldFlows.empty ())
+        {
+          flow = m_oldFlows.front ();
+
+          if (flow->GetDeficit () <= 0)
+            {
+              flow->IncreaseDeficit (m_quantum);
+              m_oldFlows.push_back (flow);
+              m_oldFlows.pop_front ();
+            }
+          else
+            {
+              NS_LOG_DEBUG ("Found an old flow with positive deficit");
+              found = true;
+            }
+        }
+
+      if (!found)
+        {
+          NS_LOG_DEBUG ("No flow found to dequeue a packet");
+          return 0;
+        }
+
+      item = flow->GetQueueDisc ()->Dequeue ();
+
+      if (item == 0)
+        {
+          NS_LOG_DEBUG ("Could not get a packet from the selected flow queue");
+          if (flow->GetStatus () == FqCoDelFlow::NEW_FLOW && !m_oldFlows.empty ())
+            {
+              // Serve the old flows before forgetting about this one, to
+              // prevent a flow from being always seen as new
+              flow->SetStatus (FqCoDelFlow::OLD_FLOW);
+              m_oldFlows.push_back (flow);
+              m_newFlows.pop_front ();
+            }
+          else if (flow->GetStatus () == FqCoDelFlow::NEW_FLOW)
+            {
+              flow->SetStatus (FqCoDelFlow::INACTIVE);
+              m_newFlows.pop_front ();
+            }
+          else
+            {
+              flow->SetStatus (FqCoDelFlow::INACTIVE);
+              m_oldFlows.pop_front ();
+            }
+        }
+      else
+        {
+          NS_LOG_DEBUG ("Dequeued packet " << item->GetPacket ());
+        }
+    } while (item == 0);
+
+  flow->IncreaseDeficit (-item->GetPacketSize ());
+
+  return item;
+}
+
+Ptr<const QueueDiscItem>
+FqCoDelQueueDisc::DoPeek (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<const QueueDiscItem> item;
+
+  for (std::list<Ptr<FqCoDelFlow> >::const_iterator it = m_newFlows.begin ();
+       item == 0 && it != m_newFlows.end (); it++)
+    {
+      item = (*it)->GetQueueDisc ()->Peek ();
+    }
+
+  for (std::list<Ptr<FqCoDelFlow> >::const_iterator it = m_oldFlows.begin ();
+       item == 0 && it != m_oldFlows.end (); it++)
+    {
+      item = (*it)->GetQueueDisc ()->Peek ();
+    }
+
+  return item;
+}
+
+bool
+FqCoDelQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("FqCoDelQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNInternalQueues () > 0)
+    {
+      NS_LOG_ERROR ("FqCoDelQueueDisc cannot have internal queues");
+      return false;
+    }
+
+  return true;
+}
+
+void
+FqCoDelQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_flowFactory.SetTypeId ("ns3::FqCoDelFlow");
+
+  // The limit of the flow queues is enforced by this queue disc
+  m_queueDiscFactory.SetTypeId ("ns3::CoDelQueueDisc");
+  m_queueDiscFactory.Set ("Mode", EnumValue (Queue::QUEUE_MODE_PACKETS));
+  m_queueDiscFactory.Set ("MaxPackets", UintegerValue (m_limit + 1));
+  m_queueDiscFactory.Set ("Interval", TimeValue (m_interval));
+  m_queueDiscFactory.Set ("Target", TimeValue (m_target));
+  m_queueDiscFactory.Set ("UseEcn", BooleanValue (m_useEcn));
+  m_queueDiscFactory.Set ("CeThreshold", TimeValue (m_ceThreshold));
+
+  m_flowsByBucket.assign (m_flows, 0);
+}
+
+uint32_t
+FqCoDelQueueDisc::FqCoDelDrop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t maxBacklog = 0;
+  Ptr<QueueDisc> fatFlow;
+
+  // Queue is full! Find the fat flow and drop packet(s) from it
+  for (uint32_t i = 0; i < GetNQueueDiscClasses (); i++)
+    {
+      Ptr<QueueDisc> qd = GetQueueDiscClass (i)->GetQueueDisc ();
+      uint32_t bytes = qd->GetNBytes ();
+      if (bytes > maxBacklog)
+        {
+          maxBacklog = bytes;
+          fatFlow = qd;
+        }
+    }
+  NS_ASSERT (fatFlow != 0);
+
+  // Our goal is to drop half of this fat flow backlog
+  uint32_t len = 0, count = 0, threshold = maxBacklog >> 1;
+  Ptr<QueueItem> item;
+
+  do
+    {
+      // The internal queue notifies the drop to the flow queue disc, which
+      // in turn notifies this queue disc through FlowDropped
+      item = fatFlow->GetInternalQueue (0)->Remove ();
+      len += item->GetPacketSize ();
+    } while (++count < m_dropBatchSize && len < threshold);
+
+  NS_LOG_DEBUG ("Dropped " << count << " packets (" << len << " bytes) from the fat flow");
+
+  return count;
+}
+
+void
+FqCoDelQueueDisc::FlowDropped (Ptr<QueueDiscItem> item, const char *reason)
+{
+  NS_LOG_FUNCTION (this << item << reason);
+  ChildDropped (item, reason != 0 ? reason : OVERLIMIT_DROP);
+}
+
+} // namespace ns3
@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FQ_CODEL_QUEUE_DISC
+#define FQ_CODEL_QUEUE_DISC
+
+#include "ns3/queue-disc.h"
+#include "ns3/object-factory.h"
+#include "ns3/nstime.h"
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A flow queue used by the FqCoDel queue disc
+ *
+ * Each flow is a queue disc class whose child queue disc is a CoDelQueueDisc,
+ * which keeps the CoDel state of the flow.
+ */
+class FqCoDelFlow : public QueueDiscClass {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief FqCoDelFlow constructor
+   */
+  FqCoDelFlow ();
+
+  virtual ~FqCoDelFlow ();
+
+  /**
+   * \enum FlowStatus
+   * \brief Used to determine the status of this flow queue
+   */
+  enum FlowStatus
+    {
+      INACTIVE,     //!< The flow is in none of the lists
+      NEW_FLOW,     //!< The flow is in the list of new flows
+      OLD_FLOW      //!< The flow is in the list of old flows
+    };
+
+  /**
+   * \brief Set the deficit for this flow
+   * \param deficit the deficit for this flow
+   */
+  void SetDeficit (int32_t deficit);
+  /**
+   * \brief Get the deficit for this flow
+   * \return the deficit for this flow
+   */
+  int32_t GetDeficit (void) const;
+  /**
+   * \brief Increase the deficit for this flow
+   * \param deficit the amount by which the deficit is to be increased
+   */
+  void IncreaseDeficit (int32_t deficit);
+  /**
+   * \brief Set the status for this flow
+   * \param status the status for this flow
+   */
+  void SetStatus (FlowStatus status);
+  /**
+   * \brief Get the status of this flow
+   * \return the status of this flow
+   */
+  FlowStatus GetStatus (void) const;
+
+private:
+  int32_t m_deficit;    //!< the deficit for this flow
+  FlowStatus m_status;  //!< the status of this flow
+};
+
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A FqCoDel packet queue disc
+ *
+ * FqCoDel (Flow Queue CoDel, RFC 8290) isolates the flows in distinct queues,
+ * each managed by CoDel, and serves them with a deficit round robin
+ * scheduler: every time a flow is visited, it may send up to a quantum of
+ * bytes. Flows which become active are put in a list of new flows, which
+ * has priority over the list of old flows, so that sparse flows (e.g., short
+ * request/response exchanges) are not queued behind bulk flows.
+ *
+ * As in Linux, the packets are classified by an internal classifier, which
+ * hashes the 5-tuple of the packet (see QueueDiscItem::Hash) into one of the
+ * configured number of flow queues; the flow queues are only created when
+ * they receive their first packet. Packet filters may be added to override
+ * the internal classifier: the value they return is then used as the hash,
+ * and packets they do not classify are dropped.
+ *
+ * When the queue disc holds more than PacketLimit packets, packets are
+ * dropped from the head of the flow with the largest backlog, until up to
+ * half of its backlog (and at most DropBatchSize packets) has been dropped.
+ *
+ * With UseEcn, ECN-capable packets are marked instead of dropped by CoDel.
+ * The drops and the marks of the flow queues are accounted by this queue
+ * disc with the reasons reported by CoDelQueueDisc.
+ */
+class FqCoDelQueueDisc : public QueueDisc {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief FqCoDelQueueDisc constructor
+   */
+  FqCoDelQueueDisc ();
+
+  virtual ~FqCoDelQueueDisc ();
+
+  /**
+   * \brief Set the quantum value.
+   *
+   * \param quantum The number of bytes each queue gets to dequeue on each round of the scheduling algorithm
+   */
+  void SetQuantum (uint32_t quantum);
+
+  /**
+   * \brief Get the quantum value.
+   *
+   * \returns The number of bytes each queue gets to dequeue on each round of the scheduling algorithm
+   */
+  uint32_t GetQuantum (void) const;
+
+  // Reasons for dropping packets
+  static const char * const UNCLASSIFIED_DROP; //!< No packet filter able to classify packet
+  static const char * const OVERLIMIT_DROP;    //!< Overlimit dropped packets
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  /**
+   * \brief Get the flow queue which a packet belongs to, creating it if needed
+   * \param item the packet
+   * \return the flow queue, or null if the packet could not be classified
+   */
+  Ptr<FqCoDelFlow> GetFlow (Ptr<QueueDiscItem> item);
+
+  /**
+   * \brief Drop packets from the head of the flow queue with the largest backlog
+   * \return the number of packets dropped
+   */
+  uint32_t FqCoDelDrop (void);
+
+  /**
+   * \brief Account a packet dropped by the CoDel queue disc of a flow
+   * \param item the packet
+   * \param reason the reason reported by CoDel, null for the packets removed
+   *        by FqCoDelDrop
+   */
+  void FlowDropped (Ptr<QueueDiscItem> item, const char *reason);
+
+  Time m_interval;           //!< CoDel interval attribute
+  Time m_target;             //!< CoDel target attribute
+  uint32_t m_limit;          //!< Maximum number of packets in the queue disc
+  uint32_t m_quantum;        //!< Deficit assigned to flows at each round
+  uint32_t m_flows;          //!< Number of flow queues
+  uint32_t m_dropBatchSize;  //!< Max number of packets dropped from the fat flow
+  uint32_t m_perturbation;   //!< Hash perturbation value
+  bool m_useEcn;             //!< True if ECN is used (packets are marked instead of being dropped)
+  Time m_ceThreshold;        //!< Threshold above which to CE mark
+
+  std::list<Ptr<FqCoDelFlow> > m_newFlows;    //!< The list of new flows
+  std::list<Ptr<FqCoDelFlow> > m_oldFlows;    //!< The list of old flows
+
+  std::vector<Ptr<FqCoDelFlow> > m_flowsByBucket;  //!< Flows indexed by hash bucket, null until used
+
+  ObjectFactory m_flowFactory;         //!< Factory to create a new flow
+  ObjectFactory m_queueDiscFactory;    //!< Factory to create a new queue disc
+};
+
+} // namespace ns3
+
+#endif /* FQ_CODEL_QUEUE_DISC */
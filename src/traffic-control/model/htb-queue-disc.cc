@@ -0,0 +1,559 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "htb-queue-disc.h"
+#include "traffic-control-layer.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("HtbQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (HtbClass);
+
+TypeId HtbClass::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::HtbClass")
+    .SetParent<QueueDiscClass> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<HtbClass> ()
+    .AddAttribute ("Rate",
+                   "The rate guaranteed to this class",
+                   DataRateValue (DataRate ("1Mbps")),
+                   MakeDataRateAccessor (&HtbClass::m_rate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Ceil",
+                   "The maximum rate this class may send at by borrowing (zero means equal to Rate)",
+                   DataRateValue (DataRate ("0bps")),
+                   MakeDataRateAccessor (&HtbClass::m_ceil),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Burst",
+                   "The number of bytes this class may send at once above its rate",
+                   UintegerValue (1600),
+                   MakeUintegerAccessor (&HtbClass::m_burst),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Cburst",
+                   "The number of bytes this class may send at once above its ceil",
+                   UintegerValue (1600),
+                   MakeUintegerAccessor (&HtbClass::m_cburst),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Priority",
+                   "The priority of this class (0 is the highest)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbClass::m_priority),
+                   MakeUintegerChecker<uint32_t> (0, HtbQueueDisc::N_PRIORITIES - 1))
+    .AddAttribute ("Quantum",
+                   "The number of bytes this class may send on each round of the scheduler "
+                   "(zero means a tenth of the bytes sent per second at Rate)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbClass::m_quantum),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+HtbClass::HtbClass ()
+  : m_deficit (0),
+    m_active (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+HtbClass::~HtbClass ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DataRate
+HtbClass::GetRate (void) const
+{
+  return m_rate;
+}
+
+DataRate
+HtbClass::GetCeil (void) const
+{
+  return m_ceil;
+}
+
+uint32_t
+HtbClass::GetPriority (void) const
+{
+  return m_priority;
+}
+
+uint32_t
+HtbClass::GetQuantum (void) const
+{
+  return m_quantum;
+}
+
+void
+HtbClass::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_ceil.GetBitRate () == 0)
+    {
+      m_ceil = m_rate;
+    }
+
+  if (m_quantum == 0)
+    {
+      // As in Linux, the quantum is derived from the rate (r2q = 10) and
+      // kept between 1000 and 200000 bytes
+      uint64_t quantum = m_rate.GetBitRate () / 8 / 10;
+      m_quantum = std::min<uint64_t> (std::max<uint64_t> (quantum, 1000), 200000);
+    }
+
+  m_buffer = m_rate.CalculateBytesTxTime (m_burst);
+  m_cbuffer = m_ceil.CalculateBytesTxTime (m_cburst);
+  m_tokens = m_buffer;
+  m_ctokens = m_cbuffer;
+  m_checkpoint = Simulator::Now ();
+  m_deficit = m_quantum;
+}
+
+HtbClass::Mode
+HtbClass::GetMode (Time now) const
+{
+  if (GetTimeToBorrow (now).IsStrictlyPositive ())
+    {
+      return CANT_SEND;
+    }
+  if (GetTimeToSend (now).IsStrictlyPositive ())
+    {
+      return MAY_BORROW;
+    }
+  return CAN_SEND;
+}
+
+Time
+HtbClass::GetTimeToSend (Time now) const
+{
+  Time tokens = Min (m_tokens + (now - m_checkpoint), m_buffer);
+  return Max (Time (0) - tokens, Time (0));
+}
+
+Time
+HtbClass::GetTimeToBorrow (Time now) const
+{
+  Time ctokens = Min (m_ctokens + (now - m_checkpoint), m_cbuffer);
+  return Max (Time (0) - ctokens, Time (0));
+}
+
+void
+HtbClass::Charge (uint32_t bytes, Time now, bool borrowed)
+{
+  NS_LOG_FUNCTION (this << bytes << now << borrowed);
+
+  m_tokens = Min (m_tokens + (now - m_checkpoint), m_buffer);
+  if (!borrowed)
+    {
+      m_tokens -= m_rate.CalculateBytesTxTime (bytes);
+    }
+  // the ceil bucket is charged for every packet
+  m_ctokens = Min (m_ctokens + (now - m_checkpoint), m_cbuffer);
+  m_ctokens -= m_ceil.CalculateBytesTxTime (bytes);
+  m_checkpoint = now;
+}
+
+void
+HtbClass::SetDeficit (int32_t deficit)
+{
+  NS_LOG_FUNCTION (this << deficit);
+  m_deficit = deficit;
+}
+
+int32_t
+HtbClass::GetDeficit (void) const
+{
+  return m_deficit;
+}
+
+void
+HtbClass::IncreaseDeficit (int32_t deficit)
+{
+  NS_LOG_FUNCTION (this << deficit);
+  m_deficit += deficit;
+}
+
+void
+HtbClass::SetActive (bool active)
+{
+  NS_LOG_FUNCTION (this << active);
+  m_active = active;
+}
+
+bool
+HtbClass::IsActive (void) const
+{
+  return m_active;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (HtbQueueDisc);
+
+const char * const HtbQueueDisc::UNCLASSIFIED_DROP = "Unclassified drop";
+
+TypeId HtbQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::HtbQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<HtbQueueDisc> ()
+    .AddAttribute ("Rate",
+                   "The rate of the root, which limits the bandwidth the classes can borrow "
+                   "(zero means no limit)",
+                   DataRateValue (DataRate ("0bps")),
+                   MakeDataRateAccessor (&HtbQueueDisc::m_rate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Burst",
+                   "The number of bytes the classes may send at once above the rate of the root",
+                   UintegerValue (1600),
+                   MakeUintegerAccessor (&HtbQueueDisc::m_burst),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DefaultClass",
+                   "The index of the class the unclassified packets are enqueued into "
+                   "(unclassified packets are dropped if the index is not valid)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbQueueDisc::m_defaultClass),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+HtbQueueDisc::HtbQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+HtbQueueDisc::~HtbQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+HtbQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Cancel (m_watchdog);
+  for (uint32_t p = 0; p < N_PRIORITIES; p++)
+    {
+      m_active[p].clear ();
+    }
+  QueueDisc::DoDispose ();
+}
+
+Ptr<HtbClass>
+HtbQueueDisc::GetClass (uint32_t i) const
+{
+  return StaticCast<HtbClass> (GetQueueDiscClass (i));
+}
+
+Time
+HtbQueueDisc::GetRootTokens (Time now) const
+{
+  return Min (m_rootTokens + (now - m_rootCheckpoint), m_rootBuffer);
+}
+
+bool
+HtbQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  int32_t ret = Classify (item);
+  uint32_t index = m_defaultClass;
+  if (ret != PacketFilter::PF_NO_MATCH && static_cast<uint32_t> (ret) < GetNQueueDiscClasses ())
+    {
+      index = ret;
+    }
+
+  if (index >= GetNQueueDiscClasses ())
+    {
+      NS_LOG_DEBUG ("No class to enqueue this packet into, drop it.");
+      Drop (item, UNCLASSIFIED_DROP);
+      return false;
+    }
+
+  Ptr<HtbClass> cl = GetClass (index);
+  bool retval = cl->GetQueueDisc ()->Enqueue (item);
+
+  // If the child queue disc drops the packet, the drop is accounted
+  // by ChildDropped, which is set as its parent drop callback
+
+  if (!cl->IsActive () && cl->GetQueueDisc ()->GetNPackets () > 0)
+    {
+      NS_LOG_DEBUG ("Class " << index << " is backlogged");
+      cl->SetActive (true);
+      cl->SetDeficit (cl->GetQuantum ());
+      m_active[cl->GetPriority ()].push_back (cl);
+    }
+
+  return retval;
+}
+
+Ptr<HtbClass>
+HtbQueueDisc::SelectClass (Time now, bool &borrow) const
+{
+  NS_LOG_FUNCTION (this << now);
+
+  // Serve the classes below their rate first
+  for (uint32_t p = 0; p < N_PRIORITIES; p++)
+    {
+      for (std::list<Ptr<HtbClass> >::const_iterator it = m_active[p].begin ();
+           it != m_active[p].end (); it++)
+        {
+          if ((*it)->GetMode (now) == HtbClass::CAN_SEND)
+            {
+              borrow = false;
+              return *it;
+            }
+        }
+    }
+
+  // Then, the classes below their ceil, if there are tokens left to borrow
+  if (m_rate.GetBitRate () == 0 || !GetRootTokens (now).IsStrictlyNegative ())
+    {
+      for (uint32_t p = 0; p < N_PRIORITIES; p++)
+        {
+          for (std::list<Ptr<HtbClass> >::const_iterator it = m_active[p].begin ();
+               it != m_active[p].end (); it++)
+            {
+              if ((*it)->GetMode (now) == HtbClass::MAY_BORROW)
+                {
+                  borrow = true;
+                  return *it;
+                }
+            }
+        }
+    }
+
+  return 0;
+}
+
+void
+HtbQueueDisc::Deactivate (Ptr<HtbClass> cl)
+{
+  NS_LOG_FUNCTION (this << cl);
+  m_active[cl->GetPriority ()].remove (cl);
+  cl->SetActive (false);
+}
+
+Ptr<QueueDiscItem>
+HtbQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  Ptr<HtbClass> cl;
+  Ptr<QueueDiscItem> item;
+  bool borrow = false;
+
+  while (item == 0)
+    {
+      cl = SelectClass (now, borrow);
+      if (cl == 0)
+        {
+          NS_LOG_LOGIC ("No class can send now");
+          ScheduleWatchdog (now);
+          return 0;
+        }
+
+      item = cl->GetQueueDisc ()->Dequeue ();
+      if (item == 0)
+        {
+          NS_LOG_DEBUG ("Could not get a packet from the selected class");
+          Deactivate (cl);
+        }
+    }
+
+  uint32_t size = item->GetPacketSize ();
+  cl->Charge (size, now, borrow);
+  if (m_rate.GetBitRate () > 0)
+    {
+      m_rootTokens = GetRootTokens (now) - m_rate.CalculateBytesTxTime (size);
+      m_rootCheckpoint = now;
+    }
+
+  NS_LOG_LOGIC ("Dequeued packet " << item->GetPacket () << (borrow ? " with borrowed tokens" : ""));
+
+  if (cl->GetQueueDisc ()->GetNPackets () == 0)
+    {
+      Deactivate (cl);
+    }
+  else
+    {
+      cl->IncreaseDeficit (-size);
+      if (cl->GetDeficit () <= 0)
+        {
+          // move the class to the tail of the list of its priority
+          std::list<Ptr<HtbClass> > &active = m_active[cl->GetPriority ()];
+          std::list<Ptr<HtbClass> >::iterator it = std::find (active.begin (), active.end (), cl);
+          NS_ASSERT (it != active.end ());
+          active.splice (active.end (), active, it);
+          cl->IncreaseDeficit (cl->GetQuantum ());
+        }
+    }
+
+  return item;
+}
+
+Ptr<const QueueDiscItem>
+HtbQueueDisc::DoPeek (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  bool borrow;
+  Ptr<HtbClass> cl = SelectClass (Simulator::Now (), borrow);
+  if (cl == 0)
+    {
+      return 0;
+    }
+  return cl->GetQueueDisc ()->Peek ();
+}
+
+void
+HtbQueueDisc::ScheduleWatchdog (Time now)
+{
+  NS_LOG_FUNCTION (this << now);
+
+  Time rootWait (0);
+  if (m_rate.GetBitRate () > 0)
+    {
+      rootWait = Max (Time (0) - GetRootTokens (now), Time (0));
+    }
+
+  // earliest time a backlogged class can send at its rate or by borrowing
+  Time next = Time::Max ();
+  for (uint32_t p = 0; p < N_PRIORITIES; p++)
+    {
+      for (std::list<Ptr<HtbClass> >::const_iterator it = m_active[p].begin ();
+           it != m_active[p].end (); it++)
+        {
+          // a class sends below its ceil, either at its rate or by borrowing
+          Time wait = Max ((*it)->GetTimeToBorrow (now),
+                           Min ((*it)->GetTimeToSend (now), rootWait));
+          next = Min (next, wait);
+        }
+    }
+
+  if (next == Time::Max ())
+    {
+      return;
+    }
+  NS_ASSERT (next.IsStrictlyPositive ());
+
+  if (m_watchdog.IsRunning ())
+    {
+      if (Simulator::GetDelayLeft (m_watchdog) <= next)
+        {
+          return;
+        }
+      m_watchdog.Cancel ();
+    }
+
+  NS_LOG_DEBUG ("Restart the transmission in " << next);
+  m_watchdog = Simulator::Schedule (next, &HtbQueueDisc::WatchdogExpired, this);
+}
+
+void
+HtbQueueDisc::WatchdogExpired (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // Run the root queue disc, which this queue disc may be a child of
+  Ptr<NetDevice> device = GetNetDevice ();
+  if (device == 0)
+    {
+      return;
+    }
+  Ptr<TrafficControlLayer> tc = device->GetNode ()->GetObject<TrafficControlLayer> ();
+  Ptr<QueueDisc> root = tc->GetRootQueueDiscOnDevice (device);
+  if (root != 0)
+    {
+      root->Run ();
+    }
+}
+
+bool
+HtbQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetNInternalQueues () > 0)
+    {
+      NS_LOG_ERROR ("HtbQueueDisc cannot have internal queues");
+      return false;
+    }
+
+  if (GetNQueueDiscClasses () == 0)
+    {
+      NS_LOG_ERROR ("HtbQueueDisc needs at least a class");
+      return false;
+    }
+
+  for (uint32_t i = 0; i < GetNQueueDiscClasses (); i++)
+    {
+      Ptr<HtbClass> cl = DynamicCast<HtbClass> (GetQueueDiscClass (i));
+      if (cl == 0)
+        {
+          NS_LOG_ERROR ("The classes of HtbQueueDisc must be HtbClass objects");
+          return false;
+        }
+
+      if (cl->GetRate ().GetBitRate () == 0)
+        {
+          NS_LOG_ERROR ("The rate of the HtbQueueDisc classes must not be zero");
+          return false;
+        }
+
+      if (cl->GetCeil ().GetBitRate () != 0 && cl->GetCeil () < cl->GetRate ())
+        {
+          NS_LOG_ERROR ("The ceil of the HtbQueueDisc classes must not be less than the rate");
+          return false;
+        }
+
+      cl->GetQueueDisc ()->SetParentDropCallback (MakeCallback (&HtbQueueDisc::ChildDropped, this));
+      cl->GetQueueDisc ()->SetParentMarkCallback (MakeCallback (&HtbQueueDisc::ChildMarked, this));
+    }
+
+  return true;
+}
+
+void
+HtbQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_rate.GetBitRate () > 0)
+    {
+      m_rootBuffer = m_rate.CalculateBytesTxTime (m_burst);
+    }
+  m_rootTokens = m_rootBuffer;
+  m_rootCheckpoint = Simulator::Now ();
+
+  for (uint32_t i = 0; i < GetNQueueDiscClasses (); i++)
+    {
+      GetClass (i)->InitializeParams ();
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,295 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PORT NOTE: This code follows the Hierarchical Token Bucket algorithm of
+ * the Linux implementation (net/sched/sch_htb.c), restricted to a two-level
+ * hierarchy.
+ */
+
+#ifndef HTB_QUEUE_DISC_H
+#define HTB_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/data-rate.h"
+#include <list>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A class of the HTB queue disc
+ *
+ * Each class is guaranteed its Rate and may borrow the bandwidth left unused
+ * by the other classes up to its Ceil. The packets of the class are stored
+ * by the child queue disc attached to the class.
+ */
+class HtbClass : public QueueDiscClass {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief HtbClass constructor
+   */
+  HtbClass ();
+
+  virtual ~HtbClass ();
+
+  /**
+   * \enum Mode
+   * \brief The mode of a class, determined by its token buckets
+   */
+  enum Mode
+    {
+      CAN_SEND,     //!< The class is below its rate
+      MAY_BORROW,   //!< The class is above its rate, but below its ceil
+      CANT_SEND     //!< The class is above its ceil
+    };
+
+  /**
+   * \brief Get the rate guaranteed to this class
+   * \return the rate of this class
+   */
+  DataRate GetRate (void) const;
+
+  /**
+   * \brief Get the maximum rate this class may send at by borrowing
+   * \return the ceil of this class
+   */
+  DataRate GetCeil (void) const;
+
+  /**
+   * \brief Get the priority of this class
+   * \return the priority of this class (0 is the highest)
+   */
+  uint32_t GetPriority (void) const;
+
+  /**
+   * \brief Get the quantum of this class
+   * \return the number of bytes this class may send on each round
+   */
+  uint32_t GetQuantum (void) const;
+
+  /**
+   * \brief Fill the token buckets and compute the parameters which are not
+   * set explicitly
+   */
+  void InitializeParams (void);
+
+  /**
+   * \brief Get the mode of this class at the given time
+   * \param now the current time
+   * \return the mode of this class
+   */
+  Mode GetMode (Time now) const;
+
+  /**
+   * \brief Get the time left until this class is below its rate
+   * \param now the current time
+   * \return the time until the rate bucket holds no negative amount of tokens
+   */
+  Time GetTimeToSend (Time now) const;
+
+  /**
+   * \brief Get the time left until this class is below its ceil
+   * \param now the current time
+   * \return the time until the ceil bucket holds no negative amount of tokens
+   */
+  Time GetTimeToBorrow (Time now) const;
+
+  /**
+   * \brief Charge this class for a transmitted packet
+   * \param bytes the size of the packet
+   * \param now the current time
+   * \param borrowed true if the packet was sent with borrowed tokens, in
+   *        which case the rate bucket is not charged
+   */
+  void Charge (uint32_t bytes, Time now, bool borrowed);
+
+  /**
+   * \brief Set the deficit for this class
+   * \param deficit the deficit for this class
+   */
+  void SetDeficit (int32_t deficit);
+
+  /**
+   * \brief Get the deficit for this class
+   * \return the deficit for this class
+   */
+  int32_t GetDeficit (void) const;
+
+  /**
+   * \brief Increase the deficit for this class
+   * \param deficit the amount by which the deficit is to be increased
+   */
+  void IncreaseDeficit (int32_t deficit);
+
+  /**
+   * \brief Set whether this class is in the list of backlogged classes
+   * \param active true if this class is in the list of backlogged classes
+   */
+  void SetActive (bool active);
+
+  /**
+   * \brief Get whether this class is in the list of backlogged classes
+   * \return true if this class is in the list of backlogged classes
+   */
+  bool IsActive (void) const;
+
+private:
+  DataRate m_rate;      //!< Rate guaranteed to this class
+  DataRate m_ceil;      //!< Maximum rate of this class
+  uint32_t m_burst;     //!< Size of the rate bucket, in bytes
+  uint32_t m_cburst;    //!< Size of the ceil bucket, in bytes
+  uint32_t m_priority;  //!< Priority of this class
+  uint32_t m_quantum;   //!< Bytes sent on each round of the DRR scheduler
+  Time m_buffer;        //!< Size of the rate bucket, in transmission time
+  Time m_cbuffer;       //!< Size of the ceil bucket, in transmission time
+  Time m_tokens;        //!< Tokens in the rate bucket at the last checkpoint
+  Time m_ctokens;       //!< Tokens in the ceil bucket at the last checkpoint
+  Time m_checkpoint;    //!< Time the buckets were last updated
+  int32_t m_deficit;    //!< The deficit for this class
+  bool m_active;        //!< True if the class is backlogged
+};
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A Hierarchical Token Bucket (HTB) queue disc
+ *
+ * HTB shapes the traffic of its classes (HtbClass) so that each class is
+ * guaranteed its Rate and may send up to its Ceil by borrowing the tokens
+ * left unused by the other classes. The queue disc itself acts as the root
+ * of the hierarchy: its Rate, if not zero, limits the total amount of
+ * bandwidth the classes can borrow. Deeper hierarchies are not supported.
+ *
+ * At each dequeue, the backlogged classes below their rate are served first,
+ * in order of priority. Only if none of them can send, the classes below
+ * their ceil borrow tokens from the root, again in order of priority.
+ * Classes with the same priority are served by a deficit round robin
+ * scheduler, where each class may send up to its Quantum bytes per round.
+ *
+ * The token buckets are updated lazily, when a class is considered for
+ * transmission. When no class can send, the queue disc computes the earliest
+ * time a backlogged class becomes eligible and schedules a single event,
+ * which restarts the transmission from the root queue disc of the device.
+ * Hence no timer is set per packet or per class.
+ *
+ * Packets are classified by the packet filters. The packets which are not
+ * classified or are classified with an invalid class index are enqueued in
+ * the DefaultClass, if valid, and dropped otherwise. The limit on the number
+ * of packets is enforced by the child queue discs attached to the classes
+ * (e.g., RED or CoDel queue discs).
+ */
+class HtbQueueDisc : public QueueDisc {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief HtbQueueDisc constructor
+   */
+  HtbQueueDisc ();
+
+  virtual ~HtbQueueDisc ();
+
+  /// Number of priority levels of the classes
+  static const uint32_t N_PRIORITIES = 8;
+
+  // Reasons for dropping packets
+  static const char * const UNCLASSIFIED_DROP; //!< No class to enqueue the packet into
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  /**
+   * \brief Get the class of the given index
+   * \param i the index of the class
+   * \return the class of the given index
+   */
+  Ptr<HtbClass> GetClass (uint32_t i) const;
+
+  /**
+   * \brief Get the tokens held by the root bucket
+   * \param now the current time
+   * \return the tokens held by the root bucket, in transmission time
+   */
+  Time GetRootTokens (Time now) const;
+
+  /**
+   * \brief Select the class to serve, without modifying the state of the
+   * scheduler
+   * \param now the current time
+   * \param borrow set to true if the selected class has to borrow tokens
+   * \return the class to serve, or null if no class can send
+   */
+  Ptr<HtbClass> SelectClass (Time now, bool &borrow) const;
+
+  /**
+   * \brief Remove a class which is no longer backlogged from the list of
+   * backlogged classes
+   * \param cl the class
+   */
+  void Deactivate (Ptr<HtbClass> cl);
+
+  /**
+   * \brief Schedule the event which restarts the transmission at the time
+   * the first backlogged class becomes eligible to send
+   * \param now the current time
+   */
+  void ScheduleWatchdog (Time now);
+
+  /**
+   * \brief Restart the transmission once a class is eligible to send
+   *
+   * Modelled after the Linux qdisc_watchdog function, which reschedules the
+   * root queue disc of the device.
+   */
+  void WatchdogExpired (void);
+
+  DataRate m_rate;          //!< Rate of the root
+  uint32_t m_burst;         //!< Size of the root bucket, in bytes
+  uint32_t m_defaultClass;  //!< Class of the unclassified packets
+  Time m_rootBuffer;        //!< Size of the root bucket, in transmission time
+  Time m_rootTokens;        //!< Tokens in the root bucket at the last checkpoint
+  Time m_rootCheckpoint;    //!< Time the root bucket was last updated
+  std::list<Ptr<HtbClass> > m_active[N_PRIORITIES];  //!< Backlogged classes, per priority
+  EventId m_watchdog;       //!< Event restarting the transmission
+};
+
+} // namespace ns3
+
+#endif /* HTB_QUEUE_DISC_H */
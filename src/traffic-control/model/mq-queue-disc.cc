@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+#include "mq-queue-disc.h"
+#include "pfifo-fast-queue-disc.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MqQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (MqQueueDisc);
+
+TypeId MqQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MqQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<MqQueueDisc> ()
+  ;
+  return tid;
+}
+
+MqQueueDisc::MqQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MqQueueDisc::~MqQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+QueueDisc::WakeMode
+MqQueueDisc::GetWakeMode (void)
+{
+  return WAKE_CHILD;
+}
+
+bool
+MqQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_FATAL_ERROR ("MqQueueDisc: DoEnqueue should never be called");
+}
+
+Ptr<QueueDiscItem>
+MqQueueDisc::DoDequeue (void)
+{
+  NS_FATAL_ERROR ("MqQueueDisc: DoDequeue should never be called");
+}
+
+Ptr<const QueueDiscItem>
+MqQueueDisc::DoPeek (void) const
+{
+  NS_FATAL_ERROR ("MqQueueDisc: DoPeek should never be called");
+}
+
+bool
+MqQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetNPacketFilters () > 0)
+    {
+      NS_LOG_ERROR ("MqQueueDisc cannot have packet filters");
+      return false;
+    }
+
+  if (GetNInternalQueues () > 0)
+    {
+      NS_LOG_ERROR ("MqQueueDisc cannot have internal queues");
+      return false;
+    }
+
+  Ptr<NetDevice> device = GetNetDevice ();
+  Ptr<NetDeviceQueueInterface> ndqi;
+  if (device != 0)
+    {
+      ndqi = device->GetObject<NetDeviceQueueInterface> ();
+    }
+  if (ndqi == 0)
+    {
+      NS_LOG_ERROR ("MqQueueDisc must be installed on a device");
+      return false;
+    }
+
+  if (GetNQueueDiscClasses () == 0)
+    {
+      // create a class with a pfifo_fast child for each transmission queue
+      for (uint8_t i = 0; i < ndqi->GetNTxQueues (); i++)
+        {
+          Ptr<QueueDisc> qd = CreateObject<PfifoFastQueueDisc> ();
+          qd->SetNetDevice (device);
+          Ptr<QueueDiscClass> c = CreateObject<QueueDiscClass> ();
+          c->SetQueueDisc (qd);
+          AddQueueDiscClass (c);
+        }
+    }
+
+  if (GetNQueueDiscClasses () != ndqi->GetNTxQueues ())
+    {
+      NS_LOG_ERROR ("MqQueueDisc needs as many classes as the transmission queues of the device");
+      return false;
+    }
+
+  return true;
+}
+
+void
+MqQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+} // namespace ns3
@@ -0,0 +1,76 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MQ_QUEUE_DISC_H
+#define MQ_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * Linux mq is a classful queue disc meant to be installed as the root queue
+ * disc of multi-queue devices. It has one class per device transmission
+ * queue, and the queue disc attached to the i-th class handles the packets
+ * sent through the i-th transmission queue.
+ *
+ * The mq queue disc does not store any packet. The traffic control layer
+ * enqueues the packets directly in the child queue disc associated with the
+ * transmission queue selected for the packet, and the device wakes such
+ * child queue disc when the transmission queue is woken (WAKE_CHILD mode).
+ * Hence, the child queue discs run independently of each other, with no
+ * state shared through the root. For the same reason, the statistics and
+ * the trace sources of the mq queue disc are not updated: those of the
+ * child queue discs have to be used instead.
+ *
+ * If no class is configured, a class with a PfifoFastQueueDisc child is
+ * created for each transmission queue, as done by Linux with the default
+ * queue disc. Otherwise, the number of classes must equal the number of
+ * transmission queues. No packet filter nor internal queue can be provided.
+ */
+class MqQueueDisc : public QueueDisc {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief MqQueueDisc constructor
+   */
+  MqQueueDisc ();
+
+  virtual ~MqQueueDisc();
+
+  /**
+   * \brief Return the wake mode adopted by this queue disc.
+   * \return WAKE_CHILD, since the child queue discs are woken
+   */
+  virtual WakeMode GetWakeMode (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+};
+
+} // namespace ns3
+
+#endif /* MQ_QUEUE_DISC_H */
@@ -33,6 +33,8 @@ NS_LOG_COMPONENT_DEFINE ("PfifoFastQueueDisc");
 
 NS_OBJECT_ENSURE_REGISTERED (PfifoFastQueueDisc);
 
+const char * const PfifoFastQueueDisc::LIMIT_EXCEEDED_DROP = "Queue disc limit exceeded";
+
 TypeId PfifoFastQueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::PfifoFastQueueDisc")
@@ -68,7 +70,7 @@ PfifoFastQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   if (GetNPackets () > m_limit)
     {
       NS_LOG_LOGIC ("Queue disc limit exceeded -- dropping packet");
-      Drop (item);
+      Drop (item, LIMIT_EXCEEDED_DROP);
       return false;
     }
 
@@ -0,0 +1,539 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PORT NOTE: This code follows the PIE algorithm as described in RFC 8033
+ * and the Linux implementation (net/sched/sch_pie.c).
+ */
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include "pie-queue-disc.h"
+#include "ns3/drop-tail-queue.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PieQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (PieQueueDisc);
+
+const char * const PieQueueDisc::UNFORCED_DROP = "Unforced drop";
+const char * const PieQueueDisc::FORCED_DROP = "Forced drop";
+const char * const PieQueueDisc::UNFORCED_MARK = "Unforced mark";
+
+TypeId PieQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PieQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<PieQueueDisc> ()
+    .AddAttribute ("Mode",
+                   "Determines unit for QueueLimit",
+                   EnumValue (Queue::QUEUE_MODE_PACKETS),
+                   MakeEnumAccessor (&PieQueueDisc::SetMode),
+                   MakeEnumChecker (Queue::QUEUE_MODE_BYTES, "QUEUE_MODE_BYTES",
+                                    Queue::QUEUE_MODE_PACKETS, "QUEUE_MODE_PACKETS"))
+    .AddAttribute ("MeanPktSize",
+                   "Average of packet size",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&PieQueueDisc::m_meanPktSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("A",
+                   "Value of alpha",
+                   DoubleValue (0.125),
+                   MakeDoubleAccessor (&PieQueueDisc::m_a),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("B",
+                   "Value of beta",
+                   DoubleValue (1.25),
+                   MakeDoubleAccessor (&PieQueueDisc::m_b),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("Tupdate",
+                   "Time period to calculate drop probability",
+                   TimeValue (MilliSeconds (15)),
+                   MakeTimeAccessor (&PieQueueDisc::m_tUpdate),
+                   MakeTimeChecker ())
+    .AddAttribute ("Supdate",
+                   "Start time of the update timer",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&PieQueueDisc::m_sUpdate),
+                   MakeTimeChecker ())
+    .AddAttribute ("QueueLimit",
+                   "Queue limit in bytes/packets",
+                   UintegerValue (25),
+                   MakeUintegerAccessor (&PieQueueDisc::SetQueueLimit),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DequeueThreshold",
+                   "Minimum queue size in bytes before dequeue rate is measured",
+                   UintegerValue (16384),
+                   MakeUintegerAccessor (&PieQueueDisc::m_dqThreshold),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("QueueDelayReference",
+                   "Desired queue delay",
+                   TimeValue (MilliSeconds (15)),
+                   MakeTimeAccessor (&PieQueueDisc::m_qDelayRef),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxBurstAllowance",
+                   "Current max burst allowance in seconds before random drop",
+                   TimeValue (MilliSeconds (150)),
+                   MakeTimeAccessor (&PieQueueDisc::m_maxBurst),
+                   MakeTimeChecker ())
+    .AddAttribute ("UseEcn",
+                   "True to mark ECN capable packets instead of dropping them",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PieQueueDisc::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MarkEcnThreshold",
+                   "ECN capable packets are marked only if the drop probability does not exceed this value",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&PieQueueDisc::m_markEcnTh),
+                   MakeDoubleChecker<double> (0, 1))
+  ;
+
+  return tid;
+}
+
+PieQueueDisc::PieQueueDisc ()
+  : QueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = CreateObject<UniformRandomVariable> ();
+}
+
+PieQueueDisc::~PieQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+PieQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = 0;
+  m_rtrsEvent.Cancel ();
+  QueueDisc::DoDispose ();
+}
+
+void
+PieQueueDisc::SetMode (Queue::QueueMode mode)
+{
+  NS_LOG_FUNCTION (this << mode);
+  m_mode = mode;
+}
+
+Queue::QueueMode
+PieQueueDisc::GetMode (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_mode;
+}
+
+void
+PieQueueDisc::SetQueueLimit (uint32_t lim)
+{
+  NS_LOG_FUNCTION (this << lim);
+  m_queueLimit = lim;
+}
+
+uint32_t
+PieQueueDisc::GetQueueSize (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetMode () == Queue::QUEUE_MODE_BYTES)
+    {
+      return GetInternalQueue (0)->GetNBytes ();
+    }
+  else if (GetMode () == Queue::QUEUE_MODE_PACKETS)
+    {
+      return GetInternalQueue (0)->GetNPackets ();
+    }
+  else
+    {
+      NS_ABORT_MSG ("Unknown PIE mode.");
+    }
+}
+
+double
+PieQueueDisc::GetDropProbability (void) const
+{
+  return m_dropProb;
+}
+
+Time
+PieQueueDisc::GetQueueDelay (void) const
+{
+  return m_qDelay;
+}
+
+PieQueueDisc::Stats
+PieQueueDisc::GetStats ()
+{
+  NS_LOG_FUNCTION (this);
+  return m_stats;
+}
+
+int64_t
+PieQueueDisc::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_uv->SetStream (stream);
+  return 1;
+}
+
+bool
+PieQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  uint32_t nQueued = GetQueueSize ();
+
+  if ((GetMode () == Queue::QUEUE_MODE_PACKETS && nQueued >= m_queueLimit)
+      || (GetMode () == Queue::QUEUE_MODE_BYTES && nQueued + item->GetPacketSize () > m_queueLimit))
+    {
+      // Drops due to queue limit: reactive
+      Drop (item, FORCED_DROP);
+      m_stats.forcedDrop++;
+      return false;
+    }
+  else if (DropEarly (item, nQueued))
+    {
+      if (m_useEcn && m_dropProb <= m_markEcnTh && Mark (item, UNFORCED_MARK))
+        {
+          // Early probability mark: the packet is enqueued
+          m_stats.unforcedMark++;
+        }
+      else
+        {
+          // Early probability drop: proactive
+          Drop (item, UNFORCED_DROP);
+          m_stats.unforcedDrop++;
+          return false;
+        }
+    }
+
+  // No drop
+  bool retval = GetInternalQueue (0)->Enqueue (item);
+
+  // If Queue::Enqueue fails, QueueDisc::Drop is called by the internal queue
+  // because QueueDisc::AddInternalQueue sets the drop callback
+
+  NS_LOG_LOGIC ("\t bytesInQueue  " << GetInternalQueue (0)->GetNBytes ());
+  NS_LOG_LOGIC ("\t packetsInQueue  " << GetInternalQueue (0)->GetNPackets ());
+
+  return retval;
+}
+
+void
+PieQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // Initially queue is empty so variables are initialized to zero except m_dqCount
+  m_inMeasurement = false;
+  m_dqCount = 0;
+  m_dropProb = 0;
+  m_avgDqRate = 0.0;
+  m_dqStart = Seconds (0);
+  m_burstAllowance = m_maxBurst;
+  m_qDelayOld = Seconds (0);
+  m_qDelay = Seconds (0);
+  m_stats.forcedDrop = 0;
+  m_stats.unforcedDrop = 0;
+  m_stats.unforcedMark = 0;
+
+  m_rtrsEvent = Simulator::Schedule (m_sUpdate, &PieQueueDisc::CalculateP, this);
+}
+
+bool
+PieQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
+{
+  NS_LOG_FUNCTION (this << item << qSize);
+
+  if (m_burstAllowance > Seconds (0))
+    {
+      // If there is still burst allowance left, skip random early drop.
+      return false;
+    }
+
+  if (m_qDelayOld < m_qDelayRef / 2 && m_dropProb < 0.2)
+    {
+      // The queue delay is low and the drop probability is not high:
+      // the congestion is not severe enough to drop
+      return false;
+    }
+  else if (GetMode () == Queue::QUEUE_MODE_BYTES && qSize <= 2 * m_meanPktSize)
+    {
+      return false;
+    }
+  else if (GetMode () == Queue::QUEUE_MODE_PACKETS && qSize <= 2)
+    {
+      return false;
+    }
+
+  double p = m_dropProb;
+
+  if (GetMode () == Queue::QUEUE_MODE_BYTES)
+    {
+      p = p * item->GetPacketSize () / m_meanPktSize;
+    }
+
+  return m_uv->GetValue () < p;
+}
+
+void
+PieQueueDisc::CalculateP (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time qDelay;
+  bool missingInitFlag = false;
+  if (m_avgDqRate > 0)
+    {
+      qDelay = Seconds (GetInternalQueue (0)->GetNBytes () / m_avgDqRate);
+    }
+  else
+    {
+      qDelay = Seconds (0);
+      missingInitFlag = true;
+    }
+
+  m_qDelay = qDelay;
+
+  double p = m_a * (qDelay - m_qDelayRef).GetSeconds ()
+    + m_b * (qDelay - m_qDelayOld).GetSeconds ();
+
+  // Auto-tune the controller: scale the adjustment down while the drop
+  // probability is small, so that it does not change too abruptly
+  if (m_dropProb < 0.000001)
+    {
+      p /= 2048;
+    }
+  else if (m_dropProb < 0.00001)
+    {
+      p /= 512;
+    }
+  else if (m_dropProb < 0.0001)
+    {
+      p /= 128;
+    }
+  else if (m_dropProb < 0.001)
+    {
+      p /= 32;
+    }
+  else if (m_dropProb < 0.01)
+    {
+      p /= 8;
+    }
+  else if (m_dropProb < 0.1)
+    {
+      p /= 2;
+    }
+
+  // Cap the increase when the drop probability is already high, to
+  // prevent a single update from causing a large number of drops
+  if (m_dropProb >= 0.1 && p > 0.02)
+    {
+      p = 0.02;
+    }
+
+  p += m_dropProb;
+
+  // For non-linear drop in prob
+  if (qDelay == Seconds (0) && m_qDelayOld == Seconds (0))
+    {
+      p *= 0.98;
+    }
+  else if (qDelay > MilliSeconds (250))
+    {
+      p += 0.02;
+    }
+
+  m_dropProb = std::min (std::max (p, 0.0), 1.0);
+
+  if (qDelay < m_qDelayRef / 2 && m_qDelayOld < m_qDelayRef / 2
+      && m_dropProb == 0 && !missingInitFlag)
+    {
+      // The queue has been idle: restart the departure rate estimation and
+      // allow a new burst
+      m_inMeasurement = false;
+      m_dqCount = 0;
+      m_avgDqRate = 0.0;
+      m_burstAllowance = m_maxBurst;
+    }
+  else if (m_burstAllowance < m_tUpdate)
+    {
+      m_burstAllowance = Seconds (0);
+    }
+  else
+    {
+      m_burstAllowance -= m_tUpdate;
+    }
+
+  NS_LOG_DEBUG ("Queue delay " << qDelay.GetSeconds () << " s, drop probability " << m_dropProb);
+
+  m_qDelayOld = qDelay;
+  m_rtrsEvent = Simulator::Schedule (m_tUpdate, &PieQueueDisc::CalculateP, this);
+}
+
+void
+PieQueueDisc::UpdateDepartureRate (uint32_t pktSize)
+{
+  NS_LOG_FUNCTION (this << pktSize);
+
+  Time now = Simulator::Now ();
+
+  // If not in a measurement cycle and the queue has built up to
+  // DequeueThreshold, start the measurement cycle
+  if (!m_inMeasurement && GetInternalQueue (0)->GetNBytes () >= m_dqThreshold)
+    {
+      m_dqStart = now;
+      m_dqCount = 0;
+      m_inMeasurement = true;
+    }
+
+  if (!m_inMeasurement)
+    {
+      return;
+    }
+
+  m_dqCount += pktSize;
+
+  // Done with a measurement cycle
+  if (m_dqCount >= m_dqThreshold)
+    {
+      double elapsed = (now - m_dqStart).GetSeconds ();
+
+      if (elapsed > 0)
+        {
+          if (m_avgDqRate == 0)
+            {
+              m_avgDqRate = m_dqCount / elapsed;
+            }
+          else
+            {
+              m_avgDqRate = 0.5 * m_avgDqRate + 0.5 * (m_dqCount / elapsed);
+            }
+          NS_LOG_DEBUG ("Departure rate " << m_avgDqRate << " bytes/s");
+        }
+
+      // Restart a measurement cycle if there is enough data
+      m_dqStart = now;
+      m_dqCount = 0;
+      m_inMeasurement = (GetInternalQueue (0)->GetNBytes () > m_dqThreshold);
+    }
+}
+
+Ptr<QueueDiscItem>
+PieQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<QueueDiscItem> item = StaticCast<QueueDiscItem> (GetInternalQueue (0)->Dequeue ());
+
+  UpdateDepartureRate (item->GetPacketSize ());
+
+  NS_LOG_LOGIC ("Popped " << item);
+
+  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
+
+  return item;
+}
+
+Ptr<const QueueDiscItem>
+PieQueueDisc::DoPeek () const
+{
+  NS_LOG_FUNCTION (this);
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<const QueueDiscItem> item = StaticCast<const QueueDiscItem> (GetInternalQueue (0)->Peek ());
+
+  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
+
+  return item;
+}
+
+bool
+PieQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("PieQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () > 0)
+    {
+      NS_LOG_ERROR ("PieQueueDisc cannot have packet filters");
+      return false;
+    }
+
+  if (GetNInternalQueues () == 0)
+    {
+      // create a DropTail queue
+      Ptr<Queue> queue = CreateObjectWithAttributes<DropTailQueue> ("Mode", EnumValue (m_mode));
+      if (m_mode == Queue::QUEUE_MODE_PACKETS)
+        {
+          queue->SetMaxPackets (m_queueLimit);
+        }
+      else
+        {
+          queue->SetMaxBytes (m_queueLimit);
+        }
+      AddInternalQueue (queue);
+    }
+
+  if (GetNInternalQueues () != 1)
+    {
+      NS_LOG_ERROR ("PieQueueDisc needs 1 internal queue");
+      return false;
+    }
+
+  if (GetInternalQueue (0)->GetMode () != m_mode)
+    {
+      NS_LOG_ERROR ("The mode of the provided queue does not match the mode set on the PieQueueDisc");
+      return false;
+    }
+
+  if ((m_mode ==  Queue::QUEUE_MODE_PACKETS && GetInternalQueue (0)->GetMaxPackets () < m_queueLimit)
+      || (m_mode ==  Queue::QUEUE_MODE_BYTES && GetInternalQueue (0)->GetMaxBytes () < m_queueLimit))
+    {
+      NS_LOG_ERROR ("The size of the internal queue is less than the queue disc limit");
+      return false;
+    }
+
+  return true;
+}
+
+} //namespace ns3
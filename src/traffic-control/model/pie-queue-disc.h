@@ -0,0 +1,214 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PORT NOTE: This code follows the PIE algorithm as described in RFC 8033
+ * and the Linux implementation (net/sched/sch_pie.c).
+ */
+
+#ifndef PIE_QUEUE_DISC_H
+#define PIE_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Implements PIE Active Queue Management discipline
+ *
+ * PIE (Proportional Integral controller Enhanced, RFC 8033) drops packets
+ * at enqueue with a probability which is periodically updated (every
+ * Tupdate) based on the deviation of the queueing delay from a reference
+ * value and on its trend. The queueing delay is not measured per packet:
+ * it is estimated as the backlog divided by the departure rate, which is
+ * measured over cycles of at least DequeueThreshold bytes. Hence the
+ * per-packet work is O(1) and no timestamp is attached to the packets.
+ *
+ * A burst allowance (MaxBurstAllowance) lets bursts pass without drops when
+ * the queue has been idle. With UseEcn, ECN capable packets are marked
+ * instead of dropped as long as the drop probability does not exceed
+ * MarkEcnThreshold.
+ */
+class PieQueueDisc : public QueueDisc
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief PieQueueDisc Constructor
+   */
+  PieQueueDisc ();
+
+  /**
+   * \brief PieQueueDisc Destructor
+   */
+  virtual ~PieQueueDisc ();
+
+  /**
+   * \brief Stats
+   */
+  typedef struct
+  {
+    uint32_t unforcedDrop;  //!< Early probability drops: proactive
+    uint32_t forcedDrop;    //!< Drops due to queue limit: reactive
+    uint32_t unforcedMark;  //!< Early probability marks
+  } Stats;
+
+  // Reasons for dropping or marking packets
+  static const char * const UNFORCED_DROP; //!< Early probability drops
+  static const char * const FORCED_DROP;   //!< Drops due to queue limit
+  static const char * const UNFORCED_MARK; //!< Early probability marks
+
+  /**
+   * \brief Set the operating mode of this queue.
+   *
+   * \param mode The operating mode of this queue.
+   */
+  void SetMode (Queue::QueueMode mode);
+
+  /**
+   * \brief Get the operating mode of this queue.
+   *
+   * \returns The operating mode of this queue.
+   */
+  Queue::QueueMode GetMode (void);
+
+  /**
+   * \brief Get the current value of the queue in bytes or packets.
+   *
+   * \returns The queue size in bytes or packets.
+   */
+  uint32_t GetQueueSize (void);
+
+  /**
+   * \brief Set the limit of the queue in bytes or packets.
+   *
+   * \param lim The limit in bytes or packets.
+   */
+  void SetQueueLimit (uint32_t lim);
+
+  /**
+   * \brief Get the current drop probability.
+   *
+   * \returns The drop probability.
+   */
+  double GetDropProbability (void) const;
+
+  /**
+   * \brief Get queue delay.
+   *
+   * \returns The queue delay estimated at the last probability update.
+   */
+  Time GetQueueDelay (void) const;
+
+  /**
+   * \brief Get PIE statistics after running.
+   *
+   * \returns The drop statistics.
+   */
+  Stats GetStats ();
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual bool CheckConfig (void);
+
+  /**
+   * \brief Initialize the queue parameters and schedule the first drop
+   * probability update.
+   */
+  virtual void InitializeParams (void);
+
+  /**
+   * \brief Check if a packet needs to be dropped (or marked) due to
+   * probability drop
+   * \param item queue item
+   * \param qSize queue size
+   * \returns true if the packet is to be dropped or marked
+   */
+  bool DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize);
+
+  /**
+   * \brief Periodically update the drop probability based on the delay
+   * samples: not only the current delay sample but also the trend where the
+   * delay is going, up or down
+   */
+  void CalculateP (void);
+
+  /**
+   * \brief Update the departure rate estimation with a dequeued packet
+   * \param pktSize the size of the dequeued packet, in bytes
+   */
+  void UpdateDepartureRate (uint32_t pktSize);
+
+  Stats m_stats;                                //!< PIE statistics
+
+  // ** Variables supplied by user
+  Queue::QueueMode m_mode;                      //!< Mode (bytes or packets)
+  uint32_t m_queueLimit;                        //!< Queue limit in bytes / packets
+  Time m_sUpdate;                               //!< Start time of the update timer
+  Time m_tUpdate;                               //!< Time period after which CalculateP () is called
+  Time m_qDelayRef;                             //!< Desired queue delay
+  uint32_t m_meanPktSize;                       //!< Average packet size in bytes
+  Time m_maxBurst;                              //!< Maximum burst allowed before random early dropping kicks in
+  double m_a;                                   //!< Parameter to PIE controller
+  double m_b;                                   //!< Parameter to PIE controller
+  uint32_t m_dqThreshold;                       //!< Minimum queue size in bytes before dequeue rate is measured
+  bool m_useEcn;                                //!< True if ECN is used (packets are marked instead of being dropped)
+  double m_markEcnTh;                           //!< ECN marking threshold on the drop probability
+
+  // ** Variables maintained by PIE
+  double m_dropProb;                            //!< Variable used in calculation of drop probability
+  Time m_qDelayOld;                             //!< Old value of queue delay
+  Time m_qDelay;                                //!< Current value of queue delay
+  Time m_burstAllowance;                        //!< Current max burst value in seconds that is allowed before random drops kick in
+  bool m_inMeasurement;                         //!< Indicates whether we are in a measurement cycle
+  double m_avgDqRate;                           //!< Time averaged dequeue rate, in bytes per second
+  Time m_dqStart;                               //!< Start timestamp of current measurement cycle
+  uint32_t m_dqCount;                           //!< Number of bytes departed since current measurement cycle starts
+  EventId m_rtrsEvent;                          //!< Event used to decide the decision of interval of drop probability calculation
+  Ptr<UniformRandomVariable> m_uv;              //!< Rng stream
+};
+
+} // namespace ns3
+
+#endif /* PIE_QUEUE_DISC_H */
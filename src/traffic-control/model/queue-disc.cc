@@ -24,17 +24,99 @@
 #include "ns3/object-vector.h"
 #include "ns3/packet.h"
 #include "ns3/unused.h"
+#include "ns3/hash.h"
 #include "queue-disc.h"
+#include <cstring>
+#include <algorithm>
+#include <limits>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("QueueDisc");
 
+QueueDiscStats::QueueDiscStats ()
+  : nTotalReceivedPackets (0),
+    nTotalReceivedBytes (0),
+    nTotalDroppedPackets (0),
+    nTotalDroppedBytes (0),
+    nTotalMarkedPackets (0),
+    nTotalMarkedBytes (0),
+    nTotalRequeuedPackets (0),
+    nTotalRequeuedBytes (0)
+{
+}
+
+void
+QueueDiscStats::Add (const QueueDiscStats &stats)
+{
+  nTotalReceivedPackets += stats.nTotalReceivedPackets;
+  nTotalReceivedBytes += stats.nTotalReceivedBytes;
+  nTotalDroppedPackets += stats.nTotalDroppedPackets;
+  nTotalDroppedBytes += stats.nTotalDroppedBytes;
+  nTotalMarkedPackets += stats.nTotalMarkedPackets;
+  nTotalMarkedBytes += stats.nTotalMarkedBytes;
+  nTotalRequeuedPackets += stats.nTotalRequeuedPackets;
+  nTotalRequeuedBytes += stats.nTotalRequeuedBytes;
+
+  std::map<std::string, uint32_t>::const_iterator it;
+  for (it = stats.nDroppedPackets.begin (); it != stats.nDroppedPackets.end (); ++it)
+    {
+      nDroppedPackets[it->first] += it->second;
+    }
+  for (it = stats.nDroppedBytes.begin (); it != stats.nDroppedBytes.end (); ++it)
+    {
+      nDroppedBytes[it->first] += it->second;
+    }
+  for (it = stats.nMarkedPackets.begin (); it != stats.nMarkedPackets.end (); ++it)
+    {
+      nMarkedPackets[it->first] += it->second;
+    }
+  for (it = stats.nMarkedBytes.begin (); it != stats.nMarkedBytes.end (); ++it)
+    {
+      nMarkedBytes[it->first] += it->second;
+    }
+}
+
+void
+QueueDiscStats::Print (std::ostream &os) const
+{
+  std::map<std::string, uint32_t>::const_iterator itp;
+  std::map<std::string, uint32_t>::const_iterator itb;
+
+  os << std::endl << "Packets/Bytes received: "
+     << nTotalReceivedPackets << " / " << nTotalReceivedBytes
+     << std::endl << "Packets/Bytes dropped: "
+     << nTotalDroppedPackets << " / " << nTotalDroppedBytes;
+  for (itp = nDroppedPackets.begin (), itb = nDroppedBytes.begin ();
+       itp != nDroppedPackets.end () && itb != nDroppedBytes.end (); ++itp, ++itb)
+    {
+      os << std::endl << "  " << itp->first << ": " << itp->second << " / " << itb->second;
+    }
+  os << std::endl << "Packets/Bytes marked: "
+     << nTotalMarkedPackets << " / " << nTotalMarkedBytes;
+  for (itp = nMarkedPackets.begin (), itb = nMarkedBytes.begin ();
+       itp != nMarkedPackets.end () && itb != nMarkedBytes.end (); ++itp, ++itb)
+    {
+      os << std::endl << "  " << itp->first << ": " << itp->second << " / " << itb->second;
+    }
+  os << std::endl << "Packets/Bytes requeued: "
+     << nTotalRequeuedPackets << " / " << nTotalRequeuedBytes
+     << std::endl;
+}
+
+std::ostream & operator << (std::ostream &os, const QueueDiscStats &stats)
+{
+  stats.Print (os);
+  return os;
+}
+
 QueueDiscItem::QueueDiscItem (Ptr<Packet> p, const Address& addr, uint16_t protocol)
   : QueueItem (p),
     m_address (addr),
     m_protocol (protocol),
-    m_txq (0)
+    m_txq (0),
+    m_flowHash (0),
+    m_flowHashValid (false)
 {
 }
 
@@ -77,6 +159,38 @@ QueueDiscItem::Print (std::ostream& os) const
   ;
 }
 
+uint32_t
+QueueDiscItem::Hash (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return 0;
+}
+
+uint32_t
+QueueDiscItem::GetFlowHash (uint32_t perturbation) const
+{
+  NS_LOG_FUNCTION (this << perturbation);
+  if (!m_flowHashValid)
+    {
+      m_flowHash = Hash ();
+      m_flowHashValid = true;
+    }
+  if (perturbation == 0)
+    {
+      return m_flowHash;
+    }
+  uint32_t buf[2] = { m_flowHash, perturbation };
+  return Hash32 ((const char*) buf, sizeof (buf));
+}
+
+void
+QueueDiscItem::SetFlowHash (uint32_t hash)
+{
+  NS_LOG_FUNCTION (this << hash);
+  m_flowHash = hash;
+  m_flowHashValid = true;
+}
+
 
 NS_OBJECT_ENSURE_REGISTERED (QueueDiscClass);
 
@@ -158,6 +272,9 @@ TypeId QueueDisc::GetTypeId (void)
     .AddTraceSource ("Drop", "Drop a packet stored in the queue disc",
                      MakeTraceSourceAccessor (&QueueDisc::m_traceDrop),
                      "ns3::QueueItem::TracedCallback")
+    .AddTraceSource ("Mark", "Mark a packet stored in the queue disc",
+                     MakeTraceSourceAccessor (&QueueDisc::m_traceMark),
+                     "ns3::QueueDisc::MarkTracedCallback")
     .AddTraceSource ("PacketsInQueue",
                      "Number of packets currently stored in the queue disc",
                      MakeTraceSourceAccessor (&QueueDisc::m_nPackets),
@@ -179,6 +296,8 @@ QueueDisc::QueueDisc ()
      m_nTotalDroppedBytes (0),
      m_nTotalRequeuedPackets (0),
      m_nTotalRequeuedBytes (0),
+     m_nTotalMarkedPackets (0),
+     m_nTotalMarkedBytes (0),
      m_running (false)
 {
   NS_LOG_FUNCTION (this);
@@ -193,7 +312,9 @@ QueueDisc::DoDispose (void)
   m_classes.clear ();
   m_device = 0;
   m_devQueueIface = 0;
-  m_requeued = 0;
+  m_requeued.clear ();
+  m_batch.clear ();
+  m_txBatch.clear ();
   Object::DoDispose ();
 }
 
@@ -280,6 +401,49 @@ QueueDisc:: GetTotalRequeuedBytes (void) const
   return m_nTotalRequeuedBytes;
 }
 
+uint32_t
+QueueDisc::GetTotalMarkedPackets (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_nTotalMarkedPackets;
+}
+
+uint32_t
+QueueDisc::GetTotalMarkedBytes (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_nTotalMarkedBytes;
+}
+
+QueueDiscStats
+QueueDisc::GetQueueDiscStats (void) const
+{
+  NS_LOG_FUNCTION (this);
+  QueueDiscStats stats;
+  stats.nTotalReceivedPackets = m_nTotalReceivedPackets;
+  stats.nTotalReceivedBytes = m_nTotalReceivedBytes;
+  stats.nTotalDroppedPackets = m_nTotalDroppedPackets;
+  stats.nTotalDroppedBytes = m_nTotalDroppedBytes;
+  stats.nTotalMarkedPackets = m_nTotalMarkedPackets;
+  stats.nTotalMarkedBytes = m_nTotalMarkedBytes;
+  stats.nTotalRequeuedPackets = m_nTotalRequeuedPackets;
+  stats.nTotalRequeuedBytes = m_nTotalRequeuedBytes;
+
+  // the reasons are only turned into strings here, off the per-packet path
+  ReasonCounters::const_iterator it;
+  for (it = m_dropReasons.begin (); it != m_dropReasons.end (); ++it)
+    {
+      stats.nDroppedPackets[it->reason] += it->packets;
+      stats.nDroppedBytes[it->reason] += it->bytes;
+    }
+  for (it = m_markReasons.begin (); it != m_markReasons.end (); ++it)
+    {
+      stats.nMarkedPackets[it->reason] += it->packets;
+      stats.nMarkedBytes[it->reason] += it->bytes;
+    }
+  return stats;
+}
+
 void
 QueueDisc::SetNetDevice (Ptr<NetDevice> device)
 {
@@ -312,6 +476,7 @@ void
 QueueDisc::AddInternalQueue (Ptr<Queue> queue)
 {
   NS_LOG_FUNCTION (this);
+  queue->SetDropCallback (MakeCallback (&QueueDisc::InternalQueueDropped, this));
   m_queues.push_back (queue);
 }
 
@@ -393,6 +558,20 @@ void
 QueueDisc::Drop (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
+  DoDrop (item, 0);
+}
+
+void
+QueueDisc::Drop (Ptr<QueueDiscItem> item, const char *reason)
+{
+  NS_LOG_FUNCTION (this << item << reason);
+  DoDrop (item, reason);
+}
+
+void
+QueueDisc::DoDrop (Ptr<QueueDiscItem> item, const char *reason)
+{
+  NS_LOG_FUNCTION (this << item << reason);
   NS_ASSERT_MSG (m_nPackets >= 1u, "No packet in the queue disc, cannot drop");
   NS_ASSERT_MSG (m_nBytes >= item->GetPacketSize (), "The size of the packet that"
                  << " is reported to be dropped is greater than the amount of bytes"
@@ -402,29 +581,111 @@ QueueDisc::Drop (Ptr<QueueDiscItem> item)
   m_nBytes -= item->GetPacketSize ();
   m_nTotalDroppedPackets++;
   m_nTotalDroppedBytes += item->GetPacketSize ();
+  if (reason != 0)
+    {
+      Count (m_dropReasons, reason, item->GetPacketSize ());
+    }
 
   NS_LOG_LOGIC ("m_traceDrop (p)");
   m_traceDrop (item);
+
+  if (!m_parentDropCallback.IsNull ())
+    {
+      m_parentDropCallback (item, reason);
+    }
+}
+
+bool
+QueueDisc::Mark (Ptr<QueueDiscItem> item, const char *reason)
+{
+  NS_LOG_FUNCTION (this << item << reason);
+
+  if (item->IsMarked ())
+    {
+      // already marked upstream or by this queue disc: nothing to count
+      return true;
+    }
+  if (!item->Mark ())
+    {
+      return false;
+    }
+
+  DoMark (item, reason);
+  return true;
+}
+
+void
+QueueDisc::DoMark (Ptr<QueueDiscItem> item, const char *reason)
+{
+  NS_LOG_FUNCTION (this << item << reason);
+
+  m_nTotalMarkedPackets++;
+  m_nTotalMarkedBytes += item->GetPacketSize ();
+  Count (m_markReasons, reason, item->GetPacketSize ());
+
+  NS_LOG_LOGIC ("m_traceMark (p)");
+  m_traceMark (item, reason);
+
+  if (!m_parentMarkCallback.IsNull ())
+    {
+      m_parentMarkCallback (item, reason);
+    }
 }
 
-/*bool QueueDisc::isEcnEnabled(Ptr<QueueDiscItem> item)
+void
+QueueDisc::ChildDropped (Ptr<QueueDiscItem> item, const char *reason)
 {
-  Ptr<Packet> pac = item->GetPacket();
-  Ipv4Header ipvh;
-  pac->PeekHeader(ipvh);
-  if(ipvh.GetEcn()==EcnType.ECN_ECT1 || ipvh.GetEcn()==EcnType.ECN_ECT2)
-    return true;
-  return false;
+  NS_LOG_FUNCTION (this << item << reason);
+  DoDrop (item, reason);
 }
 
-void QueueDisc::Mark (Ptr<QueueDiscItem> item)
+void
+QueueDisc::ChildMarked (Ptr<QueueDiscItem> item, const char *reason)
 {
-  Ptr<Packet> pac = item->GetPacket();
-  Ipv4Header ipvh;
-  pac->RemoveHeader(ipvh);
-  ipvh.SetEcn(EcnType.CE);
-  pac->AddHeader(ipvh);
-}*/
+  NS_LOG_FUNCTION (this << item << reason);
+  DoMark (item, reason);
+}
+
+void
+QueueDisc::InternalQueueDropped (Ptr<QueueItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  DoDrop (StaticCast<QueueDiscItem> (item), 0);
+}
+
+void
+QueueDisc::SetParentDropCallback (ParentCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_parentDropCallback = cb;
+}
+
+void
+QueueDisc::SetParentMarkCallback (ParentCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_parentMarkCallback = cb;
+}
+
+void
+QueueDisc::Count (ReasonCounters &counters, const char *reason, uint32_t bytes)
+{
+  ReasonCounters::iterator it;
+  for (it = counters.begin (); it != counters.end (); ++it)
+    {
+      if (it->reason == reason || std::strcmp (it->reason, reason) == 0)
+        {
+          it->packets++;
+          it->bytes += bytes;
+          return;
+        }
+    }
+  ReasonCounter counter;
+  counter.reason = reason;
+  counter.packets = 1;
+  counter.bytes = bytes;
+  counters.push_back (counter);
+}
 
 bool
 QueueDisc::Enqueue (Ptr<QueueDiscItem> item)
@@ -462,6 +723,28 @@ QueueDisc::Dequeue (void)
   return item;
 }
 
+uint32_t
+QueueDisc::DequeueBatch (std::vector<Ptr<QueueDiscItem> > &items,
+                         uint32_t maxPackets, uint32_t maxBytes)
+{
+  NS_LOG_FUNCTION (this << maxPackets << maxBytes);
+
+  uint32_t packets = 0;
+  uint32_t bytes = 0;
+  while (packets < maxPackets && bytes <= maxBytes)
+    {
+      Ptr<QueueDiscItem> item = Dequeue ();
+      if (item == 0)
+        {
+          break;
+        }
+      items.push_back (item);
+      packets++;
+      bytes += item->GetPacketSize ();
+    }
+  return packets;
+}
+
 Ptr<const QueueDiscItem>
 QueueDisc::Peek (void) const
 {
@@ -477,9 +760,10 @@ QueueDisc::Run (void)
   if (RunBegin ())
     {
       uint32_t quota = m_quota;
-      while (Restart ())
+      uint32_t packets;
+      while (Restart (quota, packets))
         {
-          quota -= 1;
+          quota -= packets;
           if (quota <= 0)
             {
               /// \todo netif_schedule (q);
@@ -511,9 +795,10 @@ QueueDisc::RunEnd (void)
 }
 
 bool
-QueueDisc::Restart (void)
+QueueDisc::Restart (uint32_t budget, uint32_t &packets)
 {
-  NS_LOG_FUNCTION (this);
+  NS_LOG_FUNCTION (this << budget);
+  packets = 0;
   Ptr<QueueDiscItem> item = DequeuePacket();
   if (item == 0)
     {
@@ -521,6 +806,13 @@ QueueDisc::Restart (void)
       return false;
     }
 
+  if (budget > 1 && TryBulkDequeue (item, budget))
+    {
+      packets = m_batch.size ();
+      return TransmitBatch ();
+    }
+
+  packets = 1;
   return Transmit (item);
 }
 
@@ -532,15 +824,15 @@ QueueDisc::DequeuePacket ()
   Ptr<QueueDiscItem> item;
 
   // First check if there is a requeued packet
-  if (m_requeued != 0)
+  if (!m_requeued.empty ())
     {
         // If the queue where the requeued packet is destined to is not stopped, return
         // the requeued packet; otherwise, return an empty packet.
         // If the device does not support flow control, the device queue is never stopped
-        if (!m_devQueueIface->GetTxQueue (m_requeued->GetTxQueueIndex ())->IsStopped ())
+        if (!m_devQueueIface->GetTxQueue (m_requeued.front ()->GetTxQueueIndex ())->IsStopped ())
           {
-            item = m_requeued;
-            m_requeued = 0;
+            item = m_requeued.front ();
+            m_requeued.pop_front ();
 
             m_nPackets--;
             m_nBytes -= item->GetPacketSize ();
@@ -564,17 +856,82 @@ QueueDisc::DequeuePacket ()
             {
               item->AddHeader ();
             }
-          // Here, Linux tries bulk dequeues
         }
     }
   return item;
 }
 
+bool
+QueueDisc::TryBulkDequeue (Ptr<QueueDiscItem> item, uint32_t maxPackets)
+{
+  NS_LOG_FUNCTION (this << item << maxPackets);
+
+  // As in Linux, packets are sent in batches only to devices with a single
+  // transmission queue. The batch contains no more packets than the device
+  // can accept and, if the transmission queue has queue limits, than the
+  // room left by the queue limits, i.e., the packets that would be sent one
+  // by one before the transmission queue is stopped. Hence, the packets are
+  // not taken away from the queue disc earlier than they would otherwise be.
+  if (m_nPackets == 0u || m_devQueueIface->GetNTxQueues () > 1)
+    {
+      return false;
+    }
+  maxPackets = std::min (maxPackets, m_device->GetMaxSendBatchSize ());
+  if (maxPackets <= 1)
+    {
+      return false;
+    }
+
+  uint32_t maxBytes = std::numeric_limits<uint32_t>::max ();
+  Ptr<QueueLimits> limits = m_devQueueIface->GetTxQueue (0)->GetQueueLimits ();
+  if (limits != 0)
+    {
+      // the transmission queue would be stopped after sending the item
+      int32_t available = limits->Available ();
+      if (available < static_cast<int32_t> (item->GetPacketSize ()))
+        {
+          return false;
+        }
+      maxBytes = available - item->GetPacketSize ();
+    }
+
+  m_batch.clear ();
+  m_batch.push_back (item);
+
+  // Requeued packets first, so that the packets are sent in order
+  uint32_t bytes = 0;
+  while (bytes <= maxBytes && m_batch.size () < maxPackets && !m_requeued.empty ())
+    {
+      Ptr<QueueDiscItem> next = DequeuePacket ();
+      NS_ASSERT (next != 0);
+      bytes += next->GetPacketSize ();
+      m_batch.push_back (next);
+    }
+
+  if (bytes <= maxBytes && m_batch.size () < maxPackets)
+    {
+      uint32_t first = m_batch.size ();
+      DequeueBatch (m_batch, maxPackets - first, maxBytes - bytes);
+      for (uint32_t i = first; i < m_batch.size (); i++)
+        {
+          m_batch[i]->AddHeader ();
+        }
+    }
+
+  NS_LOG_LOGIC ("Dequeued a batch of " << m_batch.size () << " packets");
+  if (m_batch.size () == 1)
+    {
+      m_batch.clear ();
+      return false;
+    }
+  return true;
+}
+
 void
 QueueDisc::Requeue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
-  m_requeued = item;
+  m_requeued.push_front (item);
   /// \todo netif_schedule (q);
 
   m_nPackets++;       // it's still part of the queue
@@ -598,7 +955,8 @@ QueueDisc::Transmit (Ptr<QueueDiscItem> item)
       // send a copy of the packet because the device might add the
       // MAC header even if the transmission is unsuccessful (see BUG 2284)
       Ptr<Packet> copy = item->GetPacket ()->Copy ();
-      ret = m_device->Send (copy, item->GetAddress (), item->GetProtocol ());
+      ret = m_device->SendToTxQueue (copy, item->GetAddress (), item->GetProtocol (),
+                                     item->GetTxQueueIndex ());
     }
 
   // If the transmission did not happen or failed, requeue the item
@@ -616,4 +974,38 @@ QueueDisc::Transmit (Ptr<QueueDiscItem> item)
   return ret;
 }
 
+bool
+QueueDisc::TransmitBatch (void)
+{
+  NS_LOG_FUNCTION (this << m_batch.size ());
+  NS_ASSERT (m_devQueueIface);
+  Ptr<NetDeviceQueue> txq = m_devQueueIface->GetTxQueue (0);
+  uint32_t sent = 0;
+
+  if (!txq->IsStopped ())
+    {
+      m_txBatch.resize (m_batch.size ());
+      for (uint32_t i = 0; i < m_batch.size (); i++)
+        {
+          // send copies of the packets (see Transmit)
+          m_txBatch[i].packet = m_batch[i]->GetPacket ()->Copy ();
+          m_txBatch[i].dest = m_batch[i]->GetAddress ();
+          m_txBatch[i].protocolNumber = m_batch[i]->GetProtocol ();
+        }
+      sent = m_device->SendBatch (m_txBatch);
+      NS_ASSERT (sent <= m_batch.size ());
+      m_txBatch.clear ();
+    }
+
+  // Requeue the items the device did not accept, preserving their order
+  for (uint32_t i = m_batch.size (); i > sent; i--)
+    {
+      Requeue (m_batch[i - 1]);
+    }
+  m_batch.clear ();
+
+  // If no packet was sent or the queue is now stopped, return false
+  return sent > 0 && !txq->IsStopped ();
+}
+
 } // namespace ns3
@@ -24,7 +24,11 @@
 #include "ns3/traced-value.h"
 #include <ns3/queue.h>
 #include "ns3/net-device.h"
+#include "ns3/traced-callback.h"
 #include <vector>
+#include <list>
+#include <map>
+#include <string>
 #include "packet-filter.h"
 
 namespace ns3 {
@@ -103,6 +107,45 @@ public:
    */
   virtual bool IsMarked (void) const = 0;
 
+  /**
+   * \brief Compute the hash of the flow the packet belongs to
+   *
+   * Subclasses storing packets of a given network protocol hash the 5-tuple
+   * (addresses, transport protocol and ports) found in the headers, so that
+   * queue discs such as FqCoDelQueueDisc can classify the packets without an
+   * external PacketFilter. The implementation of this base class returns 0,
+   * i.e., all the packets belong to the same flow. The perturbation used by
+   * the classifiers is combined with this hash by GetFlowHash.
+   *
+   * \returns the hash of the flow the packet belongs to
+   */
+  virtual uint32_t Hash (void) const;
+
+  /**
+   * \brief Get the hash of the flow the packet belongs to
+   *
+   * Similarly to the skb->hash of Linux, the hash of the flow is computed
+   * (through the Hash method) the first time it is
+   * needed and then stored in the item, so that the packet filters, the
+   * queue discs and the selection of the transmission queue of multi-queue
+   * devices share the same value without parsing the headers again. A non
+   * zero perturbation is combined with the stored hash.
+   *
+   * \param perturbation the value to combine with the hash of the flow
+   * \returns the hash of the flow the packet belongs to
+   */
+  uint32_t GetFlowHash (uint32_t perturbation = 0) const;
+
+  /**
+   * \brief Set the hash of the flow the packet belongs to
+   *
+   * Allows the code creating the item to provide a hash of the flow computed
+   * by other means, which is then returned by GetFlowHash.
+   *
+   * \param hash the hash of the flow the packet belongs to
+   */
+  void SetFlowHash (uint32_t hash);
+
 private:
   /**
    * \brief Default constructor
@@ -127,6 +170,8 @@ private:
   Address m_address;      //!< MAC destination address
   uint16_t m_protocol;    //!< L3 Protocol number
   uint8_t m_txq;          //!< Transmission queue index
+  mutable uint32_t m_flowHash;    //!< Hash of the flow, if m_flowHashValid
+  mutable bool m_flowHashValid;   //!< True if the hash of the flow is stored
 
 };
 
@@ -173,6 +218,53 @@ private:
 };
 
 
+/**
+ * \ingroup traffic-control
+ *
+ * Structure that keeps the statistics of a queue disc: the packets and bytes
+ * received, dropped, marked and requeued, with the drops and marks also
+ * broken down by the reason reported by the queue disc.  Drops reported
+ * without a reason only appear in the totals.
+ */
+struct QueueDiscStats
+{
+  QueueDiscStats ();
+
+  /**
+   * \brief Add the counters of another set of statistics to these ones
+   * \param stats the statistics to add
+   */
+  void Add (const QueueDiscStats &stats);
+
+  /**
+   * \brief Print the statistics.
+   * \param os output stream in which the data should be printed.
+   */
+  void Print (std::ostream &os) const;
+
+  uint32_t nTotalReceivedPackets;  //!< Total received packets
+  uint32_t nTotalReceivedBytes;    //!< Total received bytes
+  uint32_t nTotalDroppedPackets;   //!< Total dropped packets
+  uint32_t nTotalDroppedBytes;     //!< Total dropped bytes
+  uint32_t nTotalMarkedPackets;    //!< Total marked packets
+  uint32_t nTotalMarkedBytes;      //!< Total marked bytes
+  uint32_t nTotalRequeuedPackets;  //!< Total requeued packets
+  uint32_t nTotalRequeuedBytes;    //!< Total requeued bytes
+  std::map<std::string, uint32_t> nDroppedPackets; //!< Dropped packets, per reason
+  std::map<std::string, uint32_t> nDroppedBytes;   //!< Dropped bytes, per reason
+  std::map<std::string, uint32_t> nMarkedPackets;  //!< Marked packets, per reason
+  std::map<std::string, uint32_t> nMarkedBytes;    //!< Marked bytes, per reason
+};
+
+/**
+ * \brief Stream insertion operator.
+ * \param os the stream
+ * \param stats the queue disc statistics
+ * \returns a reference to the stream
+ */
+std::ostream & operator << (std::ostream &os, const QueueDiscStats &stats);
+
+
 /**
  * \ingroup traffic-control
  *
@@ -287,6 +379,56 @@ public:
    */
   uint32_t GetTotalRequeuedBytes (void) const;
 
+  /**
+   * \brief Get the total number of packets marked with Congestion Experienced
+   * \return the total number of marked packets.
+   */
+  uint32_t GetTotalMarkedPackets (void) const;
+
+  /**
+   * \brief Get the total amount of bytes marked with Congestion Experienced
+   * \return the total amount of marked bytes.
+   */
+  uint32_t GetTotalMarkedBytes (void) const;
+
+  /**
+   * \brief Get the statistics of this queue disc, including the drops and
+   * the marks per reason
+   * \return the statistics of this queue disc.
+   */
+  QueueDiscStats GetQueueDiscStats (void) const;
+
+  /**
+   * TracedCallback signature for packet mark events.
+   *
+   * \param [in] item The item whose packet has been marked.
+   * \param [in] reason The reason reported by the queue disc.
+   */
+  typedef void (* MarkTracedCallback)(Ptr<const QueueDiscItem> item, const char *reason);
+
+  /**
+   * Callback used by a child queue disc to notify its parent of a drop or a
+   * mark, along with the reason reported (null if none).
+   */
+  typedef Callback<void, Ptr<QueueDiscItem>, const char *> ParentCallback;
+
+  /**
+   * \brief Set the callback to notify the parent queue disc of the packets
+   *        dropped by this (child) queue disc
+   * \param cb the callback
+   *
+   * The packets dropped by a child queue disc are still accounted in the
+   * parent queue disc, which thus needs to update its counters.
+   */
+  void SetParentDropCallback (ParentCallback cb);
+
+  /**
+   * \brief Set the callback to notify the parent queue disc of the packets
+   *        marked by this (child) queue disc
+   * \param cb the callback
+   */
+  void SetParentMarkCallback (ParentCallback cb);
+
   /**
    * \brief Set the NetDevice on which this queue discipline is installed.
    * \param device the NetDevice on which this queue discipline is installed.
@@ -328,6 +470,22 @@ public:
    */
   Ptr<QueueDiscItem> Dequeue (void);
 
+  /**
+   * Request the queue discipline to extract up to maxPackets packets, which
+   * are appended to the given vector, and stop as soon as the total size of
+   * the extracted packets exceeds maxBytes (i.e., the packet which exhausts
+   * the byte budget is extracted, too) or the queue disc is empty.
+   * This function is used to dequeue the packets sent to the device in a
+   * batch. The default implementation calls Dequeue for each packet;
+   * subclasses may override it to amortize the per-packet work.
+   * \param items the vector the extracted items are appended to
+   * \param maxPackets the maximum number of packets to extract
+   * \param maxBytes the byte budget
+   * \return the number of extracted packets
+   */
+  virtual uint32_t DequeueBatch (std::vector<Ptr<QueueDiscItem> > &items,
+                                 uint32_t maxPackets, uint32_t maxBytes);
+
   /**
    * Get a copy of the next packet the queue discipline will extract, without
    * actually extracting the packet. This function only calls the (private)
@@ -339,7 +497,10 @@ public:
   /**
    * Modelled after the Linux function __qdisc_run (net/sched/sch_generic.c)
    * Dequeues multiple packets, until a quota is exceeded or sending a packet
-   * to the device failed.
+   * to the device failed. If the device supports SendBatch and has a single
+   * transmission queue, the packets are dequeued and sent in batches, whose
+   * size is bounded by the remaining quota, by the room in the device and
+   * by the room left by the queue limits (if any).
    */
   void Run (void);
 
@@ -432,7 +593,7 @@ public:
    *
    * \return the wake mode adopted by this queue disc.
    */
-  WakeMode GetWakeMode (void);
+  virtual WakeMode GetWakeMode (void);
 
 protected:
   /**
@@ -451,8 +612,87 @@ protected:
    *  This method is called by subclasses to notify parent (this class) of packet drops.
    */
   void Drop (Ptr<QueueDiscItem> item);
+
+  /**
+   *  \brief Drop a packet, accounting the drop to the given reason
+   *  \param item item that was dropped
+   *  \param reason the reason of the drop, a string constant of the subclass
+   */
+  void Drop (Ptr<QueueDiscItem> item, const char *reason);
+
+  /**
+   *  \brief Mark a packet with Congestion Experienced
+   *  \param item item to mark
+   *  \param reason the reason of the mark, a string constant of the subclass
+   *  \return true if the packet has been marked or was already marked, false
+   *          if it is not ECN capable
+   *
+   *  This method is called by subclasses instead of QueueDiscItem::Mark to
+   *  have the mark counted and traced.  Packets that were already marked are
+   *  not counted again.
+   */
+  bool Mark (Ptr<QueueDiscItem> item, const char *reason);
+
+  /**
+   *  \brief Account a packet dropped by a child queue disc
+   *  \param item item that was dropped
+   *  \param reason the reason reported by the child queue disc, if any
+   *
+   *  Classful queue discs set this method as the parent drop callback of
+   *  their child queue discs.
+   */
+  void ChildDropped (Ptr<QueueDiscItem> item, const char *reason);
+
+  /**
+   *  \brief Account a packet marked by a child queue disc
+   *  \param item item that was marked
+   *  \param reason the reason reported by the child queue disc
+   *
+   *  Classful queue discs set this method as the parent mark callback of
+   *  their child queue discs.
+   */
+  void ChildMarked (Ptr<QueueDiscItem> item, const char *reason);
  
 private:
+  /// Packets and bytes accounted to a drop or mark reason
+  struct ReasonCounter
+  {
+    const char *reason; //!< The reason
+    uint32_t packets;   //!< Number of packets
+    uint32_t bytes;     //!< Number of bytes
+  };
+  /// Counters of the reasons reported so far, in order of first occurrence
+  typedef std::vector<ReasonCounter> ReasonCounters;
+
+  /**
+   * Account a packet to a reason.  Subclasses use a handful of string
+   * constants, so the counters are kept in a vector searched by address.
+   * \param counters the counters
+   * \param reason the reason
+   * \param bytes the size of the packet
+   */
+  static void Count (ReasonCounters &counters, const char *reason, uint32_t bytes);
+
+  /**
+   * Update the counters and notify the parent of a dropped packet.
+   * \param item item that was dropped
+   * \param reason the reason of the drop, or null
+   */
+  void DoDrop (Ptr<QueueDiscItem> item, const char *reason);
+
+  /**
+   * Update the counters and notify the parent of a marked packet.
+   * \param item item that was marked
+   * \param reason the reason of the mark
+   */
+  void DoMark (Ptr<QueueDiscItem> item, const char *reason);
+
+  /**
+   * Drop callback of the internal queues: the packets they drop (when full
+   * or through Queue::Remove) are accounted as dropped by the queue disc.
+   * \param item item that was dropped
+   */
+  void InternalQueueDropped (Ptr<QueueItem> item);
 
   /**
    * This function actually enqueues a packet into the queue disc.
@@ -500,10 +740,14 @@ private:
 
   /**
    * Modelled after the Linux function qdisc_restart (net/sched/sch_generic.c)
-   * Dequeue a packet (by calling DequeuePacket) and send it to the device (by calling Transmit).
-   * \return true if a packet is successfully sent to the device.
+   * Dequeue a packet (by calling DequeuePacket), possibly followed by other
+   * packets (by calling TryBulkDequeue), and send them to the device (by
+   * calling Transmit or TransmitBatch).
+   * \param budget the maximum number of packets to dequeue
+   * \param packets the number of packets dequeued
+   * \return true if the packets are successfully sent to the device.
    */
-  bool Restart (void);
+  bool Restart (uint32_t budget, uint32_t &packets);
 
   /**
    * Modelled after the Linux function dequeue_skb (net/sched/sch_generic.c)
@@ -511,9 +755,23 @@ private:
    */
   Ptr<QueueDiscItem> DequeuePacket (void);
 
+  /**
+   * Modelled after the Linux function try_bulk_dequeue_skb (net/sched/sch_generic.c)
+   * Dequeue the packets following the given one (the requeued packets first)
+   * and store all of them in the batch to send to the device. This is only
+   * done if the device supports SendBatch and has a single transmission
+   * queue. The size of the batch is bounded by the room in the device and,
+   * if the transmission queue has queue limits, by the room they leave.
+   * \param item the packet already dequeued
+   * \param maxPackets the maximum number of packets in the batch
+   * \return true if the batch contains more than one packet
+   */
+  bool TryBulkDequeue (Ptr<QueueDiscItem> item, uint32_t maxPackets);
+
   /**
    * Modelled after the Linux function dev_requeue_skb (net/sched/sch_generic.c)
-   * Requeues a packet whose transmission failed.
+   * Requeues a packet whose transmission failed. The packet is inserted at
+   * the head of the requeued packets, which are sent before any other packet.
    * \param p the packet to requeue
    */
   void Requeue (Ptr<QueueDiscItem> p);
@@ -526,6 +784,13 @@ private:
    */
   bool Transmit (Ptr<QueueDiscItem> p);
 
+  /**
+   * Sends the batch of packets to the device (by calling SendBatch) and
+   * requeues the packets the device did not accept.
+   * \return true if at least a packet was sent and the queue is not stopped
+   */
+  bool TransmitBatch (void);
+
   static const uint32_t DEFAULT_QUOTA = 64; //!< Default quota (as in /proc/sys/net/core/dev_weight)
 
   std::vector<Ptr<Queue> > m_queues;            //!< Internal queues
@@ -541,11 +806,19 @@ private:
   uint32_t m_nTotalDroppedBytes;    //!< Total dropped bytes
   uint32_t m_nTotalRequeuedPackets; //!< Total requeued packets
   uint32_t m_nTotalRequeuedBytes;   //!< Total requeued bytes
+  uint32_t m_nTotalMarkedPackets;   //!< Total marked packets
+  uint32_t m_nTotalMarkedBytes;     //!< Total marked bytes
+  ReasonCounters m_dropReasons;     //!< Drops per reason
+  ReasonCounters m_markReasons;     //!< Marks per reason
   uint32_t m_quota;                 //!< Maximum number of packets dequeued in a qdisc run
   Ptr<NetDevice> m_device;          //!< The NetDevice on which this queue discipline is installed
   Ptr<NetDeviceQueueInterface> m_devQueueIface;   //!< NetDevice queue interface
   bool m_running;                   //!< The queue disc is performing multiple dequeue operations
-  Ptr<QueueDiscItem> m_requeued;    //!< The last packet that failed to be transmitted
+  std::list<Ptr<QueueDiscItem> > m_requeued;    //!< The packets that failed to be transmitted
+  std::vector<Ptr<QueueDiscItem> > m_batch;     //!< The batch of items being sent to the device
+  std::vector<NetDevice::BatchItem> m_txBatch;  //!< The batch of packets passed to the device
+  ParentCallback m_parentDropCallback; //!< Notifies the parent of a drop
+  ParentCallback m_parentMarkCallback; //!< Notifies the parent of a mark
 
   /// Traced callback: fired when a packet is enqueued
   TracedCallback<Ptr<const QueueItem> > m_traceEnqueue;
@@ -555,6 +828,8 @@ private:
   TracedCallback<Ptr<const QueueItem> > m_traceRequeue;
   /// Traced callback: fired when a packet is dropped
   TracedCallback<Ptr<const QueueItem> > m_traceDrop;
+  /// Traced callback: fired when a packet is marked
+  TracedCallback<Ptr<const QueueDiscItem>, const char *> m_traceMark;
 };
 
 } // namespace ns3
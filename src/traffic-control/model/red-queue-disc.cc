@@ -72,6 +72,13 @@ NS_LOG_COMPONENT_DEFINE ("RedQueueDisc");
 
 NS_OBJECT_ENSURE_REGISTERED (RedQueueDisc);
 
+const char * const RedQueueDisc::UNFORCED_DROP = "Unforced drop";
+const char * const RedQueueDisc::FORCED_DROP = "Forced drop";
+const char * const RedQueueDisc::QLIM_DROP = "Queue limit drop";
+const char * const RedQueueDisc::UNFORCED_MARK = "Unforced mark";
+const char * const RedQueueDisc::FORCED_MARK = "Forced mark";
+const char * const RedQueueDisc::STEP_MARK = "Step mark";
+
 TypeId RedQueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::RedQueueDisc")
@@ -114,6 +121,13 @@ TypeId RedQueueDisc::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&RedQueueDisc::m_isAdaptMaxP),
                    MakeBooleanChecker ())
+    .AddAttribute ("StepMarking",
+                   "True to mark (as required by DCTCP) all the ECN-capable packets arriving "
+                   "when the instantaneous queue length exceeds MinTh, instead of dropping or "
+                   "marking on the average queue length",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RedQueueDisc::m_isStepMarking),
+                   MakeBooleanChecker ())
     .AddAttribute ("MinTh",
                    "Minimum average length threshold in packets/bytes",
                    DoubleValue (5),
@@ -350,22 +364,32 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   m_countBytes += item->GetPacketSize ();
 
   uint32_t dropType = DTYPE_NONE;
+  const char *dropReason = FORCED_DROP;
   
-  if (m_qAvg >= m_minTh && nQueued > 1)
+  if (m_isStepMarking)
+    {
+      // Packets which are not ECN-capable are only subject to the queue limit
+      if (nQueued > m_minTh && Mark (item, STEP_MARK))
+        {
+          NS_LOG_DEBUG ("adding STEP MARK");
+          m_stats.stepMark++;
+        }
+    }
+  else if (m_qAvg >= m_minTh && nQueued > 1)
     {
       if ((!m_isGentle && m_qAvg >= m_maxTh) ||
           (m_isGentle && m_qAvg >= 2 * m_maxTh))
         {
-           if (item->Mark())
-          {
-            NS_LOG_DEBUG("adding FORCED MARK");
-            m_stats.forcedMark++;
-          }
+          if (Mark (item, FORCED_MARK))
+            {
+              NS_LOG_DEBUG ("adding FORCED MARK");
+              m_stats.forcedMark++;
+            }
           else
-          {
-            NS_LOG_DEBUG ("adding FORCED DROP ");
-            dropType = DTYPE_FORCED;
-          }
+            {
+              NS_LOG_DEBUG ("adding FORCED DROP ");
+              dropType = DTYPE_FORCED;
+            }
         }
       else if (m_old == 0)
         {
@@ -382,14 +406,14 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
       else if (DropEarly (item, nQueued))
         {
           NS_LOG_LOGIC ("DropEarly returns 1");
-          if(item->Mark())
-          {
-             m_stats.unforcedMark++;
-          }
+          if (Mark (item, UNFORCED_MARK))
+            {
+              m_stats.unforcedMark++;
+            }
           else
-          {
-            dropType = DTYPE_UNFORCED;
-          }
+            {
+              dropType = DTYPE_UNFORCED;
+            }
         }
     }
   else 
@@ -404,6 +428,7 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
     {
       NS_LOG_DEBUG ("\t Dropping due to Queue Full " << nQueued);
       dropType = DTYPE_FORCED;
+      dropReason = QLIM_DROP;
       m_stats.qLimDrop++;
     }
 
@@ -411,14 +436,14 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
     {
       NS_LOG_DEBUG ("\t Dropping due to Prob Mark " << m_qAvg);
       m_stats.unforcedDrop++;
-      Drop (item);
+      Drop (item, UNFORCED_DROP);
       return false;
     }
   else if (dropType == DTYPE_FORCED)
     {
       NS_LOG_DEBUG ("\t Dropping due to Hard Mark " << m_qAvg);
       m_stats.forcedDrop++;
-      Drop (item);
+      Drop (item, dropReason);
       if (m_isNs1Compat)
         {
           m_count = 0;
@@ -487,6 +512,7 @@ RedQueueDisc::InitializeParams (void)
   m_stats.qLimDrop = 0;
   m_stats.forcedMark = 0;
   m_stats.unforcedMark = 0;
+  m_stats.stepMark = 0;
   m_qAvg = 0.0;
   m_count = 0;
   m_countBytes = 0;
@@ -110,6 +110,7 @@ public:
     uint32_t qLimDrop;      //!< Drops due to queue limits
     uint32_t unforcedMark;  //!< Early probability marks
     uint32_t forcedMark;    //!< Forced mark, qavg > max threshold
+    uint32_t stepMark;      //!< Step marks, instantaneous queue > min threshold
   } Stats;
 
   /** 
@@ -129,6 +130,14 @@ public:
     MTYPE_UNFORCED,    //!< An "unforced" (random) mark
   };
 
+  // Reasons for dropping or marking packets
+  static const char * const UNFORCED_DROP; //!< Early probability drops
+  static const char * const FORCED_DROP; //!< Forced drops, qavg > max threshold
+  static const char * const QLIM_DROP; //!< Drops due to queue limits
+  static const char * const UNFORCED_MARK; //!< Early probability marks
+  static const char * const FORCED_MARK; //!< Forced marks, qavg > max threshold
+  static const char * const STEP_MARK; //!< Step marks, instantaneous queue > min threshold
+
   /**
    * \brief Set the operating mode of this queue.
    *  Set operating mode
@@ -292,6 +301,7 @@ private:
   bool m_isGentle;          //!< True to increases dropping prob. slowly when ave queue exceeds maxthresh
   bool m_isARED;            //!< True to enable Adaptive RED
   bool m_isAdaptMaxP;       //!< True to adapt m_curMaxP
+  bool m_isStepMarking;     //!< True to mark on the instantaneous queue length (DCTCP)
   double m_minTh;           //!< Min avg length threshold (bytes)
   double m_maxTh;           //!< Max avg length threshold (bytes), should be >= 2*minTh
   uint32_t m_queueLimit;    //!< Queue limit in bytes / packets
@@ -333,8 +343,6 @@ private:
   Time m_idleTime;          //!< Start of current idle period
 
   Ptr<UniformRandomVariable> m_uv;  //!< rng stream
-
-  //TracedCallback<Ptr<const QueueItem> > m_traceMark;
 };
 
 }; // namespace ns3
@@ -80,6 +80,10 @@ TrafficControlLayer::DoInitialize (void)
           Ptr<NetDeviceQueueInterface> devQueueIface = ndi->second.ndqi;
           NS_ASSERT (devQueueIface);
 
+          // initialize the queue disc first, since multi-queue aware queue discs
+          // (e.g., mq) may create their child queue discs when initialized
+          ndi->second.rootQueueDisc->Initialize ();
+
           // set the wake callbacks on netdevice queues
            if (ndi->second.rootQueueDisc->GetWakeMode () == QueueDisc::WAKE_ROOT)
             {
@@ -100,9 +104,6 @@ TrafficControlLayer::DoInitialize (void)
                   ndi->second.queueDiscsToWake.push_back (ndi->second.rootQueueDisc->GetQueueDiscClass (i)->GetQueueDisc ());
                 }
             }
-
-          // initialize the queue disc
-          ndi->second.rootQueueDisc->Initialize ();
         }
     }
   Object::DoInitialize ();
@@ -307,12 +308,13 @@ TrafficControlLayer::Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
         {
           txq = ndi->second.selectQueueCallback (item);
         }
-      // otherwise, Linux determines the queue index by using a hash function
-      // and associates such index to the socket which the packet belongs to,
-      // so that subsequent packets of the same socket will be mapped to the
-      // same tx queue (__netdev_pick_tx function in net/core/dev.c). It is
-      // pointless to implement this in ns-3 because currently the multi-queue
-      // devices provide a select queue callback
+      else
+        {
+          // otherwise, as Linux does (skb_tx_hash function in net/core/dev.c),
+          // use the hash of the flow, so that the packets of a flow are all
+          // mapped to the same tx queue
+          txq = item->GetFlowHash () % devQueueIface->GetNTxQueues ();
+        }
     }
 
   NS_ASSERT (txq < devQueueIface->GetNTxQueues ());
@@ -330,7 +332,7 @@ TrafficControlLayer::Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
               SocketPriorityTag priorityTag;
               item->GetPacket ()->RemovePacketTag (priorityTag);
             }
-          device->Send (item->GetPacket (), item->GetAddress (), item->GetProtocol ());
+          device->SendToTxQueue (item->GetPacket (), item->GetAddress (), item->GetProtocol (), txq);
         }
     }
   else
@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/codel-queue-disc.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-queue-disc-item.h"
+
+using namespace ns3;
+
+class EcnCodelQueueDiscTestItem : public Ipv4QueueDiscItem {
+public:
+  EcnCodelQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, const Ipv4Header & header);
+  virtual ~EcnCodelQueueDiscTestItem ();
+
+private:
+  EcnCodelQueueDiscTestItem ();
+  EcnCodelQueueDiscTestItem (const EcnCodelQueueDiscTestItem &);
+  EcnCodelQueueDiscTestItem &operator = (const EcnCodelQueueDiscTestItem &);
+};
+
+EcnCodelQueueDiscTestItem::EcnCodelQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, const Ipv4Header & header)
+  : Ipv4QueueDiscItem (p, addr, protocol, header)
+{
+}
+
+EcnCodelQueueDiscTestItem::~EcnCodelQueueDiscTestItem ()
+{
+}
+
+class EcnCodelQueueDiscTestCase : public TestCase
+{
+public:
+  EcnCodelQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  Ptr<CoDelQueueDisc> CreateQueue (StringValue mode, bool useEcn);
+  void Enqueue (Ptr<CoDelQueueDisc> queue, uint32_t nPkt, Ipv4Header::EcnType ecn);
+  void Dequeue (Ptr<CoDelQueueDisc> queue, bool marked, std::string msg);
+  void RunCodelTest (StringValue mode);
+  void RunCeThresholdTest (StringValue mode);
+};
+
+EcnCodelQueueDiscTestCase::EcnCodelQueueDiscTestCase ()
+  : TestCase ("Sanity check on the ECN support of the codel queue implementation")
+{
+}
+
+Ptr<CoDelQueueDisc>
+EcnCodelQueueDiscTestCase::CreateQueue (StringValue mode, bool useEcn)
+{
+  Ptr<CoDelQueueDisc> queue = CreateObject<CoDelQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseEcn", BooleanValue (useEcn)), true,
+                         "Verify that we can actually set the attribute UseEcn");
+  queue->Initialize ();
+  return queue;
+}
+
+void
+EcnCodelQueueDiscTestCase::RunCodelTest (StringValue mode)
+{
+  // Same schedule as the basic drop test of the codel queue disc: the
+  // first dequeue sees the sojourn time go above target, the second one
+  // enters the dropping state, the third one is not yet time for the next
+  // drop and the fourth one is.
+  Time first = MilliSeconds (10);
+  Time second = first + MilliSeconds (200);
+  Time fourth = second * 2;
+
+  // test 1: ECN capable packets are marked instead of dropped
+  Ptr<CoDelQueueDisc> queue = CreateQueue (mode, true);
+  Enqueue (queue, 20, Ipv4Header::ECN_ECT0);
+  Simulator::Schedule (first, &EcnCodelQueueDiscTestCase::Dequeue, this, queue, false,
+                       "The sojourn time has just gone above target, no packet should be marked");
+  Simulator::Schedule (second, &EcnCodelQueueDiscTestCase::Dequeue, this, queue, true,
+                       "The first packet of the dropping state should be marked");
+  Simulator::Schedule (second, &EcnCodelQueueDiscTestCase::Dequeue, this, queue, false,
+                       "It is not time for the next mark yet");
+  Simulator::Schedule (fourth, &EcnCodelQueueDiscTestCase::Dequeue, this, queue, true,
+                       "It is time for the next mark");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetDropCount (), 0, "There should be no packet dropped by the CoDel algorithm");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), 0, "There should be no dropped packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 16, "Every dequeue should have removed a single packet");
+  QueueDiscStats st = queue->GetQueueDiscStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalMarkedPackets, 2, "There should be two marked packets");
+  NS_TEST_EXPECT_MSG_EQ (st.nMarkedPackets[CoDelQueueDisc::TARGET_EXCEEDED_MARK], 2,
+                         "The packets should be marked because the target was exceeded");
+  Simulator::Destroy ();
+
+  // test 2: packets that are not ECN capable are still dropped
+  queue = CreateQueue (mode, true);
+  Enqueue (queue, 20, Ipv4Header::ECN_NotECT);
+  Simulator::Schedule (first, &EcnCodelQueueDiscTestCase::Dequeue, this, queue, false, "No packet should be marked");
+  Simulator::Schedule (second, &EcnCodelQueueDiscTestCase::Dequeue, this, queue, false, "No packet should be marked");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetDropCount (), 1, "There should be one packet dropped by the CoDel algorithm");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalMarkedPackets (), 0, "There should be no marked packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 17, "The drop should have removed one more packet");
+  Simulator::Destroy ();
+
+  // test 3: without UseEcn, ECN capable packets are dropped
+  queue = CreateQueue (mode, false);
+  Enqueue (queue, 20, Ipv4Header::ECN_ECT0);
+  Simulator::Schedule (first, &EcnCodelQueueDiscTestCase::Dequeue, this, queue, false, "No packet should be marked");
+  Simulator::Schedule (second, &EcnCodelQueueDiscTestCase::Dequeue, this, queue, false, "No packet should be marked");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetDropCount (), 1, "There should be one packet dropped by the CoDel algorithm");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalMarkedPackets (), 0, "There should be no marked packets");
+  Simulator::Destroy ();
+}
+
+void
+EcnCodelQueueDiscTestCase::RunCeThresholdTest (StringValue mode)
+{
+  // test 4: packets whose sojourn time is above the CE threshold, but
+  // below target, are marked
+  Ptr<CoDelQueueDisc> queue = CreateObject<CoDelQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("CeThreshold", TimeValue (MilliSeconds (2))), true,
+                         "Verify that we can actually set the attribute CeThreshold");
+  queue->SetAttribute ("Mode", mode);
+  queue->SetAttribute ("UseEcn", BooleanValue (true));
+  queue->Initialize ();
+  Enqueue (queue, 10, Ipv4Header::ECN_ECT1);
+  Simulator::Schedule (MilliSeconds (1), &EcnCodelQueueDiscTestCase::Dequeue, this, queue, false,
+                       "The sojourn time is below the CE threshold");
+  Simulator::Schedule (MilliSeconds (3), &EcnCodelQueueDiscTestCase::Dequeue, this, queue, true,
+                       "The sojourn time is above the CE threshold");
+  Simulator::Schedule (MilliSeconds (4), &EcnCodelQueueDiscTestCase::Dequeue, this, queue, true,
+                       "The sojourn time is above the CE threshold");
+  Simulator::Run ();
+  QueueDiscStats st = queue->GetQueueDiscStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.nMarkedPackets[CoDelQueueDisc::CE_THRESHOLD_EXCEEDED_MARK], 2,
+                         "There should be two packets marked due to the CE threshold");
+  NS_TEST_EXPECT_MSG_EQ (st.nMarkedPackets[CoDelQueueDisc::TARGET_EXCEEDED_MARK], 0,
+                         "There should be no packets marked due to the target");
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDroppedPackets, 0, "There should be no dropped packets");
+  Simulator::Destroy ();
+}
+
+void
+EcnCodelQueueDiscTestCase::Enqueue (Ptr<CoDelQueueDisc> queue, uint32_t nPkt, Ipv4Header::EcnType ecn)
+{
+  Address dest;
+  Ipv4Header hdr;
+  hdr.SetEcn (ecn);
+
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<EcnCodelQueueDiscTestItem> (Create<Packet> (1000), dest, 0, hdr));
+    }
+}
+
+void
+EcnCodelQueueDiscTestCase::Dequeue (Ptr<CoDelQueueDisc> queue, bool marked, std::string msg)
+{
+  Ptr<QueueDiscItem> item = queue->Dequeue ();
+  NS_TEST_ASSERT_MSG_NE (item, 0, "There should be a packet to dequeue");
+  NS_TEST_EXPECT_MSG_EQ (item->IsMarked (), marked, msg);
+}
+
+void
+EcnCodelQueueDiscTestCase::DoRun (void)
+{
+  RunCodelTest (StringValue ("QUEUE_MODE_PACKETS"));
+  RunCodelTest (StringValue ("QUEUE_MODE_BYTES"));
+  RunCeThresholdTest (StringValue ("QUEUE_MODE_PACKETS"));
+  RunCeThresholdTest (StringValue ("QUEUE_MODE_BYTES"));
+}
+
+static class EcnCodelQueueDiscTestSuite : public TestSuite
+{
+public:
+  EcnCodelQueueDiscTestSuite ()
+    : TestSuite ("ecn-codel-queue-disc", UNIT)
+  {
+    AddTestCase (new EcnCodelQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_ecnCodelQueueTestSuite;
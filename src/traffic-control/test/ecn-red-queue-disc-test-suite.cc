@@ -60,13 +60,23 @@ public:
 private:
   void Enqueue (Ptr<RedQueueDisc> queue, uint32_t size, uint32_t nPkt);
   void RunRedTest (StringValue mode);
+  void MarkTrace (Ptr<const QueueDiscItem> item, const char *reason);
+  uint32_t m_marks; //!< Packets marked according to the Mark trace
 };
 
 EcnRedQueueDiscTestCase::EcnRedQueueDiscTestCase ()
-  : TestCase ("Sanity check on the red queue implementation")
+  : TestCase ("Sanity check on the red queue implementation"),
+    m_marks (0)
 {
 }
 
+void
+EcnRedQueueDiscTestCase::MarkTrace (Ptr<const QueueDiscItem> item, const char *reason)
+{
+  NS_TEST_EXPECT_MSG_EQ (item->IsMarked (), true, "The traced packet should be marked");
+  m_marks++;
+}
+
 void
 EcnRedQueueDiscTestCase::RunRedTest (StringValue mode)
 {
@@ -228,6 +238,8 @@ EcnRedQueueDiscTestCase::RunRedTest (StringValue mode)
                          "Verify that we can actually set the attribute QueueLimit");
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QW", DoubleValue (0.020)), true,
                          "Verify that we can actually set the attribute QW");
+  queue->TraceConnectWithoutContext ("Mark", MakeCallback (&EcnRedQueueDiscTestCase::MarkTrace, this));
+  m_marks = 0;
   queue->Initialize ();
   Enqueue (queue, pktSize, 500);
   st = StaticCast<RedQueueDisc> (queue)->GetStats ();
@@ -237,6 +249,18 @@ EcnRedQueueDiscTestCase::RunRedTest (StringValue mode)
   NS_TEST_EXPECT_MSG_EQ (drops, 0, "There should be no unforced and forced dropped packets");
   mark.test4 = st.unforcedMark + st.forcedMark; 
   NS_TEST_EXPECT_MSG_NE (mark.test4, 0, "There should be some marked packets  due to probability mark and hard mark");
+
+  // the generic mark accounting of the queue disc agrees with the RED stats
+  QueueDiscStats qdStats = queue->GetQueueDiscStats ();
+  NS_TEST_EXPECT_MSG_EQ (m_marks, mark.test4, "The Mark trace should fire once per marked packet");
+  NS_TEST_EXPECT_MSG_EQ (qdStats.nTotalMarkedPackets, mark.test4, "Wrong number of marked packets");
+  NS_TEST_EXPECT_MSG_EQ (qdStats.nMarkedPackets[RedQueueDisc::FORCED_MARK], st.forcedMark,
+                         "Wrong number of forced marks");
+  NS_TEST_EXPECT_MSG_EQ (qdStats.nMarkedPackets[RedQueueDisc::UNFORCED_MARK], st.unforcedMark,
+                         "Wrong number of unforced marks");
+  NS_TEST_EXPECT_MSG_EQ (qdStats.nTotalDroppedPackets, st.qLimDrop, "Wrong number of dropped packets");
+  NS_TEST_EXPECT_MSG_EQ (qdStats.nDroppedPackets[RedQueueDisc::QLIM_DROP], st.qLimDrop,
+                         "Wrong number of drops due to the queue limit");
  
  }
 
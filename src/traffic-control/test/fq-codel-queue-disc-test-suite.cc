@@ -0,0 +1,284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/fq-codel-queue-disc.h"
+#include "ns3/codel-queue-disc.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-queue-disc-item.h"
+
+using namespace ns3;
+
+/**
+ * Size of the payload of the packets used by the tests. The size of the
+ * queue disc items also includes the 20 bytes of the IPv4 header.
+ */
+static const uint32_t g_payloadSize = 500;
+static const uint32_t g_itemSize = g_payloadSize + 20;
+
+class FqCoDelQueueDiscTestItem : public Ipv4QueueDiscItem {
+public:
+  FqCoDelQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, const Ipv4Header & header);
+  virtual ~FqCoDelQueueDiscTestItem ();
+
+private:
+  FqCoDelQueueDiscTestItem ();
+  FqCoDelQueueDiscTestItem (const FqCoDelQueueDiscTestItem &);
+  FqCoDelQueueDiscTestItem &operator = (const FqCoDelQueueDiscTestItem &);
+};
+
+FqCoDelQueueDiscTestItem::FqCoDelQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, const Ipv4Header & header)
+  : Ipv4QueueDiscItem (p, addr, protocol, header)
+{
+}
+
+FqCoDelQueueDiscTestItem::~FqCoDelQueueDiscTestItem ()
+{
+}
+
+class FqCoDelQueueDiscTestCase : public TestCase
+{
+public:
+  FqCoDelQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  Ptr<FqCoDelQueueDisc> CreateQueue (void);
+  void Enqueue (Ptr<FqCoDelQueueDisc> queue, const char *source, uint32_t nPkt,
+                Ipv4Header::EcnType ecn = Ipv4Header::ECN_NotECT);
+  void Dequeue (Ptr<FqCoDelQueueDisc> queue, const char *source, bool marked, std::string msg);
+  void CheckBacklog (Ptr<FqCoDelQueueDisc> queue);
+  void RunFlowSeparationTest (void);
+  void RunSchedulingTest (void);
+  void RunOverlimitTest (void);
+  void RunEcnTest (void);
+};
+
+FqCoDelQueueDiscTestCase::FqCoDelQueueDiscTestCase ()
+  : TestCase ("Sanity check on the fq-codel queue disc implementation")
+{
+}
+
+Ptr<FqCoDelQueueDisc>
+FqCoDelQueueDiscTestCase::CreateQueue (void)
+{
+  Ptr<FqCoDelQueueDisc> queue = CreateObject<FqCoDelQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Quantum", UintegerValue (g_itemSize)), true,
+                         "Verify that we can actually set the attribute Quantum");
+  return queue;
+}
+
+void
+FqCoDelQueueDiscTestCase::Enqueue (Ptr<FqCoDelQueueDisc> queue, const char *source, uint32_t nPkt,
+                                   Ipv4Header::EcnType ecn)
+{
+  Address dest;
+  Ipv4Header hdr;
+  hdr.SetSource (Ipv4Address (source));
+  hdr.SetDestination (Ipv4Address ("10.10.1.2"));
+  hdr.SetProtocol (6);
+  hdr.SetPayloadSize (g_payloadSize);
+  hdr.SetEcn (ecn);
+
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<FqCoDelQueueDiscTestItem> (Create<Packet> (g_payloadSize), dest, 0, hdr));
+    }
+}
+
+void
+FqCoDelQueueDiscTestCase::Dequeue (Ptr<FqCoDelQueueDisc> queue, const char *source, bool marked, std::string msg)
+{
+  Ptr<QueueDiscItem> item = queue->Dequeue ();
+  NS_TEST_ASSERT_MSG_NE (item, 0, "There should be a packet to dequeue");
+  Ptr<Ipv4QueueDiscItem> ipItem = DynamicCast<Ipv4QueueDiscItem> (item);
+  NS_TEST_EXPECT_MSG_EQ (ipItem->GetHeader ().GetSource (), Ipv4Address (source), msg);
+  NS_TEST_EXPECT_MSG_EQ (item->IsMarked (), marked, msg);
+}
+
+void
+FqCoDelQueueDiscTestCase::CheckBacklog (Ptr<FqCoDelQueueDisc> queue)
+{
+  uint32_t packets = 0, bytes = 0;
+  for (uint32_t i = 0; i < queue->GetNQueueDiscClasses (); i++)
+    {
+      packets += queue->GetQueueDiscClass (i)->GetQueueDisc ()->GetNPackets ();
+      bytes += queue->GetQueueDiscClass (i)->GetQueueDisc ()->GetNBytes ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), packets, "The backlog should match the one of the flows");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNBytes (), bytes, "The backlog should match the one of the flows");
+}
+
+void
+FqCoDelQueueDiscTestCase::RunFlowSeparationTest (void)
+{
+  // test 1: packets of different flows are stored in distinct flow queues,
+  // which are created when they receive their first packet
+  Ptr<FqCoDelQueueDisc> queue = CreateQueue ();
+  queue->Initialize ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNQueueDiscClasses (), 0, "No flow queue should exist yet");
+
+  Enqueue (queue, "10.10.1.1", 3);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNQueueDiscClasses (), 1, "One flow queue should have been created");
+  Enqueue (queue, "10.10.1.3", 2);
+  Enqueue (queue, "10.10.1.5", 1);
+  Enqueue (queue, "10.10.1.1", 1);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNQueueDiscClasses (), 3, "Three flow queues should have been created");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 4,
+                         "The packets of the first flow should be in the first queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 2,
+                         "The packets of the second flow should be in the second queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (2)->GetQueueDisc ()->GetNPackets (), 1,
+                         "The packets of the third flow should be in the third queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 7, "There should be seven packets queued");
+  CheckBacklog (queue);
+
+  // test 2: with a single flow queue, every packet is stored in it
+  queue = CreateQueue ();
+  queue->SetAttribute ("Flows", UintegerValue (1));
+  queue->Initialize ();
+  Enqueue (queue, "10.10.1.1", 3);
+  Enqueue (queue, "10.10.1.3", 2);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNQueueDiscClasses (), 1, "A single flow queue should have been created");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 5,
+                         "Every packet should be in the single flow queue");
+}
+
+void
+FqCoDelQueueDiscTestCase::RunSchedulingTest (void)
+{
+  // test 3: with a quantum of one packet, the flows are served in round robin
+  Ptr<FqCoDelQueueDisc> queue = CreateQueue ();
+  queue->Initialize ();
+  Enqueue (queue, "10.10.1.1", 3);
+  Enqueue (queue, "10.10.1.3", 3);
+  Dequeue (queue, "10.10.1.1", false, "The first flow should be served first");
+  Dequeue (queue, "10.10.1.3", false, "The second flow should be served second");
+  Dequeue (queue, "10.10.1.1", false, "The flows should be served in round robin");
+  Dequeue (queue, "10.10.1.3", false, "The flows should be served in round robin");
+
+  // test 4: a flow which becomes active is served before the old flows
+  Enqueue (queue, "10.10.1.5", 1);
+  Dequeue (queue, "10.10.1.5", false, "The new flow should be served before the old flows");
+  Dequeue (queue, "10.10.1.1", false, "The old flows should be served after the new one");
+  Dequeue (queue, "10.10.1.3", false, "The old flows should be served after the new one");
+  NS_TEST_EXPECT_MSG_EQ (queue->Dequeue (), 0, "The queue disc should be empty");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 0, "The queue disc should be empty");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNBytes (), 0, "The queue disc should be empty");
+
+  // test 5: the quantum is the number of bytes a flow may send at each round
+  queue = CreateQueue ();
+  queue->SetQuantum (2 * g_itemSize);
+  queue->Initialize ();
+  Enqueue (queue, "10.10.1.1", 3);
+  Enqueue (queue, "10.10.1.3", 3);
+  Dequeue (queue, "10.10.1.1", false, "The first flow may send two packets");
+  Dequeue (queue, "10.10.1.1", false, "The first flow may send two packets");
+  Dequeue (queue, "10.10.1.3", false, "The second flow may send two packets");
+  Dequeue (queue, "10.10.1.3", false, "The second flow may send two packets");
+  Dequeue (queue, "10.10.1.1", false, "The first flow should be served again");
+}
+
+void
+FqCoDelQueueDiscTestCase::RunOverlimitTest (void)
+{
+  // test 6: when the limit is exceeded, packets are dropped from the flow
+  // with the largest backlog, until half of its backlog has been dropped
+  Ptr<FqCoDelQueueDisc> queue = CreateQueue ();
+  queue->SetAttribute ("PacketLimit", UintegerValue (10));
+  queue->Initialize ();
+  Enqueue (queue, "10.10.1.3", 3);
+  Enqueue (queue, "10.10.1.1", 8);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 7, "Four packets of the fat flow should have been dropped");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3,
+                         "No packet of the thin flow should have been dropped");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 4,
+                         "Half of the fat flow should have been dropped");
+  CheckBacklog (queue);
+
+  QueueDiscStats st = queue->GetQueueDiscStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalReceivedPackets, 11, "Eleven packets should have been received");
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDroppedPackets, 4, "Four packets should have been dropped");
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDroppedBytes, 4 * g_itemSize, "Four packets should have been dropped");
+  NS_TEST_EXPECT_MSG_EQ (st.nDroppedPackets[FqCoDelQueueDisc::OVERLIMIT_DROP], 4,
+                         "The packets should have been dropped because of the limit");
+
+  // test 7: at most DropBatchSize packets are dropped at once
+  queue = CreateQueue ();
+  queue->SetAttribute ("PacketLimit", UintegerValue (10));
+  queue->SetAttribute ("DropBatchSize", UintegerValue (2));
+  queue->Initialize ();
+  Enqueue (queue, "10.10.1.1", 11);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 9, "Two packets should have been dropped");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), 2, "Two packets should have been dropped");
+}
+
+void
+FqCoDelQueueDiscTestCase::RunEcnTest (void)
+{
+  // test 8: the packets whose sojourn time is above the CE threshold are
+  // marked by the CoDel queue disc of their flow, and the marks are
+  // accounted by the fq-codel queue disc
+  Ptr<FqCoDelQueueDisc> queue = CreateQueue ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("CeThreshold", TimeValue (MilliSeconds (2))), true,
+                         "Verify that we can actually set the attribute CeThreshold");
+  queue->Initialize ();
+  Enqueue (queue, "10.10.1.1", 3, Ipv4Header::ECN_ECT0);
+  Enqueue (queue, "10.10.1.3", 3, Ipv4Header::ECN_NotECT);
+  Simulator::Schedule (MilliSeconds (1), &FqCoDelQueueDiscTestCase::Dequeue, this, queue, "10.10.1.1", false,
+                       "The sojourn time is below the CE threshold");
+  Simulator::Schedule (MilliSeconds (3), &FqCoDelQueueDiscTestCase::Dequeue, this, queue, "10.10.1.3", false,
+                       "Packets which are not ECN capable should not be marked");
+  Simulator::Schedule (MilliSeconds (3), &FqCoDelQueueDiscTestCase::Dequeue, this, queue, "10.10.1.1", true,
+                       "The sojourn time is above the CE threshold");
+  Simulator::Schedule (MilliSeconds (4), &FqCoDelQueueDiscTestCase::Dequeue, this, queue, "10.10.1.3", false,
+                       "Packets which are not ECN capable should not be marked");
+  Simulator::Schedule (MilliSeconds (4), &FqCoDelQueueDiscTestCase::Dequeue, this, queue, "10.10.1.1", true,
+                       "The sojourn time is above the CE threshold");
+  Simulator::Run ();
+
+  QueueDiscStats st = queue->GetQueueDiscStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalMarkedPackets, 2, "There should be two marked packets");
+  NS_TEST_EXPECT_MSG_EQ (st.nMarkedPackets[CoDelQueueDisc::CE_THRESHOLD_EXCEEDED_MARK], 2,
+                         "The packets should have been marked because of the CE threshold");
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDroppedPackets, 0, "There should be no dropped packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 1, "A single packet should be left");
+  CheckBacklog (queue);
+  Simulator::Destroy ();
+}
+
+void
+FqCoDelQueueDiscTestCase::DoRun (void)
+{
+  RunFlowSeparationTest ();
+  RunSchedulingTest ();
+  RunOverlimitTest ();
+  RunEcnTest ();
+}
+
+static class FqCoDelQueueDiscTestSuite : public TestSuite
+{
+public:
+  FqCoDelQueueDiscTestSuite ()
+    : TestSuite ("fq-codel-queue-disc", UNIT)
+  {
+    AddTestCase (new FqCoDelQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_fqCoDelQueueTestSuite;
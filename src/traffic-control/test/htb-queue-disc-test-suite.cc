@@ -0,0 +1,281 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/error-model.h"
+#include "ns3/traffic-control-layer.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/htb-queue-disc.h"
+#include "ns3/packet-filter.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue disc item used by the HTB tests
+ */
+class HtbTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   * \param protocol the protocol
+   */
+  HtbTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol)
+    : QueueDiscItem (p, addr, protocol)
+  {
+  }
+  virtual void AddHeader (void)
+  {
+  }
+  virtual bool Mark (void)
+  {
+    return false;
+  }
+  virtual bool IsMarked (void) const
+  {
+    return false;
+  }
+};
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Packet filter classifying the packets by their size: the packets of
+ * 1000 + i bytes belong to class i
+ */
+class HtbTestPacketFilter : public PacketFilter
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::HtbTestPacketFilter")
+      .SetParent<PacketFilter> ()
+      .SetGroupName ("TrafficControl")
+      .AddConstructor<HtbTestPacketFilter> ()
+    ;
+    return tid;
+  }
+
+private:
+  virtual bool CheckProtocol (Ptr<QueueDiscItem> item) const
+  {
+    return true;
+  }
+  virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const
+  {
+    return item->GetPacketSize () - 1000;
+  }
+};
+
+NS_OBJECT_ENSURE_REGISTERED (HtbTestPacketFilter);
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Check the rate achieved by two backlogged HTB classes
+ */
+class HtbQueueDiscTestCase : public TestCase
+{
+public:
+  HtbQueueDiscTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Configuration of a class
+   */
+  struct ClassConfig
+  {
+    std::string rate;   //!< Rate of the class
+    std::string ceil;   //!< Ceil of the class
+    uint32_t priority;  //!< Priority of the class
+    uint32_t packets;   //!< Number of packets sent to the class
+  };
+
+  /**
+   * Send the given number of packets to each class at the beginning of the
+   * simulation, and measure the rate of each class over one second
+   *
+   * \param rootRate the rate of the root
+   * \param c0 the configuration of the first class
+   * \param c1 the configuration of the second class
+   */
+  void RunTest (std::string rootRate, ClassConfig c0, ClassConfig c1);
+  /**
+   * Receive callback
+   * \param device the receiving device
+   * \param packet the received packet
+   * \param protocol the protocol
+   * \param from the sender
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+  /**
+   * Check that the rate of a class is within 2% of the expected value
+   * \param cl the index of the class
+   * \param mbps the expected rate, in Mbps
+   */
+  void CheckRate (uint32_t cl, double mbps);
+
+  uint64_t m_received[2];    //!< Bytes received per class
+};
+
+HtbQueueDiscTestCase::HtbQueueDiscTestCase ()
+  : TestCase ("Sanity check on the rates achieved by the HTB classes")
+{
+}
+
+bool
+HtbQueueDiscTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                               uint16_t protocol, const Address &from)
+{
+  m_received[packet->GetSize () - 1000] += packet->GetSize ();
+  return true;
+}
+
+void
+HtbQueueDiscTestCase::CheckRate (uint32_t cl, double mbps)
+{
+  double rate = m_received[cl] * 8 / 1e6;
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate, mbps, mbps * 0.02, "Unexpected rate of class " << cl);
+}
+
+void
+HtbQueueDiscTestCase::RunTest (std::string rootRate, ClassConfig c0, ClassConfig c1)
+{
+  m_received[0] = m_received[1] = 0;
+
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  Ptr<SimpleNetDevice> txDev = CreateObject<SimpleNetDevice> ();
+  Ptr<SimpleNetDevice> rxDev = CreateObject<SimpleNetDevice> ();
+  Ptr<SimpleNetDevice> devices[2] = { txDev, rxDev };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      node->AggregateObject (CreateObject<TrafficControlLayer> ());
+      devices[i]->SetAttribute ("DataRate", StringValue ("100Mbps"));
+      devices[i]->SetAddress (Mac48Address::Allocate ());
+      devices[i]->SetChannel (channel);
+      node->AddDevice (devices[i]);
+    }
+  rxDev->SetReceiveCallback (MakeCallback (&HtbQueueDiscTestCase::Receive, this));
+
+  TrafficControlHelper tch;
+  uint16_t handle = tch.SetRootQueueDisc ("ns3::HtbQueueDisc", "Rate", StringValue (rootRate));
+  tch.AddPacketFilter (handle, "ns3::HtbTestPacketFilter");
+  ClassConfig config[2] = { c0, c1 };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      TrafficControlHelper::ClassIdList cid = tch.AddQueueDiscClasses (handle, 1, "ns3::HtbClass",
+                                                                       "Rate", StringValue (config[i].rate),
+                                                                       "Ceil", StringValue (config[i].ceil),
+                                                                       "Priority", UintegerValue (config[i].priority));
+      tch.AddChildQueueDisc (handle, cid[0], "ns3::PfifoFastQueueDisc", "Limit", UintegerValue (2000));
+    }
+  tch.Install (txDev);
+
+  // The node must be initialized for the traffic control layer to set up
+  // the queue discs
+  txDev->GetNode ()->Initialize ();
+  Ptr<TrafficControlLayer> tc = txDev->GetNode ()->GetObject<TrafficControlLayer> ();
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      for (uint32_t j = 0; j < config[i].packets; j++)
+        {
+          tc->Send (txDev, Create<HtbTestItem> (Create<Packet> (1000 + i), rxDev->GetAddress (), 0));
+        }
+    }
+
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+HtbQueueDiscTestCase::DoRun (void)
+{
+  // Each class gets its rate, and the classes borrow the bandwidth left by
+  // the root rate
+  ClassConfig c0 = { "2Mbps", "10Mbps", 0, 2000 };
+  ClassConfig c1 = { "6Mbps", "10Mbps", 0, 2000 };
+  RunTest ("10Mbps", c0, c1);
+  NS_TEST_EXPECT_MSG_GT (m_received[0] * 8 / 1e6, 2, "The first class should have borrowed");
+  NS_TEST_EXPECT_MSG_GT (m_received[1] * 8 / 1e6, 6, "The second class should have borrowed");
+  NS_TEST_EXPECT_MSG_EQ_TOL ((m_received[0] + m_received[1]) * 8 / 1e6, 10, 0.2,
+                             "The classes should have used the rate of the root");
+
+  // Without borrowing, the classes get their rate
+  c0.ceil = "0Mbps";
+  c1.ceil = "0Mbps";
+  RunTest ("10Mbps", c0, c1);
+  CheckRate (0, 2);
+  CheckRate (1, 6);
+
+  // A class alone sends at its ceil
+  c0.ceil = "4Mbps";
+  c1.packets = 0;
+  RunTest ("10Mbps", c0, c1);
+  CheckRate (0, 4);
+  CheckRate (1, 0);
+
+  // The class with the highest priority borrows all the spare bandwidth
+  c0.ceil = "10Mbps";
+  c1.ceil = "10Mbps";
+  c1.priority = 1;
+  c1.packets = 2000;
+  RunTest ("10Mbps", c0, c1);
+  CheckRate (0, 4);
+  CheckRate (1, 6);
+  c0.rate = "1Mbps";
+  c1.rate = "1Mbps";
+  RunTest ("10Mbps", c0, c1);
+  CheckRate (0, 9);
+  CheckRate (1, 1);
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief HTB queue disc TestSuite
+ */
+static class HtbQueueDiscTestSuite : public TestSuite
+{
+public:
+  HtbQueueDiscTestSuite ()
+    : TestSuite ("htb-queue-disc", UNIT)
+  {
+    AddTestCase (new HtbQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_htbQueueDiscTestSuite;
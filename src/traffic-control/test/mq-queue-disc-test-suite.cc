@@ -0,0 +1,228 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/error-model.h"
+#include "ns3/traffic-control-layer.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/mq-queue-disc.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue disc item used by the mq tests
+ */
+class MqTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   * \param protocol the protocol
+   */
+  MqTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol)
+    : QueueDiscItem (p, addr, protocol)
+  {
+  }
+  virtual void AddHeader (void)
+  {
+  }
+  virtual bool Mark (void)
+  {
+    return false;
+  }
+  virtual bool IsMarked (void) const
+  {
+    return false;
+  }
+};
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Check that the packets sent through each transmission queue of a
+ * multi-queue device are handled by the child queue disc of that queue only
+ */
+class MqQueueDiscTestCase : public TestCase
+{
+public:
+  MqQueueDiscTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Set up a multi-queue device with the given number of transmission
+   * queues, attached to a receiving device
+   *
+   * \param nTxQueues the number of transmission queues
+   * \return the transmitting device
+   */
+  Ptr<SimpleNetDevice> CreateDevices (uint8_t nTxQueues);
+  /**
+   * Send a packet of the given flow
+   *
+   * \param dev the transmitting device
+   * \param flow the flow hash of the packet
+   */
+  void Send (Ptr<SimpleNetDevice> dev, uint32_t flow);
+  /**
+   * Receive callback
+   * \param device the receiving device
+   * \param packet the received packet
+   * \param protocol the protocol
+   * \param from the sender
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  Ptr<SimpleNetDevice> m_rxDev;   //!< The receiving device
+  uint32_t m_received;            //!< Packets received
+};
+
+MqQueueDiscTestCase::MqQueueDiscTestCase ()
+  : TestCase ("Sanity check on the mq queue disc")
+{
+}
+
+bool
+MqQueueDiscTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                              uint16_t protocol, const Address &from)
+{
+  m_received++;
+  return true;
+}
+
+Ptr<SimpleNetDevice>
+MqQueueDiscTestCase::CreateDevices (uint8_t nTxQueues)
+{
+  m_received = 0;
+
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  Ptr<SimpleNetDevice> txDev = CreateObject<SimpleNetDevice> ();
+  m_rxDev = CreateObject<SimpleNetDevice> ();
+  Ptr<SimpleNetDevice> devices[2] = { txDev, m_rxDev };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      node->AggregateObject (CreateObject<TrafficControlLayer> ());
+      devices[i]->SetAttribute ("DataRate", StringValue ("10Mbps"));
+      devices[i]->SetAttribute ("NTxQueues", UintegerValue (nTxQueues));
+      devices[i]->SetAddress (Mac48Address::Allocate ());
+      devices[i]->SetChannel (channel);
+      node->AddDevice (devices[i]);
+    }
+  m_rxDev->SetReceiveCallback (MakeCallback (&MqQueueDiscTestCase::Receive, this));
+  return txDev;
+}
+
+void
+MqQueueDiscTestCase::Send (Ptr<SimpleNetDevice> dev, uint32_t flow)
+{
+  Ptr<MqTestItem> item = Create<MqTestItem> (Create<Packet> (1000), m_rxDev->GetAddress (), 0);
+  item->SetFlowHash (flow);
+  dev->GetNode ()->GetObject<TrafficControlLayer> ()->Send (dev, item);
+}
+
+void
+MqQueueDiscTestCase::DoRun (void)
+{
+  // Without classes, mq creates a pfifo_fast child per transmission queue
+  Ptr<SimpleNetDevice> txDev = CreateDevices (4);
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc ("ns3::MqQueueDisc");
+  QueueDiscContainer qdiscs = tch.Install (txDev);
+  txDev->GetNode ()->Initialize ();
+
+  Ptr<QueueDisc> mq = qdiscs.Get (0);
+  NS_TEST_ASSERT_MSG_EQ (mq->GetNQueueDiscClasses (), 4, "mq should have a class per transmission queue");
+  NS_TEST_EXPECT_MSG_EQ (mq->GetWakeMode (), QueueDisc::WAKE_CHILD, "mq should wake its children");
+  for (uint32_t flow = 0; flow < 10; flow++)
+    {
+      for (uint32_t j = 0; j <= flow; j++)
+        {
+          Send (txDev, flow);
+        }
+    }
+  Simulator::Run ();
+
+  // the packets of flow f are sent through the transmission queue f % 4
+  uint32_t expected[4] = { 1 + 5 + 9, 2 + 6 + 10, 3 + 7, 4 + 8 };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Ptr<QueueDisc> child = mq->GetQueueDiscClass (i)->GetQueueDisc ();
+      NS_TEST_EXPECT_MSG_EQ (child->GetTotalReceivedPackets (), expected[i],
+                             "Wrong number of packets handled by child " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (mq->GetTotalReceivedPackets (), 0, "mq should not store packets");
+  NS_TEST_EXPECT_MSG_EQ (m_received, 55, "Not all the packets have been received");
+  Simulator::Destroy ();
+
+  // The children run independently: a backlog in a transmission queue only
+  // causes drops in the child of that queue
+  txDev = CreateDevices (2);
+  TrafficControlHelper tch2;
+  uint16_t handle = tch2.SetRootQueueDisc ("ns3::MqQueueDisc");
+  TrafficControlHelper::ClassIdList cid = tch2.AddQueueDiscClasses (handle, 2, "ns3::QueueDiscClass");
+  tch2.AddChildQueueDisc (handle, cid[0], "ns3::PfifoFastQueueDisc", "Limit", UintegerValue (10));
+  tch2.AddChildQueueDisc (handle, cid[1], "ns3::PfifoFastQueueDisc", "Limit", UintegerValue (1000));
+  tch2.SetQueueLimits ("ns3::DynamicQueueLimits", "MaxLimit", UintegerValue (3000));
+  tch2.Install (txDev);
+  txDev->GetNode ()->Initialize ();
+
+  for (uint32_t j = 0; j < 100; j++)
+    {
+      Send (txDev, 0);
+      Send (txDev, 1);
+    }
+  Simulator::Run ();
+
+  mq = txDev->GetNode ()->GetObject<TrafficControlLayer> ()->GetRootQueueDiscOnDevice (txDev);
+  Ptr<QueueDisc> child0 = mq->GetQueueDiscClass (0)->GetQueueDisc ();
+  Ptr<QueueDisc> child1 = mq->GetQueueDiscClass (1)->GetQueueDisc ();
+  NS_TEST_EXPECT_MSG_GT (child0->GetTotalDroppedPackets (), 0, "The first child should have dropped packets");
+  NS_TEST_EXPECT_MSG_EQ (child1->GetTotalDroppedPackets (), 0, "The second child should not have dropped packets");
+  NS_TEST_EXPECT_MSG_EQ (child1->GetTotalReceivedPackets (), 100, "Wrong number of packets handled by the second child");
+  NS_TEST_EXPECT_MSG_EQ (m_received, 200 - child0->GetTotalDroppedPackets (), "Not all the packets have been received");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief mq queue disc TestSuite
+ */
+static class MqQueueDiscTestSuite : public TestSuite
+{
+public:
+  MqQueueDiscTestSuite ()
+    : TestSuite ("mq-queue-disc", UNIT)
+  {
+    AddTestCase (new MqQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_mqQueueDiscTestSuite;
@@ -0,0 +1,295 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/pie-queue-disc.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+class PieQueueDiscTestItem : public QueueDiscItem {
+public:
+  PieQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, bool ecnCapable);
+  virtual ~PieQueueDiscTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+  virtual bool IsMarked (void) const;
+
+private:
+  PieQueueDiscTestItem ();
+  PieQueueDiscTestItem (const PieQueueDiscTestItem &);
+  PieQueueDiscTestItem &operator = (const PieQueueDiscTestItem &);
+  bool m_ecnCapable;
+  bool m_marked;
+};
+
+PieQueueDiscTestItem::PieQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, bool ecnCapable)
+  : QueueDiscItem (p, addr, protocol),
+    m_ecnCapable (ecnCapable),
+    m_marked (false)
+{
+}
+
+PieQueueDiscTestItem::~PieQueueDiscTestItem ()
+{
+}
+
+void
+PieQueueDiscTestItem::AddHeader (void)
+{
+}
+
+bool
+PieQueueDiscTestItem::Mark (void)
+{
+  if (m_ecnCapable)
+    {
+      m_marked = true;
+    }
+  return m_ecnCapable;
+}
+
+bool
+PieQueueDiscTestItem::IsMarked (void) const
+{
+  return m_marked;
+}
+
+class PieQueueDiscTestCase : public TestCase
+{
+public:
+  PieQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  void Enqueue (Ptr<PieQueueDisc> queue, uint32_t size, uint32_t nPkt, bool ecnCapable);
+  void Dequeue (Ptr<PieQueueDisc> queue, uint32_t nPkt);
+  Ptr<PieQueueDisc> CreateOverloadedQueue (bool useEcn, double markEcnTh, bool ecnCapable);
+  void RunPieTest (StringValue mode);
+  void RunPieEcnTest (void);
+};
+
+PieQueueDiscTestCase::PieQueueDiscTestCase ()
+  : TestCase ("Sanity check on the pie queue disc implementation")
+{
+}
+
+void
+PieQueueDiscTestCase::RunPieTest (StringValue mode)
+{
+  uint32_t pktSize = 0;
+  // 1 for packets; pktSize for bytes
+  uint32_t modeSize = 1;
+  uint32_t qSize = 8;
+  Ptr<PieQueueDisc> queue = CreateObject<PieQueueDisc> ();
+
+  // test 1: simple enqueue/dequeue with no drops
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("A", DoubleValue (0.125)), true,
+                         "Verify that we can actually set the attribute A");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("B", DoubleValue (1.25)), true,
+                         "Verify that we can actually set the attribute B");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Tupdate", TimeValue (Seconds (0.03))), true,
+                         "Verify that we can actually set the attribute Tupdate");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Supdate", TimeValue (Seconds (0.0))), true,
+                         "Verify that we can actually set the attribute Supdate");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("DequeueThreshold", UintegerValue (10000)), true,
+                         "Verify that we can actually set the attribute DequeueThreshold");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueDelayReference", TimeValue (Seconds (0.02))), true,
+                         "Verify that we can actually set the attribute QueueDelayReference");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxBurstAllowance", TimeValue (Seconds (0.1))), true,
+                         "Verify that we can actually set the attribute MaxBurstAllowance");
+
+  Address dest;
+
+  if (queue->GetMode () == Queue::QUEUE_MODE_BYTES)
+    {
+      pktSize = 1000;
+      modeSize = pktSize;
+      queue->SetQueueLimit (qSize * modeSize);
+    }
+
+  Ptr<Packet> p1, p2, p3, p4, p5, p6, p7, p8;
+  p1 = Create<Packet> (pktSize);
+  p2 = Create<Packet> (pktSize);
+  p3 = Create<Packet> (pktSize);
+  p4 = Create<Packet> (pktSize);
+  p5 = Create<Packet> (pktSize);
+  p6 = Create<Packet> (pktSize);
+  p7 = Create<Packet> (pktSize);
+  p8 = Create<Packet> (pktSize);
+
+  queue->Initialize ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 0 * modeSize, "There should be no packets in there");
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p1, dest, 0, false));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 1 * modeSize, "There should be one packet in there");
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p2, dest, 0, false));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 2 * modeSize, "There should be two packets in there");
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p3, dest, 0, false));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p4, dest, 0, false));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p5, dest, 0, false));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p6, dest, 0, false));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p7, dest, 0, false));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p8, dest, 0, false));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 8 * modeSize, "There should be eight packets in there");
+
+  Ptr<QueueDiscItem> item;
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the first packet");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 7 * modeSize, "There should be seven packets in there");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p1->GetUid (), "was this the first packet ?");
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the second packet");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 6 * modeSize, "There should be six packet in there");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p2->GetUid (), "Was this the second packet ?");
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the third packet");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 5 * modeSize, "There should be five packets in there");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p3->GetUid (), "Was this the third packet ?");
+
+  item = queue->Dequeue ();
+  item = queue->Dequeue ();
+  item = queue->Dequeue ();
+  item = queue->Dequeue ();
+  item = queue->Dequeue ();
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item == 0), true, "There are really no packets in there");
+
+  // test 2: the packets exceeding the queue limit are dropped
+  Enqueue (queue, pktSize, 10, false);
+  PieQueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 8 * modeSize, "The queue should be full");
+  NS_TEST_EXPECT_MSG_EQ (st.forcedDrop, 2, "There should be two forced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.unforcedDrop, 0, "There should be no unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscStats ().nDroppedPackets[PieQueueDisc::FORCED_DROP], 2,
+                         "The drops should be accounted with their reason");
+  Simulator::Destroy ();
+}
+
+Ptr<PieQueueDisc>
+PieQueueDiscTestCase::CreateOverloadedQueue (bool useEcn, double markEcnTh, bool ecnCapable)
+{
+  Ptr<PieQueueDisc> queue = CreateObject<PieQueueDisc> ();
+  queue->SetAttribute ("QueueLimit", UintegerValue (10000));
+  queue->SetAttribute ("UseEcn", BooleanValue (useEcn));
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MarkEcnThreshold", DoubleValue (markEcnTh)), true,
+                         "Verify that we can actually set the attribute MarkEcnThreshold");
+  queue->Initialize ();
+  queue->AssignStreams (1);
+
+  // Packets arrive twice as fast as they depart: the queue builds up
+  // and PIE has to react
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &PieQueueDiscTestCase::Enqueue, this,
+                           queue, 1000, 2, ecnCapable);
+      Simulator::Schedule (MilliSeconds (i), &PieQueueDiscTestCase::Dequeue, this,
+                           queue, 1);
+    }
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  return queue;
+}
+
+void
+PieQueueDiscTestCase::RunPieEcnTest (void)
+{
+  // test 3: under overload, packets are dropped early
+  Ptr<PieQueueDisc> queue = CreateOverloadedQueue (false, 0.1, true);
+  PieQueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_GT (queue->GetDropProbability (), 0, "The drop probability should have increased");
+  NS_TEST_EXPECT_MSG_GT (queue->GetQueueDelay (), Seconds (0), "The queue delay should have been estimated");
+  NS_TEST_EXPECT_MSG_GT (st.unforcedDrop, 0, "There should be unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.unforcedMark, 0, "There should be no unforced marks without UseEcn");
+  NS_TEST_EXPECT_MSG_EQ (st.forcedDrop, 0, "There should be no forced drops");
+  Simulator::Destroy ();
+
+  // test 4: with UseEcn, ECN capable packets are marked instead of dropped
+  // as long as the drop probability does not exceed the threshold
+  queue = CreateOverloadedQueue (true, 1.0, true);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_GT (st.unforcedMark, 0, "There should be unforced marks");
+  NS_TEST_EXPECT_MSG_EQ (st.unforcedDrop, 0, "There should be no unforced drops");
+  QueueDiscStats qst = queue->GetQueueDiscStats ();
+  NS_TEST_EXPECT_MSG_EQ (qst.nMarkedPackets[PieQueueDisc::UNFORCED_MARK], st.unforcedMark,
+                         "The marks should be accounted with their reason");
+  Simulator::Destroy ();
+
+  // test 5: above the threshold, ECN capable packets are dropped
+  queue = CreateOverloadedQueue (true, 0.1, true);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_GT (queue->GetDropProbability (), 0.1, "The drop probability should exceed the threshold");
+  NS_TEST_EXPECT_MSG_GT (st.unforcedMark, 0, "There should be unforced marks");
+  NS_TEST_EXPECT_MSG_GT (st.unforcedDrop, 0, "There should be unforced drops");
+  Simulator::Destroy ();
+
+  // test 6: with UseEcn, packets which are not ECN capable are dropped
+  queue = CreateOverloadedQueue (true, 1.0, false);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.unforcedMark, 0, "There should be no unforced marks");
+  NS_TEST_EXPECT_MSG_GT (st.unforcedDrop, 0, "There should be unforced drops");
+  Simulator::Destroy ();
+}
+
+void
+PieQueueDiscTestCase::Enqueue (Ptr<PieQueueDisc> queue, uint32_t size, uint32_t nPkt, bool ecnCapable)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<PieQueueDiscTestItem> (Create<Packet> (size), dest, 0, ecnCapable));
+    }
+}
+
+void
+PieQueueDiscTestCase::Dequeue (Ptr<PieQueueDisc> queue, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Dequeue ();
+    }
+}
+
+void
+PieQueueDiscTestCase::DoRun (void)
+{
+  RunPieTest (StringValue ("QUEUE_MODE_PACKETS"));
+  RunPieTest (StringValue ("QUEUE_MODE_BYTES"));
+  RunPieEcnTest ();
+}
+
+static class PieQueueDiscTestSuite : public TestSuite
+{
+public:
+  PieQueueDiscTestSuite ()
+    : TestSuite ("pie-queue-disc", UNIT)
+  {
+    AddTestCase (new PieQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_pieQueueTestSuite;
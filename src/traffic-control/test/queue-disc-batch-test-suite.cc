@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/error-model.h"
+#include "ns3/dynamic-queue-limits.h"
+#include "ns3/traffic-control-layer.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/queue-disc.h"
+#include "ns3/uinteger.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue disc item used by the batch tests
+ */
+class BatchTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   * \param protocol the protocol
+   */
+  BatchTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol)
+    : QueueDiscItem (p, addr, protocol)
+  {
+  }
+  virtual void AddHeader (void)
+  {
+  }
+  virtual bool Mark (void)
+  {
+    return false;
+  }
+  virtual bool IsMarked (void) const
+  {
+    return false;
+  }
+};
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief SimpleNetDevice recording the size of the batches it receives
+ */
+class BatchTestNetDevice : public SimpleNetDevice
+{
+public:
+  virtual uint32_t SendBatch (std::vector<BatchItem> &batch)
+  {
+    m_batches.push_back (batch.size ());
+    return SimpleNetDevice::SendBatch (batch);
+  }
+  std::vector<uint32_t> m_batches;  //!< Size of the batches sent to the device
+};
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Check that the packets backlogged in the queue disc are sent to the
+ * device in batches bounded by the quota and by the queue limits
+ */
+class QueueDiscBatchTestCase : public TestCase
+{
+public:
+  QueueDiscBatchTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Send the given number of packets of increasing size while the device
+   * transmission queue is stopped, then wake the queue up
+   *
+   * \param nPackets the number of packets
+   * \param quota the quota of the root queue disc
+   * \param limits the queue limits, if any
+   */
+  void RunTest (uint32_t nPackets, uint32_t quota, Ptr<QueueLimits> limits);
+  /**
+   * Receive callback
+   * \param device the receiving device
+   * \param packet the received packet
+   * \param protocol the protocol
+   * \param from the sender
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  Ptr<BatchTestNetDevice> m_txDev;     //!< Sender device
+  Ptr<QueueDisc> m_qdisc;              //!< Root queue disc of the sender
+  std::vector<uint32_t> m_received;    //!< Size of the received packets
+};
+
+QueueDiscBatchTestCase::QueueDiscBatchTestCase ()
+  : TestCase ("Sanity check on sending batches of packets to the device")
+{
+}
+
+bool
+QueueDiscBatchTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                 uint16_t protocol, const Address &from)
+{
+  m_received.push_back (packet->GetSize ());
+  return true;
+}
+
+void
+QueueDiscBatchTestCase::RunTest (uint32_t nPackets, uint32_t quota, Ptr<QueueLimits> limits)
+{
+  m_received.clear ();
+
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  m_txDev = CreateObject<BatchTestNetDevice> ();
+  Ptr<SimpleNetDevice> rxDev = CreateObject<SimpleNetDevice> ();
+  Ptr<SimpleNetDevice> devices[2] = { m_txDev, rxDev };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      node->AggregateObject (CreateObject<TrafficControlLayer> ());
+      devices[i]->SetAddress (Mac48Address::Allocate ());
+      devices[i]->SetChannel (channel);
+      node->AddDevice (devices[i]);
+    }
+  rxDev->SetReceiveCallback (MakeCallback (&QueueDiscBatchTestCase::Receive, this));
+
+  TrafficControlHelper tch = TrafficControlHelper::Default ();
+  m_qdisc = tch.Install (m_txDev).Get (0);
+  m_qdisc->SetQuota (quota);
+
+  Ptr<NetDeviceQueue> txq = m_txDev->GetObject<NetDeviceQueueInterface> ()->GetTxQueue (0);
+  if (limits)
+    {
+      txq->SetQueueLimits (limits);
+    }
+
+  // Backlog the packets in the queue disc. The node must be initialized for
+  // the traffic control layer to set up the queue discs
+  m_txDev->GetNode ()->Initialize ();
+  Ptr<TrafficControlLayer> tc = m_txDev->GetNode ()->GetObject<TrafficControlLayer> ();
+  txq->Stop ();
+  for (uint32_t i = 0; i < nPackets; i++)
+    {
+      tc->Send (m_txDev, Create<BatchTestItem> (Create<Packet> (1000 + i), rxDev->GetAddress (), 0));
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_qdisc->GetNPackets (), nPackets, "The packets should be in the queue disc");
+  NS_TEST_EXPECT_MSG_EQ (m_txDev->m_batches.size (), 0, "No packet should have been sent");
+
+  txq->Wake ();
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  for (uint32_t i = 0; i < m_received.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_received[i], 1000 + i, "The packets should be received in order");
+    }
+}
+
+void
+QueueDiscBatchTestCase::DoRun (void)
+{
+  // The whole backlog is sent in a single batch
+  RunTest (10, 64, 0);
+  NS_TEST_EXPECT_MSG_EQ (m_txDev->m_batches.size (), 1, "A single batch should have been sent");
+  NS_TEST_EXPECT_MSG_EQ (m_txDev->m_batches[0], 10, "The batch should contain all the packets");
+  NS_TEST_EXPECT_MSG_EQ (m_received.size (), 10, "All the packets should have been received");
+
+  // The batch is bounded by the quota
+  RunTest (10, 4, 0);
+  NS_TEST_EXPECT_MSG_EQ (m_txDev->m_batches.size (), 1, "A single batch should have been sent");
+  NS_TEST_EXPECT_MSG_EQ (m_txDev->m_batches[0], 4, "The batch should be bounded by the quota");
+  NS_TEST_EXPECT_MSG_EQ (m_received.size (), 4, "The packets in the batch should have been received");
+  NS_TEST_EXPECT_MSG_EQ (m_qdisc->GetNPackets (), 6, "The other packets should still be in the queue disc");
+
+  // The batch is bounded by the queue limits: after sending 4 packets of
+  // about 1000 bytes, the queue would be stopped
+  Ptr<DynamicQueueLimits> limits = CreateObject<DynamicQueueLimits> ();
+  limits->SetAttribute ("MinLimit", UintegerValue (3005));
+  RunTest (10, 64, limits);
+  NS_TEST_EXPECT_MSG_EQ (m_txDev->m_batches[0], 4, "The batch should be bounded by the queue limits");
+  NS_TEST_EXPECT_MSG_EQ (m_received.size (), 10, "All the packets should have been received");
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue disc batch TestSuite
+ */
+static class QueueDiscBatchTestSuite : public TestSuite
+{
+public:
+  QueueDiscBatchTestSuite ()
+    : TestSuite ("queue-disc-batch", UNIT)
+  {
+    AddTestCase (new QueueDiscBatchTestCase (), TestCase::QUICK);
+  }
+} g_queueDiscBatchTestSuite;
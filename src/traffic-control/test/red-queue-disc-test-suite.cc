@@ -33,7 +33,7 @@ using namespace ns3;
 
 class RedQueueDiscTestItem : public QueueDiscItem {
 public:
-  RedQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol);
+  RedQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, bool ecnCapable);
   virtual ~RedQueueDiscTestItem ();
   virtual void AddHeader (void);
   virtual bool Mark(void);
@@ -43,10 +43,14 @@ private:
   RedQueueDiscTestItem ();
   RedQueueDiscTestItem (const RedQueueDiscTestItem &);
   RedQueueDiscTestItem &operator = (const RedQueueDiscTestItem &);
+  bool m_ecnCapable;
+  bool m_marked;
 };
 
-RedQueueDiscTestItem::RedQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol)
-  : QueueDiscItem (p, addr, protocol)
+RedQueueDiscTestItem::RedQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, bool ecnCapable)
+  : QueueDiscItem (p, addr, protocol),
+    m_ecnCapable (ecnCapable),
+    m_marked (false)
 {
 }
 
@@ -63,13 +67,17 @@ RedQueueDiscTestItem::AddHeader (void)
 bool
 RedQueueDiscTestItem::Mark (void)
 {
-  return false;
+  if (m_ecnCapable)
+    {
+      m_marked = true;
+    }
+  return m_ecnCapable;
 }
 
 bool
 RedQueueDiscTestItem::IsMarked (void) const
 {
-  return false;
+  return m_marked;
 }
 
 class RedQueueDiscTestCase : public TestCase
@@ -78,7 +86,7 @@ public:
   RedQueueDiscTestCase ();
   virtual void DoRun (void);
 private:
-  void Enqueue (Ptr<RedQueueDisc> queue, uint32_t size, uint32_t nPkt);
+  void Enqueue (Ptr<RedQueueDisc> queue, uint32_t size, uint32_t nPkt, bool ecnCapable);
   void RunRedTest (StringValue mode);
 };
 
@@ -132,16 +140,16 @@ RedQueueDiscTestCase::RunRedTest (StringValue mode)
 
   queue->Initialize ();
   NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 0 * modeSize, "There should be no packets in there");
-  queue->Enqueue (Create<RedQueueDiscTestItem> (p1, dest, 0));
+  queue->Enqueue (Create<RedQueueDiscTestItem> (p1, dest, 0, false));
   NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 1 * modeSize, "There should be one packet in there");
-  queue->Enqueue (Create<RedQueueDiscTestItem> (p2, dest, 0));
+  queue->Enqueue (Create<RedQueueDiscTestItem> (p2, dest, 0, false));
   NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 2 * modeSize, "There should be two packets in there");
-  queue->Enqueue (Create<RedQueueDiscTestItem> (p3, dest, 0));
-  queue->Enqueue (Create<RedQueueDiscTestItem> (p4, dest, 0));
-  queue->Enqueue (Create<RedQueueDiscTestItem> (p5, dest, 0));
-  queue->Enqueue (Create<RedQueueDiscTestItem> (p6, dest, 0));
-  queue->Enqueue (Create<RedQueueDiscTestItem> (p7, dest, 0));
-  queue->Enqueue (Create<RedQueueDiscTestItem> (p8, dest, 0));
+  queue->Enqueue (Create<RedQueueDiscTestItem> (p3, dest, 0, false));
+  queue->Enqueue (Create<RedQueueDiscTestItem> (p4, dest, 0, false));
+  queue->Enqueue (Create<RedQueueDiscTestItem> (p5, dest, 0, false));
+  queue->Enqueue (Create<RedQueueDiscTestItem> (p6, dest, 0, false));
+  queue->Enqueue (Create<RedQueueDiscTestItem> (p7, dest, 0, false));
+  queue->Enqueue (Create<RedQueueDiscTestItem> (p8, dest, 0, false));
   NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 8 * modeSize, "There should be eight packets in there");
 
   Ptr<QueueDiscItem> item;
@@ -185,7 +193,7 @@ RedQueueDiscTestCase::RunRedTest (StringValue mode)
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
                          "Verify that we can actually set the attribute QueueLimit");
   queue->Initialize ();
-  Enqueue (queue, pktSize, 300);
+  Enqueue (queue, pktSize, 300, false);
   RedQueueDisc::Stats st = StaticCast<RedQueueDisc> (queue)->GetStats ();
   NS_TEST_EXPECT_MSG_EQ (st.unforcedDrop, 0, "There should zero dropped packets due probability mark");
   NS_TEST_EXPECT_MSG_EQ (st.forcedDrop, 0, "There should zero dropped packets due hardmark mark");
@@ -214,7 +222,7 @@ RedQueueDiscTestCase::RunRedTest (StringValue mode)
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QW", DoubleValue (0.020)), true,
                          "Verify that we can actually set the attribute QW");
   queue->Initialize ();
-  Enqueue (queue, pktSize, 300);
+  Enqueue (queue, pktSize, 300, false);
   st = StaticCast<RedQueueDisc> (queue)->GetStats ();
   drop.test3 = st.unforcedDrop + st.forcedDrop + st.qLimDrop;
   NS_TEST_EXPECT_MSG_NE (drop.test3, 0, "There should be some dropped packets");
@@ -234,7 +242,7 @@ RedQueueDiscTestCase::RunRedTest (StringValue mode)
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QW", DoubleValue (0.020)), true,
                          "Verify that we can actually set the attribute QW");
   queue->Initialize ();
-  Enqueue (queue, pktSize, 300);
+  Enqueue (queue, pktSize, 300, false);
   st = StaticCast<RedQueueDisc> (queue)->GetStats ();
   drop.test4 = st.unforcedDrop + st.forcedDrop + st.qLimDrop;
   NS_TEST_EXPECT_MSG_GT (drop.test4, drop.test3, "Test 4 should have more drops than test 3");
@@ -256,7 +264,7 @@ RedQueueDiscTestCase::RunRedTest (StringValue mode)
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("LInterm", DoubleValue (5)), true,
                          "Verify that we can actually set the attribute LInterm");
   queue->Initialize ();
-  Enqueue (queue, pktSize, 300);
+  Enqueue (queue, pktSize, 300, false);
   st = StaticCast<RedQueueDisc> (queue)->GetStats ();
   drop.test5 = st.unforcedDrop + st.forcedDrop + st.qLimDrop;
   NS_TEST_EXPECT_MSG_GT (drop.test5, drop.test3, "Test 5 should have more drops than test 3");
@@ -277,7 +285,7 @@ RedQueueDiscTestCase::RunRedTest (StringValue mode)
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Gentle", BooleanValue (false)), true,
                          "Verify that we can actually set the attribute Gentle");
   queue->Initialize ();
-  Enqueue (queue, pktSize, 300);
+  Enqueue (queue, pktSize, 300, false);
   st = StaticCast<RedQueueDisc> (queue)->GetStats ();
   drop.test6 = st.unforcedDrop + st.forcedDrop + st.qLimDrop;
   NS_TEST_EXPECT_MSG_GT (drop.test6, drop.test3, "Test 6 should have more drops than test 3");
@@ -298,19 +306,43 @@ RedQueueDiscTestCase::RunRedTest (StringValue mode)
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Wait", BooleanValue (false)), true,
                          "Verify that we can actually set the attribute Wait");
   queue->Initialize ();
-  Enqueue (queue, pktSize, 300);
+  Enqueue (queue, pktSize, 300, false);
   st = StaticCast<RedQueueDisc> (queue)->GetStats ();
   drop.test7 = st.unforcedDrop + st.forcedDrop + st.qLimDrop;
   NS_TEST_EXPECT_MSG_GT (drop.test7, drop.test3, "Test 7 should have more drops than test 3");
+
+
+  // test 8: step marking, on the instantaneous queue length
+  queue = CreateObject<RedQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MinTh", DoubleValue (20 * modeSize)), true,
+                         "Verify that we can actually set the attribute MinTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxTh", DoubleValue (40 * modeSize)), true,
+                         "Verify that we can actually set the attribute MaxTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (300 * modeSize)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("StepMarking", BooleanValue (true)), true,
+                         "Verify that we can actually set the attribute StepMarking");
+  queue->Initialize ();
+  Enqueue (queue, pktSize, 100, true);
+  st = StaticCast<RedQueueDisc> (queue)->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.stepMark, 79, "The packets arriving beyond MinTh should have been marked");
+  NS_TEST_EXPECT_MSG_EQ (st.unforcedMark + st.forcedMark, 0, "There should be no other marks");
+  Enqueue (queue, pktSize, 100, false);
+  st = StaticCast<RedQueueDisc> (queue)->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.stepMark, 79, "Packets not ECN-capable should not be marked");
+  NS_TEST_EXPECT_MSG_EQ (st.unforcedDrop + st.forcedDrop + st.qLimDrop, 0,
+                         "Packets not ECN-capable should only be dropped when the queue is full");
 }
 
 void 
-RedQueueDiscTestCase::Enqueue (Ptr<RedQueueDisc> queue, uint32_t size, uint32_t nPkt)
+RedQueueDiscTestCase::Enqueue (Ptr<RedQueueDisc> queue, uint32_t size, uint32_t nPkt, bool ecnCapable)
 {
   Address dest;
   for (uint32_t i = 0; i < nPkt; i++)
     {
-      queue->Enqueue (Create<RedQueueDiscTestItem> (Create<Packet> (size), dest, 0));
+      queue->Enqueue (Create<RedQueueDiscTestItem> (Create<Packet> (size), dest, 0, ecnCapable));
     }
 }
 
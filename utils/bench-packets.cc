@@ -284,6 +284,27 @@ benchFragment (uint32_t n)
   }
 }
 
+static void
+benchHeaders (uint32_t n)
+{
+  BenchHeader<14> ethernet;
+  BenchHeader<20> ipv4;
+  BenchHeader<20> tcp;
+  BenchHeader<8> udp;
+
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = Create<Packet> (1000);
+    p->AddHeader (udp);
+    p->AddHeader (tcp);
+    p->AddHeader (ipv4);
+    p->AddHeader (ethernet);
+    p->RemoveHeader (ethernet);
+    p->RemoveHeader (ipv4);
+    p->RemoveHeader (tcp);
+    p->RemoveHeader (udp);
+  }
+}
+
 static void
 benchByteTags (uint32_t n)
 {
@@ -314,7 +335,8 @@ runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
 
 
 static void
-runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
+runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name,
+          uint32_t opsPerPacket = 0, char const *ops = "")
 {
   uint64_t minDelay = std::numeric_limits<uint64_t>::max();
   for (uint32_t i = 0; i < minIterations; i++)
@@ -322,15 +344,36 @@ runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char con
       uint64_t delay = runBenchOneIteration(bench, n);
       minDelay = std::min(minDelay, delay);
     }
+  minDelay = std::max<uint64_t> (minDelay, 1);
   double ps = n;
   ps *= 1000;
   ps /= minDelay;
-  std::cout << ps << " packets/s"
-            << " (" << minDelay << " ms elapsed)\t"
+  std::cout << ps << " packets/s";
+  if (opsPerPacket > 0)
+    {
+      std::cout << ", " << ps * opsPerPacket << " " << ops << "/s";
+    }
+  std::cout << " (" << minDelay << " ms elapsed)\t"
             << name
             << std::endl;
 }
 
+static void
+runAllBenches (uint32_t n, uint32_t minIterations)
+{
+  runBench (&benchA, n, minIterations, "Copy packet, remove headers");
+  runBench (&benchB, n, minIterations, "Just add headers");
+  runBench (&benchC, n, minIterations, "Remove by func call");
+  runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
+  runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
+  runBench (&benchHeaders, n, minIterations, "Push and pop four headers", 8, "header push/pop");
+  if (!Packet::IsLeanModeEnabled ())
+    {
+      // lean packets do not support byte tags
+      runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+    }
+}
+
 int main (int argc, char *argv[])
 {
   uint32_t n = 0;
@@ -353,12 +396,22 @@ int main (int argc, char *argv[])
   std::cout << "Running bench-packets with n=" << n << std::endl;
   std::cout << "All tests begin by adding UDP and IPv4 headers." << std::endl;
 
-  runBench (&benchA, n, minIterations, "Copy packet, remove headers");
-  runBench (&benchB, n, minIterations, "Just add headers");
-  runBench (&benchC, n, minIterations, "Remove by func call");
-  runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
-  runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
-  runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  if (enablePrinting)
+    {
+      Packet::EnablePrinting ();
+    }
+
+  std::cout << "Regular packets:" << std::endl;
+  runAllBenches (n, minIterations);
+
+  if (enablePrinting)
+    {
+      std::cout << "Lean packets skipped: packet printing is enabled." << std::endl;
+      return 0;
+    }
+  std::cout << "Lean packets (no metadata, no byte tags):" << std::endl;
+  Packet::EnableLeanMode ();
+  runAllBenches (n, minIterations);
 
   return 0;
 }
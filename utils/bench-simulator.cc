@@ -184,8 +184,10 @@ int main (int argc, char *argv[])
 
   bool schedCal  = false;
   bool schedHeap = false;
+  bool schedLadder = false;
   bool schedList = false;
   bool schedMap  = true;
+  bool pool      = true;
 
   uint32_t pop   =  100000;
   uint32_t total = 1000000;
@@ -203,8 +205,10 @@ int main (int argc, char *argv[])
              "to be ascii, giving the relative event times in ns.");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
+  cmd.AddValue ("pool",  "allocate events from the EventImpl pool (default true)", pool);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
@@ -218,8 +222,10 @@ int main (int argc, char *argv[])
   ObjectFactory factory ("ns3::MapScheduler");
   if (schedCal)  { factory.SetTypeId ("ns3::CalendarScheduler"); }
   if (schedHeap) { factory.SetTypeId ("ns3::HeapScheduler");     }
+  if (schedLadder) { factory.SetTypeId ("ns3::LadderScheduler"); }
   if (schedList) { factory.SetTypeId ("ns3::ListScheduler");     }  
   Simulator::SetScheduler (factory);
+  EventImpl::EnablePool (pool);
 
   LOGME (std::setprecision (g_fwidth - 6));
   DEB ("debugging is ON");
@@ -228,6 +234,7 @@ int main (int argc, char *argv[])
   LOGME ("population: " << pop);
   LOGME ("total events: " << total);
   LOGME ("runs: " << runs);
+  LOGME ("event pool: " << (pool ? "enabled" : "disabled"));
   
   Bench *bench = new Bench (pop, total);
   bench->SetRandomStream (GetRandomStream (filename));
@@ -269,6 +276,11 @@ int main (int argc, char *argv[])
       bench->RunBench ();
     }
 
+  EventImpl::PoolStatistics stats = EventImpl::GetPoolStatistics ();
+  LOG ("");
+  LOGME ("event allocations: " << stats.allocations <<
+         ", served by the pool: " << stats.hits <<
+         " (" << (stats.allocations ? 100.0 * stats.hits / stats.allocations : 0) << "%)");
   LOG ("");
   return 0;
 